@@ -0,0 +1,89 @@
+/*
+Description:
+		Incremental version of sumRepulsiveForces. One telemetry update only changes one plane, so
+		instead of summing every plane in "me's" planesToAvoid map on every update, the accumulator
+		keeps each plane's repulsive force (in x/y) and the running total:
+			- update from another plane: only that plane's force is recalculated, and the total is
+			  corrected by the difference
+			- update from "me": every cached force depends on where "me" is, so they are all
+			  recalculated in one batched pass (RepulsiveForceBatch) and the total is summed again
+			- every fullRecomputeInterval updates: the cache is rebuilt from the map, which bounds
+			  the rounding error the running total picks up and moves the batch origin back to "me"
+
+		Positions are kept in meters from an origin near "me" (where "me" was at the last full
+		recompute) rather than from the anchor of LocalFrame::mission(), so they stay small enough
+		for the float lanes on ARM.
+
+Date: 10/14/26
+*/
+
+#ifndef FORCE_ACCUMULATOR_H
+#define FORCE_ACCUMULATOR_H
+
+#include <vector>
+
+#include "au_uav_ros/vmath.h"
+#include "au_uav_ros/planeObject.h"
+#include "au_uav_ros/RepulsiveForceBatch.h"
+
+#define DEFAULT_FULL_RECOMPUTE_INTERVAL 100	//telemetry updates between full recomputes
+
+namespace fsquared{
+
+	class ForceAccumulator{
+	public:
+		/*
+		 * Params:
+		 * 		fullRecomputeInterval: number of updates between rebuilds of the cache from the map,
+		 * 							   1 rebuilds on every update
+		 */
+		ForceAccumulator(int fullRecomputeInterval = DEFAULT_FULL_RECOMPUTE_INTERVAL);
+
+		void setFullRecomputeInterval(int updates);
+		int getFullRecomputeInterval() const;
+
+		/*
+		 * Precondition: me's map has already been updated with this telemetry update
+		 * 				 (findTempForceWaypoint does this before calling update)
+		 * Use: Bring the cached forces up to date after a telemetry update from planeID
+		 * Params:
+		 * 		me: the plane feeling the forces, its map decides which planes are cached
+		 * 		planeID: the plane the update came from, may be "me"
+		 */
+		void update(au_uav_ros::PlaneObject &me, int planeID);
+
+		/*
+		 * Use: Rebuild the cache from every plane in me's map and sum it from scratch.
+		 * 		update() calls this every fullRecomputeInterval updates.
+		 */
+		void recompute(au_uav_ros::PlaneObject &me);
+
+		/* Sum of the cached repulsive forces, same as sumRepulsiveForces(me, me.getMap()) */
+		au_uav_ros::mathVector getForce() const;
+
+		int size() const;					//number of planes cached
+		long getFullRecomputes() const;		//times the cache was rebuilt
+		long getBatchedRefreshes() const;	//times "me" moved and every force was recalculated
+
+	private:
+		void neighborUpdated(au_uav_ros::PlaneObject &me, const NeighborState &enemy);
+		void neighborRemoved(int planeID);
+		void meMoved(au_uav_ros::PlaneObject &me);
+
+		//meters in LocalFrame::mission() to meters from the origin
+		double toX(double missionX) const;
+		double toY(double missionY) const;
+
+		int fullRecomputeInterval;
+		int updatesSinceRecompute;
+		long fullRecomputes, batchedRefreshes;
+
+		bool anchored;							//false until the first recompute sets the origin
+		double originX, originY;				//meters in LocalFrame::mission()
+		RepulsiveForceBatch batch;		//one slot per cached plane
+		std::vector<int> slotOf;		//slot of each plane, indexed by plane ID, -1 if not cached
+		double sumX, sumY;
+	};
+}
+
+#endif
@@ -4,7 +4,11 @@ Authors: Andrew Cunningham
 
 Description:
 		This file contains definitions of the ForceField object that is required for the F^2 approach
-		Currently, it is setup to contain variability of field shape, but not variability of force functions
+		A ForceField is a FieldShape and a FieldFunction held by value. ForceField<Shape, Function> is
+		resolved at compile time so both calls inline; AnyForceField picks the shape and function at
+		runtime (PlaneObject::setField(int, int)) without touching the heap.
+		The tabulated shape and function give the same answers from tables built when the field is
+		made, instead of a sqrt, an exp and a few pows on every call.
 
 Date: 6/12/13
 
@@ -16,48 +20,13 @@ FUTURE WORK:
 #ifndef FORCEFIELD_H
 #define FORCEFIELD_H
 
+#include <math.h>
+#include <vector>
+#include <boost/shared_ptr.hpp>
 #include "au_uav_ros/Fsquared.h"	 //only for coordinates
 #include "au_uav_ros/vmath.h"
 #include "au_uav_ros/standardDefs.h" //contains waypoint struct
 
-//Forward Declarations of classes
-class FieldShape;
-class FieldFunction;
-
-
-
-/**************************************************************************
- * 								FORCE FIELD								  *
- **************************************************************************/
-
-
-/* Description:
- * 		This class describes an instance of an APF and is comprised of
- *			two subclasses: a FieldShape and a FieldFunction
- */
-class ForceField{
-public:
-	//Constructor, defaults to creating an oval field with a bivariate normal function
-	ForceField();
-	//~ForceField();
-	//assignment operator
-	ForceField& operator=(const ForceField& ForceFieldIn);
-
-
-	bool areCoordinatesInMyField(fsquared::relativeCoordinates positionInField, double fieldAngle, double planeAngle);
-	double findForceMagnitude(fsquared::relativeCoordinates positionInField);
-
-//	void setMyShape(FieldShape * aShape);
-//	void setMyFunction(FieldFunction * aFunction);
-	const FieldShape * getMyShape() const;
-	const FieldFunction * getMyFunction() const;
-
-
-public:
-	FieldShape * myShape;
-	FieldFunction * myFunction;
-};
-
 
 
 /**************************************************************************
@@ -65,53 +34,40 @@ public:
  **************************************************************************/
 
 /* Description:
- * 		This class is an abstract base class from which all field shapes are derived
+ * 		Field shapes are plain value classes, there is no base class. A shape is any class with
+ *
+ *		//Precondition: None
+ *		//Use:
+ *		//		This method will determine whether or not coordinates are inside
+ *		//		this field
+ *		//Params:
+ *		//		positionInField: coordinate of the plane that will feel the force
+ *		//						 relative to the position of the plane generating the field
+ *		//		fieldAngle: bearing of the plane generating the field - angle between the plane
+ *		//					genereating the field and the plane that will feel the force
+ *		//		planeAngle:	angle between the two planes, calculated starting from the generating
+ *		//					plane and going to the plane that will feel the force
+ *		bool internal_areCoordinatesInMyField(fsquared::relativeCoordinates positionInField, double fieldAngle, double planeAngle) const;
+ *
+ *		To make a new shape selectable at runtime, give it a code below and add it to AnyForceField.
  */
-
-class FieldShape{
-public:
-	virtual ~FieldShape(){};
-
-
-	//Precondition: None
-	//Use:
-	//		This method will determine whether or not coordinates are inside
-	//		this field
-	//Params:
-	//		positionInField: coordinate of the plane that will feel the force
-	//						 relative to the position of the plane generating the field
-	//		fieldAngle: bearing of the plane generating the field - angle between the plane
-	//					genereating the field and the plane that will feel the force
-	//		planeAngle:	angle between the two planes, calculated starting from the generating
-	//					plane and going to the plane that will feel the force
-
-	virtual bool internal_areCoordinatesInMyField(fsquared::relativeCoordinates positionInField, double fieldAngle, double planeAngle) =0;
-
-
-
-	/*	Precondition: positionInField is inside the field
-	 * 	Use:
-	 * 		This method will calculate how far from the outer limit of the field
-	 * 			a set of points is
-	 * 		This method can be used to build field functions that are dependent
-	 * 			on their field shape
-	 *	TODO:
-	 *		Implement if we choose a FieldFunction that is dependent on FieldShape
-	 */
-	 //virtual double distanceToLimit(fsquared::relativeCoordinates positionInField, double fieldAngle, double planeAngle);
+enum fieldShapeCode{
+	OVAL_FIELD_SHAPE = 0,
+	TABULATED_OVAL_FIELD_SHAPE = 1
 };
 
+#define DEFAULT_FIELD_TABLE_STEP 1.0	//meters between the points of a field table
+
 
 
 /* Description:
  * 			This class contains the ovoid field shape that was used by the 2012 APF group,
  */
-class OvalField : public FieldShape{
+class OvalField{
 public:
 	OvalField();
-	bool internal_areCoordinatesInMyField(fsquared::relativeCoordinates positionInField, double fieldAngle, double planeAngle);
+	inline bool internal_areCoordinatesInMyField(fsquared::relativeCoordinates positionInField, double fieldAngle, double planeAngle) const;
 
-private:
 	/* Credit:
 	 * 		Hosea Siu and Miriam Figueroa- the 2012 REU group that worked on APFs & flocking (move this later)
 	 * 		the shapeVariables struct contains the constants needed to define an ovoid
@@ -126,11 +82,48 @@ private:
 		double betaBot;
 	};
 
+	explicit OvalField(const shapeVariables &params);
+
+	//Read by fsquared::RepulsiveForceBatch so the batched kernel uses the same oval
+	const shapeVariables & getShapeParams() const;
+
+	bool operator==(const OvalField &other) const;
+
+private:
 	shapeVariables shapeParams;
 };
 
 
 
+/* Description:
+ * 		OvalField with the boundary looked up instead of calculated. Coordinates are truncated to
+ * 		whole meters before the test, the same as OvalField does, so the limit only depends on a
+ * 		whole x and the table holds it for every x the oval reaches. Answers are exactly the
+ * 		same as OvalField's.
+ */
+class TabulatedOvalField{
+public:
+	TabulatedOvalField();
+	explicit TabulatedOvalField(const OvalField &shape);
+	inline bool internal_areCoordinatesInMyField(fsquared::relativeCoordinates positionInField, double fieldAngle, double planeAngle) const;
+
+	//Rebuilds the table, unless shape has the same constants as the current one
+	void setShape(const OvalField &shape);
+	const OvalField & getShape() const;
+
+private:
+	struct boundary{
+		double top;		//y limit in front of the plane, NaN where the oval does not reach
+		double bottom;	//y limit behind the plane
+	};
+
+	OvalField shape;
+	int reach;		//largest whole |x| in the table
+	boost::shared_ptr<const std::vector<boundary> > limits;	//x = -reach to reach, shared by copies
+};
+
+
+
 
 
 /**************************************************************************
@@ -142,24 +135,24 @@ private:
 
 
 /* Description:
- * 		This class is an abstract base class from which all field functions are derived
+ * 		Field functions are plain value classes too. A function is any class with
+ *
+ *		//Precondition: positionInField is inside the field's shape
+ *		double findFieldFunctionMagnitude(fsquared::relativeCoordinates positionInField) const;
  */
-class FieldFunction{
-public:
-	virtual ~FieldFunction(){};
-	virtual double findFieldFunctionMagnitude(fsquared::relativeCoordinates positionInField) =0;
+enum fieldFunctionCode{
+	BIVARIATE_NORMAL_FUNCTION = 0,
+	TABULATED_BIVARIATE_NORMAL_FUNCTION = 1
 };
 
 /*	Function: Bivariate Normal
  * 	Equation: F = Fmax * exp(-alpha*x^2 -beta*y^2)
  */
-class BivariateNormal : public FieldFunction{
+class BivariateNormal{
 public:
 	BivariateNormal();
-	double findFieldFunctionMagnitude(fsquared::relativeCoordinates positionInField);
-
+	inline double findFieldFunctionMagnitude(fsquared::relativeCoordinates positionInField) const;
 
-private:
 	//constants needed to define the bivariate normal force function
 	struct forceVariables{
 		double maxForce;				// maximum force imposed by one plane on another, except when they are in conflict radius
@@ -168,10 +161,232 @@ private:
 		double beta;
 	};
 
+	explicit BivariateNormal(const forceVariables &params);
+
+	//Read by fsquared::RepulsiveForceBatch so the batched kernel uses the same function
+	const forceVariables & getFunctionParams() const;
+
+	bool operator==(const BivariateNormal &other) const;
+
+private:
 	forceVariables functionParams;
 };
 
 
 
+/* Description:
+ * 		BivariateNormal with the magnitude looked up instead of calculated. The magnitude is
+ * 		tabulated on a square grid, step meters apart, over the box around a field shape (the only
+ * 		place the function is called), and read back with bilinear interpolation. Coordinates
+ * 		outside the box are calculated the normal way.
+ *
+ * 		Coordinates are truncated to whole meters first, like BivariateNormal does, so with a step
+ * 		that divides 1 every lookup lands on a grid point and the answer is BivariateNormal's.
+ * 		Otherwise the difference is at most maxError(function, step):
+ * 			step^2 * maxForce * (alpha + beta) / 4
+ * 		which is the bilinear interpolation bound step^2/8 * (max|d2F/dx2| + max|d2F/dy2|).
+ */
+class TabulatedBivariateNormal{
+public:
+	TabulatedBivariateNormal();
+	/*
+	 * Params:
+	 * 		function: the constants to tabulate
+	 * 		coverage: the shape the function will be paired with, decides the size of the table
+	 * 		step: meters between grid points
+	 */
+	TabulatedBivariateNormal(const BivariateNormal &function, const OvalField &coverage = OvalField(),
+			double step = DEFAULT_FIELD_TABLE_STEP);
+	inline double findFieldFunctionMagnitude(fsquared::relativeCoordinates positionInField) const;
+
+	//Rebuilds the table, unless nothing changed
+	void setFunction(const BivariateNormal &function, const OvalField &coverage = OvalField(),
+			double step = DEFAULT_FIELD_TABLE_STEP);
+	const BivariateNormal & getFunction() const;
+	double getStep() const;
+
+	//Largest difference from BivariateNormal for any coordinates inside the coverage shape
+	static double maxError(const BivariateNormal &function, double step);
+
+private:
+	BivariateNormal function;
+	OvalField coverage;
+	double step;
+	double xMin, yMin;		//meters, first grid point
+	int columns, rows;		//grid points along x and y
+	boost::shared_ptr<const std::vector<double> > magnitudes;	//row major, shared by copies
+};
+
+
+
+/**************************************************************************
+ * 								FORCE FIELD								  *
+ **************************************************************************/
+
+
+/* Description:
+ * 		This class describes an instance of an APF and is comprised of
+ *			a field shape and a field function, both held by value
+ */
+template <class Shape = OvalField, class Function = BivariateNormal>
+class ForceField{
+public:
+	//Constructor, defaults to creating an oval field with a bivariate normal function
+	ForceField() {}
+	ForceField(const Shape &shape, const Function &function) : myShape(shape), myFunction(function) {}
+
+	bool areCoordinatesInMyField(fsquared::relativeCoordinates positionInField, double fieldAngle, double planeAngle) const{
+		return myShape.internal_areCoordinatesInMyField(positionInField, fieldAngle, planeAngle);
+	}
+
+	/* Assumptions:
+	 * 		Coordinates are within the field shape
+	 */
+	double findForceMagnitude(fsquared::relativeCoordinates positionInField) const{
+		return myFunction.findFieldFunctionMagnitude(positionInField);
+	}
+
+	const Shape & getMyShape() const { return myShape; }
+	const Function & getMyFunction() const { return myFunction; }
+
+private:
+	Shape myShape;
+	Function myFunction;
+};
+
+
+
+/* Description:
+ * 		A ForceField whose shape and function are chosen at runtime by their codes, this is
+ * 		what every PlaneObject carries. Every known shape and function is held by value and the
+ * 		codes pick which one is used, so copying a PlaneObject never allocates (the tables of the
+ * 		tabulated ones are shared, not copied).
+ */
+class AnyForceField{
+public:
+	//Defaults to an oval field with a bivariate normal function
+	AnyForceField();
+
+	//Precondition: codes are from fieldShapeCode and fieldFunctionCode, unknown codes get the default
+	AnyForceField(int encodedFieldShape, int encodedFieldFunction);
+
+	template <class Shape, class Function>
+	AnyForceField(const ForceField<Shape, Function> &field){
+		setShape(field.getMyShape());
+		setFunction(field.getMyFunction());
+	}
+
+	inline bool areCoordinatesInMyField(fsquared::relativeCoordinates positionInField, double fieldAngle, double planeAngle) const;
+	inline double findForceMagnitude(fsquared::relativeCoordinates positionInField) const;
+
+	int getShapeCode() const;
+	int getFunctionCode() const;
+
+	//The analytic shape and function in use, or the ones the tables were built from
+	const OvalField & getOval() const;
+	const BivariateNormal & getBivariateNormal() const;
+
+	//true if the codes passed to the constructor were known
+	static bool isKnownShape(int encodedFieldShape);
+	static bool isKnownFunction(int encodedFieldFunction);
+
+private:
+	void setShape(const OvalField &shape);
+	void setShape(const TabulatedOvalField &shape);
+	void setFunction(const BivariateNormal &function);
+	void setFunction(const TabulatedBivariateNormal &function);
+
+	fieldShapeCode shapeCode;
+	fieldFunctionCode functionCode;
+
+	OvalField oval;
+	TabulatedOvalField tabulatedOval;
+	BivariateNormal bivariateNormal;
+	TabulatedBivariateNormal tabulatedBivariateNormal;
+};
+
+
+
+/**************************************************************************
+ * 						Inline implementations							  *
+ **************************************************************************
+ * These are on the path of every telemetry update, keep them here so they inline
+ */
+
+//internal_areCoordinatesInMyField(...)
+//TODO REMOVE ANGLES
+inline bool OvalField::internal_areCoordinatesInMyField(fsquared::relativeCoordinates positionInField, double fieldAngle, double planeAngle) const{
+	int x = positionInField.x;
+	int y = positionInField.y;
+	if (y < 0){
+		// plane feeling the force is behind the plane exerting the force, therefore use the bottom boundary
+		double forceLimit = -sqrt((shapeParams.gamma-(shapeParams.alphaBot*pow(x,2)))/shapeParams.betaBot);
+		if (y>forceLimit) return true;
+		else return false;
+	}
+	else{
+		// plane feeling the force is in front, therefore use the top boundary
+		double forceLimit = sqrt((shapeParams.gamma-(shapeParams.alphaTop*pow(x,2)))/shapeParams.betaTop);
+		if (y<forceLimit) return true;
+		else return false;
+	}
+}
+
+inline double BivariateNormal::findFieldFunctionMagnitude(fsquared::relativeCoordinates positionInField) const{
+	int x = positionInField.x;
+	int y = positionInField.y;
+	return functionParams.maxForce * exp(-functionParams.alpha*pow(x,2)-functionParams.beta*pow(y,2));
+}
+
+//Same branches as OvalField, a NaN limit fails both comparisons like the sqrt of a negative does
+inline bool TabulatedOvalField::internal_areCoordinatesInMyField(fsquared::relativeCoordinates positionInField, double fieldAngle, double planeAngle) const{
+	int x = positionInField.x;
+	int y = positionInField.y;
+	if (x < -reach || x > reach)
+		return shape.internal_areCoordinatesInMyField(positionInField, fieldAngle, planeAngle);
+	const boundary &limit = (*limits)[x + reach];
+	if (y < 0)
+		return y > limit.bottom;
+	else
+		return y < limit.top;
+}
+
+inline double TabulatedBivariateNormal::findFieldFunctionMagnitude(fsquared::relativeCoordinates positionInField) const{
+	int x = positionInField.x;
+	int y = positionInField.y;
+	double column = (x - xMin)/step;
+	double row = (y - yMin)/step;
+	if (!(column >= 0 && column <= columns - 1 && row >= 0 && row <= rows - 1))
+		return function.findFieldFunctionMagnitude(positionInField);
+
+	//the last grid point is interpolated from the cell before it
+	int i = column < columns - 1 ? (int)column : columns - 2;
+	int j = row < rows - 1 ? (int)row : rows - 2;
+	double fx = column - i, fy = row - j;
+	const double *below = &(*magnitudes)[j*columns + i];
+	const double *above = below + columns;
+	return (below[0]*(1 - fx) + below[1]*fx)*(1 - fy) + (above[0]*(1 - fx) + above[1]*fx)*fy;
+}
+
+inline bool AnyForceField::areCoordinatesInMyField(fsquared::relativeCoordinates positionInField, double fieldAngle, double planeAngle) const{
+	switch(shapeCode){
+	case TABULATED_OVAL_FIELD_SHAPE:
+		return tabulatedOval.internal_areCoordinatesInMyField(positionInField, fieldAngle, planeAngle);
+	case OVAL_FIELD_SHAPE:
+	default:
+		return oval.internal_areCoordinatesInMyField(positionInField, fieldAngle, planeAngle);
+	}
+}
+
+inline double AnyForceField::findForceMagnitude(fsquared::relativeCoordinates positionInField) const{
+	switch(functionCode){
+	case TABULATED_BIVARIATE_NORMAL_FUNCTION:
+		return tabulatedBivariateNormal.findFieldFunctionMagnitude(positionInField);
+	case BIVARIATE_NORMAL_FUNCTION:
+	default:
+		return bivariateNormal.findFieldFunctionMagnitude(positionInField);
+	}
+}
+
 
 #endif
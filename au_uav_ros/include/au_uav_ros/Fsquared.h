@@ -19,6 +19,7 @@ Diversify field types (work on once this implementation is completed and tested
 
 //ROS Includes
 #include <map>
+#include <vector>
 #include "au_uav_ros/Telemetry.h"
 #include "au_uav_ros/vmath.h" 		 //MOVE ME IN
 #include "au_uav_ros/standardDefs.h" //contains waypoint struct
@@ -35,10 +36,19 @@ Diversify field types (work on once this implementation is completed and tested
 namespace au_uav_ros{
 	class PlaneObject;
 }
+class AnyForceField;
 
 
 namespace fsquared{
 
+	class SpatialGrid;
+	class RepulsiveForceBatch;
+	class ForceAccumulator;
+	class NeighborTable;
+	struct NeighborState;
+	class ThreatFilter;
+	class ThreatSet;
+
 
 	/*
 	 * Coordinates in meters
@@ -62,6 +72,8 @@ namespace fsquared{
 	 * Params:
 	 * 		me: The plane that is receiving the telemetry update
 	 * 		msg: The the telemetry update that is received
+	 * 		threats: optional closest point of approach prefilter, NULL to field test every
+	 * 				 plane within RADAR_ZONE
 	 * 	Use:
 	 * 		This is the primary method that calls all the other methods.
 	 * 		To use the fsquared algorithm, call this function
@@ -70,6 +82,8 @@ namespace fsquared{
 	 *		check to see if enemy is within a certain distance (RADAR_ZONE)
 	 *		if enemy is out of RADAR_ZONE
 	 *			remove enemy from the map of planes exerting forces
+	 *		else if threats says enemy will not come close soon (diverging, far future, wide miss)
+	 *			remove enemy from the map of planes exerting forces
 	 *		else enemy is within RADAR_ZONE
 	 *			if "me" is in enemy's field
 	 *				add enemy to the map of planes exerting a force on "me"
@@ -83,7 +97,61 @@ namespace fsquared{
 	 */
 
 
-	au_uav_ros::waypoint findTempForceWaypoint(au_uav_ros::PlaneObject &me, const au_uav_ros::Telemetry &msg);
+	au_uav_ros::waypoint findTempForceWaypoint(au_uav_ros::PlaneObject &me, const au_uav_ros::Telemetry &msg,
+											ThreatFilter *threats = NULL);
+
+	/*
+	 * Use:
+	 * 		The first half of every findTempForceWaypoint, without summing any forces. If the
+	 * 		telemetry update is from "me", update "me". Otherwise update "me's" map of planes that
+	 * 		are exerting a force on "me". For taking in several updates and summing once, after
+	 * 		the last one.
+	 * Params:
+	 * 		threats: may be NULL, then every plane in RADAR_ZONE gets the field test
+	 */
+	void updatePlanesToAvoid(au_uav_ros::PlaneObject &me, const au_uav_ros::Telemetry &msg, ThreatFilter *threats = NULL);
+
+	/*
+	 * Use:
+	 * 		Same as findTempForceWaypoint(me, msg), but only the planes that grid places within
+	 * 		RADAR_ZONE of "me" are summed, instead of every plane in "me's" map, and they are
+	 * 		summed in one batched pass through batch. Keeps grid up to date with the update first
+	 * 		(updateGrid). CollisionAvoidance owns the grid and the batch so they are reused
+	 * 		between updates.
+	 */
+	au_uav_ros::waypoint findTempForceWaypoint(au_uav_ros::PlaneObject &me, const au_uav_ros::Telemetry &msg, SpatialGrid &grid,
+											RepulsiveForceBatch &batch, ThreatFilter *threats = NULL);
+
+	/*
+	 * Precondition: updatePlanesToAvoid has taken msg in
+	 * Use:
+	 * 		Keeps grid holding exactly the planes in "me's" map, at the position they last reported:
+	 * 		the plane msg is from is moved if it is in the map, and taken out if it is not (out of
+	 * 		RADAR_ZONE, dropped by the prefilter, or "me" is not in its field). Updates from "me"
+	 * 		leave the grid alone.
+	 */
+	void updateGrid(au_uav_ros::PlaneObject &me, const au_uav_ros::Telemetry &msg, SpatialGrid &grid);
+
+	/*
+	 * Use:
+	 * 		Same as findTempForceWaypoint(me, msg), but the repulsive force comes from forces, which
+	 * 		only recalculates what the update changed instead of summing the whole map again.
+	 * 		forces must see every telemetry update "me" gets.
+	 */
+	au_uav_ros::waypoint findTempForceWaypoint(au_uav_ros::PlaneObject &me, const au_uav_ros::Telemetry &msg, ForceAccumulator &forces,
+											ThreatFilter *threats = NULL);
+
+	/*
+	 * Use:
+	 * 		Same as findTempForceWaypoint(me, msg), but only the most urgent planes in "me's" map
+	 * 		are summed, and ranking and summing both stop at deadline (see ThreatSet.h). With a
+	 * 		deadline, how long this takes is bounded by it instead of by the traffic; without one,
+	 * 		ranking the map still grows with the traffic.
+	 * Params:
+	 * 		deadline: ros::WallTime in seconds, 0 for none
+	 */
+	au_uav_ros::waypoint findTempForceWaypoint(au_uav_ros::PlaneObject &me, const au_uav_ros::Telemetry &msg, ThreatSet &bounded,
+											double deadline, ThreatFilter *threats = NULL);
 
 
 	//-------------------------------
@@ -108,6 +176,14 @@ namespace fsquared{
 	*/
 	au_uav_ros::mathVector calculateRepulsiveForce(au_uav_ros::PlaneObject &me, au_uav_ros::PlaneObject &enemy);
 
+	/*
+	 * Use: Same as above for a plane from "me's" map. A NeighborState has no field of its own,
+	 * 		the enemy's field is me.getNeighborField(), set for every neighbor at once through
+	 * 		CollisionAvoidance::setNeighborField (the analytic fields, or tabulated ones with
+	 * 		tabulated_fields).
+	 */
+	au_uav_ros::mathVector calculateRepulsiveForce(au_uav_ros::PlaneObject &me, const NeighborState &enemy);
+
 	
 
 	/*
@@ -119,7 +195,17 @@ namespace fsquared{
 	 * 			repulsive force on "me"
 	 * Todo: TEST TEST TEST
 	 */	
-	au_uav_ros::mathVector sumRepulsiveForces(au_uav_ros::PlaneObject &me, std::map<int, au_uav_ros::PlaneObject> & planesToAvoid);
+	au_uav_ros::mathVector sumRepulsiveForces(au_uav_ros::PlaneObject &me, const NeighborTable &planesToAvoid);
+
+	/*
+	 * Use: Same as above, but only the planes in planesToAvoid whose IDs are in nearbyPlanes are summed,
+	 * 		and the forces are calculated by RepulsiveForceBatch instead of calculateRepulsiveForce
+	 * Params:
+	 * 		nearbyPlanes: IDs of the planes near "me", usually from SpatialGrid::findNeighbors
+	 * 		batch: refilled with the nearby planes, positions are meters from "me"
+	 */
+	au_uav_ros::mathVector sumRepulsiveForces(au_uav_ros::PlaneObject &me, const NeighborTable &planesToAvoid,
+											const std::vector<int> &nearbyPlanes, RepulsiveForceBatch &batch);
 
 
 
@@ -149,6 +235,7 @@ namespace fsquared{
 	 *who:		vw - DONE, TESTED
 	 */
 	double findFieldAngle(au_uav_ros::PlaneObject &me, au_uav_ros::PlaneObject &enemy);
+	double findFieldAngle(au_uav_ros::PlaneObject &me, const NeighborState &enemy);
 
 
 	/*
@@ -161,6 +248,7 @@ namespace fsquared{
 	 *who:		vw (DONE, tested)
 	*/
 	 relativeCoordinates findRelativePosition(au_uav_ros::PlaneObject &me, au_uav_ros::PlaneObject &enemy);
+	 relativeCoordinates findRelativePosition(au_uav_ros::PlaneObject &me, const NeighborState &enemy);
 	 
 
 
@@ -182,6 +270,9 @@ namespace fsquared{
 
 	bool inEnemyField(au_uav_ros::PlaneObject &me, au_uav_ros::PlaneObject &enemy);
 
+	//enemy has the default field, see calculateRepulsiveForce(me, NeighborState)
+	bool inEnemyField(au_uav_ros::PlaneObject &me, const NeighborState &enemy);
+
 
 
 	/* 
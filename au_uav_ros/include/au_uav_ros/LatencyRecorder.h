@@ -0,0 +1,49 @@
+/*
+Description:
+		Histogram of how long something took, for latency percentiles. Bins are 1 microsecond
+		wide up to 1 ms, 10 us up to 10 ms and 100 us up to 100 ms, and a percentile is reported as
+		the upper edge of its bin. Below 1 ms that is up to 1 us high (10% at 10 us, 1% at 100 us),
+		above it no more than 1% high. Anything longer is only counted, and reported as the
+		longest time seen. The bins are a fixed array, recording never allocates.
+
+Date: 10/14/26
+*/
+
+#ifndef LATENCY_RECORDER_H
+#define LATENCY_RECORDER_H
+
+namespace au_uav_ros{
+
+	class LatencyRecorder{
+	public:
+		LatencyRecorder();
+
+		void record(double seconds);
+		void reset();
+
+		long getCount() const;
+		double getMax() const;		//seconds
+		double getMean() const;		//seconds
+
+		/*
+		 * Params:
+		 * 		percent: 0 to 100, e.g. 99.9
+		 * Returns: seconds, the upper edge of the bin the percentile falls in. 0 if nothing
+		 * 			has been recorded.
+		 */
+		double percentile(double percent) const;
+
+	private:
+		enum { BINS = 1000 + 900 + 900 };
+
+		static int binOf(double microseconds);
+		static double upperEdge(int bin);	//microseconds
+
+		long bins[BINS];
+		long overflow;			//longer than the last bin
+		long count;
+		double total, longest;	//seconds
+	};
+}
+
+#endif
@@ -0,0 +1,125 @@
+/*
+Description:
+		Local tangent plane (east, north, up) used for all the geometry collision avoidance does. The
+		frame is anchored once, at mission start, and works out how many meters a degree of latitude
+		and of longitude is at the anchor (WGS84 ellipsoid). After that every conversion between
+		latitude/longitude and meters is a subtraction and a multiplication, and distances and
+		angles are right at whatever latitude the mission is flown.
+
+		Positions are converted to meters once, when telemetry comes in, and everything after that
+		works in meters. Over a mission area of a few kilometers the error of the flat frame is
+		centimeters.
+
+		Until it is anchored a frame uses the DELTA_LAT_TO_METERS and DELTA_LON_TO_METERS constants
+		(Auburn, AL) with its origin at latitude 0, longitude 0.
+
+Date: 10/14/26
+*/
+
+#ifndef LOCAL_FRAME_H
+#define LOCAL_FRAME_H
+
+#include <math.h>
+#include "au_uav_ros/standardFuncs.h"	//coordinate, DELTA_LAT_TO_METERS, DELTA_LON_TO_METERS
+
+namespace au_uav_ros{
+
+	//meters from the anchor of a LocalFrame
+	struct localPosition{
+		double x;	//east
+		double y;	//north
+		double z;	//up
+	};
+
+	class LocalFrame{
+	public:
+		//Not anchored, see the description above
+		LocalFrame();
+		LocalFrame(double latitude, double longitude, double altitude);
+
+		/*
+		 * Use: Move the origin to this position and work out the scale there. Positions already
+		 * 		converted with the old anchor are not converted again, so anchor before collision
+		 * 		avoidance sees any telemetry.
+		 */
+		void anchor(double latitude, double longitude, double altitude);
+		bool isAnchored() const;
+		coordinate getAnchor() const;
+
+		double metersPerDegreeLatitude() const;
+		double metersPerDegreeLongitude() const;
+
+		//latitude/longitude to meters from the anchor
+		inline double toX(double longitude) const;
+		inline double toY(double latitude) const;
+		inline localPosition toLocal(const coordinate &position) const;
+
+		//meters from the anchor to latitude/longitude
+		inline double toLongitude(double x) const;
+		inline double toLatitude(double y) const;
+		coordinate toCoordinate(const localPosition &position) const;
+
+		//meters between two positions, and the cartesian angle from the first to the second in
+		//degrees on [-180, 180]
+		inline double distance(double lat1, double long1, double lat2, double long2) const;
+		inline double angle(double lat1, double long1, double lat2, double long2) const;
+
+		/*
+		 * The frame collision avoidance uses, one per process. Anchored through
+		 * CollisionAvoidance::anchorFrame, which the mover calls once with its initial position.
+		 */
+		static LocalFrame & mission();
+
+	private:
+		void setScale(double latitude);
+
+		bool anchored;
+		coordinate origin;
+		double metersPerLatitude, metersPerLongitude;		//per degree
+		double latitudePerMeter, longitudePerMeter;		//degrees
+	};
+
+
+
+	/**************************************************************************
+	 * 						Inline implementations							  *
+	 **************************************************************************
+	 * Called for every plane on every telemetry update, keep them here so they inline
+	 */
+
+	inline double LocalFrame::toX(double longitude) const{
+		return (longitude - origin.longitude)*metersPerLongitude;
+	}
+
+	inline double LocalFrame::toY(double latitude) const{
+		return (latitude - origin.latitude)*metersPerLatitude;
+	}
+
+	inline localPosition LocalFrame::toLocal(const coordinate &position) const{
+		localPosition local;
+		local.x = toX(position.longitude);
+		local.y = toY(position.latitude);
+		local.z = position.altitude - origin.altitude;
+		return local;
+	}
+
+	inline double LocalFrame::toLongitude(double x) const{
+		return origin.longitude + x*longitudePerMeter;
+	}
+
+	inline double LocalFrame::toLatitude(double y) const{
+		return origin.latitude + y*latitudePerMeter;
+	}
+
+	inline double LocalFrame::distance(double lat1, double long1, double lat2, double long2) const{
+		double x = toX(long2) - toX(long1);
+		double y = toY(lat2) - toY(lat1);
+		return sqrt(x*x + y*y);
+	}
+
+	inline double LocalFrame::angle(double lat1, double long1, double lat2, double long2) const{
+		return atan2(toY(lat2) - toY(lat1), toX(long2) - toX(long1))*180.0/PI;
+	}
+}
+
+#endif
@@ -0,0 +1,93 @@
+/*
+Description:
+		What "me" keeps about each plane that is exerting a force on it. F^2 only needs where a
+		plane is, where it is pointing, how fast it is going and when it was last heard from, so
+		that is all a NeighborState holds: a plain struct that fits in one 64 byte cache line,
+		with no paths, no map of its own and no field. Where it is, is in meters in
+		LocalFrame::mission(), converted once when the telemetry update came in.
+
+		NeighborTable is the planesToAvoid "map" of a PlaneObject. States are stored in one
+		vector indexed by plane ID, so finding, inserting, updating and removing a plane is
+		an index, and once the largest ID has been seen nothing is allocated again.
+
+Date: 10/14/26
+*/
+
+#ifndef NEIGHBOR_TABLE_H
+#define NEIGHBOR_TABLE_H
+
+#include <stddef.h>
+#include <vector>
+
+#include "au_uav_ros/LocalFrame.h"	//localPosition
+
+namespace fsquared{
+
+	struct NeighborState{
+		int id;						//plane ID, NO_NEIGHBOR marks an empty slot in a NeighborTable
+		au_uav_ros::localPosition position;	//meters in LocalFrame::mission()
+		double currentBearing;		//cardinal degrees, the enemy's field points this way
+		double targetBearing;		//cardinal degrees, bearing to the enemy's destination
+		double speed;
+		double lastUpdateTime;		//seconds, ros::Time of the telemetry update
+	};
+
+	enum { NO_NEIGHBOR = -1 };
+
+	class NeighborTable{
+	public:
+		NeighborTable();
+
+		/*
+		 * Use: Insert the plane if it is not in the table, otherwise overwrite what is there.
+		 * 		Plane IDs below zero are ignored.
+		 */
+		void update(const NeighborState &neighbor);
+
+		/* Ensure the plane is not in the table */
+		void erase(int planeID);
+
+		/* Remove every plane, keeps the memory for the next ones */
+		void clear();
+
+		/* Make room for plane IDs up to planeIDs - 1 so inserting them does not allocate */
+		void reserve(int planeIDs);
+
+		/* Returns: the plane's state, NULL if the plane is not in the table */
+		inline const NeighborState * find(int planeID) const;
+
+		bool contains(int planeID) const;
+		int size() const;		//number of planes in the table
+		bool empty() const;
+
+		/*
+		 * One more than the largest ID the table has room for. To visit every plane, in ID order:
+		 *
+		 *		for(int id = 0; id < table.idLimit(); id++)	{
+		 *			const NeighborState *neighbor = table.find(id);
+		 *			if(neighbor == NULL)
+		 *				continue;
+		 *			...
+		 *		}
+		 */
+		int idLimit() const;
+
+	private:
+		std::vector<NeighborState> slots;	//indexed by plane ID
+		int count;
+	};
+
+
+
+	/**************************************************************************
+	 * 						Inline implementations							  *
+	 **************************************************************************/
+
+	inline const NeighborState * NeighborTable::find(int planeID) const{
+		if(planeID < 0 || planeID >= (int)slots.size() || slots[planeID].id == NO_NEIGHBOR)
+			return NULL;
+		return &slots[planeID];
+	}
+}
+
+#endif
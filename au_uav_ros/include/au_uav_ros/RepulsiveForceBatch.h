@@ -0,0 +1,130 @@
+/*
+Description:
+		Batched version of fsquared::calculateRepulsiveForce. Instead of building a relative frame,
+		calling the OvalField and BivariateNormal methods and converting angles for one
+		plane at a time, the planes near "me" are loaded into contiguous arrays (structure of arrays)
+		and one pass computes, for every plane at once:
+			- "me's" position in that plane's frame (fsquared::findRelativePosition)
+			- whether that position is inside the oval (OvalField::internal_areCoordinatesInMyField)
+			- the bivariate normal magnitude (BivariateNormal::findFieldFunctionMagnitude)
+			- the repulsive force vector (fsquared::calculateRepulsiveForce)
+
+		The pass uses AVX or SSE2 on x86 and NEON on the Pi, picked at compile time from the
+		compiler's target macros, with a scalar fallback for everything else. Define
+		FSQUARED_NO_SIMD to force the scalar code. ARMv7 NEON has no double precision lanes,
+		so on ARM the arrays are floats (batchReal); build with -mfpu=neon to enable it.
+
+		Agreement with the per-plane functions (checked by src/test/fsquaredTester.cpp):
+			double lanes: relative coordinates, magnitudes and forces within 1e-9 (relative for magnitudes and forces)
+			float lanes:  relative coordinates within 1e-3m, magnitudes and forces within 1e-4 relative
+		Both OvalField and BivariateNormal truncate the relative coordinates to int, so a plane whose
+		relative coordinate is within that tolerance of a whole meter, or which sits on the edge of the
+		oval, can land on the other side of the truncation and is not covered by the bounds above.
+
+Date: 10/14/26
+*/
+
+#ifndef REPULSIVE_FORCE_BATCH_H
+#define REPULSIVE_FORCE_BATCH_H
+
+#include <vector>
+
+#include "au_uav_ros/vmath.h"
+#include "au_uav_ros/ForceField.h"	//OvalField, BivariateNormal
+
+namespace fsquared{
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+	typedef float batchReal;
+#else
+	typedef double batchReal;
+#endif
+
+	class RepulsiveForceBatch{
+	public:
+		//Uses the constants of a default constructed OvalField and BivariateNormal, the same field every PlaneObject has
+		RepulsiveForceBatch();
+		RepulsiveForceBatch(const OvalField &shape, const BivariateNormal &function);
+
+		/*
+		 * Use: Calculate field's shape and function from now on. A tabulated field is calculated
+		 * 		from the constants its tables were built from.
+		 * Returns: true if that changed the constants, the per plane results are then out of date
+		 */
+		bool setField(const AnyForceField &field);
+
+		/* Use: Empty the batch. Keeps the arrays' capacity so refilling does not allocate */
+		void clear();
+
+		/*
+		 * Use: Append one plane that exerts a field
+		 * Params:
+		 * 		planeID: carried along so results can be matched to planes
+		 * 		x, y: meters east and north of the batch origin. Any origin works, but keep it close
+		 * 			  (e.g. "me") so the float lanes on ARM keep their precision.
+		 * 		bearing: cardinal bearing of the plane in degrees, like PlaneObject::getCurrentBearing
+		 */
+		void add(int planeID, double x, double y, double bearing);
+
+		/*
+		 * Use: Replace the position and bearing of the plane in slot i, same params as add()
+		 */
+		void set(int i, double x, double y, double bearing);
+
+		/*
+		 * Use: Remove the plane in slot i by moving the last plane into its place
+		 * Returns: ID of the plane that moved into slot i, -1 if slot i was the last one
+		 */
+		int remove(int i);
+
+		int size() const;
+
+		/*
+		 * Precondition: meX, meY are in the same frame as the positions given to add()
+		 * Use: Run the vectorized pass over the whole batch
+		 * Returns: sum of the repulsive forces, same as summing calculateRepulsiveForce over the batch
+		 */
+		au_uav_ros::mathVector computeForces(double meX, double meY);
+
+		//Same as computeForces, but always runs the scalar code. Used to check the SIMD code against it.
+		au_uav_ros::mathVector computeForcesScalar(double meX, double meY);
+
+		/*
+		 * Use: Recompute only slot i, with the scalar code. The per plane results of the other
+		 * 		slots are left alone.
+		 */
+		void computeForce(int i, double meX, double meY);
+
+		//Per plane results of the last computeForces/computeForce, by slot (the order the planes were added,
+		//until remove() moves one)
+		int getPlaneID(int i) const;
+		bool isInField(int i) const;
+		double getRelativeX(int i) const;	//same as findRelativePosition().x
+		double getRelativeY(int i) const;	//same as findRelativePosition().y
+		double getMagnitude(int i) const;	//0 when the plane's field does not reach "me"
+		double getForceX(int i) const;
+		double getForceY(int i) const;
+
+		/* Name of the instruction set computeForces was built for: "AVX", "SSE2", "NEON" or "scalar" */
+		static const char * simdName();
+
+	private:
+		au_uav_ros::mathVector compute(double meX, double meY, bool useSimd);
+
+		OvalField::shapeVariables shapeParams;
+		BivariateNormal::forceVariables functionParams;
+
+		//inputs
+		std::vector<int> planeIDs;
+		std::vector<batchReal> x, y;
+		std::vector<batchReal> headingX, headingY;	//unit vector along each plane's bearing
+
+		//outputs
+		std::vector<batchReal> relativeX, relativeY;
+		std::vector<batchReal> magnitude;
+		std::vector<batchReal> forceX, forceY;
+		std::vector<unsigned char> inField;
+	};
+}
+
+#endif
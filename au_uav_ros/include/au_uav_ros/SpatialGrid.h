@@ -0,0 +1,78 @@
+/*
+Description:
+		Uniform spatial grid used by the fsquared algorithm to find the planes that are close to "me"
+		without walking every known plane. Positions are converted to meters in LocalFrame::mission(),
+		the same as PlaneObject::findDistance, and bucketed into square cells. A neighbor query only visits the cells that overlap the query radius, so the
+		cost of a query depends on how crowded the sky is near "me", not on the size of the fleet.
+
+		fsquared::updateGrid keeps it holding the planes in "me's" map. A plane was in RADAR_ZONE when
+		it reported, the query also drops the ones "me" has flown away from since, and never walks
+		the map's whole range of plane IDs.
+
+Date: 10/14/26
+*/
+
+#ifndef SPATIAL_GRID_H
+#define SPATIAL_GRID_H
+
+#include <map>
+#include <vector>
+
+#include "au_uav_ros/Fsquared.h"	//RADAR_ZONE
+
+namespace fsquared{
+
+	class SpatialGrid{
+	public:
+		/*
+		 * Params:
+		 * 		cellSize: length of one side of a grid cell in meters. Queries with a radius
+		 * 				  equal to the cell size visit at most 9 cells.
+		 */
+		SpatialGrid(double cellSize = RADAR_ZONE);
+
+		/*
+		 * Use: Insert a plane into the grid, or move it if it is already in the grid.
+		 * 		Only touches the cell lists when the plane crosses a cell boundary.
+		 */
+		void update(int planeID, double latitude, double longitude);
+
+		/*
+		 * Use: Ensure a plane is not in the grid
+		 */
+		void remove(int planeID);
+
+		/*
+		 * Use: Finds every plane within radius meters of (latitude, longitude).
+		 * Returns: IDs of the planes found. The vector is owned by the grid and is only valid until
+		 * 			the next call to findNeighbors. It is reused between calls so that steady state
+		 * 			queries do not allocate.
+		 */
+		const std::vector<int> & findNeighbors(double latitude, double longitude, double radius);
+
+		/* Number of planes tracked by the grid */
+		int size() const;
+
+		/* Remove all planes from the grid */
+		void clear();
+
+	private:
+		typedef long long cellKey;
+
+		struct member{
+			cellKey cell;
+			double x;	//meters east
+			double y;	//meters north
+		};
+
+		cellKey keyFor(int column, int row) const;
+		int cellIndex(double meters) const;
+
+		double cellSize;
+		std::map<cellKey, std::vector<int> > cells;	//planes in each occupied cell
+		std::map<int, member> members;				//where each plane is
+		std::vector<int> neighbors;					//result of the last query
+	};
+}
+
+#endif
@@ -0,0 +1,98 @@
+/*
+Description:
+		Closest point of approach prefilter, run on every plane within RADAR_ZONE before the
+		field test. From where the two planes are and where they are flying it works out the
+		time-to-go until they are closest and the zero effort miss (how far apart they will be
+		then if neither turns), and fills a threatContainer with them. Encounters that cannot
+		matter soon are dropped before any field or force math:
+			- diverging: the closest point is already behind them
+			- far future: the closest point is more than maxTimeToGo seconds away
+			- wide miss: they will pass more than maxMissDistance meters apart
+		Planes already within keepDistance are never dropped.
+
+		The planes that get through are kept, and rankThreats() orders them by urgency. Counters
+		record why planes were dropped.
+
+Date: 10/14/26
+*/
+
+#ifndef THREAT_FILTER_H
+#define THREAT_FILTER_H
+
+#include <vector>
+
+#include "au_uav_ros/standardFuncs.h"	//threatContainer
+#include "au_uav_ros/Fsquared.h"		//RADAR_ZONE
+
+#define DEFAULT_MAX_TIME_TO_GO (RADAR_ZONE/MPS_SPEED)	//seconds, time for "me" to cross the radar zone
+#define DEFAULT_MAX_MISS_DISTANCE (RADAR_ZONE/2.0)		//meters
+#define DEFAULT_KEEP_DISTANCE (2.0*COLLISION_THRESHOLD)	//meters
+
+namespace au_uav_ros{
+	class PlaneObject;
+}
+
+namespace fsquared{
+
+	struct NeighborState;
+
+	class ThreatFilter{
+	public:
+		ThreatFilter(double maxTimeToGo = DEFAULT_MAX_TIME_TO_GO, double maxMissDistance = DEFAULT_MAX_MISS_DISTANCE,
+					double keepDistance = DEFAULT_KEEP_DISTANCE);
+
+		void setMaxTimeToGo(double seconds);
+		void setMaxMissDistance(double meters);
+		void setKeepDistance(double meters);
+		double getMaxTimeToGo() const;
+		double getMaxMissDistance() const;
+		double getKeepDistance() const;
+
+		/*
+		 * Use: Time-to-go and zero effort miss of the encounter, both planes flying straight at
+		 * 		their current speed. A plane that has not reported a speed is taken to fly at MPS_SPEED.
+		 * Returns: timeToGo in seconds, negative if the planes are moving apart, 0 if they are not
+		 * 			moving relative to each other (ZEM is then the distance between them)
+		 */
+		static au_uav_ros::threatContainer assess(const au_uav_ros::PlaneObject &me, const NeighborState &enemy);
+
+		/*
+		 * Precondition: enemy is within RADAR_ZONE of "me"
+		 * Use: Assess the encounter and decide whether enemy goes on to the field test
+		 * Returns: true if enemy is kept, it is then one of the ranked threats until it is dropped or removed
+		 */
+		bool admit(const au_uav_ros::PlaneObject &me, const NeighborState &enemy);
+
+		/* Forget the plane, e.g. it left RADAR_ZONE */
+		void remove(int planeID);
+
+		/*
+		 * Returns: every plane admit() kept, most urgent (soonest closest approach, then smallest
+		 * 			miss) first. The vector is reused, it is only valid until the next call.
+		 */
+		const std::vector<au_uav_ros::threatContainer> & rankThreats();
+
+		/* Returns: the threat admit() kept for the plane, NULL if there is none */
+		const au_uav_ros::threatContainer * find(int planeID) const;
+
+		//what admit() has done since the last resetCounters()
+		long getChecked() const;		//planes assessed
+		long getAdmitted() const;
+		long getDiverging() const;		//dropped, moving apart
+		long getFarFuture() const;		//dropped, closest point too far away in time
+		long getWideMiss() const;		//dropped, will pass too far apart
+		long getDropped() const;		//all three of the above
+		void resetCounters();
+
+	private:
+		double maxTimeToGo, maxMissDistance, keepDistance;
+		std::vector<au_uav_ros::threatContainer> threats;	//indexed by plane ID, planeID is NO_NEIGHBOR if none
+		std::vector<au_uav_ros::threatContainer> ranked;	//reused by rankThreats
+		long checked, admitted, diverging, farFuture, wideMiss;
+	};
+
+	/* Returns: true if a should be dealt with before b, see rankThreats */
+	bool moreUrgent(const au_uav_ros::threatContainer &a, const au_uav_ros::threatContainer &b);
+}
+
+#endif
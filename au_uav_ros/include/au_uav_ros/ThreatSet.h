@@ -0,0 +1,103 @@
+/*
+Description:
+		Bounded version of sumRepulsiveForces for dense traffic. "Me's" map can hold any number of
+		planes, so summing all of them has no upper bound on how long it takes. A ThreatSet keeps
+		only the maxThreats most urgent planes of the map in a fixed size heap, and sums their
+		forces most urgent first until a wall clock deadline passes.
+
+		The deadline is checked while ranking as well as while summing: after every plane with
+		THREAT_BY_TIME_TO_GO and THREAT_BY_FORCE, every 16 planes with THREAT_BY_DISTANCE. Planes
+		are ranked in ID order, so when ranking is cut the heap holds the most urgent of the planes
+		ranked so far, not of the whole map. The most urgent plane in the heap is always summed,
+		so running out of time loses the least urgent forces, never all of them.
+
+		Urgency is one of:
+			- THREAT_BY_DISTANCE: closest first
+			- THREAT_BY_TIME_TO_GO: soonest closest point of approach first (ThreatFilter::assess),
+			  planes that are moving apart come last
+			- THREAT_BY_FORCE: strongest repulsive force first. Ranking needs every force, so the
+			  forces kept are not calculated again when summing.
+
+		Nothing is allocated once the heap has been filled.
+
+Date: 10/14/26
+*/
+
+#ifndef THREAT_SET_H
+#define THREAT_SET_H
+
+#include <vector>
+
+#include "au_uav_ros/vmath.h"
+
+#define DEFAULT_MAX_THREATS 8
+
+namespace au_uav_ros{
+	class PlaneObject;
+}
+
+namespace fsquared{
+
+	class NeighborTable;
+
+	enum threatPriority { THREAT_BY_DISTANCE, THREAT_BY_TIME_TO_GO, THREAT_BY_FORCE };
+
+	class ThreatSet{
+	public:
+		/*
+		 * Params:
+		 * 		maxThreats: K, the most planes summed per update, at least 1
+		 * 		priority: how urgency is decided, see above
+		 */
+		ThreatSet(int maxThreats = DEFAULT_MAX_THREATS, threatPriority priority = THREAT_BY_DISTANCE);
+
+		void setMaxThreats(int maxThreats);
+		int getMaxThreats() const;
+		void setPriority(threatPriority priority);
+		threatPriority getPriority() const;
+
+		/*
+		 * Use: Sum the repulsive forces of the maxThreats most urgent planes in planesToAvoid.
+		 * Params:
+		 * 		deadline: ros::WallTime, in seconds, after which no more forces are summed.
+		 * 				  0 for no deadline
+		 * Returns: same as sumRepulsiveForces(me, planesToAvoid), up to rounding, when the map holds
+		 * 			no more than maxThreats planes and the deadline is not reached
+		 * Time: with a deadline, the deadline plus one plane's force and up to 16 rankings. Without
+		 * 		 one, ranking still grows with the planes in the map.
+		 */
+		au_uav_ros::mathVector sumRepulsiveForces(au_uav_ros::PlaneObject &me, const NeighborTable &planesToAvoid,
+												double deadline = 0);
+
+		//what the last sumRepulsiveForces did
+		int getConsidered() const;		//planes in the map
+		int getSummed() const;			//forces in the sum
+		bool wasCut() const;			//true if the deadline stopped it
+
+		//totals since construction
+		long getDeadlinesMissed() const;	//sums the deadline cut short
+		long getThreatsDropped() const;		//planes ranked out by maxThreats or cut by the deadline
+
+		/* Parses "distance", "time_to_go" or "force", false (and priority untouched) for anything else */
+		static bool parsePriority(const char *name, threatPriority &priority);
+
+	private:
+		struct threat{
+			int planeID;
+			double urgency;			//smaller is more urgent
+			double forceX, forceY;	//only calculated while ranking with THREAT_BY_FORCE
+		};
+		static bool lessUrgent(const threat &a, const threat &b);
+		void offer(const threat &candidate);
+
+		int maxThreats;
+		threatPriority priority;
+		std::vector<threat> heap;	//max heap on urgency, the least urgent kept threat is on top
+
+		int considered, summed;
+		bool cut;
+		long deadlinesMissed, threatsDropped;
+	};
+}
+
+#endif
@@ -9,16 +9,22 @@
 //ros stuff
 #include "au_uav_ros/serial_talker.h"
 #include "au_uav_ros/mavlink_read.h"
+#include "au_uav_ros/event_loop.h"
+#include "au_uav_ros/serial_writer.h"
+#include "au_uav_ros/plane_identity.h"
 #include "ros/ros.h"
 #include "std_msgs/String.h"
 
 //custom msgs
 #include <au_uav_ros/Telemetry.h>
 #include <au_uav_ros/Command.h>
+#include <au_uav_ros/MavlinkFrame.h>
 #include <au_uav_ros/planeIDGetter.h>
 
 //mavlink stuff
 #include "mavlink/v1.0/common/mavlink.h"
+
+#define PLANE_ID_WAIT 1.0	//seconds getPlaneID waits for the first telemetry before failing, the caller asks again
 /*
  * Possible bug. Unable to contact roscore, need to put in provision?
  *
@@ -32,6 +38,10 @@ namespace au_uav_ros{
 	class ArduTalker	{
 	private:
 		SerialTalker m_ardu;			
+		au_uav_ros::mav::MavlinkReader m_ardu_in;	//after m_ardu, it reads from it
+		au_uav_ros::SerialWriter m_ardu_out;			//all writes to m_ardu go through it
+		au_uav_ros::EventLoop m_loop;
+		au_uav_ros::mav::FrameDispatcher m_dispatch;	//frames from the line, by message id
 		std::string m_port;
 		int m_baud;
 
@@ -44,10 +54,7 @@ namespace au_uav_ros{
 		int WPSendSeqNum;
 
 		//plane ID stuff.
-		int planeID;
-		boost::mutex IDSetter;
-		boost::condition_variable cond;
-		bool isIDSet;
+		au_uav_ros::PlaneIdentity identity;	//from the first telemetry with a fix, for getPlaneID
 			
 
 		//ros stuff
@@ -56,6 +63,7 @@ namespace au_uav_ros{
 		
 		ros::Publisher m_telem_pub;
 		ros::Publisher m_mav_telem_pub;
+		ros::Publisher m_mav_frame_pub;	//my AU_UAV frames as they came off the line, for xbee
 		ros::ServiceServer service;
 	public:
 		ArduTalker();
@@ -63,17 +71,21 @@ namespace au_uav_ros{
 		
 		bool init(ros::NodeHandle _n);	//Opens  and sets up port, sets up ros stuff .
 		void run();
+		void stop();		//makes listen() return, from any thread
 		void shutdown();
 	
 		//In - reading from ardu/listening
-		void listen();
+		void listen();									//waits on the line in m_loop until shutdown
+		void handleHeartbeat(const au_uav_ros::mav::FrameView &frame);
+		void handleTelemetry(const au_uav_ros::mav::FrameView &frame);	//posts AU_UAV to its topics
 
 		//Out - writing to ardu 
 		void spinThread();				//spin() and listens for myTelemCallbacks
-		void commandCallback(au_uav_ros::Command cmd);	//sends commands to ardu
+		void commandCallback(const au_uav_ros::Command::ConstPtr &cmd);	//sends commands to ardu
 
 		//Getplane ID srv
-		//Returns "me's" ID. May return -1, if id not initialized yet by ardupilot.
+		//Returns "me's" ID and the position of the ardupilot's first fix. Fails the call if there
+		//is no fix within PLANE_ID_WAIT.
 		bool getPlaneID(au_uav_ros::planeIDGetter::Request &req, 
 				au_uav_ros::planeIDGetter::Response &res); 
 	};
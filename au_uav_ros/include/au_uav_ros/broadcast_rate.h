@@ -0,0 +1,105 @@
+#ifndef AU_BROADCAST_RATE_H
+#define AU_BROADCAST_RATE_H
+/*
+ * How often a plane puts its own telemetry on the shared radio link. A plane with nobody near it
+ * sends once every slowest period (1 s), and sends every update the autopilot makes once some
+ * neighbor is inside RADAR_ZONE. In between, the period is the time the nearest neighbor could take
+ * to reach RADAR_ZONE, split into BROADCAST_UPDATES_TO_ZONE updates. That time uses the distance
+ * and the closure rate, and the closure rate is at least BROADCAST_MIN_CLOSURE, since a neighbor
+ * that is not closing now can turn. Neighbors are learned from the telemetry heard on the link,
+ * and their positions and velocities are carried forward to the time of the broadcast.
+ *
+ * On top of that, a plane has an airtime budget in bytes per second. It is spent by every byte
+ * sent and refills over time (up to one second's worth), so no neighbor can make a plane take more
+ * than its share of the link.
+ */
+
+#include <vector>
+#include <boost/thread/mutex.hpp>
+
+#include "au_uav_ros/LocalFrame.h"
+
+#define BROADCAST_SLOWEST_PERIOD 1.0	//seconds between broadcasts with nobody near
+#define BROADCAST_UPDATES_TO_ZONE 10	//broadcasts before a neighbor can reach RADAR_ZONE
+#define BROADCAST_MIN_CLOSURE MPS_SPEED	//meters/second, closure rate assumed for a neighbor not closing
+#define NEIGHBOR_TIMEOUT 5.0			//seconds, a neighbor not heard from this long is forgotten
+#define VELOCITY_BASELINE 0.5			//seconds, shortest time between the two fixes a velocity is taken from
+#define DEFAULT_AIRTIME_BUDGET (57600/10/32)	//bytes/second, a 32 plane fleet's share of a 57600 baud link
+
+namespace au_uav_ros	{
+
+	//Description:
+	//	Decides which of my telemetry updates are broadcast. Times are seconds on any clock, as
+	//	long as it is the same one for every call. Safe to call from the thread reading the link
+	//	and the one sending at once.
+	//Usage:
+	//	for every telemetry update heard from another plane:
+	//		rate.neighbor(planeID, lat, lon, alt, now);
+	//	for every update of my own:
+	//		rate.mine(lat, lon, alt, now);
+	//		if(rate.due(now))	{
+	//			send it
+	//			rate.sent(bytes, now);
+	//		}
+	class BroadcastRate	{
+	public:
+		//airtimeBudget in bytes/second, 0 for none
+		explicit BroadcastRate(int airtimeBudget = DEFAULT_AIRTIME_BUDGET, double slowestPeriod = BROADCAST_SLOWEST_PERIOD);
+
+		void setAirtimeBudget(int bytesPerSecond);
+		void setSlowestPeriod(double seconds);
+
+		void mine(double latitude, double longitude, double altitude, double now);
+		void neighbor(int planeID, double latitude, double longitude, double altitude, double now);
+
+		//Returns:
+		//	true if my update should be broadcast now: the period has passed since the last one
+		//	(less half the time between my updates, so a period of a few updates is kept to) and
+		//	the budget is not spent. A true is only counted once sent() is called.
+		bool due(double now);
+
+		//Description:
+		//	Counts a broadcast of bytes against the budget
+		void sent(int bytes, double now);
+
+		//Returns:
+		//	seconds wanted between broadcasts right now, 0 for every update
+		double period(double now);
+
+		double getNearest() const	{return nearest;}		//meters to the nearest neighbor at the last period()
+		double getClosure() const	{return closure;}		//meters/second it was closing at, below 0 if opening
+		long getSent() const	{return broadcasts;}
+		long getSkipped() const	{return skipped;}
+		long getOverBudget() const	{return overBudget;}	//skipped for the budget alone
+
+	private:
+		struct track	{
+			bool heard;
+			double heardAt;
+			localPosition position;
+			localPosition velocity;		//meters/second
+			localPosition baseline;		//the fix the next velocity is taken from
+			double baselineAt;
+		};
+
+		void fix(track &t, double latitude, double longitude, double altitude, double now);
+		double unlockedPeriod(double now);
+
+		boost::mutex lock;
+		LocalFrame frame;		//anchored at my first fix
+		track me;
+		std::vector<track> neighbors;	//by plane ID
+		int budget;
+		double slowest;
+		double credit, creditAt;	//bytes that can be sent now, below 0 after a burst
+		bool haveCreditAt;
+		double lastSent;
+		bool haveSent;
+		double updateInterval;		//seconds between my last two updates, half of it early is on time
+		double nearest, closure;
+		long broadcasts, skipped, overBudget;
+	};
+
+}//end au_uav_ros
+
+#endif
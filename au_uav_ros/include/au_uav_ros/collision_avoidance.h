@@ -3,7 +3,7 @@
 
 #include "ros/ros.h"
 
-#include <boost/thread/mutex.hpp>
+#include <vector>
 
 //Custom ros msgs
 #include "au_uav_ros/Telemetry.h"
@@ -12,28 +12,99 @@
 #include "au_uav_ros/pi_standard_defs.h"
 #include "au_uav_ros/planeObject.h"
 #include "au_uav_ros/Fsquared.h"
+#include "au_uav_ros/SpatialGrid.h"
+#include "au_uav_ros/RepulsiveForceBatch.h"
+#include "au_uav_ros/ForceAccumulator.h"
+#include "au_uav_ros/ThreatFilter.h"
+#include "au_uav_ros/ThreatSet.h"
+#include "au_uav_ros/LatencyRecorder.h"
+#include "au_uav_ros/command_snapshot.h"
 
 namespace au_uav_ros	{
 	class CollisionAvoidance	{
 	private:
 		au_uav_ros::PlaneObject me;  	//planeObject representation of the plane running this algorithm
-		au_uav_ros::Command goal_wp;
+		au_uav_ros::CommandSnapshot goal_wp;	//set by mover's GCS callback, read by avoid() without a lock
+		fsquared::SpatialGrid neighbors;	//the planes in "me's" map where they last reported, so avoid()
+											//only looks at the ones still near where "me" is now
+		fsquared::RepulsiveForceBatch forceBatch;	//arrays for the batched repulsive force pass, reused every update
+		fsquared::ForceAccumulator forces;			//cached repulsive forces, used instead of the two above in incremental mode
+		bool incremental;
+		fsquared::ThreatFilter threats;				//closest point of approach prefilter, in front of the field test
+		bool prefilter;
+		fsquared::ThreatSet threatSet;				//most urgent planes only, used instead of all of the above in bounded mode
+		bool bounded;
+		double budget;								//seconds per avoid() call, 0 for none
+		au_uav_ros::LatencyRecorder latency;		//how long each avoid() call took
 
-		boost::mutex goal_wp_lock;	//coordinate access to goal_wp 
+		/* false, with an error, if nobody has called anchorFrame() */
+		bool frameAnchored() const;
+
+		/* Takes in an update the way avoid() does, without summing the forces */
+		void remember(const au_uav_ros::Telemetry &telem);
 	public:
-		void init(int planeID);	
+		/*
+		 * forceRecomputeInterval: 0 sums the repulsive forces again on every update. Anything else
+		 * turns on incremental mode, where only the forces an update changes are recalculated and
+		 * everything is summed from scratch every forceRecomputeInterval updates.
+		 * threatPrefilter: drop planes that are moving away, or will not come close soon, before
+		 * the field test (see ThreatFilter.h).
+		 */
+		void init(int planeID, int forceRecomputeInterval = 0, bool threatPrefilter = false);	
+
+		/*
+		 * Anchors LocalFrame::mission(), the frame all of collision avoidance works in, at the
+		 * mission start. Has to be called before avoid(), the mover does it with the initial position
+		 * from getPlaneID. Anchoring again at the same point does nothing. Returns false, with an
+		 * error, if the frame is already anchored somewhere else, since the positions already
+		 * converted would then be in the wrong frame, or at 0, 0, which is a position nobody has
+		 * filled in rather than a mission start.
+		 */
+		bool anchorFrame(double latitude, double longitude, double altitude);
+
+		/*
+		 * Turns on bounded mode, which takes precedence over incremental mode: only the maxThreats
+		 * most urgent planes are summed, most urgent first, until budgetSeconds have passed since
+		 * avoid() was called (0 for no budget). maxThreats 0 turns bounded mode back off.
+		 */
+		void setThreatBound(int maxThreats, fsquared::threatPriority priority, double budgetSeconds);
+
+		/*
+		 * The field every other plane is taken to have, in every mode. Defaults to the analytic
+		 * oval and bivariate normal. The batched passes calculate a tabulated field from its constants.
+		 */
+		void setNeighborField(const AnyForceField &field);
+
 		/*
 		 * Called by mover's Telem callback. Takes in all telemetry callbacks (including my own).
 		 * Returns desired command, with bool replace field indicating wheter to queue up or replace with new CA waypoint.
 		 * If Command's lat, long, and alt fields are INVALID_GPS_COOR, it will be ignored.
+		 * It is always ignored, with an error, before anchorFrame().
 		 */
 		au_uav_ros::Command avoid(au_uav_ros::Telemetry telem);	//Called when there's a telemetry callback.
 
+		/*
+		 * Called by mover's CA worker with every update it took at once, in the order they came
+		 * in. Same command as calling avoid() on each of them in turn and keeping the last, but the
+		 * forces are only summed once, for the last update. Returns the ignored command if updates
+		 * is empty, or before anchorFrame().
+		 */
+		au_uav_ros::Command avoid(const std::vector<au_uav_ros::Telemetry> &updates);
+
 		/*
 		 * When mover receives a new GCS command, this function will be called.
 		 * Updates CA's goal waypoint to match mover's
 		 */
 		void setGoalWaypoint(au_uav_ros::Command com);
+
+		/* The prefilter, for its counters and ranked threats. Only used if init turned it on. */
+		fsquared::ThreatFilter & getThreatFilter();
+
+		/* The bounded mode threat set, for its counters. Only used if setThreatBound turned it on. */
+		const fsquared::ThreatSet & getThreatSet() const;
+
+		/* How long every avoid() call has taken */
+		const au_uav_ros::LatencyRecorder & getLatency() const;
 	};
 }
 
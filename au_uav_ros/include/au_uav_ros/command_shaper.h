@@ -0,0 +1,60 @@
+#ifndef COMMAND_SHAPER_H
+#define COMMAND_SHAPER_H
+/*
+ * Decides which of the commands collision avoidance comes up with are worth sending. avoid()
+ * returns a new waypoint for every telemetry update heard, most of them the same heading as the
+ * last one, and every command the mover publishes is a MISSION_ITEM written to the autopilot. A
+ * command only goes out if:
+ *	- it is the first one (or the first since reset())
+ *	- its heading from where "me" is differs from the last one sent by headingThreshold
+ *	- it moved positionThreshold meters from the last one sent, both from where that one was and
+ *	  in range from "me"
+ *	- an avoidance maneuver starts or ends with it
+ * A command is avoiding when its heading is more than SHAPER_AVOIDING_HEADING off the bearing to
+ * the goal waypoint: with no repulsive force F^2 flies straight at the goal.
+ *
+ * The keepalive is the mover's publish period (MOVER_PUBLISH_PERIOD), the last command sent goes
+ * out again when nothing has for that long.
+ */
+
+#include "au_uav_ros/standardFuncs.h"	//coordinate, manipulateAngle
+
+#define SHAPER_HEADING_THRESHOLD 3.0		//degrees
+#define SHAPER_POSITION_THRESHOLD 50.0		//meters
+#define SHAPER_AVOIDING_HEADING 1.0			//degrees off the goal bearing for a command to be avoiding
+
+namespace au_uav_ros	{
+
+	class CommandShaper	{
+	public:
+		CommandShaper(double headingThreshold = SHAPER_HEADING_THRESHOLD, double positionThreshold = SHAPER_POSITION_THRESHOLD);
+
+		void setHeadingThreshold(double degrees);
+		void setPositionThreshold(double meters);
+
+		//Description:
+		//	Whether command is worth sending. me is where "me" is now, goal the goal waypoint it is
+		//	flying to and command the waypoint collision avoidance wants to fly to.
+		//Returns:
+		//	true if command should be sent, it is then the last one sent
+		bool shape(const coordinate &me, const coordinate &goal, const coordinate &command);
+
+		//The next command is sent whatever it is, e.g. after the mover goes back to a green state
+		void reset();
+
+		bool isAvoiding() const;		//the last command sent was
+		long getSent() const;
+		long getSuppressed() const;
+		long getManeuvers() const;		//sent because a maneuver started or ended
+
+	private:
+		double headingThreshold, positionThreshold;
+		bool haveSent;
+		coordinate lastSent;
+		double lastRange;			//meters from "me" when lastSent was sent
+		bool avoiding;
+		long sent, suppressed, maneuvers;
+	};
+}
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef COMMAND_SNAPSHOT_H
+#define COMMAND_SNAPSHOT_H
+/*
+ * A Command shared between threads without a mutex. One thread stores it, any number load it, and
+ * nobody ever waits on anybody: a seqlock over two buffers. The writer fills the buffer readers are
+ * not pointed at, then points them at it, so a reader only has to copy again if two stores land
+ * while it is copying one buffer.
+ *
+ * A Command's header has a std::string in it, which cannot be copied while it is being written, so
+ * what is kept is every field but the header's seq and frame_id (nothing in the package reads them),
+ * plus when the telemetry behind the command came in.
+ */
+
+#include "au_uav_ros/Command.h"
+
+namespace au_uav_ros	{
+
+	//Description:
+	//	The latest Command one thread has stored, for any other thread to load. Only one thread may
+	//	store at a time (Mover::init stores before the other threads start), and only one may take().
+	//Usage:
+	//	writer:
+	//		snapshot.store(com, received);
+	//	readers:
+	//		if(snapshot.load(com))			//the latest, every time
+	//		if(snapshot.take(com, received))	//the latest, once, like popping a one command queue
+	class CommandSnapshot	{
+	public:
+		CommandSnapshot();
+
+		//received: seconds, when the telemetry behind com came in, on whatever clock the reader wants
+		void store(const au_uav_ros::Command &com, double received = 0);
+
+		//Returns:
+		//	false if nothing has been stored yet, com is left alone then
+		bool load(au_uav_ros::Command &com) const;
+
+		//Returns:
+		//	false if nothing has been stored since the last take()
+		bool take(au_uav_ros::Command &com, double &received);
+
+		long getStores() const;
+		long getRetries() const;	//copies a reader had to make again, a store landed in the middle
+
+	private:
+		struct fields	{
+			int planeID;
+			bool sim;
+			int commandID, param;
+			double latitude, longitude, altitude;
+			bool replace;
+			unsigned int stampSec, stampNsec;
+			double received;
+			long version;			//stores before this one
+		};
+
+		struct buffer	{
+			volatile unsigned int sequence;		//odd while the writer is filling it
+			fields value;
+		};
+
+		CommandSnapshot(const CommandSnapshot &);		//readers hold on to the buffers
+		CommandSnapshot & operator=(const CommandSnapshot &);
+
+		bool read(fields &out) const;
+		static void toCommand(const fields &f, au_uav_ros::Command &com);
+
+		buffer buffers[2];
+		volatile int current;		//the buffer readers copy, -1 before the first store
+		volatile long stores;
+		long taken;					//version of the last take(), only the taker touches it
+		mutable volatile long retries;
+	};
+}
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef AU_EVENT_LOOP_H
+#define AU_EVENT_LOOP_H
+/*
+ * One thread waiting on every line a node talks on, with epoll. Serial lines, UDP sockets and
+ * timers are registered with it, and it sleeps in the kernel until one of them is ready. Mavlink
+ * messages read from a line are handed to that line's handler, timers call theirs when they go off.
+ * While the lines are quiet the only wakeup is run() checking for ros shutting down every
+ * EVENT_LOOP_SHUTDOWN_CHECK_MS, so an idle node uses next to no CPU, and a message is handled as
+ * soon as the kernel wakes the thread.
+ * Every line is parsed by a FrameParser of its own, nothing is kept in mavlink's per-channel
+ * statics, so one loop can watch the autopilot, the XBee and a GCS port at once.
+ */
+
+#include <vector>
+#include <stdint.h>
+#include <boost/function.hpp>
+#include <boost/bind.hpp>	//handlers are usually made with bind
+
+#include "au_uav_ros/mavlink_read.h"
+
+#define EVENT_LOOP_MAX_EVENTS 16			//ready lines handled per wakeup
+#define EVENT_LOOP_SHUTDOWN_CHECK_MS 500	//how often run() checks for ros shutting down
+
+namespace au_uav_ros	{
+
+	typedef boost::function<void (const mavlink_message_t &)> mavlinkHandler;
+	typedef boost::function<void ()> timerHandler;
+
+	class EventLoop	{
+	public:
+		EventLoop();
+		~EventLoop();	//closes the UDP sockets and timers, not the serial lines
+
+		//Description:
+		//	Hands every message reader decodes to handler. The reader is not owned and has to stay
+		//	around until it is removed or the loop is destroyed.
+		//Returns:
+		//	an id for remove(), -1 if the line could not be watched. A line that hangs up is removed
+		//	by the loop.
+		int addSerial(au_uav_ros::mav::MavlinkReader &reader, mavlinkHandler handler);
+
+		//Description:
+		//	Hands every frame reader finds to dispatcher, in place, without copying it into a
+		//	mavlink_message_t (see mavlink_frame.h). The dispatcher is not owned either. Frames
+		//	already read when a handler removes the line are still dispatched.
+		//Returns:
+		//	an id for remove(), -1 if the line could not be watched
+		int addSerial(au_uav_ros::mav::MavlinkReader &reader, const au_uav_ros::mav::FrameDispatcher &dispatcher);
+
+		//Description:
+		//	Decodes the datagrams arriving on a bound UDP socket and hands the messages to handler.
+		//	The loop owns the socket from here on, and makes it non-blocking. Each socket gets a
+		//	FrameParser of its own, so any number of them can be watched next to serial lines.
+		//Returns:
+		//	an id for remove(), -1 if the socket could not be watched
+		int addUDP(int socket, mavlinkHandler handler);
+
+		//Description:
+		//	The same, handing the frames to dispatcher in place
+		int addUDP(int socket, const au_uav_ros::mav::FrameDispatcher &dispatcher);
+
+		//Description:
+		//	Calls handler every periodSeconds, starting periodSeconds from now. If the loop falls
+		//	behind, missed periods are not made up, handler is called once.
+		//Returns:
+		//	an id for remove(), -1 if the timer could not be made
+		int addTimer(double periodSeconds, timerHandler handler);
+
+		//Stops watching a line or timer. Can be called from a handler, including the line's own.
+		void remove(int id);
+
+		//Description:
+		//	Waits up to timeoutMs (-1 for as long as it takes) for lines to be ready and handles them.
+		//Returns:
+		//	the number of lines and timers handled, 0 on timeout, -1 if epoll failed
+		int runOnce(int timeoutMs);
+
+		//Description:
+		//	Handles lines until stop() is called or ros shuts down
+		void run();
+
+		//Makes run() return. Safe from any thread, and from a signal handler.
+		void stop();
+
+		long getWakeups() const;			//times epoll returned with something ready
+		long getMessagesDispatched() const;	//messages and frames handed to handlers
+
+	private:
+		enum sourceType { SERIAL_SOURCE, UDP_SOURCE, TIMER_SOURCE };
+		struct source	{
+			sourceType type;
+			int fd;
+			au_uav_ros::mav::MavlinkReader *reader;		//SERIAL_SOURCE
+			const au_uav_ros::mav::FrameDispatcher *dispatcher;	//handing out frames instead of messages
+			au_uav_ros::mav::FrameParser *parser;		//UDP_SOURCE, owned
+			mavlinkHandler onMessage;
+			timerHandler onTimer;
+		};
+
+		EventLoop(const EventLoop &);				//not copyable, it owns descriptors
+		EventLoop & operator=(const EventLoop &);
+
+		int add(source *watched);
+		int addUDP(int socket, source *watched);
+		void readSerial(int id);
+		void readUDP(int id);
+		void readTimer(int id);
+
+		int epollFD;
+		int stopFD;				//eventfd, written by stop()
+		bool stopped;
+		std::vector<source *> sources;			//indexed by id, NULL once removed
+		std::vector<mavlink_message_t> messages;	//decoded from one read, kept to not allocate
+		long wakeups, dispatched;
+	};
+
+}//end au_uav_ros
+
+#endif
@@ -8,6 +8,9 @@
 //ros stuff
 #include "au_uav_ros/serial_talker.h"
 #include "au_uav_ros/mavlink_read.h"
+#include "au_uav_ros/event_loop.h"
+#include "au_uav_ros/serial_writer.h"
+#include "au_uav_ros/telemetry_delta.h"
 #include "ros/ros.h"
 #include "std_msgs/String.h"
 #include <au_uav_ros/Telemetry.h>
@@ -27,6 +30,11 @@ namespace au_uav_ros{
 	class GCSTalker	{
 	private:
 		SerialTalker m_gcs;
+		au_uav_ros::mav::MavlinkReader m_gcs_in;	//after m_gcs, it reads from it
+		au_uav_ros::SerialWriter m_gcs_out;			//all writes to m_gcs go through it
+		au_uav_ros::EventLoop m_loop;
+		au_uav_ros::mav::FrameDispatcher m_dispatch;	//frames from the line, by message id
+		au_uav_ros::mav::DeltaDecoder m_decoder;		//everyone's keyframes, for their AU_UAV_DELTAs
 		std::string m_port;
 		int m_baud;
 
@@ -53,7 +61,11 @@ namespace au_uav_ros{
 		void shutdown();
 	
 		//In - reading from gcs/listening
-		void listen();
+		void listen();									//waits on the line in m_loop until shutdown
+		void handleHeartbeat(const au_uav_ros::mav::FrameView &frame);
+		void handleTelemetry(const au_uav_ros::mav::FrameView &frame);	//posts AU_UAV to its topics
+		void handleTelemetryDelta(const au_uav_ros::mav::FrameView &frame);	//posts the AU_UAV an AU_UAV_DELTA stands for
+		void publishTelemetry(const au_uav_ros::mav::FrameView &frame);
 
 		//Out - writing to ardu 
 		void spinThread();				//spin() and listens for myTelemCallbacks
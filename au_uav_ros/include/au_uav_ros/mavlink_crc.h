@@ -0,0 +1,40 @@
+#ifndef AU_MAVLINK_CRC_H
+#define AU_MAVLINK_CRC_H
+/*
+ * The mavlink checksum (X.25, also known as CRC-16/MCRF4XX: reflected polynomial 0x8408, starting
+ * at 0xFFFF) over whole buffers. checksum.h's crc_accumulate works a byte at a time with shifts;
+ * these give the same values from lookup tables, one table lookup per byte or, slicing, one per
+ * byte but 4 or 8 bytes folded in at once. The tables are built once when the program starts.
+ */
+
+#include <stdint.h>
+
+//Which one crcAccumulate() is, set with -DCRC_SLICES=...
+//	0 - checksum.h's crc_accumulate, a byte at a time
+//	1 - one table, a byte at a time
+//	4 - slice-by-4
+//	8 - slice-by-8
+#ifndef CRC_SLICES
+#define CRC_SLICES 8
+#endif
+
+namespace au_uav_ros	{
+	namespace mav	{
+
+		//Description:
+		//	Adds length bytes to crc, which starts as X25_INIT_CRC. What the frame code uses,
+		//	see CRC_SLICES.
+		//Returns:
+		//	the new crc
+		uint16_t crcAccumulate(const uint8_t *bytes, int length, uint16_t crc);
+
+		//All of them, for tests and benchmarks to compare
+		uint16_t crcBytewise(const uint8_t *bytes, int length, uint16_t crc);
+		uint16_t crcTable(const uint8_t *bytes, int length, uint16_t crc);
+		uint16_t crcSlice4(const uint8_t *bytes, int length, uint16_t crc);
+		uint16_t crcSlice8(const uint8_t *bytes, int length, uint16_t crc);
+
+	}//end mav
+}//end au_uav_ros
+
+#endif
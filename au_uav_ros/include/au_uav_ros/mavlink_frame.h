@@ -0,0 +1,166 @@
+#ifndef AU_MAVLINK_FRAME_H
+#define AU_MAVLINK_FRAME_H
+/*
+ * Mavlink frames read in place. FrameParser finds whole, checksummed frames in the bytes read off a
+ * line and hands out FrameViews that point at them where they lie in its buffer, so nothing is
+ * copied into a mavlink_message_t and then copied again by a _decode() into a struct. A frame that
+ * wraps around the end of the buffer is the one exception, it is copied once so the view is in one
+ * piece. Fields are read straight out of the payload as they are needed, AuUavView does this for
+ * our telemetry, and FrameDispatcher hands each frame to the handler for its message id.
+ */
+
+#include <stdint.h>
+#include <boost/function.hpp>
+
+#include "mavlink/v1.0/common/mavlink.h"
+
+#define READ_BUFFER_SIZE 4096		//bytes, a power of 2. About 100 AU_UAV messages
+
+namespace au_uav_ros	{
+	namespace mav	{
+
+		//Description:
+		//	A mavlink 1.0 frame as it came off the line: STX, header, payload and checksum, in one
+		//	piece. It does not own the bytes, see FrameParser::next() for how long they last.
+		//Usage:
+		//	if(frame.msgid() == MAVLINK_MSG_ID_AU_UAV)
+		//		AuUavView telemetry(frame);
+		class FrameView	{
+		public:
+			FrameView();
+			explicit FrameView(const uint8_t *frameBytes);
+
+			uint8_t length() const	{return bytes[1];}	//of the payload
+			uint8_t sequence() const	{return bytes[2];}
+			uint8_t sysid() const	{return bytes[3];}
+			uint8_t compid() const	{return bytes[4];}
+			uint8_t msgid() const	{return bytes[5];}
+			const uint8_t * payload() const	{return bytes + MAVLINK_NUM_HEADER_BYTES;}
+			uint16_t checksum() const;
+
+			const uint8_t * data() const	{return bytes;}		//the whole frame
+			int size() const	{return length() + MAVLINK_NUM_NON_PAYLOAD_BYTES;}
+
+			//Description:
+			//	Copies the frame into message, the way mavlink_parse_char leaves it, for code that
+			//	still wants a mavlink_message_t
+			void toMessage(mavlink_message_t &message) const;
+
+		private:
+			const uint8_t *bytes;
+		};
+
+		//Description:
+		//	Typed fields of an AU_UAV (id 199) frame, read from the little endian wire payload
+		//	when asked for. Names follow mavlink_au_uav_t.
+		class AuUavView	{
+		public:
+			explicit AuUavView(const FrameView &frame) : payload(frame.payload()), length(frame.length()) {}
+
+			bool valid() const	{return length >= MAVLINK_MSG_ID_AU_UAV_LEN;}	//check before reading fields
+
+			int32_t lat() const	{return field(0);}
+			int32_t lng() const	{return field(4);}
+			int32_t alt() const	{return field(8);}
+			int32_t targetLat() const	{return field(12);}
+			int32_t targetLng() const	{return field(16);}
+			int32_t targetAlt() const	{return field(20);}
+			int32_t groundSpeed() const	{return field(24);}
+			int32_t airspeed() const	{return field(28);}
+			int32_t targetBearing() const	{return field(32);}
+			int32_t distance() const	{return field(36);}
+			uint8_t targetWPIndex() const	{return payload[40];}
+
+		private:
+			int32_t field(int offset) const	{
+				const uint8_t *at = payload + offset;
+				return (int32_t)((uint32_t)at[0] | (uint32_t)at[1] << 8 | (uint32_t)at[2] << 16 | (uint32_t)at[3] << 24);
+			}
+
+			const uint8_t *payload;
+			uint8_t length;
+		};
+
+		typedef boost::function<void (const FrameView &)> frameHandler;
+
+		//Description:
+		//	Calls the handler registered for a frame's message id. Looking it up is an index into
+		//	a table, and calling it never allocates.
+		//Usage:
+		//	dispatcher.on(MAVLINK_MSG_ID_AU_UAV, boost::bind(&XbeeTalker::handleTelemetry, this, _1));
+		//	...
+		//	dispatcher.dispatch(frame);
+		class FrameDispatcher	{
+		public:
+			void on(uint8_t msgid, frameHandler handler);
+
+			//Returns:
+			//	false if nothing handles the frame's message id
+			bool dispatch(const FrameView &frame) const;
+
+		private:
+			frameHandler handlers[256];
+		};
+
+		//Description:
+		//	Keeps the bytes read off one line in a ring buffer and finds the frames in them. A
+		//	frame is only handed out once all of it is there and its checksum (with the CRC extra
+		//	byte of its message id) is right. On a bad checksum the parser looks for the next STX
+		//	from the byte after the bad frame's STX, so a frame hidden in line noise is still found.
+		//	The parser has no statics, every line can have its own.
+		//Usage:
+		//	parser.readFrom(fd);
+		//	FrameView frame;
+		//	while(parser.next(frame))
+		//		dispatcher.dispatch(frame);
+		class FrameParser	{
+		public:
+			FrameParser();
+
+			//Description:
+			//	Reads what fd has (one readv) into the free space of the buffer
+			//Returns:
+			//	bytes read, 0 if the buffer is full or nothing was there, -1 if fd could not be read
+			int readFrom(int fd);
+
+			//Description:
+			//	Copies bytes into the buffer, for bytes that did not come straight off a line
+			//Returns:
+			//	how many fitted
+			int append(const uint8_t *bytes, int length);
+
+			//Description:
+			//	Finds the next frame in the buffer. frame points into the buffer, and is good until
+			//	the next call to next(), readFrom() or append().
+			//Returns:
+			//	false if there is no whole frame yet
+			bool next(FrameView &frame);
+
+			unsigned int getBuffered() const	{return tail - head;}
+			long getFramesParsed() const	{return framesParsed;}
+			long getFramesCopied() const	{return framesCopied;}		//wrapped around the buffer
+			long getChecksumErrors() const	{return checksumErrors;}
+
+		private:
+			FrameParser(const FrameParser &);				//views point into it
+			FrameParser & operator=(const FrameParser &);
+
+			uint8_t buffer[READ_BUFFER_SIZE];
+			uint8_t wrapped[MAVLINK_MAX_PACKET_LEN];	//a frame that wrapped, in one piece
+			unsigned int head, tail;	//free running, head is the next byte to parse and tail the next free byte
+			long framesParsed, framesCopied, checksumErrors;
+		};
+
+		//Description:
+		//	Checks the checksum of a whole frame, CRC extra included, with crcAccumulate()
+		bool checkFrame(const uint8_t *frame);
+
+		//Description:
+		//	Gives a whole frame a new sequence number and the checksum that goes with it, for
+		//	frames passed on to another link as they are
+		void restampFrame(uint8_t *frame, uint8_t sequence);
+
+	}//end mav
+}//end au_uav_ros
+
+#endif
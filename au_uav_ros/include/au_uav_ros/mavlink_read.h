@@ -5,15 +5,19 @@
  * wheeee
  */
 
+#include <vector>
 #include <au_uav_ros/Telemetry.h>
 #include <au_uav_ros/Command.h>
 
 #include "ros/ros.h"
 #include "ros/console.h"
 #include "au_uav_ros/serial_talker.h"
+#include "au_uav_ros/mavlink_frame.h"
 #include "mavlink/v1.0/common/mavlink.h"
 //#include "mavlink/v1.0/ardupilotmega/mavlink.h"
 
+#define READ_POLL_TIMEOUT_MS 100	//how often MavlinkReader::next checks for ros shutting down
+
 namespace au_uav_ros	{
 	namespace mav	{
 
@@ -25,6 +29,7 @@ namespace au_uav_ros	{
 		//	Converting mavlink messages received in the ardu node so that they can be used in the
 		//	collision avoidance node
 		bool convertMavlinkTelemetryToROS(mavlink_au_uav_t &mavMessage, au_uav_ros::Telemetry &tUpdate); 
+		bool convertMavlinkTelemetryToROS(const AuUavView &mavMessage, au_uav_ros::Telemetry &tUpdate);
 
 		//Description:
 		//	This function will take a mavlink telemetry message and then set tUpdate to have the same raw,
@@ -34,6 +39,7 @@ namespace au_uav_ros	{
 		//	Passing telemetry information received from ardu node to the xbee node so that the telemetry
 		//	information of the running plane can be passed to other planes
 		bool rawMavlinkTelemetryToRawROSTelemetry(mavlink_au_uav_t &mavMessage, au_uav_ros::Telemetry &tUpdate);
+		bool rawMavlinkTelemetryToRawROSTelemetry(const AuUavView &mavMessage, au_uav_ros::Telemetry &tUpdate);
 
 
 
@@ -48,12 +54,62 @@ namespace au_uav_ros	{
 
 
 		//Description:
-		//	This function will listen in on the serial line provided by SerialTalker and will continue to
-		//	do so until a mavlink message can be decoded. Once a message is decoded, it will be returned
+		//	Reads mavlink messages from the serial line provided by SerialTalker. Instead of reading one
+		//	byte per read() call, it waits for the line to have data and then takes everything that is
+		//	there (up to READ_BUFFER_SIZE bytes) in one call, into the ring buffer of a FrameParser
+		//	(mavlink_frame.h). Frames are found in the buffer, so a burst of messages costs one read()
+		//	instead of one per byte. No lock is taken, the line is full duplex and writes go through a
+		//	SerialWriter (serial_writer.h).
+		//
+		//	readFrames() hands out the frames in place. next() and readMessages() copy each one into a
+		//	mavlink_message_t, for code that wants those.
 		//Usage:
-		//	Use to obtain a command/telemetry update from a serial line
-		mavlink_message_t readMavlinkFromSerial(SerialTalker &serialIn);
-	
+		//	One reader per serial line, owned by the talker node that listens on it:
+		//		mavlink_message_t message;
+		//		while(ros::ok())
+		//			if(reader.next(message))
+		//				...
+		class MavlinkReader	{
+		public:
+			MavlinkReader(SerialTalker &serialIn);
+
+			//Description:
+			//	Blocks until a message can be decoded and puts it in message. Messages already in
+			//	the buffer are returned without reading the line.
+			//Returns:
+			//	false if ros shut down before a message arrived
+			bool next(mavlink_message_t &message);
+
+			//Description:
+			//	Waits up to timeoutMs for the line to have data, reads what is there once, and appends
+			//	every complete message in the buffer to messages. Bytes of a message that has not
+			//	finished arriving are kept for the next call.
+			//Returns:
+			//	the number of messages appended, -1 if the line could not be read
+			int readMessages(std::vector<mavlink_message_t> &messages, int timeoutMs);
+
+			//Description:
+			//	readMessages without the copies: every complete frame is handed to dispatcher as it
+			//	lies in the buffer. Nothing is allocated.
+			//Returns:
+			//	the number of frames found, handled or not, -1 if the line could not be read
+			int readFrames(const FrameDispatcher &dispatcher, int timeoutMs);
+
+			int getFD();	//the line being read, for waiting on it with epoll (see event_loop.h)
+			long getBytesRead() const;
+			long getReadCalls() const;		//read() calls that returned data
+			long getMessagesDecoded() const;
+			long getFramesCopied() const;	//had to be copied to be in one piece
+			long getChecksumErrors() const;
+
+		private:
+			int fill(int timeoutMs);	//bytes read, 0 on timeout, -1 on error
+
+			SerialTalker &serial;
+			FrameParser parser;
+			long bytesRead, readCalls;
+		};
+
 	}//end mav
 }//end au_uav_ros
 
@@ -3,13 +3,16 @@
 #define MOVER_H 
 
 
-#include <queue>
-#include <boost/thread/mutex.hpp>
 #include <boost/thread.hpp>
 
 //collision avoidance library
 #include "au_uav_ros/collision_avoidance.h"
 #include "au_uav_ros/planeObject.h"
+#include "au_uav_ros/mover_schedule.h"
+#include "au_uav_ros/command_shaper.h"
+#include "au_uav_ros/telemetry_mailbox.h"
+#include "au_uav_ros/command_snapshot.h"
+#include "au_uav_ros/LatencyRecorder.h"
 
 #include "au_uav_ros/planeIDGetter.h"
 
@@ -27,24 +30,34 @@ namespace au_uav_ros	{
 		private:
 			bool is_testing;
 			
-			//Meta - State Machine fun. NOte - State is changed by gcs_command callback.
-			enum state {ST_RED, ST_GREEN_CA_ON, ST_GREEN_CA_OFF};	
-			enum state current_state; 
-			boost::mutex state_change_lock;			//Both gcs_command callback and move() need to FIGHT TO THE DEATH
+			//Meta - State Machine fun. The state and the wakeups of move() live here, both callbacks wake it.
+			MoverSchedule schedule;
 
-			//Collision Avoidance fun
+			//Collision Avoidance fun. Only the CA worker calls avoid(), the callback leaves it the
+			//newest telemetry from every plane in the mailbox.
 			CollisionAvoidance ca;
+			TelemetryMailbox telem_mailbox;
+			double ca_min_period;				//seconds, shortest time between avoid() passes
+			au_uav_ros::LatencyRecorder data_age;	//oldest update each avoid() pass used, posted to decided
+			long ca_passes;
 
 			int planeID;					//current plane id
 			float initialLong, initialLat, initialAlt;	//First telemetry update, used to initialize goal_wp
 			
-			//Queues for Waypoints
-			au_uav_ros::Command goal_wp;			//store goal wp from Ground control 
-			std::deque<au_uav_ros::Command> ca_wp;	 	//store collision avoidance waypoints 
-
-			//Locks for Queues
-			boost::mutex goal_wp_lock;
-			boost::mutex ca_wp_lock;
+			//Waypoints. No locks, no thread ever waits on another for them (see command_snapshot.h)
+			CommandSnapshot goal_wp;				//store goal wp from Ground control 
+			CommandSnapshot ca_wp;					//store collision avoidance waypoint, taken by move(). Received
+													//is the ros::WallTime the newest telemetry behind it came in
+			au_uav_ros::Command::Ptr last_ca;		//sent again when there is nothing new, NULL until the first
+			au_uav_ros::LatencyRecorder command_latency;	//all_telem_callback to ca_commands publish
+
+			//Which of avoid()'s commands are worth sending, only the CA worker uses it. The GCS callback
+			//sets reset_shaper and the worker resets it before its next command.
+			CommandShaper shaper;
+			volatile int reset_shaper;
+			bool shape_commands;
+			au_uav_ros::coordinate my_position;		//from my own telemetry
+			bool have_my_position;
 
 			//ROS stuff
 			ros::NodeHandle nh;
@@ -53,36 +66,54 @@ namespace au_uav_ros	{
 			ros::Subscriber my_telem_sub;	//Subscribe to just me telemetry (in raw mav format)
 			ros::Subscriber all_telem;	//Subscribe to all telemetry msgs (me and other planes)
 			ros::Subscriber gcs_commands;	//Subscribe to commands from Ground control
+			volatile int running;			//0 once stop() is called, init()'s wait, move() and the CA worker return,
+											//__sync builtins since stop() is called from another thread
+			bool isRunning();
 
 			/*
 			 * Callback for any incoming telemetry msg (including my own).
-			 * Updates my position if it's my telemetry.
-			 * Calls CollisionAvoidance's avoid() function.
-			 * Replaces or queues up avoid()'s returned command.
+			 * Posts it to the CA worker's mailbox, nothing else, so the subscriber queue never backs up
+			 * behind avoid().
 			 */
-			void all_telem_callback(au_uav_ros::Telemetry telem);
+			void all_telem_callback(const au_uav_ros::Telemetry::ConstPtr &telem);
 
 			
 			/*
 			 * callback for any ground control commands.
 			 * Replaces current goal wp with incoming command.
 			 */ 
-			void gcs_command_callback(au_uav_ros::Command com);
+			void gcs_command_callback(const au_uav_ros::Command::ConstPtr &com);
+
+			//the shaper's view of a command and of goal_wp
+			static au_uav_ros::coordinate commandCoordinate(const au_uav_ros::Command &com);
+			au_uav_ros::coordinate goalCoordinate();
 
 			//thread stuff, calls ros::spin()
 			void spinThread();
 
+			/*
+			 * CA worker thread. Takes every plane's newest telemetry from the mailbox, calls
+			 * CollisionAvoidance's avoid() over all of it at once, and replaces the queued CA command
+			 * with the result if the shaper lets it through. Updates my position from my telemetry.
+			 */
+			void caThread();
+			void reportCA();
+
 			//main decision making logic
 			void move();
 
-			//OK you can publish CA commands (ST_GREEN_CA_ON).
+			//OK you can publish CA commands (ST_GREEN_CA_ON). The newest one, or the last one again.
 			void caCommandPublish();
 			//OK you can publish goal commands, ignore CA. (ST_GREEN_CA_OFF).
 			void goalCommandPublish();
 		public:
+			Mover();
 			int getPlaneID() {return planeID;} 
 			bool init(ros::NodeHandle n, bool testing);
-			void run();
+			void run();		//work() with its own spinner thread, for the mover node
+			void work();	//the CA worker and move(), until stop() or ROS shuts down. Callbacks are left to
+							//whoever spins nh's queue, the nodelet manager in a nodelet
+			void stop();	//from any thread
 
 	};
 }	
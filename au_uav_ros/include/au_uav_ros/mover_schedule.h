@@ -0,0 +1,70 @@
+#ifndef MOVER_SCHEDULE_H
+#define MOVER_SCHEDULE_H
+/*
+ * When the mover publishes to ca_commands. The mover's thread sleeps on a condition variable in
+ * wait() and is woken by the callbacks, instead of spinning: in ST_RED it sleeps until the GCS
+ * changes the state, in the green states until a new CA or goal command is ready or the publish
+ * period runs out with nothing new (then the last command goes out again, so the ardupilot keeps
+ * hearing from us). CommandShaper only lets through commands that change something, so the publish
+ * period is a keepalive, not how often the ardupilot hears what to do. A new command goes out as soon as it is ready, but never sooner than the
+ * minimum command interval after the last one, no swamping the ardupilot.
+ */
+
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#define MOVER_PUBLISH_PERIOD 2.0			//seconds, a command at least this often in the green states (keepalive)
+#define MOVER_MIN_COMMAND_INTERVAL 0.25		//seconds, no two commands closer than this, as often as move() used to publish
+#define MOVER_SHUTDOWN_CHECK 0.5			//seconds, longest wait() sleeps before move() checks ros::ok()
+
+namespace au_uav_ros	{
+
+	//Meta - State Machine fun. Note - State is changed by gcs_command callback.
+	enum moverState {ST_RED, ST_GREEN_CA_ON, ST_GREEN_CA_OFF};
+
+	class MoverSchedule	{
+	public:
+		enum wakeReason {
+			WAKE_STATE,		//the state changed, nothing to publish yet
+			WAKE_COMMAND,	//a new command is ready
+			WAKE_DEADLINE,	//the publish period ran out, publish the last command again
+			WAKE_TIMEOUT	//maxWait went by, nothing to do
+		};
+
+		MoverSchedule(double publishPeriod = MOVER_PUBLISH_PERIOD, double minCommandInterval = MOVER_MIN_COMMAND_INTERVAL);
+
+		void setPublishPeriod(double seconds);
+		void setMinCommandInterval(double seconds);
+
+		//Description:
+		//	Called by the callbacks, both wake wait() up
+		void setState(moverState s);
+		void commandReady();
+
+		moverState getState();		//without the lock, never waits on the callbacks or wait()
+
+		//Description:
+		//	Sleeps until there is something to do or maxWait seconds have gone by. A command ready in
+		//	ST_RED is dropped, the green states start from whatever is newest.
+		//Returns:
+		//	why it woke up, and the state to publish in. The publish period and the minimum command
+		//	interval count from the last WAKE_COMMAND or WAKE_DEADLINE.
+		wakeReason wait(moverState &s, double maxWait);
+
+		long getWakeups() const	{return wakeups;}	//returns from wait(), timeouts included
+
+	private:
+		boost::mutex lock;
+		boost::condition_variable wakeup;
+		moverState state;
+		volatile int currentState;		//state, for getState()
+		bool stateChanged;
+		bool pending;					//a new command is ready
+		boost::posix_time::ptime lastPublished;	//not_a_date_time until the first
+		boost::posix_time::time_duration period, minInterval;
+		long wakeups;
+	};
+}
+
+#endif
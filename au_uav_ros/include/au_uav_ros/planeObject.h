@@ -3,7 +3,6 @@
 #ifndef PLANE_OBJECT_H
 #define PLANE_OBJECT_H
 
-#include <map>
 #include <list>
 #include "au_uav_ros/Telemetry.h"
 #include "au_uav_ros/Command.h"
@@ -11,6 +10,8 @@
 #include "au_uav_ros/standardFuncs.h"
 #include "au_uav_ros/Fsquared.h"
 #include "au_uav_ros/ForceField.h"
+#include "au_uav_ros/NeighborTable.h"
+#include "au_uav_ros/LocalFrame.h"
 
 namespace au_uav_ros {
 
@@ -45,6 +46,7 @@ namespace au_uav_ros {
             int getID(void) const;
             au_uav_ros::coordinate getPreviousLoc(void) const;
             au_uav_ros::coordinate getCurrentLoc(void) const;
+            au_uav_ros::localPosition getLocalPosition(void) const;	/* current location in LocalFrame::mission() */
             double getTargetBearing(void) const;
             double getCurrentBearing(void) const;
             double getSpeed(void) const;
@@ -84,30 +86,42 @@ namespace au_uav_ros {
             *************************************************************************************************/
 
             /*Field Accessor, will return the plane's field*/
-            ForceField getField();
+            const AnyForceField & getField() const;
 
-            /*This method will adjust the field of the plane to specificiations provided by the arguements*/
+            /*This method will adjust the field of the plane to specificiations provided by the arguements.
+             *Codes are from fieldShapeCode and fieldFunctionCode in ForceField.h*/
             void setField(int encodedFieldShape, int encodedFieldFunction);
 
             /*This method will adjust the field of the plane to a specific field*/
-            void setField(ForceField  newField);
+            void setField(const AnyForceField &newField);
+
+            /*Field of every plane in this plane's planesToAvoid map. They are NeighborStates and carry
+             *no field of their own, so they all get this one, the default AnyForceField unless changed*/
+            const AnyForceField & getNeighborField() const;
+            void setNeighborField(const AnyForceField &newField);
 
 
 	    //Note = map setters and getters are NOT guaranteed to be thread safe.  
 
 	    /*Accessor method for planesToAvoid map */
-            std::map<int, au_uav_ros::PlaneObject> & getMap();
+            fsquared::NeighborTable & getMap();
 
             /* If the plane is not in the map, add it
              * If the plane is in the map, update it
+             * Only the plane's NeighborState is kept, not the PlaneObject
              */
-            void planeIn_updateMap(au_uav_ros::PlaneObject plane);
+            void planeIn_updateMap(const au_uav_ros::PlaneObject &plane);
+            void planeIn_updateMap(const fsquared::NeighborState &plane);
 
 	    /* Clears plane's planesToAvoid map. */
 	    void clearMap();
 
             /* Ensure plane is not in the map */
             void planeOut_updateMap(au_uav_ros::PlaneObject &plane);
+            void planeOut_updateMap(int planeID);
+
+            /* What this plane looks like from another plane's planesToAvoid map */
+            fsquared::NeighborState toNeighborState() const;
 
         private:
             /* Private data members */
@@ -122,10 +136,11 @@ namespace au_uav_ros {
             au_uav_ros::waypoint destination;
             au_uav_ros::waypoint tempForceWaypoint; //temporary destination waypoint that is generated from
             										//the fsquared algorithm
-            std::map<int, au_uav_ros::PlaneObject>  planesToAvoid; //Planes whose fields "me" is in
+            fsquared::NeighborTable  planesToAvoid; //Planes whose fields "me" is in
         							 	//and are exerting a force on "me"
 
-            ForceField  planeField;		/*Object that handles APF calls*/
+            AnyForceField  planeField;		/*Object that handles APF calls, held by value*/
+            AnyForceField  neighborField;	/*what every plane in planesToAvoid exerts*/
             std::list <au_uav_ros::waypoint> normalPath;
             std::list <au_uav_ros::waypoint> avoidancePath;
 
@@ -0,0 +1,49 @@
+#ifndef PLANE_IDENTITY_H
+#define PLANE_IDENTITY_H
+/*
+ * What ardu's getPlaneID service answers with: the plane ID and where the mission starts, both from
+ * the ardupilot's first telemetry with a GPS fix. The mover anchors collision avoidance's local frame
+ * at that position, so telemetry at 0, 0 (no fix yet) is not taken for it.
+ */
+
+#include <boost/thread.hpp>
+#include <au_uav_ros/Telemetry.h>
+#include <au_uav_ros/planeIDGetter.h>
+
+namespace au_uav_ros	{
+
+	//Description:
+	//	Set once by ardu's listener thread, waited on by getPlaneID on a service thread.
+	//Usage:
+	//	listener:
+	//		if(!identity.isSet())
+	//			identity.set(sysid, telemetry);
+	//	service:
+	//		return identity.wait(res, PLANE_ID_WAIT);
+	class PlaneIdentity	{
+	public:
+		PlaneIdentity();
+
+		//Returns:
+		//	true if this was the first fix, false if the ID was already set or telem is at 0, 0
+		bool set(int id, const au_uav_ros::Telemetry &telem);
+
+		//Description:
+		//	Fills in res's planeID and initial position once set() has been called, waiting at most
+		//	seconds for it.
+		//Returns:
+		//	false, res left alone, if there was no fix by then
+		bool wait(au_uav_ros::planeIDGetter::Response &res, double seconds);
+
+		bool isSet();
+
+	private:
+		boost::mutex lock;
+		boost::condition_variable changed;
+		bool identified;
+		int planeID;
+		double latitude, longitude, altitude;
+	};
+}
+
+#endif
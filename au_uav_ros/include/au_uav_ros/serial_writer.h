@@ -0,0 +1,131 @@
+#ifndef AU_SERIAL_WRITER_H
+#define AU_SERIAL_WRITER_H
+/*
+ * Sends mavlink frames on a serial line from a thread of its own. Any thread hands a frame to
+ * send(), which copies it into a fixed size queue and returns without touching the line or taking
+ * a lock. The writer thread takes every frame waiting (up to TX_COALESCE_FRAMES) and puts them on
+ * the line with one writev(). A write blocked on a slow radio only holds up the writer thread,
+ * never the thread reading the line or the callback that made the frame.
+ *
+ * Each priority class has a queue of its own, and the writer always takes from the most urgent
+ * class with frames waiting, so an avoidance command never waits behind routine telemetry that was
+ * queued before it. Commands are kept in order: a full command queue drops the new frame. Telemetry
+ * goes stale, so a full telemetry queue drops the oldest frame to make room.
+ *
+ * A queue is a bounded ring of slots. Each slot has a sequence number that says whose turn it is:
+ * a sender claims a slot by moving the tail forward with compare and swap, fills it, and then sets
+ * its sequence to hand it over. Frames are taken by moving the head forward the same way, which
+ * lets a sender take the oldest frame off a full telemetry queue while the writer takes from it too.
+ *
+ * On a slow radio the kernel's output buffer would soak up kilobytes of telemetry that a command
+ * then has to wait behind, so priorities mean nothing once the frames are in it. setLinkRate()
+ * paces the writer to the speed of the link, so at most TX_BURST_BYTES and one frame are ever
+ * ahead of a new command.
+ */
+
+#include <stdint.h>
+#include <boost/thread.hpp>
+
+#include "au_uav_ros/serial_talker.h"
+#include "mavlink/v1.0/common/mavlink.h"
+
+#define DEFAULT_TX_QUEUE_FRAMES 64	//a power of 2
+#define TX_COALESCE_FRAMES 16		//most frames put in one writev()
+#define TX_BURST_BYTES 64			//bytes a paced writer may write ahead of the link
+
+namespace au_uav_ros	{
+
+	//Priority classes, most urgent first
+	enum txPriority	{
+		TX_SAFETY,		//avoidance commands
+		TX_MISSION,		//other commands
+		TX_TELEMETRY,	//drops the oldest when full
+		TX_PRIORITIES
+	};
+
+	class SerialWriter	{
+	public:
+		//queueFrames is for each priority class, rounded up to a power of 2
+		SerialWriter(SerialTalker &serialOut, int queueFrames = DEFAULT_TX_QUEUE_FRAMES);
+		~SerialWriter();	//stops the writer thread
+
+		//Description:
+		//	Starts the writer thread, after the line is open. Frames sent before this wait in the queue.
+		//Returns:
+		//	false if it could not be started
+		bool start();
+
+		//Description:
+		//	Paces the writer to a link that takes bytesPerSecond (baud/10 for 8N1), before start().
+		//	0, the default, writes as fast as the line takes it.
+		void setLinkRate(int bytesPerSecond);
+
+		//Description:
+		//	Writes out the frames still queued and stops the writer thread, before the line is closed
+		void stop();
+
+		//Description:
+		//	Queues a message, or a frame already packed by mavlink_msg_to_send_buffer. Safe from any
+		//	number of threads at once, never blocks.
+		//Returns:
+		//	false if the queue was full and the frame was dropped. A telemetry frame that pushed
+		//	out an older one returns true.
+		bool send(const mavlink_message_t &message, txPriority priority = TX_MISSION);
+		bool send(const uint8_t *frame, int length, txPriority priority = TX_MISSION);
+
+		//All classes together
+		long getFramesSent() const;		//written to the line
+		long getFramesDropped() const;	//queue was full
+		long getWriteCalls() const;		//writev() calls, fewer than frames when they are coalesced
+
+		//One class
+		long getFramesSent(txPriority priority) const;
+		long getBytesSent(txPriority priority) const;
+		long getFramesDropped(txPriority priority) const;	//the new frame, or the oldest for telemetry
+
+	private:
+		struct slot	{
+			volatile unsigned int sequence;
+			int length;
+			uint8_t frame[MAVLINK_MAX_PACKET_LEN];
+		};
+
+		struct queue	{
+			slot *slots;
+			volatile unsigned int tail;	//next slot a sender claims
+			volatile unsigned int head;	//next slot taken, by the writer or a sender dropping the oldest
+			bool dropOldest;
+			volatile long framesSent, bytesSent, framesDropped;
+		};
+
+		SerialWriter(const SerialWriter &);				//not copyable, it owns a thread
+		SerialWriter & operator=(const SerialWriter &);
+
+		slot * take(queue &q, unsigned int &pos);		//NULL if empty, release() the slot after
+		void release(slot *taken, unsigned int pos);
+		bool ready(queue &q);
+		void writeLoop();
+		int writeOut();		//frames taken from the queues and written, 0 if they were empty
+		void waitForFrames();
+		void waitForLink();
+		void wake();
+
+		SerialTalker &serial;
+		queue queues[TX_PRIORITIES];
+		unsigned int mask;			//slots in each queue - 1
+		volatile int sleeping;		//1 while the writer waits on wakeFD
+		int wakeFD;					//eventfd, written when a frame is queued while the writer sleeps
+		volatile int running;
+		boost::thread *writer;
+
+		//pacing, only the writer thread touches these once it has started
+		int linkRate;				//bytes per second, 0 if not paced
+		double credit;				//bytes the link can take now, below 0 while it catches up
+		double creditAt;			//when credit was worked out
+
+		volatile long writeCalls;
+	};
+
+}//end au_uav_ros
+
+#endif
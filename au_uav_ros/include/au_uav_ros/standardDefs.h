@@ -66,8 +66,7 @@ bool isValidYesNo(char c);
 
 /*
 distanceBetween(...)
-Returns the distance in meters between the two waypoints provided.  Note that it does take into account
-the earth's curvature.
+Returns the distance in meters between the two waypoints provided, measured in LocalFrame::mission().
 */
 double distanceBetween(struct au_uav_ros::waypoint first, struct au_uav_ros::waypoint second);
 
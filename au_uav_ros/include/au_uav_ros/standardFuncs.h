@@ -6,7 +6,8 @@ throughout the code. Note: All angles are in degrees. */
 #ifndef STANDARD_FUNCS
 #define STANDARD_FUNCS
 
-/* Constants for converting latitude/longitude to meters */
+/* Constants for converting latitude/longitude to meters near Auburn, AL. Collision avoidance
+converts with au_uav_ros::LocalFrame::mission(), which only uses these until it is anchored */
 #define DELTA_LAT_TO_METERS 111200
 #define DELTA_LON_TO_METERS 93670
 
@@ -62,12 +63,12 @@ double manipulateAngle(double angle);
 
 /* Returns the distance between two points of latitude and longitude in meters.  The first two parameters
 are the latitude and longitude of the starting point, and the last two parameters are the latitude and
-longitude of the ending point. */
+longitude of the ending point. Measured in LocalFrame::mission(). */
 double findDistance(double lat1, double long1, double lat2, double long2);
 
 /* Returns the Cartesian angle between two points of latitude and longitude in degrees.  The starting point
 is given by lat1 and long1 (the first two parameters), and the final point is given by lat2 and long2 (the
-final two parameters). The value returned is on the interval [-180, 180]. */
+final two parameters). The value returned is on the interval [-180, 180]. Measured in LocalFrame::mission(). */
 double findAngle(double lat1, double long1, double lat2, double long2);
 
 /* Returns the sign of the double. */
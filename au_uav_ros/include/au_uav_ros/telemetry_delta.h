@@ -0,0 +1,105 @@
+#ifndef AU_TELEMETRY_DELTA_H
+#define AU_TELEMETRY_DELTA_H
+/*
+ * Compact telemetry for the XBee link. Most of an AU_UAV does not change from one update to the
+ * next, the target and waypoint index only change at a waypoint and the position moves by a few
+ * meters. A plane sends a whole AU_UAV now and then (the keyframe), and in between an AU_UAV_DELTA
+ * (id 200) with only the fields that are different from the keyframe, each as an int16_t. lat and
+ * lng are rounded to DELTA_POSITION_STEP, everything else is exact. The differences are always from
+ * the keyframe and never from the update before, so a lost AU_UAV_DELTA costs only itself. A lost
+ * keyframe is found from au_key_seq, and the AU_UAV_DELTAs after it are dropped until the next one.
+ */
+
+#include <stdint.h>
+
+#include "au_uav_ros/mavlink_frame.h"
+
+#define DELTA_KEYFRAME_INTERVAL 10	//updates, a keyframe at least this often
+#define DELTA_POSITION_STEP 10		//1E-7 degrees, about 11 cm of latitude. At most half of it is lost
+
+namespace au_uav_ros	{
+	namespace mav	{
+
+		//The fields an AU_UAV_DELTA can have, in the order they are packed. Bit i of au_changed
+		//is field i.
+		enum deltaField	{
+			DELTA_LAT, DELTA_LNG, DELTA_ALT, DELTA_GROUND_SPEED, DELTA_AIRSPEED,
+			DELTA_TARGET_BEARING, DELTA_DISTANCE, DELTA_FIELDS
+		};
+
+		//Description:
+		//	Turns one plane's AU_UAV frames into what is sent for them: the AU_UAV itself as a
+		//	keyframe every keyframeInterval updates, or when the target or waypoint index changed or
+		//	a field moved too far for an int16_t, and an AU_UAV_DELTA otherwise. Every frame put out
+		//	gets the encoder's own sequence number, au_key_seq is the keyframe's.
+		//Usage:
+		//	One per plane, in the node that sends its telemetry on:
+		//		uint8_t out[MAVLINK_MAX_PACKET_LEN];
+		//		int length = encoder.encode(frame, out);
+		//		if(length > 0)
+		//			writer.send(out, length, TX_TELEMETRY);
+		class DeltaEncoder	{
+		public:
+			explicit DeltaEncoder(int keyframeInterval = DELTA_KEYFRAME_INTERVAL);
+
+			//Returns:
+			//	bytes put in out (at most MAVLINK_MAX_PACKET_LEN), 0 if frame is not an AU_UAV
+			int encode(const FrameView &frame, uint8_t *out);
+
+			long getKeyframes() const	{return keyframes;}
+			long getDeltas() const	{return deltas;}
+
+		private:
+			int keyframeInterval;
+			uint8_t key[MAVLINK_MSG_ID_AU_UAV_LEN];		//payload of the last keyframe
+			bool haveKey;
+			uint8_t keySequence;
+			uint8_t sequence;
+			int sinceKey;		//updates sent since the keyframe
+			long keyframes, deltas;
+		};
+
+		//Description:
+		//	Keeps the last keyframe of every plane, by system id, and turns an AU_UAV_DELTA back
+		//	into the AU_UAV it stands for. Every AU_UAV that comes in has to be shown to keyframe(),
+		//	whether it came from a plane sending AU_UAV_DELTAs or not.
+		//Usage:
+		//	dispatcher.on(MAVLINK_MSG_ID_AU_UAV, ...)	//decoder.keyframe(frame), then use frame
+		//	dispatcher.on(MAVLINK_MSG_ID_AU_UAV_DELTA, ...)
+		//		uint8_t rebuilt[MAVLINK_MAX_PACKET_LEN];
+		//		if(decoder.rebuild(frame, rebuilt))
+		//			AuUavView telemetry(FrameView(rebuilt));
+		class DeltaDecoder	{
+		public:
+			DeltaDecoder();
+
+			//Description:
+			//	Remembers an AU_UAV as its plane's keyframe
+			void keyframe(const FrameView &frame);
+
+			//Description:
+			//	Puts the whole AU_UAV frame an AU_UAV_DELTA stands for in out, with the
+			//	AU_UAV_DELTA's sequence number, system and component ids, and checksummed
+			//Returns:
+			//	false if its keyframe was not seen (lost, or from before the last one) or the
+			//	frame is cut off, then out is left alone
+			bool rebuild(const FrameView &delta, uint8_t *out);
+
+			long getRebuilt() const	{return rebuilt;}
+			long getDropped() const	{return dropped;}
+
+		private:
+			struct plane	{
+				bool seen;
+				uint8_t sequence;
+				uint8_t payload[MAVLINK_MSG_ID_AU_UAV_LEN];
+			};
+
+			plane planes[256];
+			long rebuilt, dropped;
+		};
+
+	}//end mav
+}//end au_uav_ros
+
+#endif
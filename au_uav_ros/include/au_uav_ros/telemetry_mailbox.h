@@ -0,0 +1,77 @@
+#ifndef TELEMETRY_MAILBOX_H
+#define TELEMETRY_MAILBOX_H
+/*
+ * Where all_telem_callback leaves telemetry for the mover's CA worker. Every plane has one slot
+ * holding its newest update, indexed by plane ID like NeighborTable, so posting is an index and a
+ * copy no matter how far behind the worker is. An update posted before the worker took the last
+ * one from the same plane replaces it (counted as overwritten): collision avoidance only wants
+ * where a plane is now, and a burst of updates turns into one per plane.
+ */
+
+#include <vector>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+#include "au_uav_ros/Telemetry.h"
+
+namespace au_uav_ros	{
+
+	struct mailboxEntry	{
+		au_uav_ros::Telemetry telem;
+		double received;		//seconds, when the newest update from this plane was posted
+	};
+
+	//Description:
+	//	Latest-value mailbox between the callbacks and the CA worker. Times are seconds on any
+	//	clock, as long as it is the same one for every call. post() and take() may be called from
+	//	different threads at once.
+	//Usage:
+	//	callback:
+	//		mailbox.post(telem, now);
+	//	worker:
+	//		if(mailbox.take(updates, maxWait) > 0)
+	//			avoid over updates
+	class TelemetryMailbox	{
+	public:
+		TelemetryMailbox();
+
+		//Description:
+		//	Puts telem in its plane's slot, replacing any update from that plane not taken yet,
+		//	and wakes take(). Plane IDs below zero are ignored.
+		void post(const au_uav_ros::Telemetry &telem, double received);
+
+		//Description:
+		//	Sleeps until something is posted, stop() is called or maxWait seconds have gone by.
+		//Returns:
+		//	the number of updates in updates: every plane posted since the last take, in the order
+		//	the planes were first posted, each with its newest update. 0 on a timeout or once stopped.
+		int take(std::vector<mailboxEntry> &updates, double maxWait);
+
+		//Description:
+		//	Wakes take() for good, for shutting the worker down
+		void stop();
+
+		int getDepth();				//planes waiting to be taken
+		int getMaxDepth();			//most planes ever waiting at once
+		long getPosted();
+		long getOverwritten();		//updates replaced before they were taken
+		long getTakes();			//returns from take() with updates
+		long getTaken();			//updates returned by take()
+
+	private:
+		struct slot	{
+			mailboxEntry entry;
+			bool waiting;
+		};
+
+		boost::mutex lock;
+		boost::condition_variable wakeup;
+		std::vector<slot> slots;	//indexed by plane ID
+		std::vector<int> order;		//IDs of the waiting slots, first posted first
+		bool stopped;
+		int maxDepth;
+		long posted, overwritten, takes, taken;
+	};
+}
+
+#endif
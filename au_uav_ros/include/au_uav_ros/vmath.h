@@ -1,8 +1,11 @@
 /* Vector Math
  
 The vector math class handles calculations with vectors used throughout the project
-(in force.cpp in particular). Specifically, a polar coordinate system based in the
-Cartesian plane is utilized. */
+(in Fsquared.cpp in particular). Vectors are stored as x (east) and y (north) components,
+so adding and subtracting them needs no trig. Magnitude and direction (degrees, Cartesian
+plane) are still available, but are computed from x and y when asked for. A zero vector still
+has the direction it was given or last had, like when magnitude and direction were stored, so
+mathVector(0, 90).setMagnitude(5) points at 90. */
 
 #ifndef MATH_VECTOR_H
 #define MATH_VECTOR_H
@@ -18,10 +21,17 @@ namespace au_uav_ros{
             /* Copy constructor. */ 
             mathVector(const mathVector& mV);
 
+            /* Named constructor: Specify the x and y components instead of a magnitude and direction. */
+            static mathVector fromCartesian(double x, double y);
+
             /* Accessor methods: Allow the client to access the magnitude and direction of the math vector. */
             double getDirection(void) const;
             double getMagnitude(void) const;
 
+            /* Accessor methods: Allow the client to access the x and y components without any trig. */
+            double getX(void) const;
+            double getY(void) const;
+
             /* Modifier methods: Allow the client to modify the magnitude and direction of the math vector. */
             void setDirection(double d);
                 void setMagnitude(double m);
@@ -61,8 +71,12 @@ namespace au_uav_ros{
 
 	    double findAngleBetween(const au_uav_ros::mathVector& mV);
         private:
-            /* Private data members specifying the magnitude and direction of the math vector. */
-            double magnitude;
+            /* Private data members specifying the x and y components of the math vector. */
+            double x;
+            double y;
+
+            /* Only read while x and y are both 0: the direction set through the polar API, or the one
+            the vector had before it was scaled to 0. 0 after adding up to exactly nothing, as atan2 gives. */
             double direction;
 	};	
 };
@@ -10,8 +10,13 @@
 
 //mavlink stuff
 #include "au_uav_ros/mavlink_read.h"
+#include "au_uav_ros/event_loop.h"
+#include "au_uav_ros/serial_writer.h"
+#include "au_uav_ros/telemetry_delta.h"
+#include "au_uav_ros/broadcast_rate.h"
 #include "mavlink/v1.0/ardupilotmega/mavlink.h"
 #include <au_uav_ros/Telemetry.h>
+#include <au_uav_ros/MavlinkFrame.h>
 /*
  * Possible bug. Unable to contact roscore, need to put in provision?
  *
@@ -25,6 +30,13 @@ namespace au_uav_ros{
 	class XbeeTalker	{
 	private:
 		SerialTalker m_xbee;			
+		au_uav_ros::mav::MavlinkReader m_xbee_in;	//after m_xbee, it reads from it
+		au_uav_ros::SerialWriter m_xbee_out;			//all writes to m_xbee go through it
+		au_uav_ros::EventLoop m_loop;
+		au_uav_ros::mav::FrameDispatcher m_dispatch;	//frames from the line, by message id
+		au_uav_ros::mav::DeltaEncoder m_encoder;		//my telemetry, when it is sent compact
+		au_uav_ros::mav::DeltaDecoder m_decoder;		//everyone's keyframes, for their AU_UAV_DELTAs
+		au_uav_ros::BroadcastRate m_rate;			//which of my updates go out, from the telemetry heard
 		std::string m_port;
 		int m_baud;
 
@@ -35,27 +47,38 @@ namespace au_uav_ros{
 		bool pc2serial;	
 		int updateIndex;
 		int WPSendSeqNum;
+		bool restampFrames;		//give frames passed through our own sequence numbers
+		uint8_t frameSeqNum;
+		bool compactTelemetry;	//send my telemetry as keyframes and AU_UAV_DELTAs
+		bool adaptiveRate;		//send my telemetry as often as m_rate says, not every update
 
 		//ros stuff
 		ros::NodeHandle m_node;
 		ros::Publisher m_telem_pub;
 		ros::Publisher m_cmd_pub;
 		ros::Subscriber telem_sub;	//Subscribes to my telemetry msgs
+		ros::Subscriber frame_sub;	//Subscribes to my telemetry frames, straight from ardu
 	public:
 		XbeeTalker();
 		XbeeTalker(std::string port, int baud);
 		
 		bool init(ros::NodeHandle _n);	//Opens  and sets up port, sets up ros stuff .
+		bool init(ros::NodeHandle _n, ros::NodeHandle params);	//params: where restamp_frames etc. are read from
 		void run();
+		void stop();		//makes listen() return, from any thread
 		void shutdown();
 	
 		//In - reading from xbee/listening
-		void listen();
+		void listen();									//waits on the line in m_loop until shutdown
+		void handleHeartbeat(const au_uav_ros::mav::FrameView &frame);
+		void handleTelemetry(const au_uav_ros::mav::FrameView &frame);	//posts AU_UAV to its topics
+		void handleTelemetryDelta(const au_uav_ros::mav::FrameView &frame);	//posts the AU_UAV an AU_UAV_DELTA stands for
+		void publishTelemetry(const au_uav_ros::mav::FrameView &frame);
+		void handleCommand(const au_uav_ros::mav::FrameView &frame);	//forwards MISSION_ITEM to collision avoidance
 
 		//Out - writing to xbee
-		void spinThread();				//spin() and listens for myTelemCallbacks
-//		void myTelemCallback(std_msgs::String msg);	//broadcasts my telem messages
-		void myTelemCallback(au_uav_ros::Telemetry tUpdate);	//broadcasts my telem messages
+		void spinThread();				//spin() and listens for myFrameCallbacks
+		void myFrameCallback(const au_uav_ros::MavlinkFrame::ConstPtr &raw);	//broadcasts my telem frames as they are
 
 		bool convertMavlinkTelemetryToROS(mavlink_au_uav_t &mavMessage, au_uav_ros::Telemetry &tUpdate); 
 		bool convertROSToMavlinkTelemetry(au_uav_ros::Telemetry &tUpdate, mavlink_au_uav_t &mavMessage); 
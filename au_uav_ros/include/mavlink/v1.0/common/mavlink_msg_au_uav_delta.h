@@ -0,0 +1,182 @@
+// MESSAGE AU_UAV_DELTA PACKING
+
+#define MAVLINK_MSG_ID_AU_UAV_DELTA 200
+
+typedef struct __mavlink_au_uav_delta_t
+{
+ uint8_t au_key_seq; ///< Sequence number of the keyframe the differences are from
+ uint8_t au_changed; ///< Bitmask of the differences sent: 0 lat, 1 lng, 2 alt, 3 ground speed, 4 airspeed, 5 target bearing, 6 distance
+ uint8_t au_delta[14]; ///< The differences, each an int16_t little endian. lat and lng are in steps of DELTA_POSITION_STEP * 1E-7 degrees, the rest in the units of AU_UAV
+} mavlink_au_uav_delta_t;
+
+#define MAVLINK_MSG_ID_AU_UAV_DELTA_LEN 16
+#define MAVLINK_MSG_ID_200_LEN 16
+
+#define MAVLINK_MSG_AU_UAV_DELTA_FIELD_AU_DELTA_LEN 14
+
+#define MAVLINK_MESSAGE_INFO_AU_UAV_DELTA { \
+	"AU_UAV_DELTA", \
+	3, \
+	{  { "au_key_seq", NULL, MAVLINK_TYPE_UINT8_T, 0, 0, offsetof(mavlink_au_uav_delta_t, au_key_seq) }, \
+         { "au_changed", NULL, MAVLINK_TYPE_UINT8_T, 0, 1, offsetof(mavlink_au_uav_delta_t, au_changed) }, \
+         { "au_delta", NULL, MAVLINK_TYPE_UINT8_T, 14, 2, offsetof(mavlink_au_uav_delta_t, au_delta) }, \
+         } \
+}
+
+
+/**
+ * @brief Pack a au_uav_delta message
+ * @param system_id ID of this system
+ * @param component_id ID of this component (e.g. 200 for IMU)
+ * @param msg The MAVLink message to compress the data into
+ *
+ * @param au_key_seq Sequence number of the keyframe the differences are from
+ * @param au_changed Bitmask of the differences sent: 0 lat, 1 lng, 2 alt, 3 ground speed, 4 airspeed, 5 target bearing, 6 distance
+ * @param au_delta The differences, each an int16_t little endian. lat and lng are in steps of DELTA_POSITION_STEP * 1E-7 degrees, the rest in the units of AU_UAV
+ * @return length of the message in bytes (excluding serial stream start sign)
+ */
+static inline uint16_t mavlink_msg_au_uav_delta_pack(uint8_t system_id, uint8_t component_id, mavlink_message_t* msg,
+						       uint8_t au_key_seq, uint8_t au_changed, const uint8_t *au_delta)
+{
+#if MAVLINK_NEED_BYTE_SWAP || !MAVLINK_ALIGNED_FIELDS
+	char buf[16];
+	_mav_put_uint8_t(buf, 0, au_key_seq);
+	_mav_put_uint8_t(buf, 1, au_changed);
+	_mav_put_uint8_t_array(buf, 2, au_delta, 14);
+        memcpy(_MAV_PAYLOAD_NON_CONST(msg), buf, 16);
+#else
+	mavlink_au_uav_delta_t packet;
+	packet.au_key_seq = au_key_seq;
+	packet.au_changed = au_changed;
+	mav_array_memcpy(packet.au_delta, au_delta, sizeof(uint8_t)*14);
+        memcpy(_MAV_PAYLOAD_NON_CONST(msg), &packet, 16);
+#endif
+
+	msg->msgid = MAVLINK_MSG_ID_AU_UAV_DELTA;
+	return mavlink_finalize_message(msg, system_id, component_id, 16, 255);
+}
+
+/**
+ * @brief Pack a au_uav_delta message on a channel
+ * @param system_id ID of this system
+ * @param component_id ID of this component (e.g. 200 for IMU)
+ * @param chan The MAVLink channel this message was sent over
+ * @param msg The MAVLink message to compress the data into
+ * @param au_key_seq Sequence number of the keyframe the differences are from
+ * @param au_changed Bitmask of the differences sent: 0 lat, 1 lng, 2 alt, 3 ground speed, 4 airspeed, 5 target bearing, 6 distance
+ * @param au_delta The differences, each an int16_t little endian. lat and lng are in steps of DELTA_POSITION_STEP * 1E-7 degrees, the rest in the units of AU_UAV
+ * @return length of the message in bytes (excluding serial stream start sign)
+ */
+static inline uint16_t mavlink_msg_au_uav_delta_pack_chan(uint8_t system_id, uint8_t component_id, uint8_t chan,
+							   mavlink_message_t* msg,
+						           uint8_t au_key_seq,uint8_t au_changed,const uint8_t *au_delta)
+{
+#if MAVLINK_NEED_BYTE_SWAP || !MAVLINK_ALIGNED_FIELDS
+	char buf[16];
+	_mav_put_uint8_t(buf, 0, au_key_seq);
+	_mav_put_uint8_t(buf, 1, au_changed);
+	_mav_put_uint8_t_array(buf, 2, au_delta, 14);
+        memcpy(_MAV_PAYLOAD_NON_CONST(msg), buf, 16);
+#else
+	mavlink_au_uav_delta_t packet;
+	packet.au_key_seq = au_key_seq;
+	packet.au_changed = au_changed;
+	mav_array_memcpy(packet.au_delta, au_delta, sizeof(uint8_t)*14);
+        memcpy(_MAV_PAYLOAD_NON_CONST(msg), &packet, 16);
+#endif
+
+	msg->msgid = MAVLINK_MSG_ID_AU_UAV_DELTA;
+	return mavlink_finalize_message_chan(msg, system_id, component_id, chan, 16, 255);
+}
+
+/**
+ * @brief Encode a au_uav_delta struct into a message
+ *
+ * @param system_id ID of this system
+ * @param component_id ID of this component (e.g. 200 for IMU)
+ * @param msg The MAVLink message to compress the data into
+ * @param au_uav_delta C-struct to read the message contents from
+ */
+static inline uint16_t mavlink_msg_au_uav_delta_encode(uint8_t system_id, uint8_t component_id, mavlink_message_t* msg, const mavlink_au_uav_delta_t* au_uav_delta)
+{
+	return mavlink_msg_au_uav_delta_pack(system_id, component_id, msg, au_uav_delta->au_key_seq, au_uav_delta->au_changed, au_uav_delta->au_delta);
+}
+
+/**
+ * @brief Send a au_uav_delta message
+ * @param chan MAVLink channel to send the message
+ *
+ * @param au_key_seq Sequence number of the keyframe the differences are from
+ * @param au_changed Bitmask of the differences sent: 0 lat, 1 lng, 2 alt, 3 ground speed, 4 airspeed, 5 target bearing, 6 distance
+ * @param au_delta The differences, each an int16_t little endian. lat and lng are in steps of DELTA_POSITION_STEP * 1E-7 degrees, the rest in the units of AU_UAV
+ */
+#ifdef MAVLINK_USE_CONVENIENCE_FUNCTIONS
+
+static inline void mavlink_msg_au_uav_delta_send(mavlink_channel_t chan, uint8_t au_key_seq, uint8_t au_changed, const uint8_t *au_delta)
+{
+#if MAVLINK_NEED_BYTE_SWAP || !MAVLINK_ALIGNED_FIELDS
+	char buf[16];
+	_mav_put_uint8_t(buf, 0, au_key_seq);
+	_mav_put_uint8_t(buf, 1, au_changed);
+	_mav_put_uint8_t_array(buf, 2, au_delta, 14);
+	_mav_finalize_message_chan_send(chan, MAVLINK_MSG_ID_AU_UAV_DELTA, buf, 16, 255);
+#else
+	mavlink_au_uav_delta_t packet;
+	packet.au_key_seq = au_key_seq;
+	packet.au_changed = au_changed;
+	mav_array_memcpy(packet.au_delta, au_delta, sizeof(uint8_t)*14);
+	_mav_finalize_message_chan_send(chan, MAVLINK_MSG_ID_AU_UAV_DELTA, (const char *)&packet, 16, 255);
+#endif
+}
+
+#endif
+
+// MESSAGE AU_UAV_DELTA UNPACKING
+
+
+/**
+ * @brief Get field au_key_seq from au_uav_delta message
+ *
+ * @return Sequence number of the keyframe the differences are from
+ */
+static inline uint8_t mavlink_msg_au_uav_delta_get_au_key_seq(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_uint8_t(msg,  0);
+}
+
+/**
+ * @brief Get field au_changed from au_uav_delta message
+ *
+ * @return Bitmask of the differences sent: 0 lat, 1 lng, 2 alt, 3 ground speed, 4 airspeed, 5 target bearing, 6 distance
+ */
+static inline uint8_t mavlink_msg_au_uav_delta_get_au_changed(const mavlink_message_t* msg)
+{
+	return _MAV_RETURN_uint8_t(msg,  1);
+}
+
+/**
+ * @brief Get field au_delta from au_uav_delta message
+ *
+ * @return The differences, each an int16_t little endian. lat and lng are in steps of DELTA_POSITION_STEP * 1E-7 degrees, the rest in the units of AU_UAV
+ */
+static inline uint16_t mavlink_msg_au_uav_delta_get_au_delta(const mavlink_message_t* msg, uint8_t *au_delta)
+{
+	return _MAV_RETURN_uint8_t_array(msg, au_delta, 14,  2);
+}
+
+/**
+ * @brief Decode a au_uav_delta message into a struct
+ *
+ * @param msg The message to decode
+ * @param au_uav_delta C-struct to decode the message contents into
+ */
+static inline void mavlink_msg_au_uav_delta_decode(const mavlink_message_t* msg, mavlink_au_uav_delta_t* au_uav_delta)
+{
+#if MAVLINK_NEED_BYTE_SWAP
+	au_uav_delta->au_key_seq = mavlink_msg_au_uav_delta_get_au_key_seq(msg);
+	au_uav_delta->au_changed = mavlink_msg_au_uav_delta_get_au_changed(msg);
+	mavlink_msg_au_uav_delta_get_au_delta(msg, au_uav_delta->au_delta);
+#else
+	memcpy(au_uav_delta, _MAV_PAYLOAD(msg), 16);
+#endif
+}
@@ -4064,6 +4064,53 @@ static void mavlink_test_au_uav(uint8_t system_id, uint8_t component_id, mavlink
         MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
 }
 
+static void mavlink_test_au_uav_delta(uint8_t system_id, uint8_t component_id, mavlink_message_t *last_msg)
+{
+	mavlink_message_t msg;
+        uint8_t buffer[MAVLINK_MAX_PACKET_LEN];
+        uint16_t i;
+	mavlink_au_uav_delta_t packet_in = {
+		5,
+	72,
+	{ 139, 140, 141, 142, 143, 144, 145, 146, 147, 148, 149, 150, 151, 152 },
+	};
+	mavlink_au_uav_delta_t packet1, packet2;
+        memset(&packet1, 0, sizeof(packet1));
+        	packet1.au_key_seq = packet_in.au_key_seq;
+        	packet1.au_changed = packet_in.au_changed;
+        
+        	mav_array_memcpy(packet1.au_delta, packet_in.au_delta, sizeof(uint8_t)*14);
+        
+
+        memset(&packet2, 0, sizeof(packet2));
+	mavlink_msg_au_uav_delta_encode(system_id, component_id, &msg, &packet1);
+	mavlink_msg_au_uav_delta_decode(&msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+
+        memset(&packet2, 0, sizeof(packet2));
+	mavlink_msg_au_uav_delta_pack(system_id, component_id, &msg , packet1.au_key_seq , packet1.au_changed , packet1.au_delta );
+	mavlink_msg_au_uav_delta_decode(&msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+
+        memset(&packet2, 0, sizeof(packet2));
+	mavlink_msg_au_uav_delta_pack_chan(system_id, component_id, MAVLINK_COMM_0, &msg , packet1.au_key_seq , packet1.au_changed , packet1.au_delta );
+	mavlink_msg_au_uav_delta_decode(&msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+
+        memset(&packet2, 0, sizeof(packet2));
+        mavlink_msg_to_send_buffer(buffer, &msg);
+        for (i=0; i<mavlink_msg_get_send_buffer_length(&msg); i++) {
+        	comm_send_ch(MAVLINK_COMM_0, buffer[i]);
+        }
+	mavlink_msg_au_uav_delta_decode(last_msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+        
+        memset(&packet2, 0, sizeof(packet2));
+	mavlink_msg_au_uav_delta_send(MAVLINK_COMM_1 , packet1.au_key_seq , packet1.au_changed , packet1.au_delta );
+	mavlink_msg_au_uav_delta_decode(last_msg, &packet2);
+        MAVLINK_ASSERT(memcmp(&packet1, &packet2, sizeof(packet1)) == 0);
+}
+
 static void mavlink_test_common(uint8_t system_id, uint8_t component_id, mavlink_message_t *last_msg)
 {
 	mavlink_test_heartbeat(system_id, component_id, last_msg);
@@ -4142,6 +4189,7 @@ static void mavlink_test_common(uint8_t system_id, uint8_t component_id, mavlink
 	mavlink_test_statustext(system_id, component_id, last_msg);
 	mavlink_test_debug(system_id, component_id, last_msg);
 	mavlink_test_au_uav(system_id, component_id, last_msg);
+	mavlink_test_au_uav_delta(system_id, component_id, last_msg);
 }
 
 #ifdef __cplusplus
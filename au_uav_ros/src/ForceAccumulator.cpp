@@ -0,0 +1,148 @@
+/*
+Description:
+		Implementation of ForceAccumulator.h. For information on how to use these functions, visit ForceAccumulator.h.
+		Comments in this file are related to implementation, not usage.
+
+Date: 10/14/26
+*/
+
+#include "au_uav_ros/ForceAccumulator.h"
+#include "au_uav_ros/NeighborTable.h"
+
+fsquared::ForceAccumulator::ForceAccumulator(int _fullRecomputeInterval)	{
+	setFullRecomputeInterval(_fullRecomputeInterval);
+	anchored = false;	//forces a rebuild, and so an origin, on the first update
+	updatesSinceRecompute = 0;
+	fullRecomputes = 0;
+	batchedRefreshes = 0;
+	originX = 0;
+	originY = 0;
+	sumX = 0;
+	sumY = 0;
+}
+
+void fsquared::ForceAccumulator::setFullRecomputeInterval(int updates)	{
+	fullRecomputeInterval = updates < 1 ? 1 : updates;
+}
+
+int fsquared::ForceAccumulator::getFullRecomputeInterval() const	{
+	return fullRecomputeInterval;
+}
+
+double fsquared::ForceAccumulator::toX(double missionX) const	{
+	return missionX - originX;
+}
+
+double fsquared::ForceAccumulator::toY(double missionY) const	{
+	return missionY - originY;
+}
+
+void fsquared::ForceAccumulator::update(au_uav_ros::PlaneObject &me, int planeID)	{
+	//a new neighbor field changes every cached force
+	if(!anchored || ++updatesSinceRecompute >= fullRecomputeInterval || batch.setField(me.getNeighborField()))	{
+		recompute(me);
+		return;
+	}
+
+	if(planeID == me.getID())	{
+		meMoved(me);
+		return;
+	}
+
+	//updatePlanesToAvoid has already put the plane in the map or taken it out
+	const fsquared::NeighborState *enemy = me.getMap().find(planeID);
+	if(enemy == NULL)
+		neighborRemoved(planeID);
+	else
+		neighborUpdated(me, *enemy);
+}
+
+void fsquared::ForceAccumulator::recompute(au_uav_ros::PlaneObject &me)	{
+	au_uav_ros::localPosition meLocal = me.getLocalPosition();
+	originX = meLocal.x;
+	originY = meLocal.y;
+	anchored = true;
+
+	//clear() and assign() keep their capacity, rebuilding does not allocate once the fleet has been seen
+	batch.setField(me.getNeighborField());
+	batch.clear();
+	slotOf.assign(slotOf.size(), -1);
+
+	const fsquared::NeighborTable &planesToAvoid = me.getMap();
+	if(planesToAvoid.idLimit() > (int)slotOf.size())
+		slotOf.resize(planesToAvoid.idLimit(), -1);
+	for(int id = 0; id < planesToAvoid.idLimit(); id++)	{
+		const fsquared::NeighborState *enemy = planesToAvoid.find(id);
+		if(enemy == NULL)
+			continue;
+		slotOf[id] = batch.size();
+		batch.add(id, toX(enemy->position.x), toY(enemy->position.y), enemy->currentBearing);
+	}
+
+	au_uav_ros::mathVector sum = batch.computeForces(0, 0);	//"me" is the origin
+	sumX = sum.getX();
+	sumY = sum.getY();
+	updatesSinceRecompute = 0;
+	fullRecomputes++;
+}
+
+//Every force depends on "me", recalculate all of them. Summing them again also drops whatever
+//rounding the running total has picked up since the last pass.
+void fsquared::ForceAccumulator::meMoved(au_uav_ros::PlaneObject &me)	{
+	au_uav_ros::localPosition meLocal = me.getLocalPosition();
+	au_uav_ros::mathVector sum = batch.computeForces(toX(meLocal.x), toY(meLocal.y));
+	sumX = sum.getX();
+	sumY = sum.getY();
+	batchedRefreshes++;
+}
+
+//The table never holds negative IDs, so planeID can index slotOf
+void fsquared::ForceAccumulator::neighborUpdated(au_uav_ros::PlaneObject &me, const fsquared::NeighborState &enemy)	{
+	int planeID = enemy.id;
+	if(planeID >= (int)slotOf.size())
+		slotOf.resize(planeID + 1, -1);
+
+	int slot = slotOf[planeID];
+	if(slot < 0)	{
+		//new slots start with no force, so the correction below is the whole force
+		slot = slotOf[planeID] = batch.size();
+		batch.add(planeID, toX(enemy.position.x), toY(enemy.position.y), enemy.currentBearing);
+	}
+	else
+		batch.set(slot, toX(enemy.position.x), toY(enemy.position.y), enemy.currentBearing);
+
+	double oldX = batch.getForceX(slot), oldY = batch.getForceY(slot);
+	au_uav_ros::localPosition meLocal = me.getLocalPosition();
+	batch.computeForce(slot, toX(meLocal.x), toY(meLocal.y));
+	sumX += batch.getForceX(slot) - oldX;
+	sumY += batch.getForceY(slot) - oldY;
+}
+
+void fsquared::ForceAccumulator::neighborRemoved(int planeID)	{
+	if(planeID < 0 || planeID >= (int)slotOf.size() || slotOf[planeID] < 0)
+		return;
+
+	int slot = slotOf[planeID];
+	sumX -= batch.getForceX(slot);
+	sumY -= batch.getForceY(slot);
+	int moved = batch.remove(slot);
+	if(moved >= 0)
+		slotOf[moved] = slot;
+	slotOf[planeID] = -1;
+}
+
+au_uav_ros::mathVector fsquared::ForceAccumulator::getForce() const	{
+	return au_uav_ros::mathVector::fromCartesian(sumX, sumY);
+}
+
+int fsquared::ForceAccumulator::size() const	{
+	return batch.size();
+}
+
+long fsquared::ForceAccumulator::getFullRecomputes() const	{
+	return fullRecomputes;
+}
+
+long fsquared::ForceAccumulator::getBatchedRefreshes() const	{
+	return batchedRefreshes;
+}
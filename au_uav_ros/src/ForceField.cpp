@@ -4,75 +4,82 @@ Authors: Andrew Cunningham
 
 Description:
 		This file contains an implementation of the ForceField object that is required for the F^2 approach
-		(ADD MORE)
+		The shape and function evaluations are inline in ForceField.h, this file has the constructors
+		and the runtime selection in AnyForceField.
 
 Date: 6/13/13
 */
 
 
+#include <algorithm>
 #include "au_uav_ros/ForceField.h"
 
 /**************************************************************************
  * 								FORCE FIELD								  *
  **************************************************************************
- The following methods are members of the ForceField object which carries
- a FieldShape and a FieldFunction */
+ The following methods are members of AnyForceField, the runtime
+ selectable ForceField that every PlaneObject carries */
 
 
 
-/* Default constructor, initializes a ForceField with an oval shape and a
+/* Default constructor, initializes an AnyForceField with an oval shape and a
  * bivariate normal function
- *
- * TODO:
- * 		Create a constructor that enables choosing a field and a shape
  */
-ForceField::ForceField(){
-	myShape = new OvalField();
-	myFunction = new BivariateNormal();
+AnyForceField::AnyForceField(){
+	shapeCode = OVAL_FIELD_SHAPE;
+	functionCode = BIVARIATE_NORMAL_FUNCTION;
 }
 
-/*
-ForceField::~ForceField(){
-	delete myShape;
-	delete myFunction;
+/* Codes that are not known fall back to the default, the switches in the
+ * inline methods rely on shapeCode and functionCode always being valid
+ */
+AnyForceField::AnyForceField(int encodedFieldShape, int encodedFieldFunction){
+	shapeCode = isKnownShape(encodedFieldShape) ? (fieldShapeCode)encodedFieldShape : OVAL_FIELD_SHAPE;
+	functionCode = isKnownFunction(encodedFieldFunction) ? (fieldFunctionCode)encodedFieldFunction : BIVARIATE_NORMAL_FUNCTION;
 }
-*/
 
-const FieldShape * ForceField::getMyShape() const{
-	return myShape;
+int AnyForceField::getShapeCode() const{
+	return shapeCode;
 }
 
-const FieldFunction * ForceField::getMyFunction() const{
-	return myFunction;
+int AnyForceField::getFunctionCode() const{
+	return functionCode;
 }
 
-ForceField& ForceField::operator=(const ForceField& ForceFieldIn){
-	*myShape = *(ForceFieldIn.getMyShape());
-	*myFunction = *(ForceFieldIn.getMyFunction());
+const OvalField & AnyForceField::getOval() const{
+	return shapeCode == TABULATED_OVAL_FIELD_SHAPE ? tabulatedOval.getShape() : oval;
+}
 
-	return *this;
+const BivariateNormal & AnyForceField::getBivariateNormal() const{
+	return functionCode == TABULATED_BIVARIATE_NORMAL_FUNCTION ? tabulatedBivariateNormal.getFunction() : bivariateNormal;
 }
 
+bool AnyForceField::isKnownShape(int encodedFieldShape){
+	return encodedFieldShape == OVAL_FIELD_SHAPE || encodedFieldShape == TABULATED_OVAL_FIELD_SHAPE;
+}
 
-/* areCoordinatesInMyField(...)
- * Description:
- * 		Calls the ForceField's FieldShape member to determine whether or not
- * 		a relative coordinate lies within this ForceField's zone of influence
- */
-bool ForceField::areCoordinatesInMyField(fsquared::relativeCoordinates positionInField, double fieldAngle, double planeAngle){
-	return myShape->internal_areCoordinatesInMyField(positionInField, fieldAngle, planeAngle);
+bool AnyForceField::isKnownFunction(int encodedFieldFunction){
+	return encodedFieldFunction == BIVARIATE_NORMAL_FUNCTION || encodedFieldFunction == TABULATED_BIVARIATE_NORMAL_FUNCTION;
 }
 
-/* findForceMagnitude(...)
- * Description:
- * 		Calls the ForceField's FieldFunction member to determine the force exerted
- * 		by the ForceField on a set of coordinates.
- * 	Assumptions:
- * 		Coordinates are within the field shape
- * 	TODO: RENAME TO INTERNAL
- */
-double ForceField::findForceMagnitude(fsquared::relativeCoordinates positionInField){
-		return myFunction->findFieldFunctionMagnitude(positionInField);
+void AnyForceField::setShape(const OvalField &shape){
+	shapeCode = OVAL_FIELD_SHAPE;
+	oval = shape;
+}
+
+void AnyForceField::setShape(const TabulatedOvalField &shape){
+	shapeCode = TABULATED_OVAL_FIELD_SHAPE;
+	tabulatedOval = shape;
+}
+
+void AnyForceField::setFunction(const BivariateNormal &function){
+	functionCode = BIVARIATE_NORMAL_FUNCTION;
+	bivariateNormal = function;
+}
+
+void AnyForceField::setFunction(const TabulatedBivariateNormal &function){
+	functionCode = TABULATED_BIVARIATE_NORMAL_FUNCTION;
+	tabulatedBivariateNormal = function;
 }
 
 
@@ -83,55 +90,79 @@ double ForceField::findForceMagnitude(fsquared::relativeCoordinates positionInFi
 
 
 /*	Constructor for an oval field
- * 	TODO:
- * 		make another constructor that allows choosing constants
- *
  */
 OvalField::OvalField(){
 	shapeParams.gamma = 1500;
 	shapeParams.alphaTop = .5;
 	shapeParams.betaTop = .25;
+	shapeParams.alphaBot = .5;	//was never set, so the bottom of the oval depended on whatever was in memory
 	shapeParams.betaBot = 1.6;
 }
 
-//internal_areCoordinatesInMyField(...)
-//Precondition: None
-//Use:
-//		This method will determine whether or not coordinates are inside
-//		this field
-//Params:
-//		positionInField: coordinate of the plane that will feel the force
-//						 relative to the position of the plane generating the field
-//		fieldAngle: bearing of the plane generating the field - angle between the plane
-//					genereating the field and the plane that will feel the force
-//		planeAngle:	angle between the two planes, calculated starting from the generating
-//					plane and going to the plane that will feel the force
-//TODO REMOVE ANGLES
-bool OvalField::internal_areCoordinatesInMyField(fsquared::relativeCoordinates positionInField, double fieldAngle, double planeAngle){
-	int x = positionInField.x;
-	int y = positionInField.y;
-	if (y < 0){
-		// plane feeling the force is behind the plane exerting the force, therefore use the bottom boundary
-		double forceLimit = -sqrt((shapeParams.gamma-(shapeParams.alphaBot*pow(x,2)))/shapeParams.betaBot);
-		if (y>forceLimit) return true;
-		else return false;
-	}
-	else{
-		// plane feeling the force is in front, therefore use the top boundary
-		double forceLimit = sqrt((shapeParams.gamma-(shapeParams.alphaTop*pow(x,2)))/shapeParams.betaTop);
-		if (y<forceLimit) return true;
-		else return false;
+OvalField::OvalField(const shapeVariables &params){
+	shapeParams = params;
+}
+
+const OvalField::shapeVariables & OvalField::getShapeParams() const{
+	return shapeParams;
+}
+
+bool OvalField::operator==(const OvalField &other) const{
+	return shapeParams.gamma == other.shapeParams.gamma &&
+			shapeParams.alphaTop == other.shapeParams.alphaTop && shapeParams.betaTop == other.shapeParams.betaTop &&
+			shapeParams.alphaBot == other.shapeParams.alphaBot && shapeParams.betaBot == other.shapeParams.betaBot;
+}
+
+/* How far from the plane generating the field an oval reaches, in meters. Constants that do not
+ * close the oval are capped at RADAR_ZONE, the tabulated classes fall back to calculating past it.
+ */
+static double ovalReach(double gamma, double coefficient){
+	if (coefficient <= 0 || gamma/coefficient > RADAR_ZONE*RADAR_ZONE)
+		return RADAR_ZONE;
+	if (gamma <= 0)
+		return 0;
+	return sqrt(gamma/coefficient);
+}
+
+//Every default constructed TabulatedOvalField shares one table
+TabulatedOvalField::TabulatedOvalField(){
+	static const TabulatedOvalField defaultField = TabulatedOvalField(OvalField());
+	*this = defaultField;
+}
+
+TabulatedOvalField::TabulatedOvalField(const OvalField &shape){
+	setShape(shape);
+}
+
+/* The limits come from the same expressions as OvalField::internal_areCoordinatesInMyField, so a
+ * lookup gives the same answer bit for bit, including the NaN where the oval does not reach.
+ */
+void TabulatedOvalField::setShape(const OvalField &newShape){
+	if (limits && shape == newShape)
+		return;
+	shape = newShape;
+	const OvalField::shapeVariables &params = shape.getShapeParams();
+	reach = (int)floor(ovalReach(params.gamma, std::min(params.alphaTop, params.alphaBot)));
+
+	std::vector<boundary> *table = new std::vector<boundary>(2*reach + 1);
+	for (int x = -reach; x <= reach; x++){
+		boundary &limit = (*table)[x + reach];
+		limit.top = sqrt((params.gamma-(params.alphaTop*pow(x,2)))/params.betaTop);
+		limit.bottom = -sqrt((params.gamma-(params.alphaBot*pow(x,2)))/params.betaBot);
 	}
+	limits.reset(table);
+}
+
+const OvalField & TabulatedOvalField::getShape() const{
+	return shape;
 }
 
 
 /**************************************************************************
  * 								Functions								  *
- **************************************************************************
+ **************************************************************************/
 
 /* Constructor for bivariate normal function
- * TODO:
- * 		make another constructor that allows choosing constants
  */
 BivariateNormal::BivariateNormal(){
 	functionParams.maxForce = 4000;
@@ -139,10 +170,77 @@ BivariateNormal::BivariateNormal(){
 	functionParams.beta = .000850;
 }
 
-double BivariateNormal::findFieldFunctionMagnitude(fsquared::relativeCoordinates positionInField){
-	int x = positionInField.x;
-	int y = positionInField.y;
-	return functionParams.maxForce * exp(-functionParams.alpha*pow(x,2)-functionParams.beta*pow(y,2));
+BivariateNormal::BivariateNormal(const forceVariables &params){
+	functionParams = params;
+}
+
+const BivariateNormal::forceVariables & BivariateNormal::getFunctionParams() const{
+	return functionParams;
+}
+
+bool BivariateNormal::operator==(const BivariateNormal &other) const{
+	return functionParams.maxForce == other.functionParams.maxForce &&
+			functionParams.alpha == other.functionParams.alpha && functionParams.beta == other.functionParams.beta;
 }
 
+//Every default constructed TabulatedBivariateNormal shares one table
+TabulatedBivariateNormal::TabulatedBivariateNormal(){
+	static const TabulatedBivariateNormal defaultFunction = TabulatedBivariateNormal(BivariateNormal());
+	*this = defaultFunction;
+}
+
+TabulatedBivariateNormal::TabulatedBivariateNormal(const BivariateNormal &function, const OvalField &coverage, double step){
+	setFunction(function, coverage, step);
+}
+
+/* The grid starts on a whole meter and covers every whole meter coordinate inside the coverage
+ * oval, grid points are calculated with BivariateNormal itself.
+ */
+void TabulatedBivariateNormal::setFunction(const BivariateNormal &newFunction, const OvalField &newCoverage, double newStep){
+	if (newStep <= 0)
+		newStep = DEFAULT_FIELD_TABLE_STEP;
+	if (magnitudes && function == newFunction && coverage == newCoverage && step == newStep)
+		return;
+	function = newFunction;
+	coverage = newCoverage;
+	step = newStep;
+
+	const OvalField::shapeVariables &params = coverage.getShapeParams();
+	double xReach = floor(ovalReach(params.gamma, std::min(params.alphaTop, params.alphaBot)));
+	double yTop = floor(ovalReach(params.gamma, params.betaTop));
+	double yBottom = floor(ovalReach(params.gamma, params.betaBot));
+	xMin = -xReach;
+	yMin = -yBottom;
+	columns = std::max(2, (int)ceil(2*xReach/step) + 1);
+	rows = std::max(2, (int)ceil((yTop + yBottom)/step) + 1);
+
+	std::vector<double> *table = new std::vector<double>(columns*rows);
+	fsquared::relativeCoordinates point;
+	for (int j = 0; j < rows; j++){
+		for (int i = 0; i < columns; i++){
+			//whole meter points keep their value, the others are only ever interpolated
+			point.x = xMin + i*step;
+			point.y = yMin + j*step;
+			if (point.x == floor(point.x) && point.y == floor(point.y))
+				(*table)[j*columns + i] = function.findFieldFunctionMagnitude(point);
+			else{
+				const BivariateNormal::forceVariables &f = function.getFunctionParams();
+				(*table)[j*columns + i] = f.maxForce*exp(-f.alpha*point.x*point.x - f.beta*point.y*point.y);
+			}
+		}
+	}
+	magnitudes.reset(table);
+}
+
+const BivariateNormal & TabulatedBivariateNormal::getFunction() const{
+	return function;
+}
 
+double TabulatedBivariateNormal::getStep() const{
+	return step;
+}
+
+double TabulatedBivariateNormal::maxError(const BivariateNormal &function, double step){
+	const BivariateNormal::forceVariables &f = function.getFunctionParams();
+	return step*step*f.maxForce*(fabs(f.alpha) + fabs(f.beta))/4;
+}
@@ -12,9 +12,15 @@ Date: 6/13/13
 
 
 */
-#include <ros/console.h>
+#include <ros/ros.h>
 #include "au_uav_ros/Fsquared.h"
 #include "au_uav_ros/planeObject.h"
+#include "au_uav_ros/NeighborTable.h"
+#include "au_uav_ros/SpatialGrid.h"
+#include "au_uav_ros/RepulsiveForceBatch.h"
+#include "au_uav_ros/ForceAccumulator.h"
+#include "au_uav_ros/ThreatFilter.h"
+#include "au_uav_ros/ThreatSet.h"
 
 //defines from 2012 APF group to resolve looping
 #define MAXIMUM_TURNING_ANGLE 22.5 //degrees
@@ -110,31 +116,55 @@ bool inLoop(const au_uav_ros::PlaneObject &pobj1, au_uav_ros::mathVector &tForce
 }
 
 
-au_uav_ros::waypoint fsquared::findTempForceWaypoint(au_uav_ros::PlaneObject &me, const au_uav_ros::Telemetry &msg){
+/*
+ * Shared by every version of findTempForceWaypoint.
+ */
+void fsquared::updatePlanesToAvoid(au_uav_ros::PlaneObject &me, const au_uav_ros::Telemetry &msg, fsquared::ThreatFilter *threats){
 
 	//If the telemetry update is not from "me", update "me's"
 	//map of other planes that are exerting a force on "me"
 	if(me.getID() != msg.planeID){
 
-		//create enemy plane, 12 is the collision radius
-		au_uav_ros::PlaneObject enemy(12, msg);
+		//create enemy plane. Only what F^2 uses: the current bearing is left at 0, as it always
+		//was for a plane built from a telemetry update. This is where its position becomes meters,
+		//nothing after this converts it again
+		au_uav_ros::coordinate enemyLoc;
+		enemyLoc.latitude = msg.currentLatitude;
+		enemyLoc.longitude = msg.currentLongitude;
+		enemyLoc.altitude = msg.currentAltitude;
+		fsquared::NeighborState enemy;
+		enemy.id = msg.planeID;
+		enemy.position = au_uav_ros::LocalFrame::mission().toLocal(enemyLoc);
+		enemy.currentBearing = 0.0;
+		enemy.targetBearing = msg.targetBearing;
+		enemy.speed = msg.groundSpeed;
+		enemy.lastUpdateTime = ros::Time::now().toSec();
 
 		//check to see if the updated plane is within RADAR_ZONE
-		if(me.findDistance(enemy) > RADAR_ZONE){
+		au_uav_ros::localPosition meLocal = me.getLocalPosition();
+		double dx = enemy.position.x - meLocal.x, dy = enemy.position.y - meLocal.y;
+		if(sqrt(dx*dx + dy*dy) > RADAR_ZONE){
 			//plane is out of the RADAR_ZONE
 			//take enemy out of the map if it is in the map
-			me.planeOut_updateMap(enemy);
+			me.planeOut_updateMap(enemy.id);
+			if(threats != NULL)
+				threats->remove(enemy.id);
+		}
+
+		else if(threats != NULL && !threats->admit(me, enemy)){
+			//plane is in the RADAR_ZONE, but will not come close any time soon
+			me.planeOut_updateMap(enemy.id);
 		}
 
 		else{
 			//plane is in the RADAR_ZONE
-			if(inEnemyField(me, enemy)){
+			if(fsquared::inEnemyField(me, enemy)){
 				//enemy is exerting a force on "me"
 				me.planeIn_updateMap(enemy);
 			}
 			else{
 				//enemy is not exerting a force on "me"
-				me.planeOut_updateMap(enemy);
+				me.planeOut_updateMap(enemy.id);
 			}
 		}
 	}
@@ -143,13 +173,19 @@ au_uav_ros::waypoint fsquared::findTempForceWaypoint(au_uav_ros::PlaneObject &me
 	else{
 		me.setCurrentLoc(msg.currentLatitude, msg.currentLongitude, msg.currentAltitude);
 		me.setCurrentBearing(msg.targetBearing);
+		me.setSpeed(msg.groundSpeed);
 	}
+}
 
+/*
+ * Shared by both versions of findTempForceWaypoint.
+ * Adds the attractive force to the already summed repulsive force and turns the
+ * resultant into a waypoint.
+ */
+static au_uav_ros::waypoint resultantForceWaypoint(au_uav_ros::PlaneObject &me, au_uav_ros::mathVector repulsiveForce){
 	//calculate next direction to travel in
-	au_uav_ros::mathVector resultantForce(0,0), attractiveForce(0,0), repulsiveForce(0,0);
+	au_uav_ros::mathVector resultantForce(0,0), attractiveForce(0,0);
 
-	//commented out to test navigation without APF avoidance
-	repulsiveForce = fsquared::sumRepulsiveForces(me, me.getMap());
 	attractiveForce = fsquared::calculateAttractiveForce(me, me.getDestination());
 
 	resultantForce = repulsiveForce + attractiveForce;
@@ -177,10 +213,63 @@ au_uav_ros::waypoint fsquared::findTempForceWaypoint(au_uav_ros::PlaneObject &me
 	return fsquared::motionVectorToWaypoint(resultantForce.getDirection(), meCurrentWaypoint, (WP_GEN_SCALAR * 10000));
 }
 
+au_uav_ros::waypoint fsquared::findTempForceWaypoint(au_uav_ros::PlaneObject &me, const au_uav_ros::Telemetry &msg,
+												fsquared::ThreatFilter *threats){
+	updatePlanesToAvoid(me, msg, threats);
+
+	au_uav_ros::mathVector repulsiveForce = fsquared::sumRepulsiveForces(me, me.getMap());
+	return resultantForceWaypoint(me, repulsiveForce);
+}
+
+/*
+ * Planes outside RADAR_ZONE can never put "me" inside their field (the oval field is
+ * smaller than RADAR_ZONE), so skipping them does not change the resultant force.
+ */
+au_uav_ros::waypoint fsquared::findTempForceWaypoint(au_uav_ros::PlaneObject &me, const au_uav_ros::Telemetry &msg, fsquared::SpatialGrid &grid,
+												fsquared::RepulsiveForceBatch &batch, fsquared::ThreatFilter *threats){
+	updatePlanesToAvoid(me, msg, threats);
+	updateGrid(me, msg, grid);
+
+	au_uav_ros::coordinate meLoc = me.getCurrentLoc();
+	const std::vector<int> &nearbyPlanes = grid.findNeighbors(meLoc.latitude, meLoc.longitude, RADAR_ZONE);
+	au_uav_ros::mathVector repulsiveForce = fsquared::sumRepulsiveForces(me, me.getMap(), nearbyPlanes, batch);
+	return resultantForceWaypoint(me, repulsiveForce);
+}
+
+void fsquared::updateGrid(au_uav_ros::PlaneObject &me, const au_uav_ros::Telemetry &msg, fsquared::SpatialGrid &grid){
+	if(msg.planeID == me.getID())
+		return;
+	if(me.getMap().contains(msg.planeID))
+		grid.update(msg.planeID, msg.currentLatitude, msg.currentLongitude);
+	else
+		grid.remove(msg.planeID);
+}
+
+au_uav_ros::waypoint fsquared::findTempForceWaypoint(au_uav_ros::PlaneObject &me, const au_uav_ros::Telemetry &msg, fsquared::ForceAccumulator &forces,
+												fsquared::ThreatFilter *threats){
+	updatePlanesToAvoid(me, msg, threats);
+
+	forces.update(me, msg.planeID);
+	return resultantForceWaypoint(me, forces.getForce());
+}
+
+au_uav_ros::waypoint fsquared::findTempForceWaypoint(au_uav_ros::PlaneObject &me, const au_uav_ros::Telemetry &msg, fsquared::ThreatSet &bounded,
+												double deadline, fsquared::ThreatFilter *threats){
+	updatePlanesToAvoid(me, msg, threats);
+
+	au_uav_ros::mathVector repulsiveForce = bounded.sumRepulsiveForces(me, me.getMap(), deadline);
+	return resultantForceWaypoint(me, repulsiveForce);
+}
+
 //-----------------------------------------
 //Fields
 //-----------------------------------------
 
+//Same as PlaneObject::findAngle from the enemy to "me"
+static double angleFromNeighbor(const fsquared::NeighborState &enemy, const au_uav_ros::localPosition &meLocal){
+	return atan2(meLocal.y - enemy.position.y, meLocal.x - enemy.position.x)*180.0/PI;
+}
+
 
 
 /*
@@ -199,33 +288,63 @@ au_uav_ros::waypoint fsquared::findTempForceWaypoint(au_uav_ros::PlaneObject &me
  */
 double fsquared::findFieldAngle(au_uav_ros::PlaneObject& me, au_uav_ros::PlaneObject &enemy)	{
 
-	//Make two vectors - one representing bearing of enemy plane
-	//		     the other representing relative position from
-	//		     enemy to me
-	au_uav_ros::mathVector enemyBearing(1, toCartesian(enemy.getCurrentBearing()));
-	au_uav_ros::mathVector positionToMe(1, enemy.findAngle(me));
+	//Two directions - one representing bearing of enemy plane
+	//		    the other representing relative position from
+	//		    enemy to me
+	double enemyBearing = toCartesian(enemy.getCurrentBearing());
+	double positionToMe = enemy.findAngle(me);
 
 
-	//Find angle between two vectors
-	return enemyBearing.findAngleBetween(positionToMe); 
+	//Find angle between the two directions, same result as mathVector::findAngleBetween
+	//without building unit vectors just to take their angles back out
+	return manipulateAngle(forceAngle360(enemyBearing) - forceAngle360(positionToMe));
+}
+
+double fsquared::findFieldAngle(au_uav_ros::PlaneObject& me, const fsquared::NeighborState &enemy)	{
+	double enemyBearing = toCartesian(enemy.currentBearing);
+	double positionToMe = angleFromNeighbor(enemy, me.getLocalPosition());
+	return manipulateAngle(forceAngle360(enemyBearing) - forceAngle360(positionToMe));
 }
 
 /*
  * precondition: me and map are not null
  * 		 map only contains planes  exerting a repulsive force on me
  */
-au_uav_ros::mathVector fsquared::sumRepulsiveForces(au_uav_ros::PlaneObject &me, std::map<int, au_uav_ros::PlaneObject> & planesToAvoid)	{
+au_uav_ros::mathVector fsquared::sumRepulsiveForces(au_uav_ros::PlaneObject &me, const fsquared::NeighborTable &planesToAvoid)	{
 	
 	au_uav_ros::mathVector sum, current;
 
-	std::map<int, au_uav_ros::PlaneObject> :: iterator it;
-	for(it = planesToAvoid.begin(); it!= planesToAvoid.end(); it++)	{
-		current = calculateRepulsiveForce(me, it-> second);
+	for(int id = 0; id < planesToAvoid.idLimit(); id++)	{
+		const fsquared::NeighborState *enemy = planesToAvoid.find(id);
+		if(enemy == NULL)
+			continue;
+		current = calculateRepulsiveForce(me, *enemy);
 		sum += current;
 	}
 	return sum;
 }
 
+/*
+ * precondition: me and map are not null
+ * 		 nearbyPlanes may name planes that are not in the map, those are skipped
+ * Positions go into the batch as meters from "me", so "me" is at the origin of the batch.
+ * The batch calculates me's neighbor field, from its constants if it is tabulated.
+ */
+au_uav_ros::mathVector fsquared::sumRepulsiveForces(au_uav_ros::PlaneObject &me, const fsquared::NeighborTable &planesToAvoid,
+												const std::vector<int> &nearbyPlanes, fsquared::RepulsiveForceBatch &batch)	{
+	au_uav_ros::localPosition meLocal = me.getLocalPosition();
+
+	batch.setField(me.getNeighborField());
+	batch.clear();
+	for(unsigned int i = 0; i < nearbyPlanes.size(); i++)	{
+		const fsquared::NeighborState *enemy = planesToAvoid.find(nearbyPlanes[i]);
+		if(enemy == NULL)
+			continue;
+		batch.add(enemy->id, enemy->position.x - meLocal.x, enemy->position.y - meLocal.y, enemy->currentBearing);
+	}
+	return batch.computeForces(0, 0);
+}
+
 
 /* rightHandTurnRule(...)
  * Description:
@@ -340,6 +459,22 @@ au_uav_ros::mathVector fsquared::calculateRepulsiveForce(au_uav_ros::PlaneObject
 	}
 }
 
+//Same steps as above, without the PlaneObject
+au_uav_ros::mathVector fsquared::calculateRepulsiveForce(au_uav_ros::PlaneObject &me, const fsquared::NeighborState &enemy){
+	double fieldAngle = fsquared::findFieldAngle(me, enemy);
+	double planeAngle = angleFromNeighbor(enemy, me.getLocalPosition());
+	fsquared::relativeCoordinates relativePosition = fsquared::findRelativePosition(me, enemy);
+	const AnyForceField &neighborField = me.getNeighborField();
+	if(neighborField.areCoordinatesInMyField(relativePosition, fieldAngle, planeAngle)){
+		au_uav_ros::mathVector repulsiveForceVector(neighborField.findForceMagnitude(relativePosition), planeAngle);
+		return repulsiveForceVector;
+	}
+	else{
+		au_uav_ros::mathVector repulsiveForceVector(0,0);
+		return repulsiveForceVector;
+	}
+}
+
 /* Assumptions:
  * 		The magnitude of the attractive force to the waypoint is defined correctly
  *
@@ -394,6 +529,20 @@ fsquared::relativeCoordinates fsquared::findRelativePosition(au_uav_ros::PlaneOb
 	return loc;
 }
 
+fsquared::relativeCoordinates fsquared::findRelativePosition(au_uav_ros::PlaneObject &me, const fsquared::NeighborState &enemy){
+	fsquared::relativeCoordinates loc;
+
+	au_uav_ros::localPosition meLocal = me.getLocalPosition();
+	double dx = meLocal.x - enemy.position.x, dy = meLocal.y - enemy.position.y;
+	double distance = sqrt(dx*dx + dy*dy);
+	double fieldAngle = fsquared::findFieldAngle(me, enemy);
+
+	loc.y = cos(fieldAngle*PI/180.0)*distance;
+	loc.x = sin(fieldAngle*PI/180.0)*distance;
+
+	return loc;
+}
+
 /* Assumptions:
  * 		Enemy plane has a properly initialized field
  * 	Description:
@@ -403,7 +552,7 @@ fsquared::relativeCoordinates fsquared::findRelativePosition(au_uav_ros::PlaneOb
  * 		field
  */
 bool fsquared::inEnemyField(au_uav_ros::PlaneObject &enemy, fsquared::relativeCoordinates locationOfMe, double fieldAngle, double planeAngle){
-	ForceField  enemyField = enemy.getField();
+	const AnyForceField &enemyField = enemy.getField();
 	return enemyField.areCoordinatesInMyField(locationOfMe, fieldAngle, planeAngle);
 }
 
@@ -415,10 +564,17 @@ bool fsquared::inEnemyField(au_uav_ros::PlaneObject &me, au_uav_ros::PlaneObject
 	fieldAngle = findFieldAngle(me, enemy);
 	planeAngle = enemy.findAngle(me);
 	relativePosition = findRelativePosition(me, enemy);
-	ForceField  enemyField = enemy.getField();
+	const AnyForceField &enemyField = enemy.getField();
 	return enemyField.areCoordinatesInMyField(relativePosition, fieldAngle, planeAngle);
 }
 
+bool fsquared::inEnemyField(au_uav_ros::PlaneObject &me, const fsquared::NeighborState &enemy){
+	double fieldAngle = findFieldAngle(me, enemy);
+	double planeAngle = angleFromNeighbor(enemy, me.getLocalPosition());
+	relativeCoordinates relativePosition = findRelativePosition(me, enemy);
+	return me.getNeighborField().areCoordinatesInMyField(relativePosition, fieldAngle, planeAngle);
+}
+
 
 //-----------------------------------------
 //Waypoint Generation
@@ -440,8 +596,9 @@ au_uav_ros::waypoint fsquared::motionVectorToWaypoint(double angle, au_uav_ros::
 	double y_delta_meters = scalar*sin(angle*PI/180.0); 
 
 	//Calculate new waypoint 
-	double dest_wp_long= me_loc.longitude+ (x_delta_meters*METERS_TO_DELTA_LON);
-	double dest_wp_lat= me_loc.latitude+ (y_delta_meters*METERS_TO_DELTA_LAT);
+	const au_uav_ros::LocalFrame &frame = au_uav_ros::LocalFrame::mission();
+	double dest_wp_long= frame.toLongitude(frame.toX(me_loc.longitude) + x_delta_meters);
+	double dest_wp_lat= frame.toLatitude(frame.toY(me_loc.latitude) + y_delta_meters);
 	dest_wp.longitude = dest_wp_long;
 	dest_wp.latitude = dest_wp_lat;	
 	dest_wp.altitude = me_loc.altitude;
@@ -0,0 +1,93 @@
+/*
+Description:
+		Implementation of LatencyRecorder.h. For information on how to use these functions, visit LatencyRecorder.h.
+		Comments in this file are related to implementation, not usage.
+
+Date: 10/14/26
+*/
+
+#include <math.h>
+
+#include "au_uav_ros/LatencyRecorder.h"
+
+au_uav_ros::LatencyRecorder::LatencyRecorder()	{
+	reset();
+}
+
+void au_uav_ros::LatencyRecorder::reset()	{
+	for(int i = 0; i < BINS; i++)
+		bins[i] = 0;
+	overflow = 0;
+	count = 0;
+	total = 0;
+	longest = 0;
+}
+
+/*
+ * 0 - 999:		1 us each, [0, 1000) us
+ * 1000 - 1899:	10 us each, [1 ms, 10 ms)
+ * 1900 - 2799:	100 us each, [10 ms, 100 ms)
+ * -1 past the end
+ */
+int au_uav_ros::LatencyRecorder::binOf(double microseconds)	{
+	if(microseconds < 0)
+		microseconds = 0;
+	if(microseconds < 1000)
+		return (int)microseconds;
+	if(microseconds < 10000)
+		return 1000 + (int)((microseconds - 1000)/10);
+	if(microseconds < 100000)
+		return 1900 + (int)((microseconds - 10000)/100);
+	return -1;
+}
+
+double au_uav_ros::LatencyRecorder::upperEdge(int bin)	{
+	if(bin < 1000)
+		return bin + 1;
+	if(bin < 1900)
+		return 1000 + (bin - 1000 + 1)*10.0;
+	return 10000 + (bin - 1900 + 1)*100.0;
+}
+
+void au_uav_ros::LatencyRecorder::record(double seconds)	{
+	int bin = binOf(seconds*1e6);
+	if(bin < 0)
+		overflow++;
+	else
+		bins[bin]++;
+	count++;
+	total += seconds;
+	if(seconds > longest)
+		longest = seconds;
+}
+
+long au_uav_ros::LatencyRecorder::getCount() const	{
+	return count;
+}
+
+double au_uav_ros::LatencyRecorder::getMax() const	{
+	return longest;
+}
+
+double au_uav_ros::LatencyRecorder::getMean() const	{
+	return count > 0 ? total/count : 0;
+}
+
+//The edge of a bin can be past the longest time recorded, the percentile is never reported above it
+double au_uav_ros::LatencyRecorder::percentile(double percent) const	{
+	if(count == 0)
+		return 0;
+	long rank = (long)ceil(percent/100.0*count);
+	if(rank < 1)
+		rank = 1;
+
+	long seen = 0;
+	for(int i = 0; i < BINS; i++)	{
+		seen += bins[i];
+		if(seen >= rank)	{
+			double edge = upperEdge(i)*1e-6;
+			return edge < longest ? edge : longest;
+		}
+	}
+	return longest;	//in the overflow
+}
@@ -0,0 +1,80 @@
+/*
+Description:
+		Implementation of LocalFrame.h. For information on how to use these functions, visit LocalFrame.h.
+		Comments in this file are related to implementation, not usage.
+
+Date: 10/14/26
+*/
+
+#include "au_uav_ros/LocalFrame.h"
+
+//WGS84 ellipsoid
+#define WGS84_SEMI_MAJOR_AXIS 6378137.0		//meters
+#define WGS84_ECCENTRICITY_SQUARED 6.69437999014e-3
+
+au_uav_ros::LocalFrame::LocalFrame()	{
+	anchored = false;
+	origin.latitude = 0;
+	origin.longitude = 0;
+	origin.altitude = 0;
+	metersPerLatitude = DELTA_LAT_TO_METERS;
+	metersPerLongitude = DELTA_LON_TO_METERS;
+	latitudePerMeter = METERS_TO_DELTA_LAT;
+	longitudePerMeter = METERS_TO_DELTA_LON;
+}
+
+au_uav_ros::LocalFrame::LocalFrame(double latitude, double longitude, double altitude)	{
+	anchor(latitude, longitude, altitude);
+}
+
+void au_uav_ros::LocalFrame::anchor(double latitude, double longitude, double altitude)	{
+	origin.latitude = latitude;
+	origin.longitude = longitude;
+	origin.altitude = altitude;
+	setScale(latitude);
+	anchored = true;
+}
+
+/* Length of a degree along the meridian (from the meridional radius of curvature) and along the
+ * parallel (from the prime vertical radius of curvature) at this latitude.
+ */
+void au_uav_ros::LocalFrame::setScale(double latitude)	{
+	double sinLatitude = sin(latitude*DEGREE_TO_RAD);
+	double w = 1 - WGS84_ECCENTRICITY_SQUARED*sinLatitude*sinLatitude;
+	double meridional = WGS84_SEMI_MAJOR_AXIS*(1 - WGS84_ECCENTRICITY_SQUARED)/(w*sqrt(w));
+	double primeVertical = WGS84_SEMI_MAJOR_AXIS/sqrt(w);
+
+	metersPerLatitude = meridional*DEGREE_TO_RAD;
+	metersPerLongitude = primeVertical*cos(latitude*DEGREE_TO_RAD)*DEGREE_TO_RAD;
+	latitudePerMeter = 1.0/metersPerLatitude;
+	longitudePerMeter = 1.0/metersPerLongitude;
+}
+
+bool au_uav_ros::LocalFrame::isAnchored() const	{
+	return anchored;
+}
+
+au_uav_ros::coordinate au_uav_ros::LocalFrame::getAnchor() const	{
+	return origin;
+}
+
+double au_uav_ros::LocalFrame::metersPerDegreeLatitude() const	{
+	return metersPerLatitude;
+}
+
+double au_uav_ros::LocalFrame::metersPerDegreeLongitude() const	{
+	return metersPerLongitude;
+}
+
+au_uav_ros::coordinate au_uav_ros::LocalFrame::toCoordinate(const au_uav_ros::localPosition &position) const	{
+	au_uav_ros::coordinate c;
+	c.latitude = toLatitude(position.y);
+	c.longitude = toLongitude(position.x);
+	c.altitude = origin.altitude + position.z;
+	return c;
+}
+
+au_uav_ros::LocalFrame & au_uav_ros::LocalFrame::mission()	{
+	static LocalFrame missionFrame;
+	return missionFrame;
+}
@@ -0,0 +1,68 @@
+/*
+Description:
+		Implementation of NeighborTable.h. For information on how to use these functions, visit NeighborTable.h.
+		Comments in this file are related to implementation, not usage.
+
+Date: 10/14/26
+*/
+
+#include "au_uav_ros/NeighborTable.h"
+
+//A NeighborState has to stay within one cache line, this fails to compile if a field pushes it over
+typedef char neighborStateFitsInACacheLine[sizeof(fsquared::NeighborState) <= 64 ? 1 : -1];
+
+namespace	{
+	fsquared::NeighborState emptySlot()	{
+		fsquared::NeighborState empty = fsquared::NeighborState();
+		empty.id = fsquared::NO_NEIGHBOR;
+		return empty;
+	}
+}
+
+fsquared::NeighborTable::NeighborTable()	{
+	count = 0;
+}
+
+void fsquared::NeighborTable::update(const fsquared::NeighborState &neighbor)	{
+	if(neighbor.id < 0)
+		return;
+	if(neighbor.id >= (int)slots.size())
+		slots.resize(neighbor.id + 1, emptySlot());
+	if(slots[neighbor.id].id == NO_NEIGHBOR)
+		count++;
+	slots[neighbor.id] = neighbor;
+}
+
+void fsquared::NeighborTable::erase(int planeID)	{
+	if(find(planeID) == NULL)
+		return;
+	slots[planeID].id = NO_NEIGHBOR;
+	count--;
+}
+
+//assign() keeps the capacity
+void fsquared::NeighborTable::clear()	{
+	slots.assign(slots.size(), emptySlot());
+	count = 0;
+}
+
+void fsquared::NeighborTable::reserve(int planeIDs)	{
+	if(planeIDs > (int)slots.size())
+		slots.resize(planeIDs, emptySlot());
+}
+
+bool fsquared::NeighborTable::contains(int planeID) const	{
+	return find(planeID) != NULL;
+}
+
+int fsquared::NeighborTable::size() const	{
+	return count;
+}
+
+bool fsquared::NeighborTable::empty() const	{
+	return count == 0;
+}
+
+int fsquared::NeighborTable::idLimit() const	{
+	return slots.size();
+}
@@ -0,0 +1,401 @@
+/*
+Description:
+		Implementation of RepulsiveForceBatch.h. For information on how to use these functions, visit RepulsiveForceBatch.h.
+		Comments in this file are related to implementation, not usage.
+
+		The pass is written once (forceLanes) against a small set of operations, and each
+		instruction set supplies those operations in its own struct. scalarOps handles one plane
+		at a time and is used for the fallback and for the planes left over at the end of a batch.
+
+Date: 10/14/26
+*/
+
+#include <math.h>
+#include "au_uav_ros/RepulsiveForceBatch.h"
+#include "au_uav_ros/standardFuncs.h"	//toCartesian, DEGREE_TO_RAD
+
+#if defined(FSQUARED_NO_SIMD)
+	//scalar only
+#elif defined(__AVX__)
+	#include <immintrin.h>
+	#define FSQUARED_BATCH_AVX
+#elif defined(__SSE2__)
+	#include <emmintrin.h>
+	#define FSQUARED_BATCH_SSE2
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+	#include <arm_neon.h>
+	#define FSQUARED_BATCH_NEON
+#endif
+
+namespace	{
+
+typedef fsquared::batchReal real;
+
+/*
+ * exp() for the vector paths, there is no vector exp in SSE2/AVX/NEON.
+ * exp(a) = exp(a/64)^64: a/64 is small enough for a short Taylor series, then 6 squarings.
+ * Arguments below -40 are clamped, exp(-40)*maxForce is far below the tolerance anyway.
+ */
+template <class Ops>
+inline typename Ops::vec vectorExp(typename Ops::vec a)	{
+	typedef typename Ops::vec vec;
+	static const double inverseFactorial[] = {1.0, 1.0, 1.0/2, 1.0/6, 1.0/24, 1.0/120, 1.0/720, 1.0/5040,
+			1.0/40320, 1.0/362880, 1.0/3628800, 1.0/39916800, 1.0/479001600, 1.0/6227020800.0};
+
+	vec r = Ops::mul(Ops::max(a, Ops::set1(-40)), Ops::set1(1.0/64));
+	vec p = Ops::set1(inverseFactorial[Ops::expTerms - 1]);
+	for(int k = Ops::expTerms - 2; k >= 0; k--)
+		p = Ops::add(Ops::mul(p, r), Ops::set1(inverseFactorial[k]));
+	for(int k = 0; k < 6; k++)
+		p = Ops::mul(p, p);
+	return p;
+}
+
+struct scalarOps	{
+	typedef real vec;
+	typedef bool mask;
+	enum { width = 1 };
+
+	static vec load(const real *p)			{ return *p; }
+	static void store(real *p, vec a)		{ *p = a; }
+	static vec set1(double a)				{ return a; }
+	static vec add(vec a, vec b)			{ return a + b; }
+	static vec sub(vec a, vec b)			{ return a - b; }
+	static vec mul(vec a, vec b)			{ return a * b; }
+	static vec rsqrt(vec a)					{ return 1/sqrt(a); }
+	static vec exp(vec a)					{ return ::exp(a); }
+	static vec trunc(vec a)					{ return (int)a; }	//the same conversion OvalField does
+	static mask lessThan(vec a, vec b)		{ return a < b; }
+	static mask equal(vec a, vec b)			{ return a == b; }
+	static vec select(mask m, vec a, vec b)	{ return m ? a : b; }
+	static vec zeroUnless(mask m, vec a)	{ return m ? a : 0; }
+	static int bits(mask m)					{ return m; }
+};
+
+#ifdef FSQUARED_BATCH_AVX
+struct avxOps	{
+	typedef __m256d vec;
+	typedef __m256d mask;
+	enum { width = 4, expTerms = 14 };
+
+	static vec load(const real *p)			{ return _mm256_loadu_pd(p); }
+	static void store(real *p, vec a)		{ _mm256_storeu_pd(p, a); }
+	static vec set1(double a)				{ return _mm256_set1_pd(a); }
+	static vec add(vec a, vec b)			{ return _mm256_add_pd(a, b); }
+	static vec sub(vec a, vec b)			{ return _mm256_sub_pd(a, b); }
+	static vec mul(vec a, vec b)			{ return _mm256_mul_pd(a, b); }
+	static vec max(vec a, vec b)			{ return _mm256_max_pd(a, b); }
+	static vec rsqrt(vec a)					{ return _mm256_div_pd(_mm256_set1_pd(1), _mm256_sqrt_pd(a)); }
+	static vec exp(vec a)					{ return vectorExp<avxOps>(a); }
+	static vec trunc(vec a)					{ return _mm256_round_pd(a, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); }
+	static mask lessThan(vec a, vec b)		{ return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+	static mask equal(vec a, vec b)			{ return _mm256_cmp_pd(a, b, _CMP_EQ_OQ); }
+	static vec select(mask m, vec a, vec b)	{ return _mm256_blendv_pd(b, a, m); }
+	static vec zeroUnless(mask m, vec a)	{ return _mm256_and_pd(m, a); }
+	static int bits(mask m)					{ return _mm256_movemask_pd(m); }
+};
+typedef avxOps simdOps;
+#endif
+
+#ifdef FSQUARED_BATCH_SSE2
+struct sse2Ops	{
+	typedef __m128d vec;
+	typedef __m128d mask;
+	enum { width = 2, expTerms = 14 };
+
+	static vec load(const real *p)			{ return _mm_loadu_pd(p); }
+	static void store(real *p, vec a)		{ _mm_storeu_pd(p, a); }
+	static vec set1(double a)				{ return _mm_set1_pd(a); }
+	static vec add(vec a, vec b)			{ return _mm_add_pd(a, b); }
+	static vec sub(vec a, vec b)			{ return _mm_sub_pd(a, b); }
+	static vec mul(vec a, vec b)			{ return _mm_mul_pd(a, b); }
+	static vec max(vec a, vec b)			{ return _mm_max_pd(a, b); }
+	static vec rsqrt(vec a)					{ return _mm_div_pd(_mm_set1_pd(1), _mm_sqrt_pd(a)); }
+	static vec exp(vec a)					{ return vectorExp<sse2Ops>(a); }
+	static vec trunc(vec a)					{ return _mm_cvtepi32_pd(_mm_cvttpd_epi32(a)); }
+	static mask lessThan(vec a, vec b)		{ return _mm_cmplt_pd(a, b); }
+	static mask equal(vec a, vec b)			{ return _mm_cmpeq_pd(a, b); }
+	static vec select(mask m, vec a, vec b)	{ return _mm_or_pd(_mm_and_pd(m, a), _mm_andnot_pd(m, b)); }
+	static vec zeroUnless(mask m, vec a)	{ return _mm_and_pd(m, a); }
+	static int bits(mask m)					{ return _mm_movemask_pd(m); }
+};
+typedef sse2Ops simdOps;
+#endif
+
+#ifdef FSQUARED_BATCH_NEON
+struct neonOps	{
+	typedef float32x4_t vec;
+	typedef uint32x4_t mask;
+	enum { width = 4, expTerms = 9 };	//enough terms for float
+
+	static vec load(const real *p)			{ return vld1q_f32(p); }
+	static void store(real *p, vec a)		{ vst1q_f32(p, a); }
+	static vec set1(double a)				{ return vdupq_n_f32((float)a); }
+	static vec add(vec a, vec b)			{ return vaddq_f32(a, b); }
+	static vec sub(vec a, vec b)			{ return vsubq_f32(a, b); }
+	static vec mul(vec a, vec b)			{ return vmulq_f32(a, b); }
+	static vec max(vec a, vec b)			{ return vmaxq_f32(a, b); }
+	//ARMv7 has no vector divide or square root, refine the estimate with two Newton-Raphson steps
+	static vec rsqrt(vec a)	{
+		vec e = vrsqrteq_f32(a);
+		e = vmulq_f32(e, vrsqrtsq_f32(vmulq_f32(a, e), e));
+		return vmulq_f32(e, vrsqrtsq_f32(vmulq_f32(a, e), e));
+	}
+	static vec exp(vec a)					{ return vectorExp<neonOps>(a); }
+	static vec trunc(vec a)					{ return vcvtq_f32_s32(vcvtq_s32_f32(a)); }
+	static mask lessThan(vec a, vec b)		{ return vcltq_f32(a, b); }
+	static mask equal(vec a, vec b)			{ return vceqq_f32(a, b); }
+	static vec select(mask m, vec a, vec b)	{ return vbslq_f32(m, a, b); }
+	static vec zeroUnless(mask m, vec a)	{ return vreinterpretq_f32_u32(vandq_u32(m, vreinterpretq_u32_f32(a))); }
+	static int bits(mask m)	{
+		return (vgetq_lane_u32(m, 0) & 1) | (vgetq_lane_u32(m, 1) & 2) | (vgetq_lane_u32(m, 2) & 4) | (vgetq_lane_u32(m, 3) & 8);
+	}
+};
+typedef neonOps simdOps;
+#endif
+
+//Pointers into the batch's arrays, so forceLanes does not need to know about RepulsiveForceBatch
+struct lanes	{
+	const real *x, *y, *headingX, *headingY;
+	real *relativeX, *relativeY, *magnitude, *forceX, *forceY;
+	unsigned char *inField;
+};
+
+/*
+ * Runs Ops::width planes starting at i. The steps follow calculateRepulsiveForce, with the
+ * angles replaced by the unit vector along the enemy's bearing.
+ */
+template <class Ops>
+inline void forceLanes(const OvalField::shapeVariables &shape, const BivariateNormal::forceVariables &function,
+						typename Ops::vec meX, typename Ops::vec meY, const lanes &l, int i)	{
+	typedef typename Ops::vec vec;
+	typedef typename Ops::mask mask;
+	const vec zero = Ops::set1(0), one = Ops::set1(1);
+
+	//vector from the enemy to "me"
+	vec dx = Ops::sub(meX, Ops::load(l.x + i));
+	vec dy = Ops::sub(meY, Ops::load(l.y + i));
+
+	//"me" in the enemy's frame: y along its bearing, x to its right (findRelativePosition)
+	vec hx = Ops::load(l.headingX + i);
+	vec hy = Ops::load(l.headingY + i);
+	vec relX = Ops::sub(Ops::mul(hy, dx), Ops::mul(hx, dy));
+	vec relY = Ops::add(Ops::mul(hx, dx), Ops::mul(hy, dy));
+
+	//the field and the function both work on the coordinates truncated to int
+	vec tx = Ops::trunc(relX), ty = Ops::trunc(relY);
+	vec tx2 = Ops::mul(tx, tx), ty2 = Ops::mul(ty, ty);
+
+	//OvalField compares y against +-sqrt((gamma - alpha*x^2)/beta), squaring both sides
+	//gives alpha*x^2 + beta*y^2 < gamma with the bottom constants behind the enemy
+	mask behind = Ops::lessThan(ty, zero);
+	vec alpha = Ops::select(behind, Ops::set1(shape.alphaBot), Ops::set1(shape.alphaTop));
+	vec beta = Ops::select(behind, Ops::set1(shape.betaBot), Ops::set1(shape.betaTop));
+	mask inside = Ops::lessThan(Ops::add(Ops::mul(alpha, tx2), Ops::mul(beta, ty2)), Ops::set1(shape.gamma));
+
+	//bivariate normal, zeroed outside the field
+	vec exponent = Ops::sub(zero, Ops::add(Ops::mul(Ops::set1(function.alpha), tx2), Ops::mul(Ops::set1(function.beta), ty2)));
+	vec mag = Ops::zeroUnless(inside, Ops::mul(Ops::set1(function.maxForce), Ops::exp(exponent)));
+
+	//force points from the enemy to "me", east when the planes are on top of each other (atan2(0, 0) == 0)
+	vec d2 = Ops::add(Ops::mul(dx, dx), Ops::mul(dy, dy));
+	mask same = Ops::equal(d2, zero);
+	vec inverseDistance = Ops::rsqrt(Ops::select(same, one, d2));
+	vec ux = Ops::select(same, one, Ops::mul(dx, inverseDistance));
+	vec uy = Ops::select(same, zero, Ops::mul(dy, inverseDistance));
+
+	Ops::store(l.relativeX + i, relX);
+	Ops::store(l.relativeY + i, relY);
+	Ops::store(l.magnitude + i, mag);
+	Ops::store(l.forceX + i, Ops::mul(mag, ux));
+	Ops::store(l.forceY + i, Ops::mul(mag, uy));
+	int insideBits = Ops::bits(inside);
+	for(int lane = 0; lane < Ops::width; lane++)
+		l.inField[i + lane] = (insideBits >> lane) & 1;
+}
+
+//Run Ops over as much of the batch as fits in whole vectors, returns where it stopped
+template <class Ops>
+int forceBatch(const OvalField::shapeVariables &shape, const BivariateNormal::forceVariables &function,
+				double meX, double meY, const lanes &l, int count)	{
+	typename Ops::vec vx = Ops::set1(meX), vy = Ops::set1(meY);
+	int i = 0;
+	for(; i + Ops::width <= count; i += Ops::width)
+		forceLanes<Ops>(shape, function, vx, vy, l, i);
+	return i;
+}
+
+}
+
+fsquared::RepulsiveForceBatch::RepulsiveForceBatch()	{
+	shapeParams = OvalField().getShapeParams();
+	functionParams = BivariateNormal().getFunctionParams();
+}
+
+fsquared::RepulsiveForceBatch::RepulsiveForceBatch(const OvalField &shape, const BivariateNormal &function)	{
+	shapeParams = shape.getShapeParams();
+	functionParams = function.getFunctionParams();
+}
+
+bool fsquared::RepulsiveForceBatch::setField(const AnyForceField &field)	{
+	OvalField shape(shapeParams);
+	BivariateNormal function(functionParams);
+	if(shape == field.getOval() && function == field.getBivariateNormal())
+		return false;
+	shapeParams = field.getOval().getShapeParams();
+	functionParams = field.getBivariateNormal().getFunctionParams();
+	return true;
+}
+
+void fsquared::RepulsiveForceBatch::clear()	{
+	planeIDs.clear();
+	x.clear();
+	y.clear();
+	headingX.clear();
+	headingY.clear();
+	relativeX.clear();
+	relativeY.clear();
+	magnitude.clear();
+	forceX.clear();
+	forceY.clear();
+	inField.clear();
+}
+
+void fsquared::RepulsiveForceBatch::add(int planeID, double _x, double _y, double bearing)	{
+	double heading = toCartesian(bearing)*DEGREE_TO_RAD;
+	planeIDs.push_back(planeID);
+	x.push_back(_x);
+	y.push_back(_y);
+	headingX.push_back(cos(heading));
+	headingY.push_back(sin(heading));
+
+	//outputs are sized here so computeForces never allocates
+	relativeX.push_back(0);
+	relativeY.push_back(0);
+	magnitude.push_back(0);
+	forceX.push_back(0);
+	forceY.push_back(0);
+	inField.push_back(0);
+}
+
+void fsquared::RepulsiveForceBatch::set(int i, double _x, double _y, double bearing)	{
+	double heading = toCartesian(bearing)*DEGREE_TO_RAD;
+	x[i] = _x;
+	y[i] = _y;
+	headingX[i] = cos(heading);
+	headingY[i] = sin(heading);
+}
+
+int fsquared::RepulsiveForceBatch::remove(int i)	{
+	int last = size() - 1;
+	int moved = -1;
+	if(i != last)	{
+		moved = planeIDs[i] = planeIDs[last];
+		x[i] = x[last];
+		y[i] = y[last];
+		headingX[i] = headingX[last];
+		headingY[i] = headingY[last];
+		relativeX[i] = relativeX[last];
+		relativeY[i] = relativeY[last];
+		magnitude[i] = magnitude[last];
+		forceX[i] = forceX[last];
+		forceY[i] = forceY[last];
+		inField[i] = inField[last];
+	}
+	planeIDs.pop_back();
+	x.pop_back();
+	y.pop_back();
+	headingX.pop_back();
+	headingY.pop_back();
+	relativeX.pop_back();
+	relativeY.pop_back();
+	magnitude.pop_back();
+	forceX.pop_back();
+	forceY.pop_back();
+	inField.pop_back();
+	return moved;
+}
+
+int fsquared::RepulsiveForceBatch::size() const	{
+	return planeIDs.size();
+}
+
+au_uav_ros::mathVector fsquared::RepulsiveForceBatch::computeForces(double meX, double meY)	{
+	return compute(meX, meY, true);
+}
+
+au_uav_ros::mathVector fsquared::RepulsiveForceBatch::computeForcesScalar(double meX, double meY)	{
+	return compute(meX, meY, false);
+}
+
+void fsquared::RepulsiveForceBatch::computeForce(int i, double meX, double meY)	{
+	lanes l = {&x[0], &y[0], &headingX[0], &headingY[0],
+			&relativeX[0], &relativeY[0], &magnitude[0], &forceX[0], &forceY[0], &inField[0]};
+	forceLanes<scalarOps>(shapeParams, functionParams, meX, meY, l, i);
+}
+
+au_uav_ros::mathVector fsquared::RepulsiveForceBatch::compute(double meX, double meY, bool useSimd)	{
+	int count = size();
+	if(count == 0)
+		return au_uav_ros::mathVector();
+
+	lanes l = {&x[0], &y[0], &headingX[0], &headingY[0],
+			&relativeX[0], &relativeY[0], &magnitude[0], &forceX[0], &forceY[0], &inField[0]};
+
+	int done = 0;
+#if defined(FSQUARED_BATCH_AVX) || defined(FSQUARED_BATCH_SSE2) || defined(FSQUARED_BATCH_NEON)
+	if(useSimd)
+		done = forceBatch<simdOps>(shapeParams, functionParams, meX, meY, l, count);
+#endif
+	//whatever did not fill a whole vector
+	for(int i = done; i < count; i++)
+		forceLanes<scalarOps>(shapeParams, functionParams, meX, meY, l, i);
+
+	//sum in double, in the order the planes were added
+	double sumX = 0, sumY = 0;
+	for(int i = 0; i < count; i++)	{
+		sumX += forceX[i];
+		sumY += forceY[i];
+	}
+	return au_uav_ros::mathVector::fromCartesian(sumX, sumY);
+}
+
+int fsquared::RepulsiveForceBatch::getPlaneID(int i) const	{
+	return planeIDs[i];
+}
+
+bool fsquared::RepulsiveForceBatch::isInField(int i) const	{
+	return inField[i];
+}
+
+double fsquared::RepulsiveForceBatch::getRelativeX(int i) const	{
+	return relativeX[i];
+}
+
+double fsquared::RepulsiveForceBatch::getRelativeY(int i) const	{
+	return relativeY[i];
+}
+
+double fsquared::RepulsiveForceBatch::getMagnitude(int i) const	{
+	return magnitude[i];
+}
+
+double fsquared::RepulsiveForceBatch::getForceX(int i) const	{
+	return forceX[i];
+}
+
+double fsquared::RepulsiveForceBatch::getForceY(int i) const	{
+	return forceY[i];
+}
+
+const char * fsquared::RepulsiveForceBatch::simdName()	{
+#if defined(FSQUARED_BATCH_AVX)
+	return "AVX";
+#elif defined(FSQUARED_BATCH_SSE2)
+	return "SSE2";
+#elif defined(FSQUARED_BATCH_NEON)
+	return "NEON";
+#else
+	return "scalar";
+#endif
+}
@@ -0,0 +1,113 @@
+/*
+Description:
+		Implementation of SpatialGrid.h. For information on how to use these functions, visit SpatialGrid.h.
+		Comments in this file are related to implementation, not usage.
+
+Date: 10/14/26
+*/
+
+#include <math.h>
+#include <algorithm>
+#include "au_uav_ros/SpatialGrid.h"
+#include "au_uav_ros/LocalFrame.h"
+
+fsquared::SpatialGrid::SpatialGrid(double _cellSize)	{
+	cellSize = _cellSize;
+}
+
+//Pack column and row into one key, row in the low 32 bits
+fsquared::SpatialGrid::cellKey fsquared::SpatialGrid::keyFor(int column, int row) const	{
+	return ((cellKey)column << 32) | (cellKey)(unsigned int)row;
+}
+
+//floor, not truncation, so that cells on either side of zero are the same size
+int fsquared::SpatialGrid::cellIndex(double meters) const	{
+	return (int)floor(meters / cellSize);
+}
+
+void fsquared::SpatialGrid::update(int planeID, double latitude, double longitude)	{
+	const au_uav_ros::LocalFrame &frame = au_uav_ros::LocalFrame::mission();
+	double x = frame.toX(longitude);
+	double y = frame.toY(latitude);
+	cellKey newCell = keyFor(cellIndex(x), cellIndex(y));
+
+	std::map<int, member>::iterator it = members.find(planeID);
+	if(it == members.end())	{
+		//new plane
+		member m;
+		m.cell = newCell;
+		m.x = x;
+		m.y = y;
+		members[planeID] = m;
+		cells[newCell].push_back(planeID);
+		return;
+	}
+
+	//plane moved to another cell, take it out of the old one
+	if(it->second.cell != newCell)	{
+		std::vector<int> &oldCell = cells[it->second.cell];
+		std::vector<int>::iterator pos = std::find(oldCell.begin(), oldCell.end(), planeID);
+		if(pos != oldCell.end())	{
+			*pos = oldCell.back();
+			oldCell.pop_back();
+		}
+		//empty cells are kept so that a plane flying back and forth does not reallocate
+		cells[newCell].push_back(planeID);
+		it->second.cell = newCell;
+	}
+	it->second.x = x;
+	it->second.y = y;
+}
+
+void fsquared::SpatialGrid::remove(int planeID)	{
+	std::map<int, member>::iterator it = members.find(planeID);
+	if(it == members.end())
+		return;
+
+	std::vector<int> &cell = cells[it->second.cell];
+	std::vector<int>::iterator pos = std::find(cell.begin(), cell.end(), planeID);
+	if(pos != cell.end())	{
+		*pos = cell.back();
+		cell.pop_back();
+	}
+	members.erase(it);
+}
+
+const std::vector<int> & fsquared::SpatialGrid::findNeighbors(double latitude, double longitude, double radius)	{
+	const au_uav_ros::LocalFrame &frame = au_uav_ros::LocalFrame::mission();
+	double x = frame.toX(longitude);
+	double y = frame.toY(latitude);
+
+	neighbors.clear();
+
+	int minColumn = cellIndex(x - radius), maxColumn = cellIndex(x + radius);
+	int minRow = cellIndex(y - radius), maxRow = cellIndex(y + radius);
+
+	for(int column = minColumn; column <= maxColumn; column++)	{
+		for(int row = minRow; row <= maxRow; row++)	{
+			std::map<cellKey, std::vector<int> >::const_iterator cell = cells.find(keyFor(column, row));
+			if(cell == cells.end())
+				continue;
+
+			//cells at the corners of the search square can hold planes outside the radius
+			for(unsigned int i = 0; i < cell->second.size(); i++)	{
+				const member &m = members[cell->second[i]];
+				double xdiff = m.x - x;
+				double ydiff = m.y - y;
+				if(xdiff*xdiff + ydiff*ydiff <= radius*radius)
+					neighbors.push_back(cell->second[i]);
+			}
+		}
+	}
+	return neighbors;
+}
+
+int fsquared::SpatialGrid::size() const	{
+	return members.size();
+}
+
+void fsquared::SpatialGrid::clear()	{
+	cells.clear();
+	members.clear();
+	neighbors.clear();
+}
@@ -0,0 +1,182 @@
+/*
+Description:
+		Implementation of ThreatFilter.h. For information on how to use these functions, visit ThreatFilter.h.
+		Comments in this file are related to implementation, not usage.
+
+Date: 10/14/26
+*/
+
+#include <math.h>
+#include <algorithm>
+
+#include "au_uav_ros/ThreatFilter.h"
+#include "au_uav_ros/planeObject.h"
+#include "au_uav_ros/NeighborTable.h"
+
+#define MIN_CLOSING_SPEED_SQUARED 1e-6	//(m/s)^2, below this the planes are not moving relative to each other
+
+fsquared::ThreatFilter::ThreatFilter(double _maxTimeToGo, double _maxMissDistance, double _keepDistance)	{
+	maxTimeToGo = _maxTimeToGo;
+	maxMissDistance = _maxMissDistance;
+	keepDistance = _keepDistance;
+	resetCounters();
+}
+
+void fsquared::ThreatFilter::setMaxTimeToGo(double seconds)	{
+	maxTimeToGo = seconds;
+}
+
+void fsquared::ThreatFilter::setMaxMissDistance(double meters)	{
+	maxMissDistance = meters;
+}
+
+void fsquared::ThreatFilter::setKeepDistance(double meters)	{
+	keepDistance = meters;
+}
+
+double fsquared::ThreatFilter::getMaxTimeToGo() const	{
+	return maxTimeToGo;
+}
+
+double fsquared::ThreatFilter::getMaxMissDistance() const	{
+	return maxMissDistance;
+}
+
+double fsquared::ThreatFilter::getKeepDistance() const	{
+	return keepDistance;
+}
+
+/*
+ * Bearings are cardinal, so east (x) is the sine and north (y) the cosine.
+ * With r the enemy's position and v its velocity, both relative to "me", the planes are
+ * closest at t = -(r.v)/(v.v), and are then |r + vt| apart.
+ */
+au_uav_ros::threatContainer fsquared::ThreatFilter::assess(const au_uav_ros::PlaneObject &me, const fsquared::NeighborState &enemy)	{
+	au_uav_ros::localPosition meLocal = me.getLocalPosition();
+	double rx = enemy.position.x - meLocal.x;
+	double ry = enemy.position.y - meLocal.y;
+
+	double meSpeed = me.getSpeed() > 0 ? me.getSpeed() : MPS_SPEED;
+	double enemySpeed = enemy.speed > 0 ? enemy.speed : MPS_SPEED;
+	double meBearing = me.getCurrentBearing()*DEGREE_TO_RAD;
+	double enemyBearing = enemy.targetBearing*DEGREE_TO_RAD;
+	double vx = enemySpeed*sin(enemyBearing) - meSpeed*sin(meBearing);
+	double vy = enemySpeed*cos(enemyBearing) - meSpeed*cos(meBearing);
+
+	au_uav_ros::threatContainer threat;
+	threat.planeID = enemy.id;
+
+	double closingSquared = vx*vx + vy*vy;
+	if(closingSquared < MIN_CLOSING_SPEED_SQUARED)	{
+		threat.timeToGo = 0;
+		threat.ZEM = sqrt(rx*rx + ry*ry);
+		return threat;
+	}
+
+	threat.timeToGo = -(rx*vx + ry*vy)/closingSquared;
+	double missX = rx + vx*threat.timeToGo;
+	double missY = ry + vy*threat.timeToGo;
+	threat.ZEM = sqrt(missX*missX + missY*missY);
+	return threat;
+}
+
+bool fsquared::ThreatFilter::admit(const au_uav_ros::PlaneObject &me, const fsquared::NeighborState &enemy)	{
+	checked++;
+	au_uav_ros::threatContainer threat = assess(me, enemy);
+
+	//close planes go on to the field test whatever they are doing
+	au_uav_ros::localPosition meLocal = me.getLocalPosition();
+	double dx = enemy.position.x - meLocal.x, dy = enemy.position.y - meLocal.y;
+	bool close = dx*dx + dy*dy <= keepDistance*keepDistance;
+
+	if(!close)	{
+		bool dropped = true;
+		if(threat.timeToGo < 0)
+			diverging++;
+		else if(threat.timeToGo > maxTimeToGo)
+			farFuture++;
+		else if(threat.ZEM > maxMissDistance)
+			wideMiss++;
+		else
+			dropped = false;
+
+		if(dropped)	{
+			remove(enemy.id);
+			return false;
+		}
+	}
+
+	if(enemy.id < 0)
+		return true;
+	if(enemy.id >= (int)threats.size())	{
+		au_uav_ros::threatContainer empty;
+		empty.planeID = NO_NEIGHBOR;
+		empty.ZEM = 0;
+		empty.timeToGo = 0;
+		threats.resize(enemy.id + 1, empty);
+	}
+	threats[enemy.id] = threat;
+	admitted++;
+	return true;
+}
+
+void fsquared::ThreatFilter::remove(int planeID)	{
+	if(planeID >= 0 && planeID < (int)threats.size())
+		threats[planeID].planeID = NO_NEIGHBOR;
+}
+
+//ranked keeps its capacity, so once every plane has been a threat this does not allocate
+const std::vector<au_uav_ros::threatContainer> & fsquared::ThreatFilter::rankThreats()	{
+	ranked.clear();
+	for(unsigned int id = 0; id < threats.size(); id++)
+		if(threats[id].planeID != NO_NEIGHBOR)
+			ranked.push_back(threats[id]);
+	std::sort(ranked.begin(), ranked.end(), fsquared::moreUrgent);
+	return ranked;
+}
+
+const au_uav_ros::threatContainer * fsquared::ThreatFilter::find(int planeID) const	{
+	if(planeID < 0 || planeID >= (int)threats.size() || threats[planeID].planeID == NO_NEIGHBOR)
+		return NULL;
+	return &threats[planeID];
+}
+
+long fsquared::ThreatFilter::getChecked() const	{
+	return checked;
+}
+
+long fsquared::ThreatFilter::getAdmitted() const	{
+	return admitted;
+}
+
+long fsquared::ThreatFilter::getDiverging() const	{
+	return diverging;
+}
+
+long fsquared::ThreatFilter::getFarFuture() const	{
+	return farFuture;
+}
+
+long fsquared::ThreatFilter::getWideMiss() const	{
+	return wideMiss;
+}
+
+long fsquared::ThreatFilter::getDropped() const	{
+	return diverging + farFuture + wideMiss;
+}
+
+void fsquared::ThreatFilter::resetCounters()	{
+	checked = 0;
+	admitted = 0;
+	diverging = 0;
+	farFuture = 0;
+	wideMiss = 0;
+}
+
+bool fsquared::moreUrgent(const au_uav_ros::threatContainer &a, const au_uav_ros::threatContainer &b)	{
+	if(a.timeToGo != b.timeToGo)
+		return a.timeToGo < b.timeToGo;
+	if(a.ZEM != b.ZEM)
+		return a.ZEM < b.ZEM;
+	return a.planeID < b.planeID;
+}
@@ -0,0 +1,168 @@
+/*
+Description:
+		Implementation of ThreatSet.h. For information on how to use these functions, visit ThreatSet.h.
+		Comments in this file are related to implementation, not usage.
+
+Date: 10/14/26
+*/
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <ros/ros.h>
+
+#include "au_uav_ros/ThreatSet.h"
+#include "au_uav_ros/ThreatFilter.h"
+#include "au_uav_ros/planeObject.h"
+#include "au_uav_ros/NeighborTable.h"
+
+#define MOVING_APART_URGENCY 1e9	//added to the distance, ranks planes moving apart after any closing one
+#define DISTANCE_DEADLINE_STRIDE 16	//planes ranked by distance between looks at the clock, reading it costs more than one
+
+fsquared::ThreatSet::ThreatSet(int _maxThreats, fsquared::threatPriority _priority)	{
+	setMaxThreats(_maxThreats);
+	priority = _priority;
+	considered = 0;
+	summed = 0;
+	cut = false;
+	deadlinesMissed = 0;
+	threatsDropped = 0;
+}
+
+void fsquared::ThreatSet::setMaxThreats(int _maxThreats)	{
+	maxThreats = _maxThreats < 1 ? 1 : _maxThreats;
+	heap.clear();
+	heap.reserve(maxThreats);
+}
+
+int fsquared::ThreatSet::getMaxThreats() const	{
+	return maxThreats;
+}
+
+void fsquared::ThreatSet::setPriority(fsquared::threatPriority _priority)	{
+	priority = _priority;
+}
+
+fsquared::threatPriority fsquared::ThreatSet::getPriority() const	{
+	return priority;
+}
+
+//Orders the heap, the largest urgency (least urgent) is on top. Ties go by plane ID so the
+//order does not depend on the order the map was walked in.
+bool fsquared::ThreatSet::lessUrgent(const threat &a, const threat &b)	{
+	if(a.urgency != b.urgency)
+		return a.urgency < b.urgency;
+	return a.planeID < b.planeID;
+}
+
+//Keeps the maxThreats most urgent candidates. Once full, a candidate only gets in by pushing
+//out the least urgent one on top.
+void fsquared::ThreatSet::offer(const threat &candidate)	{
+	if((int)heap.size() < maxThreats)	{
+		heap.push_back(candidate);
+		std::push_heap(heap.begin(), heap.end(), lessUrgent);
+	}
+	else if(lessUrgent(candidate, heap.front()))	{
+		std::pop_heap(heap.begin(), heap.end(), lessUrgent);
+		heap.back() = candidate;
+		std::push_heap(heap.begin(), heap.end(), lessUrgent);
+	}
+}
+
+au_uav_ros::mathVector fsquared::ThreatSet::sumRepulsiveForces(au_uav_ros::PlaneObject &me, const fsquared::NeighborTable &planesToAvoid,
+															double deadline)	{
+	au_uav_ros::localPosition meLocal = me.getLocalPosition();
+	heap.clear();
+	considered = 0;
+	summed = 0;
+	cut = false;
+
+	//rank, the deadline is checked here too so a long map cannot run past it. time_to_go and
+	//force are expensive per plane and check after every one
+	int stride = priority == THREAT_BY_DISTANCE ? DISTANCE_DEADLINE_STRIDE : 1;
+	for(int id = 0; id < planesToAvoid.idLimit() && !cut; id++)	{
+		const fsquared::NeighborState *enemy = planesToAvoid.find(id);
+		if(enemy == NULL)
+			continue;
+		considered++;
+
+		threat candidate;
+		candidate.planeID = id;
+		candidate.forceX = 0;
+		candidate.forceY = 0;
+		double dx = enemy->position.x - meLocal.x, dy = enemy->position.y - meLocal.y;
+		if(priority == THREAT_BY_TIME_TO_GO)	{
+			au_uav_ros::threatContainer cpa = fsquared::ThreatFilter::assess(me, *enemy);
+			candidate.urgency = cpa.timeToGo >= 0 ? cpa.timeToGo : MOVING_APART_URGENCY + sqrt(dx*dx + dy*dy);
+		}
+		else if(priority == THREAT_BY_FORCE)	{
+			au_uav_ros::mathVector force = fsquared::calculateRepulsiveForce(me, *enemy);
+			candidate.forceX = force.getX();
+			candidate.forceY = force.getY();
+			candidate.urgency = -(candidate.forceX*candidate.forceX + candidate.forceY*candidate.forceY);
+		}
+		else
+			candidate.urgency = dx*dx + dy*dy;
+		offer(candidate);
+		if(deadline > 0 && considered % stride == 0)
+			cut = ros::WallTime::now().toSec() > deadline;
+	}
+	if(cut)
+		considered = planesToAvoid.size();
+
+	//sum, most urgent first
+	std::sort_heap(heap.begin(), heap.end(), lessUrgent);
+	double sumX = 0, sumY = 0;
+	for(unsigned int i = 0; i < heap.size(); i++)	{
+		if(priority != THREAT_BY_FORCE)	{
+			if(i > 0 && deadline > 0 && ros::WallTime::now().toSec() > deadline)	{
+				cut = true;
+				break;
+			}
+			const fsquared::NeighborState *enemy = planesToAvoid.find(heap[i].planeID);
+			au_uav_ros::mathVector force = fsquared::calculateRepulsiveForce(me, *enemy);
+			heap[i].forceX = force.getX();
+			heap[i].forceY = force.getY();
+		}
+		sumX += heap[i].forceX;
+		sumY += heap[i].forceY;
+		summed++;
+	}
+
+	if(cut)
+		deadlinesMissed++;
+	threatsDropped += considered - summed;
+	return au_uav_ros::mathVector::fromCartesian(sumX, sumY);
+}
+
+int fsquared::ThreatSet::getConsidered() const	{
+	return considered;
+}
+
+int fsquared::ThreatSet::getSummed() const	{
+	return summed;
+}
+
+bool fsquared::ThreatSet::wasCut() const	{
+	return cut;
+}
+
+long fsquared::ThreatSet::getDeadlinesMissed() const	{
+	return deadlinesMissed;
+}
+
+long fsquared::ThreatSet::getThreatsDropped() const	{
+	return threatsDropped;
+}
+
+bool fsquared::ThreatSet::parsePriority(const char *name, fsquared::threatPriority &_priority)	{
+	if(strcmp(name, "distance") == 0)
+		_priority = THREAT_BY_DISTANCE;
+	else if(strcmp(name, "time_to_go") == 0)
+		_priority = THREAT_BY_TIME_TO_GO;
+	else if(strcmp(name, "force") == 0)
+		_priority = THREAT_BY_FORCE;
+	else
+		return false;
+	return true;
+}
@@ -3,12 +3,12 @@
 #include <string>
 #include <ros/console.h>	//used for debugging
 
-au_uav_ros::ArduTalker::ArduTalker()	{
+au_uav_ros::ArduTalker::ArduTalker() : m_ardu_in(m_ardu), m_ardu_out(m_ardu)	{
 	m_port = "dev/ttyACM0";
 	m_baud = 115200;
 }
 
-au_uav_ros::ArduTalker::ArduTalker(std::string _port, int _baud)	{
+au_uav_ros::ArduTalker::ArduTalker(std::string _port, int _baud) : m_ardu_in(m_ardu), m_ardu_out(m_ardu)	{
 	m_port = _port;
 	m_baud = _baud;	
 	
@@ -23,10 +23,6 @@ bool au_uav_ros::ArduTalker::init(ros::NodeHandle _n)	{
 	updateIndex = 0;
 	WPSendSeqNum = 0;
 
-	//plane id shenanigans 
-	planeID = -1;
-	isIDSet = false;
-	
 	//Open and setup port.
 	if(m_ardu.open_port(m_port) == -1)	{
 		ROS_ERROR("Could not open port %s", m_port.c_str());
@@ -35,6 +31,7 @@ bool au_uav_ros::ArduTalker::init(ros::NodeHandle _n)	{
 	else	{
 		ROS_DEBUG("opened port %s", m_port.c_str());
 		m_ardu.setup_port(m_baud, 8, 1, true);		
+		m_ardu_out.start();
 	}
 
 
@@ -44,6 +41,7 @@ bool au_uav_ros::ArduTalker::init(ros::NodeHandle _n)	{
 	
 	m_telem_pub = m_node.advertise<au_uav_ros::Telemetry>("all_telemetry", 5);
 	m_mav_telem_pub = m_node.advertise<au_uav_ros::Telemetry>("my_mav_telemetry", 5);
+	m_mav_frame_pub = m_node.advertise<au_uav_ros::MavlinkFrame>("my_mav_frames", 5);
 	
 	service = m_node.advertiseService("getPlaneID", &ArduTalker::getPlaneID, this); 
 	return true;
@@ -63,9 +61,14 @@ void au_uav_ros::ArduTalker::run()	{
 	sendCommands.join();	
 }
 
+void au_uav_ros::ArduTalker::stop()	{
+	m_loop.stop();
+}
+
 void au_uav_ros::ArduTalker::shutdown()	{
 	//ROS_INFO("Shutting down Xbee port %s", m_port.c_str());
 	printf("ArduTalker::Shutting down Xbee port %s\n", m_port.c_str()); //i ros::shutdown when exiting run
+	m_ardu_out.stop();	//writes out what is still queued
 	m_ardu.close_port();
 }
 
@@ -73,74 +76,67 @@ void au_uav_ros::ArduTalker::shutdown()	{
 //---------------------------------------------------------------------------
 
 void au_uav_ros::ArduTalker::listen()	{
-	while(ros::ok())
-	{
-		//get a mavlink message from the serial line
-		mavlink_message_t message = au_uav_ros::mav::readMavlinkFromSerial(m_ardu);
-		//decode the message and post it to the appropriate topic
-		if(message.msgid == MAVLINK_MSG_ID_HEARTBEAT)
-		{
-			mavlink_heartbeat_t receivedHeartbeat;
-			mavlink_msg_heartbeat_decode(&message, &receivedHeartbeat);
-			ROS_INFO("Received heartbeat");
-		}
-		if(message.msgid == MAVLINK_MSG_ID_AU_UAV)
-		{
-			//We know our plane id now!
-			if(!isIDSet)	{
-				IDSetter.lock();
-				planeID = message.sysid;
-				isIDSet = true;
-				cond.notify_all();
-				IDSetter.unlock();
-				fprintf(stderr, "\nGOT PLANE ID!!!!!!!!!!!!!!!!!!!!!!!!!!!! %d\n", planeID);
-			}
-			//ROS_INFO("Received AU_UAV message from serial with ID #%d (sys:%d|comp:%d):\n", message.msgid, message.
-			au_uav_ros::Telemetry tUpdate, tRawUpdate;
-			mavlink_au_uav_t myMSG;
-			mavlink_msg_au_uav_decode(&message, &myMSG);
-			
-			//Post update as new telemetry update
-			au_uav_ros::mav::convertMavlinkTelemetryToROS(myMSG, tUpdate);
-			tUpdate.planeID = message.sysid; 
-	  		m_telem_pub.publish(tUpdate);
-		        ROS_INFO("Received telemetry message from UAV[#%d] (lat:%f|lng:%f|alt:%f)", tUpdate.planeID, tUpdate.currentLatitude, tUpdate.currentLongitude, tUpdate.currentAltitude);	
-
-			//Forward raw telemetry update to the xbee_talker node
-			au_uav_ros::mav::rawMavlinkTelemetryToRawROSTelemetry(myMSG, tRawUpdate);
-			tRawUpdate.planeID = message.sysid;
-			m_mav_telem_pub.publish(tRawUpdate);
-		}
-	}
+	m_dispatch.on(MAVLINK_MSG_ID_HEARTBEAT, boost::bind(&ArduTalker::handleHeartbeat, this, _1));
+	m_dispatch.on(MAVLINK_MSG_ID_AU_UAV, boost::bind(&ArduTalker::handleTelemetry, this, _1));
+	m_loop.addSerial(m_ardu_in, m_dispatch);
+	m_loop.run();
 }
 
+void au_uav_ros::ArduTalker::handleHeartbeat(const au_uav_ros::mav::FrameView &frame)	{
+	ROS_INFO("Received heartbeat");
+}
 
+//Fields are read straight off the frame
+void au_uav_ros::ArduTalker::handleTelemetry(const au_uav_ros::mav::FrameView &frame)	{
+	au_uav_ros::mav::AuUavView myMSG(frame);
+	if(!myMSG.valid())
+		return;
+	//Published as shared pointers, not touched after publish(): in a nodelet manager, subscribers
+	//in the same process get the pointer itself, nothing is serialized or copied
+	au_uav_ros::Telemetry::Ptr tUpdate(new au_uav_ros::Telemetry);
+
+	//Post update as new telemetry update
+	au_uav_ros::mav::convertMavlinkTelemetryToROS(myMSG, *tUpdate);
+	tUpdate->planeID = frame.sysid();
+	//We know our plane id now! And where the mission starts, once there is a fix
+	if(!identity.isSet() && identity.set(frame.sysid(), *tUpdate))
+		fprintf(stderr, "\nGOT PLANE ID!!!!!!!!!!!!!!!!!!!!!!!!!!!! %d\n", frame.sysid());
+	ROS_INFO("Received telemetry message from UAV[#%d] (lat:%f|lng:%f|alt:%f)", tUpdate->planeID, tUpdate->currentLatitude, tUpdate->currentLongitude, tUpdate->currentAltitude);
+	m_telem_pub.publish(tUpdate);
+
+	//Forward the frame itself to the xbee_talker node, it goes out on the radio as it is
+	au_uav_ros::MavlinkFrame::Ptr raw(new au_uav_ros::MavlinkFrame);
+	raw->frame.assign(frame.data(), frame.data() + frame.size());
+	m_mav_frame_pub.publish(raw);
+
+	//Raw telemetry is only converted for whoever still wants it as fields
+	if(m_mav_telem_pub.getNumSubscribers() > 0)	{
+		au_uav_ros::Telemetry::Ptr tRawUpdate(new au_uav_ros::Telemetry);
+		au_uav_ros::mav::rawMavlinkTelemetryToRawROSTelemetry(myMSG, *tRawUpdate);
+		tRawUpdate->planeID = frame.sysid();
+		m_mav_telem_pub.publish(tRawUpdate);
+	}
+}
 
 //Output - writing to xbee
 //---------------------------------------------------------------------------
-void au_uav_ros::ArduTalker::commandCallback(au_uav_ros::Command cmd)	{
+void au_uav_ros::ArduTalker::commandCallback(const au_uav_ros::Command::ConstPtr &cmd)	{
 	ROS_INFO("ArduTalker::commandCallback::ding! \n");
 	//----------------
 	//Callback time! 
 	//----------------
 	mavlink_message_t mavlinkMsg;
-	sysid = cmd.planeID;
+	sysid = cmd->planeID;
 	//stuff mavlinkMsg with the correct paramaters
 	mavlink_msg_mission_item_pack(sysid, compid, &mavlinkMsg, 
 			              sysid, serial_compid, 0, 
 				      MAV_FRAME_GLOBAL, MAV_CMD_NAV_WAYPOINT, 
 				      2, 0, 20.0, 100.0, 1.0, 0.0, 
-				      cmd.latitude, cmd.longitude, cmd.altitude);
+				      cmd->latitude, cmd->longitude, cmd->altitude);
 
 	//take command -> send to ardupilot	
-	static uint8_t buffer[MAVLINK_MAX_PACKET_LEN];
-	int messageLength = mavlink_msg_to_send_buffer(buffer, &mavlinkMsg);
-	ros::Duration(0.000001).sleep();
-	m_ardu.lock();
-	int written = write(m_ardu.getFD(), (char*)buffer, messageLength);
-	m_ardu.unlock();
-	if (messageLength != written) ROS_ERROR("ERROR: Wrote %d bytes but should have written %d\n",
-						written, messageLength);
+	if(!m_ardu_out.send(mavlinkMsg, cmd->replace ? au_uav_ros::TX_SAFETY : au_uav_ros::TX_MISSION))
+		ROS_ERROR("ERROR: send queue for %s is full, command dropped\n", m_port.c_str());
 }
 
 void au_uav_ros::ArduTalker::spinThread()	{
@@ -151,35 +147,14 @@ void au_uav_ros::ArduTalker::spinThread()	{
 
 //Service
 //------------------------------------------
-// warning - may block on ardupilot!!! probably not a good thing. SHoudl look into a timed conditional variable... once
-// the time is reached, the thing will return -1 or something
+//Waits at most PLANE_ID_WAIT for the ardupilot's first fix, then fails the call so the caller
+//(and the service thread) are not held until the autopilot answers.
 bool au_uav_ros::ArduTalker::getPlaneID(au_uav_ros::planeIDGetter::Request &req, au_uav_ros::planeIDGetter::Response &res) {
-
-	//You know what? Might as well stick a conditional variable. In for a penny in for a pound. DOn't push this waiting crap onto other nodes
-	//I don't know enough about boost.
 	fprintf(stderr, "ardutalker::getPlaneID() callback called!");
-	boost::unique_lock<boost::mutex> lock(IDSetter);
-	while(!isIDSet)	{	
-		fprintf(stderr, "ardutalker::getPlaneID() idNOT set.. waiting!");
-		cond.wait(lock);
+	if(!identity.wait(res, PLANE_ID_WAIT))	{
+		fprintf(stderr, "ardutalker::getPlaneID() no fix yet, try again");
+		return false;
 	}
-	fprintf(stderr, "ardutalker::getPlaneID() Got! %d\n", planeID);
-	res.planeID = planeID;
+	fprintf(stderr, "ardutalker::getPlaneID() Got! %d\n", res.planeID);
 	return true;	
 }
-
-//Main
-//--------------------------------------------------------
-
-int main(int argc, char** argv)	{
-
-	std::cout << "hello world!" <<std::endl;
-	std::string port = "/dev/ttyACM0";
-
-	ros::init(argc, argv, "ArduTalker");
-	ros::NodeHandle n;
-	au_uav_ros::ArduTalker talk(port, 115200);
-	if(talk.init(n))	//OK. what if the xbee can't be read???
-		talk.run();
-	talk.shutdown();
-}
@@ -0,0 +1,18 @@
+#include "au_uav_ros/ardu_talker.h"
+
+//The ardu node on its own. src/nodelets.cpp loads the same ArduTalker into a nodelet manager.
+
+int main(int argc, char** argv)	{
+
+	std::cout << "hello world!" <<std::endl;
+	std::string port;
+
+	ros::init(argc, argv, "ArduTalker");
+	ros::NodeHandle n;
+	ros::NodeHandle("~").param<std::string>("port", port, "/dev/ttyACM0");
+	au_uav_ros::ArduTalker talk(port, 115200);
+	if(talk.init(n))	//OK. what if the xbee can't be read???
+		talk.run();
+	talk.shutdown();
+}
+
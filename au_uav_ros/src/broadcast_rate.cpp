@@ -0,0 +1,140 @@
+#include <math.h>
+#include <algorithm>
+#include "au_uav_ros/broadcast_rate.h"
+#include "au_uav_ros/Fsquared.h"	//RADAR_ZONE
+
+au_uav_ros::BroadcastRate::BroadcastRate(int airtimeBudget, double slowestPeriod)	{
+	me.heard = false;
+	budget = airtimeBudget;
+	slowest = slowestPeriod;
+	credit = budget;
+	creditAt = 0;
+	haveCreditAt = false;
+	lastSent = 0;
+	haveSent = false;
+	updateInterval = 0;
+	nearest = -1;
+	closure = 0;
+	broadcasts = 0;
+	skipped = 0;
+	overBudget = 0;
+}
+
+void au_uav_ros::BroadcastRate::setAirtimeBudget(int bytesPerSecond)	{
+	boost::mutex::scoped_lock guard(lock);
+	budget = bytesPerSecond;
+	credit = budget;
+}
+
+void au_uav_ros::BroadcastRate::setSlowestPeriod(double seconds)	{
+	boost::mutex::scoped_lock guard(lock);
+	slowest = seconds;
+}
+
+//The velocity is taken over at least VELOCITY_BASELINE, so a fast autopilot's GPS noise is not
+//divided by a few milliseconds
+void au_uav_ros::BroadcastRate::fix(track &t, double latitude, double longitude, double altitude, double now)	{
+	if(!frame.isAnchored())
+		frame.anchor(latitude, longitude, altitude);
+	coordinate at;
+	at.latitude = latitude;
+	at.longitude = longitude;
+	at.altitude = altitude;
+	localPosition position = frame.toLocal(at);
+	if(!t.heard || now - t.heardAt > NEIGHBOR_TIMEOUT || now < t.baselineAt)	{
+		t.velocity.x = t.velocity.y = t.velocity.z = 0;
+		t.baseline = position;
+		t.baselineAt = now;
+	}
+	else if(now - t.baselineAt >= VELOCITY_BASELINE)	{
+		double dt = now - t.baselineAt;
+		t.velocity.x = (position.x - t.baseline.x)/dt;
+		t.velocity.y = (position.y - t.baseline.y)/dt;
+		t.velocity.z = (position.z - t.baseline.z)/dt;
+		t.baseline = position;
+		t.baselineAt = now;
+	}
+	t.position = position;
+	t.heardAt = now;
+	t.heard = true;
+}
+
+void au_uav_ros::BroadcastRate::mine(double latitude, double longitude, double altitude, double now)	{
+	boost::mutex::scoped_lock guard(lock);
+	updateInterval = me.heard && now > me.heardAt ? now - me.heardAt : 0;
+	fix(me, latitude, longitude, altitude, now);
+}
+
+void au_uav_ros::BroadcastRate::neighbor(int planeID, double latitude, double longitude, double altitude, double now)	{
+	if(planeID < 0)
+		return;
+	boost::mutex::scoped_lock guard(lock);
+	if(planeID >= (int)neighbors.size())	{
+		track unheard;
+		unheard.heard = false;
+		neighbors.resize(planeID + 1, unheard);
+	}
+	fix(neighbors[planeID], latitude, longitude, altitude, now);
+}
+
+//Positions are carried forward to now with the velocities, horizontally, the way F^2 measures
+//RADAR_ZONE
+double au_uav_ros::BroadcastRate::unlockedPeriod(double now)	{
+	nearest = -1;
+	closure = 0;
+	if(!me.heard)
+		return slowest;
+	double myAge = now - me.heardAt;
+	double myX = me.position.x + me.velocity.x*myAge, myY = me.position.y + me.velocity.y*myAge;
+	double soonest = slowest*BROADCAST_UPDATES_TO_ZONE;		//seconds until a neighbor could be in RADAR_ZONE
+	for(unsigned int i = 0; i < neighbors.size(); i++)	{
+		const track &n = neighbors[i];
+		double age = now - n.heardAt;
+		if(!n.heard || age > NEIGHBOR_TIMEOUT)
+			continue;
+		double dx = n.position.x + n.velocity.x*age - myX, dy = n.position.y + n.velocity.y*age - myY;
+		double dvx = n.velocity.x - me.velocity.x, dvy = n.velocity.y - me.velocity.y;
+		double distance = sqrt(dx*dx + dy*dy);
+		double closing = distance > 0 ? -(dx*dvx + dy*dvy)/distance : 0;
+		if(nearest < 0 || distance < nearest)	{
+			nearest = distance;
+			closure = closing;
+		}
+		soonest = std::min(soonest, std::max(distance - RADAR_ZONE, 0.0)/std::max(closing, (double)BROADCAST_MIN_CLOSURE));
+	}
+	return std::min(slowest, soonest/BROADCAST_UPDATES_TO_ZONE);
+}
+
+double au_uav_ros::BroadcastRate::period(double now)	{
+	boost::mutex::scoped_lock guard(lock);
+	return unlockedPeriod(now);
+}
+
+bool au_uav_ros::BroadcastRate::due(double now)	{
+	boost::mutex::scoped_lock guard(lock);
+	if(budget > 0)	{
+		if(haveCreditAt && now > creditAt)
+			credit = std::min(credit + budget*(now - creditAt), (double)budget);
+		creditAt = now;
+		haveCreditAt = true;
+	}
+	if(haveSent && now - lastSent < unlockedPeriod(now) - updateInterval/2)	{
+		skipped++;
+		return false;
+	}
+	if(budget > 0 && credit <= 0)	{
+		skipped++;
+		overBudget++;
+		return false;
+	}
+	return true;
+}
+
+void au_uav_ros::BroadcastRate::sent(int bytes, double now)	{
+	boost::mutex::scoped_lock guard(lock);
+	if(budget > 0)
+		credit -= bytes;
+	lastSent = now;
+	haveSent = true;
+	broadcasts++;
+}
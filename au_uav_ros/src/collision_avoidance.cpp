@@ -1,28 +1,102 @@
 #include "au_uav_ros/collision_avoidance.h"
 
-void au_uav_ros::CollisionAvoidance::init(int planeID)	{
+#define LATENCY_REPORT_INTERVAL 1000	//avoid() calls between latency reports
+
+//The command the mover does not send
+static au_uav_ros::Command ignoredCommand()	{
+	au_uav_ros::Command ignored;
+	ignored.latitude = ignored.longitude = ignored.altitude = INVALID_GPS_COOR;
+	return ignored;
+}
+
+void au_uav_ros::CollisionAvoidance::init(int planeID, int forceRecomputeInterval, bool threatPrefilter)	{
 
 	ROS_INFO("CollisionAvoidance:init()");
 	me.setID(planeID);
 
+	incremental = forceRecomputeInterval > 0;
+	if(incremental)	{
+		ROS_INFO("CollisionAvoidance: incremental forces, full recompute every %d updates", forceRecomputeInterval);
+		forces.setFullRecomputeInterval(forceRecomputeInterval);
+	}
+
+	prefilter = threatPrefilter;
+	if(prefilter)
+		ROS_INFO("CollisionAvoidance: threat prefilter, time-to-go up to %f s, miss distance up to %f m",
+				threats.getMaxTimeToGo(), threats.getMaxMissDistance());
+
+	bounded = false;
+	budget = 0;
+}
+
+void au_uav_ros::CollisionAvoidance::setThreatBound(int maxThreats, fsquared::threatPriority priority, double budgetSeconds)	{
+	bounded = maxThreats > 0;
+	budget = budgetSeconds > 0 ? budgetSeconds : 0;
+	if(!bounded)
+		return;
+
+	threatSet.setMaxThreats(maxThreats);
+	threatSet.setPriority(priority);
+	ROS_INFO("CollisionAvoidance: bounded mode, %d threats at most, budget %f us per update", maxThreats, budget*1e6);
+}
+
+void au_uav_ros::CollisionAvoidance::setNeighborField(const AnyForceField &field)	{
+	me.setNeighborField(field);
+	ROS_INFO("CollisionAvoidance: neighbor field shape %d, function %d", field.getShapeCode(), field.getFunctionCode());
+}
+
+bool au_uav_ros::CollisionAvoidance::anchorFrame(double latitude, double longitude, double altitude)	{
+	au_uav_ros::LocalFrame &frame = au_uav_ros::LocalFrame::mission();
+	if(latitude == 0 && longitude == 0)	{
+		ROS_ERROR("CollisionAvoidance: not anchoring the local frame at 0, 0, no initial position");
+		return false;
+	}
+	if(frame.isAnchored())	{
+		au_uav_ros::coordinate anchor = frame.getAnchor();
+		if(anchor.latitude == latitude && anchor.longitude == longitude && anchor.altitude == altitude)
+			return true;
+		ROS_ERROR("CollisionAvoidance: local frame already anchored at %f, %f, not moving it to %f, %f",
+				anchor.latitude, anchor.longitude, latitude, longitude);
+		return false;
+	}
+	frame.anchor(latitude, longitude, altitude);
+	ROS_INFO("CollisionAvoidance: local frame anchored at %f, %f", latitude, longitude);
+	return true;
+}
+
+bool au_uav_ros::CollisionAvoidance::frameAnchored() const	{
+	if(au_uav_ros::LocalFrame::mission().isAnchored())
+		return true;
+	ROS_ERROR_THROTTLE(1, "CollisionAvoidance: avoid() before anchorFrame(), update ignored");
+	return false;
 }
 
-//TODO: Add some method to not resend commands when the waypoint has not changed?
+//Returns a command for every update, the mover's CommandShaper decides which ones are worth sending.
 au_uav_ros::Command au_uav_ros::CollisionAvoidance::avoid(au_uav_ros::Telemetry telem)	{
+	ros::WallTime start = ros::WallTime::now();
 	ROS_INFO("CollisionAvoidance::avoid() me position: %f, %f, %f | me destination: %f, %f", me.getCurrentLoc().latitude, me.getCurrentLoc().longitude, me.getCurrentLoc().altitude,
 											me.getDestination().latitude, me.getDestination().longitude);
+	if(!frameAnchored())
+		return ignoredCommand();
 	au_uav_ros::Command newCmd;
 
 	//Setting goalwp in plane object
 	au_uav_ros::waypoint dest;
-	goal_wp_lock.lock();
-	dest.latitude = goal_wp.latitude;
-	dest.longitude = goal_wp.longitude;
-	dest.altitude = goal_wp.altitude;
-	goal_wp_lock.unlock();
+	au_uav_ros::Command goal;
+	goal_wp.load(goal);
+	dest.latitude = goal.latitude;
+	dest.longitude = goal.longitude;
+	dest.altitude = goal.altitude;
 	me.setDestination(dest);
 
-	au_uav_ros::waypoint tempForceWaypoint = fsquared::findTempForceWaypoint(me, telem);
+	au_uav_ros::waypoint tempForceWaypoint;
+	fsquared::ThreatFilter *threatFilter = prefilter ? &threats : NULL;
+	if(bounded)
+		tempForceWaypoint = fsquared::findTempForceWaypoint(me, telem, threatSet, budget > 0 ? start.toSec() + budget : 0, threatFilter);
+	else if(incremental)
+		tempForceWaypoint = fsquared::findTempForceWaypoint(me, telem, forces, threatFilter);
+	else
+		tempForceWaypoint = fsquared::findTempForceWaypoint(me, telem, neighbors, forceBatch, threatFilter);
 	//Make new command from the calculated waypoint
 	//newCmd.stamp = ros::Time::now();
 	newCmd.planeID = me.getID();
@@ -32,13 +106,50 @@ au_uav_ros::Command au_uav_ros::CollisionAvoidance::avoid(au_uav_ros::Telemetry
 	newCmd.longitude = tempForceWaypoint.longitude;
 	newCmd.altitude = me.getDestination().altitude;
 	newCmd.replace = true;
+
+	latency.record((ros::WallTime::now() - start).toSec());
+	if(latency.getCount() % LATENCY_REPORT_INTERVAL == 0)
+		ROS_INFO("CollisionAvoidance: avoid() latency over %ld calls, p50 %.1f us, p99 %.1f us, p99.9 %.1f us, max %.1f us",
+				latency.getCount(), latency.percentile(50)*1e6, latency.percentile(99)*1e6, latency.percentile(99.9)*1e6,
+				latency.getMax()*1e6);
 	return newCmd;
 }
 
+au_uav_ros::Command au_uav_ros::CollisionAvoidance::avoid(const std::vector<au_uav_ros::Telemetry> &updates)	{
+	if(updates.empty() || !frameAnchored())
+		return ignoredCommand();
+
+	for(unsigned int i = 0; i + 1 < updates.size(); i++)
+		remember(updates[i]);
+	return avoid(updates.back());
+}
+
+//Everything findTempForceWaypoint would keep from the update, in whichever mode is on. Bounded
+//mode only keeps "me's" map, the threat set is ranked from it when the forces are summed.
+void au_uav_ros::CollisionAvoidance::remember(const au_uav_ros::Telemetry &telem)	{
+	fsquared::updatePlanesToAvoid(me, telem, prefilter ? &threats : NULL);
+	if(bounded)
+		return;
+	if(incremental)
+		forces.update(me, telem.planeID);
+	else
+		fsquared::updateGrid(me, telem, neighbors);
+}
+
 void au_uav_ros::CollisionAvoidance::setGoalWaypoint(au_uav_ros::Command com)	{
 	ROS_INFO("CollisionAvoidance::setGoalWaypoint()");
 	
-	goal_wp_lock.lock();
-	goal_wp = com;
-	goal_wp_lock.unlock();
+	goal_wp.store(com);
+}
+
+fsquared::ThreatFilter & au_uav_ros::CollisionAvoidance::getThreatFilter()	{
+	return threats;
+}
+
+const fsquared::ThreatSet & au_uav_ros::CollisionAvoidance::getThreatSet() const	{
+	return threatSet;
+}
+
+const au_uav_ros::LatencyRecorder & au_uav_ros::CollisionAvoidance::getLatency() const	{
+	return latency;
 }
@@ -0,0 +1,81 @@
+#include <math.h>
+#include <algorithm>
+#include "au_uav_ros/command_shaper.h"
+#include "au_uav_ros/LocalFrame.h"
+
+au_uav_ros::CommandShaper::CommandShaper(double _headingThreshold, double _positionThreshold)	{
+	headingThreshold = _headingThreshold;
+	positionThreshold = _positionThreshold;
+	haveSent = false;
+	avoiding = false;
+	sent = 0;
+	suppressed = 0;
+	maneuvers = 0;
+}
+
+void au_uav_ros::CommandShaper::setHeadingThreshold(double degrees)	{
+	headingThreshold = degrees;
+}
+
+void au_uav_ros::CommandShaper::setPositionThreshold(double meters)	{
+	positionThreshold = meters;
+}
+
+/*
+ * Headings are taken from where "me" is now. A waypoint has not moved if it is where it was (a goal
+ * "me" flies toward) or as far from "me" as it was (F^2's, WP_GEN_SCALAR*10 km ahead wherever "me"
+ * is), how far it moves sideways is the heading's to judge. A goal closer than COLLISION_THRESHOLD
+ * has no bearing worth comparing, and nothing counts as avoiding then.
+ */
+bool au_uav_ros::CommandShaper::shape(const coordinate &me, const coordinate &goal, const coordinate &command)	{
+	const LocalFrame &frame = LocalFrame::mission();
+	double heading = frame.angle(me.latitude, me.longitude, command.latitude, command.longitude);
+	double range = frame.distance(me.latitude, me.longitude, command.latitude, command.longitude);
+	bool nowAvoiding = frame.distance(me.latitude, me.longitude, goal.latitude, goal.longitude) > COLLISION_THRESHOLD &&
+			fabs(manipulateAngle(heading - frame.angle(me.latitude, me.longitude, goal.latitude, goal.longitude))) > SHAPER_AVOIDING_HEADING;
+
+	bool send = !haveSent;
+	if(haveSent && nowAvoiding != avoiding)	{
+		send = true;
+		maneuvers++;
+	}
+	else if(haveSent)	{
+		double turn = manipulateAngle(heading - frame.angle(me.latitude, me.longitude, lastSent.latitude, lastSent.longitude));
+		double moved = std::min(frame.distance(lastSent.latitude, lastSent.longitude, command.latitude, command.longitude),
+				fabs(range - lastRange));
+		double climb = command.altitude - lastSent.altitude;
+		send = fabs(turn) > headingThreshold || sqrt(moved*moved + climb*climb) > positionThreshold;
+	}
+
+	if(!send)	{
+		suppressed++;
+		return false;
+	}
+	haveSent = true;
+	lastSent = command;
+	lastRange = range;
+	avoiding = nowAvoiding;
+	sent++;
+	return true;
+}
+
+void au_uav_ros::CommandShaper::reset()	{
+	haveSent = false;
+	avoiding = false;
+}
+
+bool au_uav_ros::CommandShaper::isAvoiding() const	{
+	return avoiding;
+}
+
+long au_uav_ros::CommandShaper::getSent() const	{
+	return sent;
+}
+
+long au_uav_ros::CommandShaper::getSuppressed() const	{
+	return suppressed;
+}
+
+long au_uav_ros::CommandShaper::getManeuvers() const	{
+	return maneuvers;
+}
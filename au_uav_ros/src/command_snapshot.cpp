@@ -0,0 +1,115 @@
+#include "au_uav_ros/command_snapshot.h"
+
+/*
+ * The same GCC __sync builtins serial_writer.cpp uses, full barriers, so a buffer's sequence number
+ * is odd before the writer touches its fields and even again only once they are all written, and a
+ * reader has copied every field before it looks at the sequence number a second time.
+ */
+
+template<typename T>
+static inline T atomicLoad(const volatile T *at)	{
+	return __sync_fetch_and_add(const_cast<volatile T *>(at), 0);
+}
+
+template<typename T>
+static inline void atomicStore(volatile T *at, T value)	{
+	T seen = atomicLoad(at);
+	while(!__sync_bool_compare_and_swap(at, seen, value))
+		seen = atomicLoad(at);
+}
+
+au_uav_ros::CommandSnapshot::CommandSnapshot()	{
+	for(int i = 0; i < 2; i++)	{
+		buffers[i].sequence = 0;
+		buffers[i].value.version = 0;
+	}
+	current = -1;
+	stores = 0;
+	taken = 0;
+	retries = 0;
+}
+
+void au_uav_ros::CommandSnapshot::store(const au_uav_ros::Command &com, double received)	{
+	int next = atomicLoad(&current) == 0 ? 1 : 0;
+	buffer &b = buffers[next];
+
+	__sync_fetch_and_add(&b.sequence, 1);
+	fields &f = b.value;
+	f.planeID = com.planeID;
+	f.sim = com.sim;
+	f.commandID = com.commandID;
+	f.param = com.param;
+	f.latitude = com.latitude;
+	f.longitude = com.longitude;
+	f.altitude = com.altitude;
+	f.replace = com.replace;
+	f.stampSec = com.commandHeader.stamp.sec;
+	f.stampNsec = com.commandHeader.stamp.nsec;
+	f.received = received;
+	f.version = __sync_add_and_fetch(&stores, 1);
+	__sync_fetch_and_add(&b.sequence, 1);
+
+	atomicStore(&current, next);
+}
+
+//A copy started on one buffer can be caught out by the writer coming back around to it, two stores
+//later: the sequence number moved. Or the reader was slow enough to look at a buffer that was then
+//filled with a newer store not made current yet, and the store after this one would go back to the
+//older buffer: current moved. Either way the copy is made again, from whichever buffer is current
+//by then, so a reader never sees stores out of order.
+bool au_uav_ros::CommandSnapshot::read(fields &out) const	{
+	while(true)	{
+		int now = atomicLoad(&current);
+		if(now < 0)
+			return false;
+		const buffer &b = buffers[now];
+		unsigned int before = atomicLoad(&b.sequence);
+		if((before & 1) == 0)	{
+			out = b.value;
+			__sync_synchronize();
+			if(atomicLoad(&b.sequence) == before && atomicLoad(&current) == now)
+				return true;
+		}
+		__sync_fetch_and_add(&retries, 1);
+	}
+}
+
+void au_uav_ros::CommandSnapshot::toCommand(const fields &f, au_uav_ros::Command &com)	{
+	com.planeID = f.planeID;
+	com.sim = f.sim;
+	com.commandID = f.commandID;
+	com.param = f.param;
+	com.latitude = f.latitude;
+	com.longitude = f.longitude;
+	com.altitude = f.altitude;
+	com.replace = f.replace;
+	com.commandHeader.stamp.sec = f.stampSec;
+	com.commandHeader.stamp.nsec = f.stampNsec;
+}
+
+bool au_uav_ros::CommandSnapshot::load(au_uav_ros::Command &com) const	{
+	fields f;
+	if(!read(f))
+		return false;
+	toCommand(f, com);
+	return true;
+}
+
+bool au_uav_ros::CommandSnapshot::take(au_uav_ros::Command &com, double &received)	{
+	fields f;
+	if(!read(f) || f.version == taken)
+		return false;
+	taken = f.version;
+
+	toCommand(f, com);
+	received = f.received;
+	return true;
+}
+
+long au_uav_ros::CommandSnapshot::getStores() const	{
+	return atomicLoad(&stores);
+}
+
+long au_uav_ros::CommandSnapshot::getRetries() const	{
+	return atomicLoad(&retries);
+}
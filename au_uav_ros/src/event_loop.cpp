@@ -0,0 +1,250 @@
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <fcntl.h>
+#include <math.h>
+#include "au_uav_ros/event_loop.h"
+
+#define STOP_ID 0xffffffff	//epoll data of stopFD, never a source id
+
+au_uav_ros::EventLoop::EventLoop()	{
+	stopped = false;
+	wakeups = 0;
+	dispatched = 0;
+
+	epollFD = epoll_create1(EPOLL_CLOEXEC);
+	stopFD = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if(epollFD < 0 || stopFD < 0)	{
+		ROS_ERROR("EventLoop: could not create epoll (%s)", strerror(errno));
+		return;
+	}
+	struct epoll_event event;
+	event.events = EPOLLIN;
+	event.data.u32 = STOP_ID;
+	epoll_ctl(epollFD, EPOLL_CTL_ADD, stopFD, &event);
+}
+
+au_uav_ros::EventLoop::~EventLoop()	{
+	for(unsigned int id = 0; id < sources.size(); id++)
+		remove(id);
+	if(stopFD >= 0)
+		close(stopFD);
+	if(epollFD >= 0)
+		close(epollFD);
+}
+
+//Sources are never moved once added, so the id is their index for as long as the loop lives
+int au_uav_ros::EventLoop::add(source *watched)	{
+	int id = sources.size();
+	struct epoll_event event;
+	event.events = EPOLLIN;
+	event.data.u32 = id;
+	if(epollFD < 0 || watched->fd < 0 || epoll_ctl(epollFD, EPOLL_CTL_ADD, watched->fd, &event) < 0)	{
+		ROS_ERROR("EventLoop: could not watch fd %d (%s)", watched->fd, strerror(errno));
+		if(watched->type != SERIAL_SOURCE && watched->fd >= 0)
+			close(watched->fd);
+		delete watched->parser;
+		delete watched;
+		return -1;
+	}
+	sources.push_back(watched);
+	return id;
+}
+
+int au_uav_ros::EventLoop::addSerial(au_uav_ros::mav::MavlinkReader &reader, au_uav_ros::mavlinkHandler handler)	{
+	source *watched = new source;
+	watched->type = SERIAL_SOURCE;
+	watched->fd = reader.getFD();
+	watched->reader = &reader;
+	watched->dispatcher = NULL;
+	watched->parser = NULL;
+	watched->onMessage = handler;
+	return add(watched);
+}
+
+int au_uav_ros::EventLoop::addSerial(au_uav_ros::mav::MavlinkReader &reader, const au_uav_ros::mav::FrameDispatcher &dispatcher)	{
+	source *watched = new source;
+	watched->type = SERIAL_SOURCE;
+	watched->fd = reader.getFD();
+	watched->reader = &reader;
+	watched->dispatcher = &dispatcher;
+	watched->parser = NULL;
+	return add(watched);
+}
+
+int au_uav_ros::EventLoop::addUDP(int socket, au_uav_ros::mavlinkHandler handler)	{
+	source *watched = new source;
+	watched->dispatcher = NULL;
+	watched->onMessage = handler;
+	return addUDP(socket, watched);
+}
+
+int au_uav_ros::EventLoop::addUDP(int socket, const au_uav_ros::mav::FrameDispatcher &dispatcher)	{
+	source *watched = new source;
+	watched->dispatcher = &dispatcher;
+	return addUDP(socket, watched);
+}
+
+//readUDP() reads datagrams straight into the parser, so the socket must not block when the
+//loop is woken for nothing
+int au_uav_ros::EventLoop::addUDP(int socket, source *watched)	{
+	watched->type = UDP_SOURCE;
+	watched->fd = socket;
+	watched->reader = NULL;
+	watched->parser = new au_uav_ros::mav::FrameParser;
+	if(socket >= 0)
+		fcntl(socket, F_SETFL, fcntl(socket, F_GETFL) | O_NONBLOCK);
+	return add(watched);
+}
+
+int au_uav_ros::EventLoop::addTimer(double periodSeconds, au_uav_ros::timerHandler handler)	{
+	int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if(fd < 0)	{
+		ROS_ERROR("EventLoop: could not create timer (%s)", strerror(errno));
+		return -1;
+	}
+	struct itimerspec period;
+	period.it_interval.tv_sec = (time_t)periodSeconds;
+	period.it_interval.tv_nsec = (long)((periodSeconds - floor(periodSeconds))*1e9);
+	if(period.it_interval.tv_sec == 0 && period.it_interval.tv_nsec == 0)
+		period.it_interval.tv_nsec = 1;	//zero would disarm it
+	period.it_value = period.it_interval;
+	timerfd_settime(fd, 0, &period, NULL);
+
+	source *watched = new source;
+	watched->type = TIMER_SOURCE;
+	watched->fd = fd;
+	watched->reader = NULL;
+	watched->dispatcher = NULL;
+	watched->parser = NULL;
+	watched->onTimer = handler;
+	return add(watched);
+}
+
+void au_uav_ros::EventLoop::remove(int id)	{
+	if(id < 0 || id >= (int)sources.size() || sources[id] == NULL)
+		return;
+	source *watched = sources[id];
+	epoll_ctl(epollFD, EPOLL_CTL_DEL, watched->fd, NULL);
+	if(watched->type != SERIAL_SOURCE)
+		close(watched->fd);
+	sources[id] = NULL;
+	delete watched->parser;
+	delete watched;
+}
+
+//Handlers can remove any source, their own included, so sources[id] is looked up again after each call
+void au_uav_ros::EventLoop::readSerial(int id)	{
+	if(sources[id]->dispatcher != NULL)	{
+		int found = sources[id]->reader->readFrames(*sources[id]->dispatcher, 0);
+		if(found < 0)	{
+			ROS_ERROR("EventLoop: serial fd %d hung up, no longer watching it", sources[id]->fd);
+			remove(id);
+			return;
+		}
+		dispatched += found;
+		return;
+	}
+	messages.clear();
+	if(sources[id]->reader->readMessages(messages, 0) < 0)	{
+		ROS_ERROR("EventLoop: serial fd %d hung up, no longer watching it", sources[id]->fd);
+		remove(id);
+		return;
+	}
+	for(unsigned int i = 0; i < messages.size() && sources[id] != NULL; i++)	{
+		dispatched++;
+		sources[id]->onMessage(messages[i]);
+	}
+}
+
+//A datagram holds whole frames, but a frame split over two is still put back together by the
+//source's parser. Every frame is handed out before the next read, so there is always room for a
+//datagram. A handler removing the source deletes the parser, so it is looked up again each time.
+void au_uav_ros::EventLoop::readUDP(int id)	{
+	if(sources[id]->parser->readFrom(sources[id]->fd) < 0)	{
+		ROS_ERROR("EventLoop: recv on fd %d failed (%s)", sources[id]->fd, strerror(errno));
+		return;
+	}
+	au_uav_ros::mav::FrameView frame;
+	mavlink_message_t message;
+	while(sources[id] != NULL && sources[id]->parser->next(frame))	{
+		dispatched++;
+		if(sources[id]->dispatcher != NULL)
+			sources[id]->dispatcher->dispatch(frame);
+		else	{
+			frame.toMessage(message);
+			sources[id]->onMessage(message);
+		}
+	}
+}
+
+void au_uav_ros::EventLoop::readTimer(int id)	{
+	uint64_t expirations;
+	if(read(sources[id]->fd, &expirations, sizeof(expirations)) == sizeof(expirations))
+		sources[id]->onTimer();
+}
+
+int au_uav_ros::EventLoop::runOnce(int timeoutMs)	{
+	struct epoll_event events[EVENT_LOOP_MAX_EVENTS];
+	int ready = epoll_wait(epollFD, events, EVENT_LOOP_MAX_EVENTS, timeoutMs);
+	if(ready < 0)
+		return errno == EINTR ? 0 : -1;
+	if(ready > 0)
+		wakeups++;
+
+	int handled = 0;
+	for(int i = 0; i < ready; i++)	{
+		if(events[i].data.u32 == STOP_ID)	{
+			//a stop that cannot be cleared is still a stop, the next run() would just end straight away
+			uint64_t count;
+			if(read(stopFD, &count, sizeof(count)) != sizeof(count) && errno != EAGAIN)
+				ROS_ERROR("EventLoop: could not clear stop (%s)", strerror(errno));
+			stopped = true;
+			continue;
+		}
+		//an earlier handler in this batch may have removed it
+		int id = events[i].data.u32;
+		if(id >= (int)sources.size() || sources[id] == NULL)
+			continue;
+		switch(sources[id]->type)	{
+			case SERIAL_SOURCE:
+				readSerial(id);
+				break;
+			case UDP_SOURCE:
+				readUDP(id);
+				break;
+			case TIMER_SOURCE:
+				readTimer(id);
+				break;
+		}
+		handled++;
+	}
+	return handled;
+}
+
+//ros shutting down does not wake epoll (its SIGINT handler may run on any thread), so it is
+//checked on a slow timeout. Data on a line still wakes the loop straight away.
+void au_uav_ros::EventLoop::run()	{
+	stopped = false;
+	while(!stopped && ros::ok())	{
+		if(runOnce(EVENT_LOOP_SHUTDOWN_CHECK_MS) < 0)	{
+			ROS_ERROR("EventLoop: epoll_wait failed (%s)", strerror(errno));
+			return;
+		}
+	}
+}
+
+void au_uav_ros::EventLoop::stop()	{
+	//EAGAIN is a counter already full of stops, the loop will see one
+	uint64_t one = 1;
+	if(write(stopFD, &one, sizeof(one)) < 0 && errno != EAGAIN)
+		ROS_ERROR("EventLoop: could not stop (%s)", strerror(errno));
+}
+
+long au_uav_ros::EventLoop::getWakeups() const	{
+	return wakeups;
+}
+
+long au_uav_ros::EventLoop::getMessagesDispatched() const	{
+	return dispatched;
+}
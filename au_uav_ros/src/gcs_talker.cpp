@@ -3,12 +3,12 @@
 #include <string>
 #include <ros/console.h>	//used for debugging
 
-au_uav_ros::GCSTalker::GCSTalker()	{
+au_uav_ros::GCSTalker::GCSTalker() : m_gcs_in(m_gcs), m_gcs_out(m_gcs)	{
 	m_port = "dev/ttyUSB0";
 	m_baud = 57600;
 }
 
-au_uav_ros::GCSTalker::GCSTalker(std::string _port, int _baud)	{
+au_uav_ros::GCSTalker::GCSTalker(std::string _port, int _baud) : m_gcs_in(m_gcs), m_gcs_out(m_gcs)	{
 	m_port = _port;
 	m_baud = _baud;	
 	
@@ -23,6 +23,8 @@ bool au_uav_ros::GCSTalker::init(ros::NodeHandle _n)	{
 	else	{
 		ROS_INFO("opened port %s", m_port.c_str());
 		m_gcs.setup_port(m_baud, 8, 1, true);
+		m_gcs_out.setLinkRate(m_baud/10);	//a radio, 8N1
+		m_gcs_out.start();
 	}
 
 	//mavlink
@@ -59,6 +61,7 @@ void au_uav_ros::GCSTalker::run()	{
 void au_uav_ros::GCSTalker::shutdown()	{
 	//ROS_INFO("Shutting down Xbee port %s", m_port.c_str());
 	printf("GCSTalker::Shutting down Xbee port %s\n", m_port.c_str()); //i ros::shutdown when exiting run
+	m_gcs_out.stop();	//writes out what is still queued
 	m_gcs.close_port();
 }
 
@@ -66,37 +69,48 @@ void au_uav_ros::GCSTalker::shutdown()	{
 //---------------------------------------------------------------------------
 
 void au_uav_ros::GCSTalker::listen()	{
-	while(ros::ok())
-	{
-		//get a mavlink message from the serial line
-		mavlink_message_t message = au_uav_ros::mav::readMavlinkFromSerial(m_gcs);
-		//decode the message and post it to the appropriate topic
-		if(message.msgid == MAVLINK_MSG_ID_HEARTBEAT)
-		{
-			mavlink_heartbeat_t receivedHeartbeat;
-			mavlink_msg_heartbeat_decode(&message, &receivedHeartbeat);
-			ROS_INFO("Received heartbeat");
-		}
-		if(message.msgid == MAVLINK_MSG_ID_AU_UAV)
-		{
-			//ROS_INFO("Received AU_UAV message from serial with ID #%d (sys:%d|comp:%d):\n", message.msgid, message.
-			au_uav_ros::Telemetry tUpdate, tRawUpdate;
-			mavlink_au_uav_t myMSG;
-			mavlink_msg_au_uav_decode(&message, &myMSG);
-			
-			//Post update as new telemetry update
-			au_uav_ros::mav::convertMavlinkTelemetryToROS(myMSG, tUpdate);
-			tUpdate.planeID = message.sysid;
-	  		m_telem_pub.publish(tUpdate);
-		        ROS_INFO("Received telemetry message from UAV[#%d] (lat:%f|lng:%f|alt:%f)", tUpdate.planeID, tUpdate.currentLatitude, tUpdate.currentLongitude, tUpdate.currentAltitude);
-
-
-			//Forward raw telemetry update to the xbee_talker node
-			au_uav_ros::mav::rawMavlinkTelemetryToRawROSTelemetry(myMSG, tRawUpdate);
-			tRawUpdate.planeID = message.sysid;
-			m_mav_telem_pub.publish(tRawUpdate);
-		}
-	}
+	m_dispatch.on(MAVLINK_MSG_ID_HEARTBEAT, boost::bind(&GCSTalker::handleHeartbeat, this, _1));
+	m_dispatch.on(MAVLINK_MSG_ID_AU_UAV, boost::bind(&GCSTalker::handleTelemetry, this, _1));
+	m_dispatch.on(MAVLINK_MSG_ID_AU_UAV_DELTA, boost::bind(&GCSTalker::handleTelemetryDelta, this, _1));
+	m_loop.addSerial(m_gcs_in, m_dispatch);
+	m_loop.run();
+}
+
+void au_uav_ros::GCSTalker::handleHeartbeat(const au_uav_ros::mav::FrameView &frame)	{
+	ROS_INFO("Received heartbeat");
+}
+
+//An AU_UAV is also the keyframe of that plane's AU_UAV_DELTAs
+void au_uav_ros::GCSTalker::handleTelemetry(const au_uav_ros::mav::FrameView &frame)	{
+	m_decoder.keyframe(frame);
+	publishTelemetry(frame);
+}
+
+void au_uav_ros::GCSTalker::handleTelemetryDelta(const au_uav_ros::mav::FrameView &frame)	{
+	uint8_t rebuilt[MAVLINK_MAX_PACKET_LEN];
+	if(m_decoder.rebuild(frame, rebuilt))
+		publishTelemetry(au_uav_ros::mav::FrameView(rebuilt));
+	else
+		ROS_INFO("Dropped compact telemetry from UAV[#%d], its keyframe was lost", frame.sysid());
+}
+
+//Fields are read straight off the frame
+void au_uav_ros::GCSTalker::publishTelemetry(const au_uav_ros::mav::FrameView &frame)	{
+	au_uav_ros::mav::AuUavView myMSG(frame);
+	if(!myMSG.valid())
+		return;
+	au_uav_ros::Telemetry tUpdate, tRawUpdate;
+
+	//Post update as new telemetry update
+	au_uav_ros::mav::convertMavlinkTelemetryToROS(myMSG, tUpdate);
+	tUpdate.planeID = frame.sysid();
+	m_telem_pub.publish(tUpdate);
+	ROS_INFO("Received telemetry message from UAV[#%d] (lat:%f|lng:%f|alt:%f)", tUpdate.planeID, tUpdate.currentLatitude, tUpdate.currentLongitude, tUpdate.currentAltitude);
+
+	//Forward raw telemetry update to the xbee_talker node
+	au_uav_ros::mav::rawMavlinkTelemetryToRawROSTelemetry(myMSG, tRawUpdate);
+	tRawUpdate.planeID = frame.sysid();
+	m_mav_telem_pub.publish(tRawUpdate);
 }
 
 
@@ -118,20 +132,14 @@ void au_uav_ros::GCSTalker::commandCallback(au_uav_ros::Command cmd)	{
 				      cmd.latitude, cmd.longitude, cmd.altitude);
 
 	//take command -> send to ardupilots
-	static uint8_t buffer[MAVLINK_MAX_PACKET_LEN];
-	int messageLength = mavlink_msg_to_send_buffer(buffer, &mavlinkMsg);
-	m_gcs.lock();
-	int written = write(m_gcs.getFD(), (char*)buffer, messageLength);
-	m_gcs.unlock();
-	if (messageLength != written) ROS_ERROR("ERROR: Wrote %d bytes but should have written %d\n",
-						written, messageLength);
+	if(!m_gcs_out.send(mavlinkMsg, cmd.replace ? au_uav_ros::TX_SAFETY : au_uav_ros::TX_MISSION))
+		ROS_ERROR("ERROR: send queue for %s is full, command dropped\n", m_port.c_str());
 }
 
 void au_uav_ros::GCSTalker::myTelemCallback(au_uav_ros::Telemetry tUpdate)	{
 ROS_INFO("GCSTalker::telemCallback::ding! \n");
 
 mavlink_message_t mavlinkMsg;
-        static uint8_t buffer[MAVLINK_MAX_PACKET_LEN];
 //stuff mavlinkMsg with all the correct paramaters
 mavlink_msg_au_uav_pack(tUpdate.planeID, compid, &mavlinkMsg, tUpdate.currentLatitude, tUpdate.currentLongitude,
 tUpdate.currentAltitude, tUpdate.destLatitude, tUpdate.destLongitude,
@@ -139,13 +147,8 @@ tUpdate.currentAltitude, tUpdate.destLatitude, tUpdate.destLongitude,
 tUpdate.distanceToDestination, tUpdate.currentWaypointIndex);
 
 
-        int messageLength = mavlink_msg_to_send_buffer(buffer, &mavlinkMsg);
-ros::Duration(0.000001).sleep();
-        m_gcs.lock();
-        int written = write(m_gcs.getFD(), (char*)buffer, messageLength);
-        m_gcs.unlock();
-        if (messageLength != written) ROS_ERROR("ERROR: Wrote %d bytes but should have written %d\n",
-                                                written, messageLength);
+	if(!m_gcs_out.send(mavlinkMsg, au_uav_ros::TX_TELEMETRY))
+		ROS_ERROR("ERROR: send queue for %s is full, telemetry dropped\n", m_port.c_str());
 
 }
 
@@ -0,0 +1,78 @@
+#include <stdint.h>
+#include "mavlink/v1.0/checksum.h"
+#include "au_uav_ros/mavlink_crc.h"
+
+#define CRC_POLYNOMIAL 0x8408		//0x1021 reflected
+
+//table[0][b] is the crc of byte b from 0, table[k][b] that followed by k zero bytes, so byte i of an
+//8 byte slice is looked up in table[7 - i]
+static uint16_t table[8][256];
+
+namespace	{
+struct buildTables	{
+	buildTables()	{
+		for(int b = 0; b < 256; b++)	{
+			uint16_t crc = b;
+			for(int bit = 0; bit < 8; bit++)
+				crc = (crc & 1) ? (crc >> 1) ^ CRC_POLYNOMIAL : crc >> 1;
+			table[0][b] = crc;
+		}
+		for(int k = 1; k < 8; k++)
+			for(int b = 0; b < 256; b++)
+				table[k][b] = (table[k - 1][b] >> 8) ^ table[0][table[k - 1][b] & 0xFF];
+	}
+} tablesBuilt;
+}
+
+static inline uint16_t tableByte(uint8_t byte, uint16_t crc)	{
+	return (crc >> 8) ^ table[0][(crc ^ byte) & 0xFF];
+}
+
+uint16_t au_uav_ros::mav::crcBytewise(const uint8_t *bytes, int length, uint16_t crc)	{
+	for(int i = 0; i < length; i++)
+		crc_accumulate(bytes[i], &crc);
+	return crc;
+}
+
+uint16_t au_uav_ros::mav::crcTable(const uint8_t *bytes, int length, uint16_t crc)	{
+	for(int i = 0; i < length; i++)
+		crc = tableByte(bytes[i], crc);
+	return crc;
+}
+
+//The crc is only 16 bits, so it only mixes with the first two bytes of a slice, the rest are looked
+//up on their own
+uint16_t au_uav_ros::mav::crcSlice4(const uint8_t *bytes, int length, uint16_t crc)	{
+	const uint8_t *end = bytes + length;
+	for(; end - bytes >= 4; bytes += 4)
+		crc = table[3][(crc ^ bytes[0]) & 0xFF] ^ table[2][(crc >> 8) ^ bytes[1]] ^
+				table[1][bytes[2]] ^ table[0][bytes[3]];
+	for(; bytes < end; bytes++)
+		crc = tableByte(*bytes, crc);
+	return crc;
+}
+
+uint16_t au_uav_ros::mav::crcSlice8(const uint8_t *bytes, int length, uint16_t crc)	{
+	const uint8_t *end = bytes + length;
+	for(; end - bytes >= 8; bytes += 8)
+		crc = table[7][(crc ^ bytes[0]) & 0xFF] ^ table[6][(crc >> 8) ^ bytes[1]] ^
+				table[5][bytes[2]] ^ table[4][bytes[3]] ^ table[3][bytes[4]] ^
+				table[2][bytes[5]] ^ table[1][bytes[6]] ^ table[0][bytes[7]];
+	for(; bytes < end; bytes++)
+		crc = tableByte(*bytes, crc);
+	return crc;
+}
+
+uint16_t au_uav_ros::mav::crcAccumulate(const uint8_t *bytes, int length, uint16_t crc)	{
+#if CRC_SLICES == 0
+	return crcBytewise(bytes, length, crc);
+#elif CRC_SLICES == 1
+	return crcTable(bytes, length, crc);
+#elif CRC_SLICES == 4
+	return crcSlice4(bytes, length, crc);
+#elif CRC_SLICES == 8
+	return crcSlice8(bytes, length, crc);
+#else
+#error CRC_SLICES has to be 0, 1, 4 or 8
+#endif
+}
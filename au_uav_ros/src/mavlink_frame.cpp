@@ -0,0 +1,139 @@
+#include <errno.h>
+#include <string.h>
+#include <sys/uio.h>
+#include "au_uav_ros/mavlink_frame.h"
+#include "au_uav_ros/mavlink_crc.h"
+
+static const uint8_t crcExtras[256] = MAVLINK_MESSAGE_CRCS;
+
+//The header after STX and the payload in one go, then the CRC extra
+static uint16_t frameChecksum(const uint8_t *frame)	{
+	uint16_t crc = au_uav_ros::mav::crcAccumulate(frame + 1, MAVLINK_NUM_HEADER_BYTES - 1 + frame[1], X25_INIT_CRC);
+	crc_accumulate(crcExtras[frame[5]], &crc);
+	return crc;
+}
+
+bool au_uav_ros::mav::checkFrame(const uint8_t *frame)	{
+	uint16_t crc = frameChecksum(frame);
+	const uint8_t *ck = frame + MAVLINK_NUM_HEADER_BYTES + frame[1];
+	return ck[0] == (crc & 0xFF) && ck[1] == (crc >> 8);
+}
+
+void au_uav_ros::mav::restampFrame(uint8_t *frame, uint8_t sequence)	{
+	frame[2] = sequence;
+	uint16_t crc = frameChecksum(frame);
+	uint8_t *ck = frame + MAVLINK_NUM_HEADER_BYTES + frame[1];
+	ck[0] = crc & 0xFF;
+	ck[1] = crc >> 8;
+}
+
+au_uav_ros::mav::FrameView::FrameView() : bytes(NULL)	{
+}
+
+au_uav_ros::mav::FrameView::FrameView(const uint8_t *frameBytes) : bytes(frameBytes)	{
+}
+
+uint16_t au_uav_ros::mav::FrameView::checksum() const	{
+	const uint8_t *ck = payload() + length();
+	return ck[0] | ck[1] << 8;
+}
+
+//mavlink_parse_char keeps the checksum bytes just past the payload too, mavlink_msg_to_send_buffer
+//reads them from there
+void au_uav_ros::mav::FrameView::toMessage(mavlink_message_t &message) const	{
+	message.magic = bytes[0];
+	message.len = length();
+	message.seq = sequence();
+	message.sysid = sysid();
+	message.compid = compid();
+	message.msgid = msgid();
+	message.checksum = checksum();
+	memcpy(_MAV_PAYLOAD_NON_CONST(&message), payload(), length() + MAVLINK_NUM_CHECKSUM_BYTES);
+}
+
+void au_uav_ros::mav::FrameDispatcher::on(uint8_t msgid, au_uav_ros::mav::frameHandler handler)	{
+	handlers[msgid] = handler;
+}
+
+bool au_uav_ros::mav::FrameDispatcher::dispatch(const FrameView &frame) const	{
+	const frameHandler &handler = handlers[frame.msgid()];
+	if(handler.empty())
+		return false;
+	handler(frame);
+	return true;
+}
+
+au_uav_ros::mav::FrameParser::FrameParser()	{
+	head = 0;
+	tail = 0;
+	framesParsed = 0;
+	framesCopied = 0;
+	checksumErrors = 0;
+}
+
+//head and tail only ever grow, they wrap around the buffer by masking. tail - head is the number
+//of bytes waiting to be parsed, which is right even after the counters overflow.
+int au_uav_ros::mav::FrameParser::readFrom(int fd)	{
+	unsigned int used = tail - head;
+	if(used == READ_BUFFER_SIZE)
+		return 0;	//full, parse some first
+
+	//the free space is at most two pieces, the end of the array and then its start
+	unsigned int start = tail & (READ_BUFFER_SIZE - 1);
+	unsigned int space = READ_BUFFER_SIZE - used;
+	struct iovec pieces[2];
+	pieces[0].iov_base = buffer + start;
+	pieces[0].iov_len = start + space <= READ_BUFFER_SIZE ? space : READ_BUFFER_SIZE - start;
+	pieces[1].iov_base = buffer;
+	pieces[1].iov_len = space - pieces[0].iov_len;
+
+	ssize_t num = readv(fd, pieces, pieces[1].iov_len > 0 ? 2 : 1);
+	if(num < 0)
+		return (errno == EAGAIN || errno == EINTR) ? 0 : -1;
+	tail += num;
+	return num;
+}
+
+int au_uav_ros::mav::FrameParser::append(const uint8_t *bytes, int length)	{
+	int fits = READ_BUFFER_SIZE - (tail - head);
+	if(length > fits)
+		length = fits;
+	for(int i = 0; i < length; i++)
+		buffer[(tail + i) & (READ_BUFFER_SIZE - 1)] = bytes[i];
+	tail += length;
+	return length;
+}
+
+bool au_uav_ros::mav::FrameParser::next(FrameView &frame)	{
+	while(tail != head)	{
+		unsigned int start = head & (READ_BUFFER_SIZE - 1);
+		if(buffer[start] != MAVLINK_STX)	{
+			head++;
+			continue;
+		}
+		if(tail - head < 2)
+			return false;	//no length yet
+		int size = buffer[(head + 1) & (READ_BUFFER_SIZE - 1)] + MAVLINK_NUM_NON_PAYLOAD_BYTES;
+		if(tail - head < (unsigned int)size)
+			return false;	//the rest has not arrived
+
+		const uint8_t *bytes = buffer + start;
+		if(start + size > READ_BUFFER_SIZE)	{
+			int first = READ_BUFFER_SIZE - start;
+			memcpy(wrapped, buffer + start, first);
+			memcpy(wrapped + first, buffer, size - first);
+			bytes = wrapped;
+			framesCopied++;
+		}
+		if(!checkFrame(bytes))	{
+			checksumErrors++;
+			head++;		//not a frame after all, look again from the next byte
+			continue;
+		}
+		head += size;
+		framesParsed++;
+		frame = FrameView(bytes);
+		return true;
+	}
+	return false;
+}
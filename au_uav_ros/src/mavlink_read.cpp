@@ -1,3 +1,5 @@
+#include <poll.h>
+#include <sys/uio.h>
 #include "au_uav_ros/mavlink_read.h"
 /*
 bool au_uav_ros::ArduTalker::convertROSToMavlinkTelemetry(au_uav_ros::Telemetry &tUpdate, mavlink_au_uav_t &mavMessage)	{
@@ -49,6 +51,43 @@ bool au_uav_ros::mav::rawMavlinkTelemetryToRawROSTelemetry(mavlink_au_uav_t &mav
 }
 
 
+//Same as for mavlink_au_uav_t, reading the fields off the wire
+bool au_uav_ros::mav::convertMavlinkTelemetryToROS(const AuUavView &mavMessage, au_uav_ros::Telemetry &tUpdate) {
+	tUpdate.currentLatitude = mavMessage.lat() / 10000000.0;
+	tUpdate.currentLongitude = mavMessage.lng() / 10000000.0;
+	tUpdate.currentAltitude = mavMessage.alt() / 100.0;
+
+	tUpdate.destLatitude = mavMessage.targetLat() / 10000000.0;
+	tUpdate.destLongitude = mavMessage.targetLng() / 10000000.0;
+	tUpdate.destAltitude = mavMessage.targetAlt() / 100.0;
+
+	tUpdate.groundSpeed = mavMessage.groundSpeed() / 100.0;
+	tUpdate.distanceToDestination = mavMessage.distance();
+	tUpdate.targetBearing = mavMessage.targetBearing() / 100;
+	tUpdate.currentWaypointIndex = mavMessage.targetWPIndex();
+
+	tUpdate.telemetryHeader.stamp = ros::Time::now();
+	return true;
+}
+
+bool au_uav_ros::mav::rawMavlinkTelemetryToRawROSTelemetry(const AuUavView &mavMessage, au_uav_ros::Telemetry &tUpdate) {
+	tUpdate.currentLatitude = mavMessage.lat();
+	tUpdate.currentLongitude = mavMessage.lng();
+	tUpdate.currentAltitude = mavMessage.alt();
+
+	tUpdate.destLatitude = mavMessage.targetLat();
+	tUpdate.destLongitude = mavMessage.targetLng();
+	tUpdate.destAltitude = mavMessage.targetAlt();
+
+	tUpdate.groundSpeed = mavMessage.groundSpeed();
+	tUpdate.distanceToDestination = mavMessage.distance();
+	tUpdate.targetBearing = mavMessage.targetBearing();
+	tUpdate.currentWaypointIndex = mavMessage.targetWPIndex();
+
+	tUpdate.telemetryHeader.stamp = ros::Time::now();
+	return true;
+}
+
 bool au_uav_ros::mav::convertMavlinkCommandToROS(mavlink_mission_item_t &receivedCommand, au_uav_ros::Command &cmdToForward){
 	//If we are receiveing a command for real planes, it better not be intended for simulated planes
 	cmdToForward.sim = false;
@@ -65,40 +104,108 @@ bool au_uav_ros::mav::convertMavlinkCommandToROS(mavlink_mission_item_t &receive
 
 
 
-mavlink_message_t au_uav_ros::mav::readMavlinkFromSerial(SerialTalker &serialIn){
-	mavlink_status_t lastStatus;
-	lastStatus.packet_rx_drop_count = 0;
-
-	// Blocking wait for new data
-		//if (debug) printf("Checking for new data on serial port\n");
-		// Block until data is available, read only one byte to be able to continue immediately
-		//char buf[MAVLINK_MAX_PACKET_LEN];
-	while(ros::ok()){
-		uint8_t cp;
-		mavlink_message_t message;
-		mavlink_status_t status;
-		uint8_t msgReceived = false;
-		//sleep for 1E-6 seconds, allows 1E6 readings per second, which is greater than baud rate
-		ros::Duration(0.000001).sleep();
-		serialIn.lock();
-		int num = read(serialIn.getFD(), &cp, 1);
-		serialIn.unlock();
-		//ROS_INFO("Read %c", (char)cp);
-		if (num > 0)
-		{
-			// Check if a message could be decoded, return the message in case yes
-			msgReceived = mavlink_parse_char(MAVLINK_COMM_1, cp, &message, &status);
-		}
+au_uav_ros::mav::MavlinkReader::MavlinkReader(SerialTalker &serialIn) : serial(serialIn)	{
+	bytesRead = 0;
+	readCalls = 0;
+}
+
+int au_uav_ros::mav::MavlinkReader::fill(int timeoutMs)	{
+	if(parser.getBuffered() == READ_BUFFER_SIZE)
+		return 0;	//full, decode some first
+
+	struct pollfd waitFor;
+	waitFor.fd = serial.getFD();
+	waitFor.events = POLLIN;
+	waitFor.revents = 0;
+	int ready = poll(&waitFor, 1, timeoutMs);
+	if(ready == 0 || (ready < 0 && errno == EINTR))
+		return 0;
+	if(ready < 0 || !(waitFor.revents & POLLIN))
+		return -1;
+
+	//no lock, reading and writing a tty from two threads do not get in each other's way
+	int num = parser.readFrom(serial.getFD());
+	if(num > 0)	{
+		bytesRead += num;
+		readCalls++;
+	}
+	return num;
+}
 
-		else
-		{
-			//if (!silent) fprintf(stderr, "ERROR: Could not read from port %s\n", port.c_str());
+bool au_uav_ros::mav::MavlinkReader::next(mavlink_message_t &message)	{
+	FrameView frame;
+	while(ros::ok())	{
+		if(parser.next(frame))	{
+			frame.toMessage(message);
+			return true;
 		}
+		if(fill(READ_POLL_TIMEOUT_MS) < 0)
+			ros::Duration(READ_POLL_TIMEOUT_MS/1000.0).sleep();	//line is gone, don't spin on it
+	}
+	return false;
+}
 
-		// If a message could be decoded, return it
-		if(msgReceived)
-			return message;
+int au_uav_ros::mav::MavlinkReader::readMessages(std::vector<mavlink_message_t> &messages, int timeoutMs)	{
+	int found = 0;
+	FrameView frame;
+	while(parser.next(frame))	{
+		messages.push_back(mavlink_message_t());
+		frame.toMessage(messages.back());
+		found++;
 	}
+	if(found > 0)
+		return found;
+
+	if(fill(timeoutMs) < 0)
+		return -1;
+	while(parser.next(frame))	{
+		messages.push_back(mavlink_message_t());
+		frame.toMessage(messages.back());
+		found++;
+	}
+	return found;
+}
+
+//Frames are handed out before the line is read, a read could write over the ones already found
+int au_uav_ros::mav::MavlinkReader::readFrames(const FrameDispatcher &dispatcher, int timeoutMs)	{
+	int found = 0;
+	FrameView frame;
+	while(parser.next(frame))	{
+		dispatcher.dispatch(frame);
+		found++;
+	}
+	if(found > 0)
+		return found;
+
+	if(fill(timeoutMs) < 0)
+		return -1;
+	while(parser.next(frame))	{
+		dispatcher.dispatch(frame);
+		found++;
+	}
+	return found;
+}
+
+int au_uav_ros::mav::MavlinkReader::getFD()	{
+	return serial.getFD();
 }
 
+long au_uav_ros::mav::MavlinkReader::getBytesRead() const	{
+	return bytesRead;
+}
 
+long au_uav_ros::mav::MavlinkReader::getReadCalls() const	{
+	return readCalls;
+}
+
+long au_uav_ros::mav::MavlinkReader::getMessagesDecoded() const	{
+	return parser.getFramesParsed();
+}
+
+long au_uav_ros::mav::MavlinkReader::getFramesCopied() const	{
+	return parser.getFramesCopied();
+}
+
+long au_uav_ros::mav::MavlinkReader::getChecksumErrors() const	{
+	return parser.getChecksumErrors();
+}
@@ -1,80 +1,70 @@
+#include <algorithm>
 #include "au_uav_ros/mover.h"
 
-//callbacks
+#define LATENCY_REPORT_INTERVAL 1000	//CA commands between command latency reports
+#define CA_REPORT_INTERVAL 1000			//avoid() passes between mailbox reports
+
+//helpers
 //----------------------------------------------------
-void au_uav_ros::Mover::all_telem_callback(au_uav_ros::Telemetry telem)	{
+au_uav_ros::coordinate au_uav_ros::Mover::commandCoordinate(const au_uav_ros::Command &com)	{
+	au_uav_ros::coordinate c;
+	c.latitude = com.latitude;
+	c.longitude = com.longitude;
+	c.altitude = com.altitude;
+	return c;
+}
 
-	//CA will go here.
-	//It's OK to have movement/publishing ca-commands here, since this will be called
-	//when ardupilot publishes *my* telemetry msgs too.
+au_uav_ros::coordinate au_uav_ros::Mover::goalCoordinate()	{
+	au_uav_ros::Command goal;
+	goal_wp.load(goal);
+	return commandCoordinate(goal);
+}
 
-	au_uav_ros::Command com;
-	if(!is_testing)
-		com = ca.avoid(telem);	
-	else	{
-		//Using goal_wp as our "avoidance" wp, for testing.
-		goal_wp_lock.lock();
-		com = goal_wp;	//something ain't working right T.T
-		com.replace = true; 	
-		goal_wp_lock.unlock();
-		fprintf(stderr, "\nmover::telem_callback goalwp(%f|%f|%f)\n", com.latitude, com.longitude, com.altitude);
-	}
-	//Check if ca_waypoint should be ignored
-	if(com.latitude == INVALID_GPS_COOR && com.longitude == INVALID_GPS_COOR && com.altitude == INVALID_GPS_COOR)	{
-		//ignore.
-	}		
-	else	{
-		ca_wp_lock.lock();
-		ca_wp.clear();
-		ca_wp.push_back(com);	
-		ca_wp_lock.unlock();	
-	}
+//callbacks
+//----------------------------------------------------
+void au_uav_ros::Mover::all_telem_callback(const au_uav_ros::Telemetry::ConstPtr &telem)	{
+	//O(1) no matter how long avoid() takes, the CA worker picks it up
+	telem_mailbox.post(*telem, ros::WallTime::now().toSec());
 }
 
-void au_uav_ros::Mover::gcs_command_callback(au_uav_ros::Command com)	{
+void au_uav_ros::Mover::gcs_command_callback(const au_uav_ros::Command::ConstPtr &msg)	{
+	const au_uav_ros::Command &com = *msg;
 
 	//State changing will be done in this function, instead of in move(). This GCS callback will be executed not as frequently as the move,
 	//since not many gcs commands will be coming in.
 
 	//TESTING STUFF - Quick Emergency Protocol - START and STOP publishing to ca_commands to prevent overtaking manual mode.
 	if(planeID == com.planeID)	{
-		enum state temp;
 		if(com.latitude == EMERGENCY_PROTOCOL_LAT)	{
 			int incomingCommand = (int)com.longitude;
 			switch(incomingCommand)	{
 			case(META_START_CA_ON_LON):	
 				fprintf(stderr, "Mover::CHANGING TO GREEN CA OFF MODE\n");
 				//change state to using CA 
-				state_change_lock.lock();
-				current_state = ST_GREEN_CA_ON;
-				state_change_lock.unlock();
+				schedule.setState(ST_GREEN_CA_ON);
+				__sync_lock_test_and_set(&reset_shaper, 1);
 				break;
 			//No matter the state, STOP publishing.
 			case(META_STOP_LON):	
 				fprintf(stderr, "Mover::CHANGING TO NOGO MODE\n");
 				//change state to NOGO
-				state_change_lock.lock();
-				current_state = ST_RED;
-				state_change_lock.unlock();
+				schedule.setState(ST_RED);
 				break;
 			case(META_START_CA_OFF_LON):
 				fprintf(stderr, "Mover::CHANGING TO GREEN CA ON MODE\n");
 				//change state to not using CA 
-				state_change_lock.lock();
-				current_state = ST_GREEN_CA_OFF;
-				state_change_lock.unlock();
+				schedule.setState(ST_GREEN_CA_OFF);
 				break;
 			}
 		}
 		else	{
 			//just a regular old gcs command, move along now.
-			//Add this to the goal_wp q.
-			goal_wp_lock.lock();
-			goal_wp = com;	
-			goal_wp_lock.unlock();
+			//This is the goal_wp now.
+			goal_wp.store(com);
 //			ROS_INFO("Received new command with lat%f|lon%f|alt%f", com.latitude, com.longitude, com.altitude);
 			fprintf(stderr, "mover::callback::Received new command with lat%f|lon%f|alt%f", com.latitude, com.longitude, com.altitude);
 			ca.setGoalWaypoint(com);
+			schedule.commandReady();
 
 		}	
 	}
@@ -83,6 +73,14 @@ void au_uav_ros::Mover::gcs_command_callback(au_uav_ros::Command com)	{
 //node functions
 //----------------------------------------------------
 
+au_uav_ros::Mover::Mover()	{
+	running = 1;
+}
+
+bool au_uav_ros::Mover::isRunning()	{
+	return __sync_fetch_and_add(&running, 0) != 0;
+}
+
 bool au_uav_ros::Mover::init(ros::NodeHandle n, bool _test)	{
 	//Ros stuff
 	nh = n;
@@ -93,33 +91,80 @@ bool au_uav_ros::Mover::init(ros::NodeHandle n, bool _test)	{
 	gcs_commands = nh.subscribe("gcs_commands", 20, &Mover::gcs_command_callback, this);	
 	
 
-	//Find out my Plane ID.
-	//-> need timed call? or keep trying to get plane id???
+	//Find out my Plane ID. ardu fails the call until the ardupilot's first GPS fix, so keep asking
+	//until stop() - a nodelet's destructor must not wait on the autopilot.
 	if(_test)
 		planeID = 999;
 	else	{
 		au_uav_ros::planeIDGetter srv;
-		if(IDclient.call(srv))	{
+		bool gotID = false;
+		while(!gotID && isRunning() && ros::ok())
+			gotID = IDclient.waitForExistence(ros::Duration(MOVER_SHUTDOWN_CHECK)) && IDclient.call(srv);
+		if(gotID)	{
 			ROS_INFO("mover::init Got plane ID %d", srv.response.planeID);
 			ROS_INFO("mover::init Got initial position lat: %f|long: %f|alt: %f",
 					srv.response.initialLatitude, srv.response.initialLongitude, srv.response.initialAltitude);
 			planeID = srv.response.planeID;
-			goal_wp.planeID = planeID;
-			goal_wp.latitude = initialLat = srv.response.initialLatitude;
-			goal_wp.longitude= initialLong = srv.response.initialLongitude;
-			goal_wp.latitude = initialAlt = srv.response.initialLatitude;
-			goal_wp.param = 2;
-			goal_wp.commandID = 2;
+			au_uav_ros::Command goal;
+			goal.planeID = planeID;
+			goal.latitude = initialLat = srv.response.initialLatitude;
+			goal.longitude= initialLong = srv.response.initialLongitude;
+			goal.altitude = initialAlt = srv.response.initialAltitude;
+			goal.param = 2;
+			goal.commandID = 2;
+			goal_wp.store(goal);
+
+			//all collision avoidance geometry is in meters from where the mission starts, anchorFrame()
+			//refuses a response still at 0, 0 rather than put the frame on the equator
+			if(!ca.anchorFrame(srv.response.initialLatitude, srv.response.initialLongitude, srv.response.initialAltitude))
+				return false;
 		}
 		else	{
-			ROS_ERROR("mover::init Unsuccessful get plane ID call.");//what to do here.... keep trying?
+			ROS_ERROR("mover::init stopped before getting a plane ID.");
 			return false;
 		}
 	}
 	//CA init
-	ca.init(planeID);
-
-	current_state = ST_RED;
+	int forceRecomputeInterval;
+	nh.param<int>("force_recompute_interval", forceRecomputeInterval, 0);	//0 = no incremental forces
+	bool threatPrefilter;
+	nh.param<bool>("threat_prefilter", threatPrefilter, false);	//skip planes that will not come close soon
+	ca.init(planeID, forceRecomputeInterval, threatPrefilter);
+
+	int maxThreats, budgetMicroseconds;
+	std::string priorityName;
+	nh.param<int>("max_threats", maxThreats, 0);	//0 = every plane in the map, bounded mode off
+	nh.param<std::string>("threat_priority", priorityName, "distance");	//distance, time_to_go or force
+	nh.param<int>("avoid_budget_us", budgetMicroseconds, 0);	//0 = no budget, only used with max_threats
+	fsquared::threatPriority priority = fsquared::THREAT_BY_DISTANCE;
+	if(!fsquared::ThreatSet::parsePriority(priorityName.c_str(), priority))
+		ROS_WARN("mover::init unknown threat_priority %s, using distance", priorityName.c_str());
+	ca.setThreatBound(maxThreats, priority, budgetMicroseconds*1e-6);
+
+	double publishPeriod, minCommandInterval;
+	nh.param<double>("publish_period", publishPeriod, MOVER_PUBLISH_PERIOD);	//seconds, longest without a command
+	nh.param<double>("min_command_interval", minCommandInterval, MOVER_MIN_COMMAND_INTERVAL);	//no swamping the ardupilot
+	schedule.setPublishPeriod(publishPeriod);
+	schedule.setMinCommandInterval(minCommandInterval);
+
+	double headingThreshold, positionThreshold;
+	nh.param<bool>("shape_commands", shape_commands, true);	//only send CA commands that change something
+	nh.param<double>("command_heading_threshold", headingThreshold, SHAPER_HEADING_THRESHOLD);	//degrees
+	nh.param<double>("command_position_threshold", positionThreshold, SHAPER_POSITION_THRESHOLD);	//meters
+	shaper.setHeadingThreshold(headingThreshold);
+	shaper.setPositionThreshold(positionThreshold);
+
+	nh.param<double>("ca_min_period", ca_min_period, 0.0);	//seconds, 0 runs avoid() as soon as anything comes in
+
+	bool tabulatedFields;
+	nh.param<bool>("tabulated_fields", tabulatedFields, false);	//look up other planes' fields in tables
+	if(tabulatedFields)
+		ca.setNeighborField(AnyForceField(TABULATED_OVAL_FIELD_SHAPE, TABULATED_BIVARIATE_NORMAL_FUNCTION));
+
+	schedule.setState(ST_RED);
+	have_my_position = false;
+	reset_shaper = 0;
+	ca_passes = 0;
 	is_testing = _test;
 	return true;
 }
@@ -131,39 +176,51 @@ void au_uav_ros::Mover::run()	{
 	//spin up thread to get callbacks
 	boost::thread spinner(boost::bind(&Mover::spinThread, this));
 
-	//Given GCS commands and ca waypoints, decide which ones to send to ardupilot	
-	move();
+	work();
 
 	ros::shutdown();
 	spinner.join();
 }
 
+void au_uav_ros::Mover::work()	{
+	//a thread to turn the callbacks' telemetry into ca waypoints
+	boost::thread worker(boost::bind(&Mover::caThread, this));
+
+	//Given GCS commands and ca waypoints, decide which ones to send to ardupilot	
+	move();
+
+	telem_mailbox.stop();
+	worker.join();
+}
+
+//move() and the worker notice within MOVER_SHUTDOWN_CHECK
+void au_uav_ros::Mover::stop()	{
+	__sync_lock_test_and_set(&running, 0);
+	telem_mailbox.stop();
+}
+
 
 
 void au_uav_ros::Mover::move()	{
 
 	ROS_INFO("Entering mover::move()");	
-	au_uav_ros::Command com;
 	
-	while(ros::ok())	{
+	while(ros::ok() && isRunning())	{
 		//state machine fun
-		//note - current state is changed in gcs_callback
-		//First, get the current state
-		enum state temp;
-		state_change_lock.lock();
-		temp = current_state;
-		state_change_lock.unlock();
-		//then do some switching
-		switch(current_state)	{
+		//note - current state is changed in gcs_callback, which wakes us up. So does a new command,
+		//and the schedule keeps us from swamping the ardupilot, it's a delicate thing
+		moverState state;
+		MoverSchedule::wakeReason why = schedule.wait(state, MOVER_SHUTDOWN_CHECK);
+		if(why != MoverSchedule::WAKE_COMMAND && why != MoverSchedule::WAKE_DEADLINE)
+			continue;
+		switch(state)	{
 			case(ST_RED):
 				//DO NOT PUBLISH! DO NOT PUBLISH!
 				break;
 			case(ST_GREEN_CA_OFF):
-				ros::Duration(0.25).sleep(); 	//no swamping the ardupilot, it's a delicate thing 
 				goalCommandPublish();
 				break;
 			case(ST_GREEN_CA_ON):
-				ros::Duration(0.25).sleep(); 	//no swamping the ardupilot, it's a delicate thing 
 				caCommandPublish();
 				break;
 		}
@@ -174,12 +231,10 @@ void au_uav_ros::Mover::move()	{
 //Assumes we are in ST_GREEN_CA_OFF
 void au_uav_ros::Mover::goalCommandPublish()	{
 	fprintf(stderr, "mover::(ST_GREEN_CA_OFF) PUBLISHING goal COMMAND!\n");
-	au_uav_ros::Command com;
+	au_uav_ros::Command::Ptr com(new au_uav_ros::Command);
 
 	//Just send out goal wp, no collision avoidance.
-	goal_wp_lock.lock();
-	com = goal_wp;	
-	goal_wp_lock.unlock();
+	goal_wp.load(*com);
 	ca_commands.publish(com);
 
 }
@@ -187,43 +242,97 @@ void au_uav_ros::Mover::goalCommandPublish()	{
 //Assumes we are in ST_GREEN_CA_ON mode.
 void au_uav_ros::Mover::caCommandPublish()	{
 	fprintf(stderr, "mover::(ST_GREEN_CA_ON) PUBLISHING CA COMMAND!\n");
-	au_uav_ros::Command com;
+	au_uav_ros::Command::Ptr com(new au_uav_ros::Command);
+	double received = 0;
 	
-	bool empty_ca_q = false;
-	ca_wp_lock.lock();
-	empty_ca_q = ca_wp.empty();
-	if(!empty_ca_q)	{
-		com = ca_wp.front();
-		ca_wp.pop_front();	
+	//don't want to forward deafult command, if no command is returned. Published commands are never
+	//changed after, the last one goes out again as the same message
+	if(!ca_wp.take(*com, received))	{
+		if(last_ca)
+			ca_commands.publish(last_ca);
+		return;
 	}
-	ca_wp_lock.unlock();	
-
-	//don't want to forward deafult command, if no command is returned
-//	if(com.latitude != INVALID_GPS_COOR && com.latitude !=0)
-		ca_commands.publish(com);
+	ca_commands.publish(com);
+	last_ca = com;
 
+	command_latency.record(ros::WallTime::now().toSec() - received);
+	if(command_latency.getCount() % LATENCY_REPORT_INTERVAL == 0)
+		ROS_INFO("mover: telemetry to ca_commands latency over %ld commands, p50 %.1f us, p99 %.1f us, max %.1f us",
+				command_latency.getCount(), command_latency.percentile(50)*1e6, command_latency.percentile(99)*1e6,
+				command_latency.getMax()*1e6);
 }
 
-void au_uav_ros::Mover::spinThread()	{
-	ROS_INFO("mover::starting spinner thread");
-	ros::spin();
-}
-//main
-//----------------------------------------------------
-int main(int argc, char **argv)	{
-	ros::init(argc, argv, "ca_logic");
-	ros::NodeHandle n;
+void au_uav_ros::Mover::caThread()	{
+	ROS_INFO("mover::starting CA worker thread");
+	std::vector<au_uav_ros::mailboxEntry> taken;
+	std::vector<au_uav_ros::Telemetry> updates;
+
+	while(ros::ok() && isRunning())	{
+		double passStart = ros::WallTime::now().toSec();
+		if(telem_mailbox.take(taken, MOVER_SHUTDOWN_CHECK) == 0)
+			continue;
+
+		//in the order the planes came in, and my position from my own telemetry
+		updates.clear();
+		double oldest = taken[0].received, newest = taken[0].received;
+		for(unsigned int i = 0; i < taken.size(); i++)	{
+			const au_uav_ros::Telemetry &telem = taken[i].telem;
+			updates.push_back(telem);
+			oldest = std::min(oldest, taken[i].received);
+			newest = std::max(newest, taken[i].received);
+			if(telem.planeID == planeID)	{
+				my_position.latitude = telem.currentLatitude;
+				my_position.longitude = telem.currentLongitude;
+				my_position.altitude = telem.currentAltitude;
+				have_my_position = true;
+			}
+		}
 
-	bool is_test;
-	n.param<bool>("testing", is_test, false);
-	au_uav_ros::Mover mv;
-	
-	fprintf(stderr, "MOVER::Testing var is %d", (int)is_test);
-	
-	if(mv.init(n, is_test))	//channnge if doing real planes to true
-		mv.run();	
-	//spin and do move logic in separate thread
+		au_uav_ros::Command com;
+		if(!is_testing)
+			com = ca.avoid(updates);
+		else	{
+			//Using goal_wp as our "avoidance" wp, for testing.
+			goal_wp.load(com);	//something ain't working right T.T
+			com.replace = true; 	
+			fprintf(stderr, "\nmover::caThread goalwp(%f|%f|%f)\n", com.latitude, com.longitude, com.altitude);
+		}
+		data_age.record(ros::WallTime::now().toSec() - oldest);
+		ca_passes++;
+		if(ca_passes % CA_REPORT_INTERVAL == 0)
+			reportCA();
+
+		//Check if ca_waypoint should be ignored
+		bool send = !(com.latitude == INVALID_GPS_COOR && com.longitude == INVALID_GPS_COOR && com.altitude == INVALID_GPS_COOR);
+		if(__sync_bool_compare_and_swap(&reset_shaper, 1, 0))
+			shaper.reset();
+		if(send && shape_commands && have_my_position)	{
+			//not different enough from the last one sent, the keepalive sends that one again
+			send = shaper.shape(my_position, goalCoordinate(), commandCoordinate(com));
+		}
+		//only ST_GREEN_CA_ON publishes ca_wp, waking move() in the other states would send the goal again
+		if(send)	{
+			ca_wp.store(com, newest);
+			if(schedule.getState() == ST_GREEN_CA_ON)
+				schedule.commandReady();
+		}
 
+		//let more updates pile up in the mailbox, they are coalesced into the next pass
+		double rest = ca_min_period - (ros::WallTime::now().toSec() - passStart);
+		if(rest > 0)
+			ros::WallDuration(rest).sleep();
+	}
 }
 
+void au_uav_ros::Mover::reportCA()	{
+	long takes = telem_mailbox.getTakes();
+	ROS_INFO("mover: %ld avoid() passes, %.1f updates per pass (most waiting %d), %ld of %ld updates overwritten before avoid() saw them, "
+			"data age p50 %.1f ms, p99 %.1f ms, max %.1f ms", ca_passes, takes > 0 ? (double)telem_mailbox.getTaken()/takes : 0.0,
+			telem_mailbox.getMaxDepth(), telem_mailbox.getOverwritten(), telem_mailbox.getPosted(), data_age.percentile(50)*1e3,
+			data_age.percentile(99)*1e3, data_age.getMax()*1e3);
+}
 
+void au_uav_ros::Mover::spinThread()	{
+	ROS_INFO("mover::starting spinner thread");
+	ros::spin();
+}
@@ -0,0 +1,19 @@
+#include "au_uav_ros/mover.h"
+
+//The mover node on its own. src/nodelets.cpp loads the same Mover into a nodelet manager.
+
+int main(int argc, char **argv)	{
+	ros::init(argc, argv, "ca_logic");
+	ros::NodeHandle n;
+
+	bool is_test;
+	n.param<bool>("testing", is_test, false);
+	au_uav_ros::Mover mv;
+	
+	fprintf(stderr, "MOVER::Testing var is %d", (int)is_test);
+	
+	if(mv.init(n, is_test))	//channnge if doing real planes to true
+		mv.run();	
+	//spin and do move logic in separate thread
+
+}
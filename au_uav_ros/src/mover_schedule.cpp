@@ -0,0 +1,94 @@
+#include <algorithm>
+#include <boost/thread/thread_time.hpp>
+#include "au_uav_ros/mover_schedule.h"
+
+static boost::posix_time::time_duration duration(double seconds)	{
+	return boost::posix_time::microseconds((long)(seconds*1e6));
+}
+
+au_uav_ros::MoverSchedule::MoverSchedule(double publishPeriod, double minCommandInterval)	{
+	state = ST_RED;
+	currentState = ST_RED;
+	stateChanged = false;
+	pending = false;
+	period = duration(publishPeriod);
+	minInterval = duration(minCommandInterval);
+	wakeups = 0;
+}
+
+void au_uav_ros::MoverSchedule::setPublishPeriod(double seconds)	{
+	boost::mutex::scoped_lock guard(lock);
+	period = duration(seconds);
+	wakeup.notify_all();
+}
+
+void au_uav_ros::MoverSchedule::setMinCommandInterval(double seconds)	{
+	boost::mutex::scoped_lock guard(lock);
+	minInterval = duration(seconds);
+	wakeup.notify_all();
+}
+
+void au_uav_ros::MoverSchedule::setState(moverState s)	{
+	boost::mutex::scoped_lock guard(lock);
+	if(s == state)
+		return;
+	state = s;
+	__sync_lock_test_and_set(&currentState, (int)s);
+	stateChanged = true;
+	pending = false;
+	wakeup.notify_all();
+}
+
+void au_uav_ros::MoverSchedule::commandReady()	{
+	boost::mutex::scoped_lock guard(lock);
+	if(state == ST_RED)
+		return;
+	pending = true;
+	wakeup.notify_all();
+}
+
+au_uav_ros::moverState au_uav_ros::MoverSchedule::getState()	{
+	return (moverState)__sync_fetch_and_add(&currentState, 0);
+}
+
+//Nothing published yet counts as long enough ago for both the period and the interval. A wakeup to
+//publish counts as published, whether the mover had anything to send or not.
+au_uav_ros::MoverSchedule::wakeReason au_uav_ros::MoverSchedule::wait(moverState &s, double maxWait)	{
+	boost::unique_lock<boost::mutex> guard(lock);
+	boost::posix_time::ptime now = boost::get_system_time();
+	boost::posix_time::ptime giveUp = now + duration(maxWait);
+	wakeReason why = WAKE_TIMEOUT;
+	while(true)	{
+		if(stateChanged)	{
+			stateChanged = false;
+			why = WAKE_STATE;
+			break;
+		}
+		boost::posix_time::ptime wakeAt = giveUp;
+		if(state != ST_RED)	{
+			bool never = lastPublished.is_not_a_date_time();
+			boost::posix_time::ptime earliest = never ? now : lastPublished + minInterval;
+			boost::posix_time::ptime due = never ? now : lastPublished + period;
+			if(pending && now >= earliest)	{
+				why = WAKE_COMMAND;
+				break;
+			}
+			if(now >= due)	{
+				why = WAKE_DEADLINE;
+				break;
+			}
+			wakeAt = std::min(giveUp, pending ? earliest : due);
+		}
+		if(now >= giveUp)
+			break;
+		wakeup.timed_wait(guard, wakeAt);
+		now = boost::get_system_time();
+	}
+	if(why == WAKE_COMMAND || why == WAKE_DEADLINE)	{
+		pending = false;
+		lastPublished = now;
+	}
+	s = state;
+	wakeups++;
+	return why;
+}
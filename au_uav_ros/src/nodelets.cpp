@@ -0,0 +1,133 @@
+#include <string>
+#include <boost/thread.hpp>
+#include <boost/shared_ptr.hpp>
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+
+#include "au_uav_ros/ardu_talker.h"
+#include "au_uav_ros/xbee_talker.h"
+#include "au_uav_ros/mover.h"
+
+/*
+ * ardu, xbee and mover as nodelets, all three loaded into one nodelet manager by
+ * launch/PiDeCAF_nodelets.launch. Topics between them then go from publish() to the subscriber's callback
+ * as the shared pointer that was published, nothing serialized, no loopback TCP. Each keeps its own
+ * thread for what the node's main thread did (the serial line's event loop, or move() and the CA worker),
+ * the manager's threads run the callbacks. onInit() has to return quickly, so it only starts that thread.
+ */
+
+namespace au_uav_ros	{
+
+	//Description:
+	//	ArduTalker in a nodelet manager. Params ~port and ~baud, the node's defaults.
+	class ArduNodelet : public nodelet::Nodelet	{
+	public:
+		~ArduNodelet();
+	private:
+		virtual void onInit();
+
+		boost::shared_ptr<ArduTalker> talker;
+		boost::shared_ptr<boost::thread> listener;	//talker->listen(), until the destructor stops it
+	};
+
+	//Description:
+	//	XbeeTalker in a nodelet manager. Params ~port and ~baud, the node's defaults, and the node's
+	//	~restamp_frames etc. from the nodelet's private namespace.
+	class XbeeNodelet : public nodelet::Nodelet	{
+	public:
+		~XbeeNodelet();
+	private:
+		virtual void onInit();
+
+		boost::shared_ptr<XbeeTalker> talker;
+		boost::shared_ptr<boost::thread> listener;
+	};
+
+	//Description:
+	//	Mover in a nodelet manager. init() keeps asking the getPlaneID service until ardu has an ID, so it
+	//	runs on the nodelet's own thread, followed by work(). The destructor's stop() ends either.
+	class MoverNodelet : public nodelet::Nodelet	{
+	public:
+		~MoverNodelet();
+	private:
+		virtual void onInit();
+		void run();
+
+		Mover mover;
+		boost::shared_ptr<boost::thread> worker;
+	};
+}
+
+//ardu
+//----------------------------------------------------
+void au_uav_ros::ArduNodelet::onInit()	{
+	std::string port;
+	int baud;
+	getPrivateNodeHandle().param<std::string>("port", port, "/dev/ttyACM0");
+	getPrivateNodeHandle().param<int>("baud", baud, 115200);
+
+	talker.reset(new ArduTalker(port, baud));
+	if(!talker->init(getNodeHandle()))	{
+		NODELET_ERROR("ardu: could not open %s", port.c_str());
+		return;
+	}
+	listener.reset(new boost::thread(boost::bind(&ArduTalker::listen, talker.get())));
+}
+
+au_uav_ros::ArduNodelet::~ArduNodelet()	{
+	if(listener)	{
+		talker->stop();
+		listener->join();
+	}
+	if(talker)
+		talker->shutdown();
+}
+
+//xbee
+//----------------------------------------------------
+void au_uav_ros::XbeeNodelet::onInit()	{
+	std::string port;
+	int baud;
+	getPrivateNodeHandle().param<std::string>("port", port, "/dev/ttyUSB0");
+	getPrivateNodeHandle().param<int>("baud", baud, 57600);
+
+	talker.reset(new XbeeTalker(port, baud));
+	if(!talker->init(getNodeHandle(), getPrivateNodeHandle()))	{
+		NODELET_ERROR("xbee: could not open %s", port.c_str());
+		return;
+	}
+	listener.reset(new boost::thread(boost::bind(&XbeeTalker::listen, talker.get())));
+}
+
+au_uav_ros::XbeeNodelet::~XbeeNodelet()	{
+	if(listener)	{
+		talker->stop();
+		listener->join();
+	}
+	if(talker)
+		talker->shutdown();
+}
+
+//mover
+//----------------------------------------------------
+void au_uav_ros::MoverNodelet::onInit()	{
+	worker.reset(new boost::thread(boost::bind(&MoverNodelet::run, this)));
+}
+
+void au_uav_ros::MoverNodelet::run()	{
+	bool is_test;
+	getNodeHandle().param<bool>("testing", is_test, false);
+	if(mover.init(getNodeHandle(), is_test))
+		mover.work();
+}
+
+au_uav_ros::MoverNodelet::~MoverNodelet()	{
+	if(worker)	{
+		mover.stop();
+		worker->join();
+	}
+}
+
+PLUGINLIB_EXPORT_CLASS(au_uav_ros::ArduNodelet, nodelet::Nodelet)
+PLUGINLIB_EXPORT_CLASS(au_uav_ros::XbeeNodelet, nodelet::Nodelet)
+PLUGINLIB_EXPORT_CLASS(au_uav_ros::MoverNodelet, nodelet::Nodelet)
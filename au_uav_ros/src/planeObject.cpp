@@ -6,6 +6,7 @@
 #include "au_uav_ros/planeObject.h"
 #include <math.h>
 #include "au_uav_ros/standardFuncs.h" /* for PI, EARTH_RADIUS in meters */
+#include "au_uav_ros/LocalFrame.h"
 //#include "AU_UAV_ROS/ForceField.h"
 #include <math.h>
 using namespace au_uav_ros;
@@ -114,6 +115,11 @@ void PlaneObject::setSpeed(double speed) {
 }
 //should only be called for avoidance wps
 void PlaneObject::setDestination(const waypoint &destination) {
+	//CollisionAvoidance sets this on every telemetry update, reuse the node instead of reallocating it
+	if (this->avoidancePath.size() == 1) {
+		this->avoidancePath.front() = destination;
+		return;
+	}
 	this->avoidancePath.clear(); //TODO find out if we need queue or just 1 wp
 	this->avoidancePath.push_front(destination);
 }
@@ -133,9 +139,8 @@ bool PlaneObject::update(const Telemetry &msg, Command &newCommand) {
 	this->setCurrentLoc(msg.currentLatitude, msg.currentLongitude, msg.currentAltitude);
 	
 	//Calculate actual Cardinal Bearing
-	double numerator = (this->currentLoc.latitude - this->previousLoc.latitude);
-	double denominator = (this->currentLoc.longitude - this->previousLoc.longitude);
-	double angle = atan2(numerator*DELTA_LAT_TO_METERS,denominator*DELTA_LON_TO_METERS)*180/PI;
+	double angle = LocalFrame::mission().angle(this->previousLoc.latitude, this->previousLoc.longitude,
+			this->currentLoc.latitude, this->currentLoc.longitude);
 
 	if (this->currentLoc.latitude != this->previousLoc.latitude && this->currentLoc.longitude != this->previousLoc.longitude) //TODO change to ||
 	{ 
@@ -239,7 +244,7 @@ bool PlaneObject::update(const Telemetry &msg, Command &newCommand) {
 }
 
 
-void PlaneObject::setField(ForceField  newField){
+void PlaneObject::setField(const AnyForceField &newField){
 	planeField = newField;
 }
 
@@ -257,6 +262,10 @@ coordinate PlaneObject::getCurrentLoc(void) const {
 	return this->currentLoc;
 }
 
+localPosition PlaneObject::getLocalPosition(void) const {
+	return LocalFrame::mission().toLocal(this->currentLoc);
+}
+
 double PlaneObject::getTargetBearing(void) const {
 	return this->targetBearing;
 }
@@ -296,10 +305,7 @@ double PlaneObject::findDistance(const PlaneObject& plane) const {
 /* Find distance between this plane and another pair of coordinates, 
 returns value in meters */
 double PlaneObject::findDistance(double lat2, double lon2) const {
-	double xdiff = (lon2 - this->currentLoc.longitude)*DELTA_LON_TO_METERS;
-	double ydiff = (lat2 - this->currentLoc.latitude)*DELTA_LAT_TO_METERS;
-
-	return sqrt(pow(xdiff, 2) + pow(ydiff, 2));
+	return LocalFrame::mission().distance(this->currentLoc.latitude, this->currentLoc.longitude, lat2, lon2);
 }
 
 /* Find Cartesian angle between this plane and another plane, using this plane
@@ -311,32 +317,33 @@ double PlaneObject::findAngle(const PlaneObject& plane) const {
 /* Find Cartesian angle between this plane and another plane's latitude/longitude 
 using this plane as the origin */
 double PlaneObject::findAngle(double lat2, double lon2) const {
-	double xdiff = (lon2 - this->currentLoc.longitude)*DELTA_LON_TO_METERS;
-	double ydiff = (lat2 - this->currentLoc.latitude)*DELTA_LAT_TO_METERS;
-
 	//Get angle in degrees, in range [-180 to 180] in cartesian coordinate frame
-	double degrees =  atan2(ydiff, xdiff)*180.0/PI;
-
-	//added in an attempt to get test to work
-	return degrees;
-
+	return LocalFrame::mission().angle(this->currentLoc.latitude, this->currentLoc.longitude, lat2, lon2);
 }
 
 //FIELD METHODS
 
 
 /*This method will adjust the field of the plane to specifications provided by the arguments
- * TODO:
- * 		DELETE PREVIOUS FIELD
- * 		Enable choosing multiple field setups, this method will currently only call one field type
+ * Unknown codes get the default oval/bivariate normal field
  */
 void PlaneObject::setField(int encodedFieldShape, int encodedFieldFunction){
-
+	if(!AnyForceField::isKnownShape(encodedFieldShape) || !AnyForceField::isKnownFunction(encodedFieldFunction))
+		ROS_WARN("Plane %d: unknown field shape %d or function %d, using the default field", this->id, encodedFieldShape, encodedFieldFunction);
+	planeField = AnyForceField(encodedFieldShape, encodedFieldFunction);
 }
 
-ForceField PlaneObject::getField(){
+const AnyForceField & PlaneObject::getField() const{
 	return this->planeField;
 }
+
+const AnyForceField & PlaneObject::getNeighborField() const{
+	return this->neighborField;
+}
+
+void PlaneObject::setNeighborField(const AnyForceField &newField){
+	neighborField = newField;
+}
 /*
 double PlaneObject::findMyFieldForceMagnitude(fsquared::relativeCoordinates relativePosition){
 	return planeField->findFieldForceMagnitude(relativePosition);
@@ -351,20 +358,22 @@ bool PlaneObject::isInMyField(fsquared::relativeCoordinates relativePosition, do
 
 /*Accessor method for planesToAvoid map */
 
-std::map<int, PlaneObject> & PlaneObject::getMap()	{
+fsquared::NeighborTable & PlaneObject::getMap()	{
 	return planesToAvoid; 		
 }
 
 /* 
 * 
-*Insert plane. Copy by value. If it exists, will update the existing plane.
-*After adding plane, will clear its map to prevent infinite loop of planes with maps with planes...
-*
+*Insert plane. Only its NeighborState is copied, so the map never holds paths or maps of other planes.
+*If it exists, will update the existing plane.
 *
 */
-void PlaneObject::planeIn_updateMap(PlaneObject plane)	{
-	(planesToAvoid)[plane.getID()]  = plane;
-	plane.clearMap();
+void PlaneObject::planeIn_updateMap(const PlaneObject &plane)	{
+	planesToAvoid.update(plane.toNeighborState());
+}
+
+void PlaneObject::planeIn_updateMap(const fsquared::NeighborState &plane)	{
+	planesToAvoid.update(plane);
 }
 
 /*
@@ -376,13 +385,22 @@ void PlaneObject::clearMap()	{
 
 /* Ensure plane is not in the map */
 void PlaneObject::planeOut_updateMap(PlaneObject &plane)	{
+	planesToAvoid.erase(plane.getID());
+}
+
+void PlaneObject::planeOut_updateMap(int planeID)	{
+	planesToAvoid.erase(planeID);
+}
 
-	//If plane is in map, TAKE IT OUT arggghh
-	std::map<int, PlaneObject> ::iterator it;
-	int plane_id = plane.getID();
-	it = planesToAvoid.find(plane_id);
-	if(it != planesToAvoid.end())
-		planesToAvoid.erase(it);
+fsquared::NeighborState PlaneObject::toNeighborState() const	{
+	fsquared::NeighborState state;
+	state.id = this->id;
+	state.position = this->getLocalPosition();
+	state.currentBearing = this->currentBearing;
+	state.targetBearing = this->targetBearing;
+	state.speed = this->speed;
+	state.lastUpdateTime = this->lastUpdateTime;
+	return state;
 }
 
 // TODO: Add equality check for force field
@@ -0,0 +1,41 @@
+#include "au_uav_ros/plane_identity.h"
+
+au_uav_ros::PlaneIdentity::PlaneIdentity()	{
+	identified = false;
+	planeID = -1;
+	latitude = longitude = altitude = 0;
+}
+
+bool au_uav_ros::PlaneIdentity::set(int id, const au_uav_ros::Telemetry &telem)	{
+	if(telem.currentLatitude == 0 && telem.currentLongitude == 0)
+		return false;
+	boost::lock_guard<boost::mutex> guard(lock);
+	if(identified)
+		return false;
+	planeID = id;
+	latitude = telem.currentLatitude;
+	longitude = telem.currentLongitude;
+	altitude = telem.currentAltitude;
+	identified = true;
+	changed.notify_all();
+	return true;
+}
+
+bool au_uav_ros::PlaneIdentity::wait(au_uav_ros::planeIDGetter::Response &res, double seconds)	{
+	boost::unique_lock<boost::mutex> guard(lock);
+	boost::system_time deadline = boost::get_system_time() + boost::posix_time::milliseconds((long)(seconds*1000));
+	while(!identified)	{
+		if(!changed.timed_wait(guard, deadline) && !identified)
+			return false;
+	}
+	res.planeID = planeID;
+	res.initialLatitude = latitude;
+	res.initialLongitude = longitude;
+	res.initialAltitude = altitude;
+	return true;
+}
+
+bool au_uav_ros::PlaneIdentity::isSet()	{
+	boost::lock_guard<boost::mutex> guard(lock);
+	return identified;
+}
@@ -0,0 +1,314 @@
+#include <poll.h>
+#include <time.h>
+#include <sys/uio.h>
+#include <sys/eventfd.h>
+#include "ros/ros.h"
+#include "au_uav_ros/serial_writer.h"
+
+/*
+ * Sequence numbers, for the slot at position pos (pos only grows, the slot is pos & mask):
+ * 		pos				free, a sender can claim it
+ * 		pos + 1			filled, it can be taken
+ * 		pos + mask + 1	taken and done with, free again for the sender one lap later
+ * Everything shared between the senders and the writer goes through the GCC __sync builtins, which
+ * are full barriers, so a frame is always in its slot before its sequence number says it is.
+ */
+
+template<typename T>
+static inline T atomicLoad(volatile T *at)	{
+	return __sync_fetch_and_add(at, 0);
+}
+
+template<typename T>
+static inline void atomicStore(volatile T *at, T value)	{
+	T seen = atomicLoad(at);
+	while(!__sync_bool_compare_and_swap(at, seen, value))
+		seen = atomicLoad(at);
+}
+
+static double monotonicSeconds()	{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+au_uav_ros::SerialWriter::SerialWriter(SerialTalker &serialOut, int queueFrames) : serial(serialOut)	{
+	unsigned int size = 1;
+	while(size < (unsigned int)queueFrames)
+		size *= 2;
+	mask = size - 1;
+	for(int p = 0; p < TX_PRIORITIES; p++)	{
+		queue &q = queues[p];
+		q.slots = new slot[size];
+		for(unsigned int i = 0; i < size; i++)	{
+			q.slots[i].sequence = i;
+			q.slots[i].length = 0;
+		}
+		q.tail = 0;
+		q.head = 0;
+		q.dropOldest = (p == TX_TELEMETRY);
+		q.framesSent = 0;
+		q.bytesSent = 0;
+		q.framesDropped = 0;
+	}
+	sleeping = 0;
+	running = 0;
+	writer = NULL;
+	linkRate = 0;
+	credit = 0;
+	creditAt = 0;
+	writeCalls = 0;
+	wakeFD = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+}
+
+au_uav_ros::SerialWriter::~SerialWriter()	{
+	stop();
+	if(wakeFD >= 0)
+		close(wakeFD);
+	for(int p = 0; p < TX_PRIORITIES; p++)
+		delete [] queues[p].slots;
+}
+
+bool au_uav_ros::SerialWriter::start()	{
+	if(writer != NULL)
+		return true;
+	if(wakeFD < 0)	{
+		ROS_ERROR("SerialWriter: could not create eventfd for %s", serial.getPortName().c_str());
+		return false;
+	}
+	credit = TX_BURST_BYTES;
+	creditAt = monotonicSeconds();
+	atomicStore(&running, 1);
+	writer = new boost::thread(boost::bind(&SerialWriter::writeLoop, this));
+	return true;
+}
+
+void au_uav_ros::SerialWriter::setLinkRate(int bytesPerSecond)	{
+	linkRate = bytesPerSecond > 0 ? bytesPerSecond : 0;
+}
+
+void au_uav_ros::SerialWriter::stop()	{
+	if(writer == NULL)
+		return;
+	atomicStore(&running, 0);
+	wake();
+	writer->join();
+	delete writer;
+	writer = NULL;
+}
+
+bool au_uav_ros::SerialWriter::send(const mavlink_message_t &message, txPriority priority)	{
+	uint8_t frame[MAVLINK_MAX_PACKET_LEN];
+	int length = mavlink_msg_to_send_buffer(frame, &message);
+	return send(frame, length, priority);
+}
+
+bool au_uav_ros::SerialWriter::send(const uint8_t *frame, int length, txPriority priority)	{
+	if(length <= 0 || length > MAVLINK_MAX_PACKET_LEN || priority < 0 || priority >= TX_PRIORITIES)
+		return false;
+	queue &q = queues[priority];
+
+	//claim a slot
+	unsigned int pos = atomicLoad(&q.tail);
+	slot *claimed;
+	while(true)	{
+		claimed = &q.slots[pos & mask];
+		unsigned int sequence = atomicLoad(&claimed->sequence);
+		int lead = (int)(sequence - pos);
+		if(lead == 0)	{
+			if(__sync_bool_compare_and_swap(&q.tail, pos, pos + 1))
+				break;
+		}
+		else if(lead < 0)	{
+			//not freed since the last lap, the queue is full. Taking the oldest frame only makes
+			//room if it is in this slot, and not if the writer has the slot on the line.
+			unsigned int oldestPos;
+			slot *oldest = NULL;
+			if(q.dropOldest && atomicLoad(&q.head) == pos - mask - 1)
+				oldest = take(q, oldestPos);
+			__sync_fetch_and_add(&q.framesDropped, 1);
+			if(oldest == NULL)
+				return false;
+			release(oldest, oldestPos);
+		}
+		pos = atomicLoad(&q.tail);	//another sender got it first, or there is room now
+	}
+
+	//fill it and hand it over
+	memcpy(claimed->frame, frame, length);
+	claimed->length = length;
+	atomicStore(&claimed->sequence, pos + 1);
+
+	if(atomicLoad(&sleeping))
+		wake();
+	return true;
+}
+
+au_uav_ros::SerialWriter::slot * au_uav_ros::SerialWriter::take(queue &q, unsigned int &pos)	{
+	pos = atomicLoad(&q.head);
+	while(true)	{
+		slot *next = &q.slots[pos & mask];
+		int lead = (int)(atomicLoad(&next->sequence) - (pos + 1));
+		if(lead == 0)	{
+			if(__sync_bool_compare_and_swap(&q.head, pos, pos + 1))
+				return next;
+		}
+		else if(lead < 0)
+			return NULL;	//empty, or its sender is still filling it
+		pos = atomicLoad(&q.head);
+	}
+}
+
+void au_uav_ros::SerialWriter::release(slot *taken, unsigned int pos)	{
+	atomicStore(&taken->sequence, pos + mask + 1);
+}
+
+bool au_uav_ros::SerialWriter::ready(queue &q)	{
+	unsigned int pos = atomicLoad(&q.head);
+	return atomicLoad(&q.slots[pos & mask].sequence) == pos + 1;
+}
+
+void au_uav_ros::SerialWriter::wake()	{
+	uint64_t one = 1;
+	if(write(wakeFD, &one, sizeof(one)) < 0 && errno != EAGAIN)
+		ROS_ERROR("SerialWriter: could not wake writer (%s)", strerror(errno));
+}
+
+//The sender sets the sequence and then reads sleeping, the writer sets sleeping and then reads the
+//sequences, each with a barrier between. So either the writer sees the frame, or the sender sees
+//it sleeping and wakes it.
+void au_uav_ros::SerialWriter::waitForFrames()	{
+	atomicStore(&sleeping, 1);
+	bool any = false;
+	for(int p = 0; p < TX_PRIORITIES && !any; p++)
+		any = ready(queues[p]);
+	if(!any && atomicLoad(&running))	{
+		struct pollfd waitFor;
+		waitFor.fd = wakeFD;
+		waitFor.events = POLLIN;
+		waitFor.revents = 0;
+		poll(&waitFor, 1, -1);
+	}
+	//EAGAIN is nothing to clear, the writer found frames without being woken
+	uint64_t count;
+	if(read(wakeFD, &count, sizeof(count)) < 0 && errno != EAGAIN)
+		ROS_ERROR("SerialWriter: could not clear wakeup (%s)", strerror(errno));
+	atomicStore(&sleeping, 0);
+}
+
+//Tops up the credit for the time gone by, and sleeps until the link has caught up with what was written
+void au_uav_ros::SerialWriter::waitForLink()	{
+	if(linkRate == 0)
+		return;
+	double now = monotonicSeconds();
+	credit += (now - creditAt)*linkRate;
+	creditAt = now;
+	if(credit > TX_BURST_BYTES)
+		credit = TX_BURST_BYTES;
+	if(credit < 0)	{
+		ros::WallDuration(-credit/linkRate).sleep();
+		now = monotonicSeconds();
+		credit += (now - creditAt)*linkRate;
+		creditAt = now;
+	}
+}
+
+//Takes the most urgent frames first. A paced writer stops once it has used up its credit, so a
+//command queued while this writev is on the line is not behind a long run of telemetry.
+int au_uav_ros::SerialWriter::writeOut()	{
+	struct iovec pieces[TX_COALESCE_FRAMES];
+	slot *taken[TX_COALESCE_FRAMES];
+	unsigned int takenPos[TX_COALESCE_FRAMES];
+	int takenFrom[TX_COALESCE_FRAMES];
+	int count = 0, bytes = 0;
+	waitForLink();
+	for(int p = 0; p < TX_PRIORITIES; p++)	{
+		while(count < TX_COALESCE_FRAMES && (linkRate == 0 || bytes < credit))	{
+			slot *next = take(queues[p], takenPos[count]);
+			if(next == NULL)
+				break;
+			taken[count] = next;
+			takenFrom[count] = p;
+			pieces[count].iov_base = next->frame;
+			pieces[count].iov_len = next->length;
+			bytes += next->length;
+			count++;
+		}
+	}
+	if(count == 0)
+		return 0;
+
+	//writev can stop part way through, carry on from where it got to
+	struct iovec *remaining = pieces;
+	int left = count;
+	while(left > 0)	{
+		ssize_t num = writev(serial.getFD(), remaining, left);
+		if(num < 0)	{
+			if(errno == EINTR || errno == EAGAIN)
+				continue;
+			ROS_ERROR("SerialWriter: write to %s failed (%s), %d frames lost", serial.getPortName().c_str(),
+					strerror(errno), left);
+			break;
+		}
+		__sync_fetch_and_add(&writeCalls, 1);
+		while(left > 0 && num >= (ssize_t)remaining->iov_len)	{
+			num -= remaining->iov_len;
+			remaining++;
+			left--;
+		}
+		if(left > 0)	{
+			remaining->iov_base = (uint8_t *)remaining->iov_base + num;
+			remaining->iov_len -= num;
+		}
+	}
+	credit -= bytes;
+
+	//count what made it out, and free the slots for the next lap
+	for(int i = 0; i < count; i++)	{
+		queue &q = queues[takenFrom[i]];
+		if(i < count - left)	{
+			__sync_fetch_and_add(&q.framesSent, 1);
+			__sync_fetch_and_add(&q.bytesSent, taken[i]->length);
+		}
+		release(taken[i], takenPos[i]);
+	}
+	return count;
+}
+
+//Once stopped, whatever is already queued is still written out
+void au_uav_ros::SerialWriter::writeLoop()	{
+	while(atomicLoad(&running))
+		if(writeOut() == 0)
+			waitForFrames();
+	while(writeOut() > 0);
+}
+
+long au_uav_ros::SerialWriter::getFramesSent() const	{
+	long sum = 0;
+	for(int p = 0; p < TX_PRIORITIES; p++)
+		sum += queues[p].framesSent;
+	return sum;
+}
+
+long au_uav_ros::SerialWriter::getFramesDropped() const	{
+	long sum = 0;
+	for(int p = 0; p < TX_PRIORITIES; p++)
+		sum += queues[p].framesDropped;
+	return sum;
+}
+
+long au_uav_ros::SerialWriter::getWriteCalls() const	{
+	return writeCalls;
+}
+
+long au_uav_ros::SerialWriter::getFramesSent(txPriority priority) const	{
+	return queues[priority].framesSent;
+}
+
+long au_uav_ros::SerialWriter::getBytesSent(txPriority priority) const	{
+	return queues[priority].bytesSent;
+}
+
+long au_uav_ros::SerialWriter::getFramesDropped(txPriority priority) const	{
+	return queues[priority].framesDropped;
+}
@@ -4,6 +4,7 @@
 #include <ctype.h>
 
 #include "au_uav_ros/standardDefs.h"
+#include "au_uav_ros/LocalFrame.h"
 
 /*
 isBlankLine(...)
@@ -48,27 +49,12 @@ bool isValidYesNo(char c)
 
 /*
 distanceBetween(...)
-Returns the distance in meters between the two waypoints provided.  Note that it does take into account
-the earth's curvature.
+Returns the distance in meters between the two waypoints provided, measured in the mission's local frame
+(see LocalFrame.h) instead of with the haversine formula.
 */
 double distanceBetween(struct au_uav_ros::waypoint first, struct au_uav_ros::waypoint second)
 {
-	//difference in latitudes in radians
-	double lat1 = first.latitude*DEGREES_TO_RADIANS;
-	double lat2 = second.latitude*DEGREES_TO_RADIANS;
-	double long1 = first.longitude*DEGREES_TO_RADIANS;
-	double long2 = second.longitude*DEGREES_TO_RADIANS;
-	
-	double deltaLat = lat2 - lat1;
-	double deltaLong = long2 - long1;
-	
-	//haversine crazy math, should probably be verified further beyond basic testing
-	//calculate distance from current position to destination
-	double a = pow(sin(deltaLat / 2.0), 2);
-	a = a + cos(lat1)*cos(lat2)*pow(sin(deltaLong/2.0), 2);
-	a = 2.0 * asin(sqrt(a));
-	
-	return EARTH_RADIUS * a;
+	return au_uav_ros::LocalFrame::mission().distance(first.latitude, first.longitude, second.latitude, second.longitude);
 }
 
 bool operator==(const struct au_uav_ros::waypoint &wp1, const struct au_uav_ros::waypoint &wp2) {
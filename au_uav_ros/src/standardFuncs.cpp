@@ -6,31 +6,23 @@ are related to implementation, not usage.
 #include <cmath>
 #include <stdlib.h>
 #include "au_uav_ros/standardFuncs.h"
+#include "au_uav_ros/LocalFrame.h"
 
 
 
 au_uav_ros::waypoint calculateCoordinate(au_uav_ros::waypoint currentPosition, double bearing, double distance){
-	// Calculate final latitude and longitude; see movable-type.co.uk/scripts/latlong.html for more detail
+	// Step the distance along the bearing in the mission's local frame. Callers move tens of meters,
+	// where the frame is as good as the rhumb line math this used to do
+	const au_uav_ros::LocalFrame &frame = au_uav_ros::LocalFrame::mission();
 	bearing *= DEGREES_TO_RADIANS; // convert angle of force to radians
+	double meters = distance*EARTH_RADIUS; // distance is angular
 
-	double lat1 = currentPosition.latitude*DEGREES_TO_RADIANS; // lat1 = current latitude in radians
-	double dLat = distance*cos(bearing); // calculate change in latitude
-	double lat2 = lat1 + dLat; // calculate final latitude
-	double dPhi = log(tan(lat2/2+PI/4)/tan(lat1/2+PI/4));
-	double q = (!(dPhi < 0.0001)) ? dLat/dPhi : cos(lat1);  // East-West line gives dPhi=0
-	double dLon = distance*sin(bearing)/q; // calculate change in longitude
-
-	// check for some daft bugger going past the pole, normalise latitude if so
-	if (abs(lat2) > PI/2)
-		lat2 = lat2>0 ? PI-lat2 : -(PI-lat2);
-
-	double lon2 = (currentPosition.longitude*DEGREES_TO_RADIANS+dLon) * RADIANS_TO_DEGREES; // calculate final latitude and convert to degrees
+	double lat2 = frame.toLatitude(frame.toY(currentPosition.latitude) + meters*cos(bearing));
+	double lon2 = frame.toLongitude(frame.toX(currentPosition.longitude) + meters*sin(bearing));
 
 	//wrap around if necessary to ensure final longitude is on the interval [-180, 180]
 	lon2 = manipulateAngle(lon2);
 
-	lat2 *= RADIANS_TO_DEGREES; // convert final latitude to degrees
-
 	au_uav_ros::waypoint coordinate;
 	coordinate.latitude = lat2;
 	coordinate.longitude = lon2;
@@ -105,13 +97,7 @@ longitude of the ending point.
 */
 
 double findDistance(double lat1, double long1, double lat2, double long2){
-	
-	/* Get difference in radians */
-	double latDiff = (lat2 - lat1)*DELTA_LAT_TO_METERS;
-	double lonDiff = (long2 - long1)*DELTA_LON_TO_METERS;
-
-	/* Return result in meters */
-	return sqrt(pow(latDiff, 2) + pow(lonDiff, 2));
+	return au_uav_ros::LocalFrame::mission().distance(lat1, long1, lat2, long2);
 }
 
 /* 
@@ -120,13 +106,7 @@ by lat1 and long1 (the first two parameters), and the final point is given by la
 The value returned is on the interval [-180, 180].
 */
 double findAngle(double lat1, double long1, double lat2, double long2){
-	
-	/* Get difference in radians */
-	double latDiff = (lat2 - lat1)*DELTA_LAT_TO_METERS;
-	double lonDiff = (long2 - long1)*DELTA_LON_TO_METERS;
-
-	/* Return result in degrees */
-	return atan2(latDiff,lonDiff)*180.0/PI;
+	return au_uav_ros::LocalFrame::mission().angle(lat1, long1, lat2, long2);
 }
 
 /* Returns the sign of the double*/
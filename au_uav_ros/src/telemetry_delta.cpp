@@ -0,0 +1,143 @@
+#include <string.h>
+#include <limits.h>
+#include "au_uav_ros/telemetry_delta.h"
+
+#define TARGET_OFFSET 12		//target lat, lng and alt, 12 bytes of the AU_UAV payload
+#define TARGET_WP_INDEX_OFFSET 40
+#define DELTA_HEADER_LEN 2		//au_key_seq and au_changed, then the differences
+
+//Where each deltaField is in the AU_UAV payload, and the step it is sent in
+static const int fieldOffset[au_uav_ros::mav::DELTA_FIELDS] = {0, 4, 8, 24, 28, 32, 36};
+static const int fieldStep[au_uav_ros::mav::DELTA_FIELDS] = {DELTA_POSITION_STEP, DELTA_POSITION_STEP, 1, 1, 1, 1, 1};
+
+static int32_t readInt32(const uint8_t *at)	{
+	return (int32_t)((uint32_t)at[0] | (uint32_t)at[1] << 8 | (uint32_t)at[2] << 16 | (uint32_t)at[3] << 24);
+}
+
+static void writeInt32(uint8_t *at, int32_t value)	{
+	uint32_t bits = value;
+	at[0] = bits;
+	at[1] = bits >> 8;
+	at[2] = bits >> 16;
+	at[3] = bits >> 24;
+}
+
+//Rounded to the nearest step, halves away from zero
+static int64_t steps(int64_t difference, int step)	{
+	return difference >= 0 ? (difference + step/2)/step : -((-difference + step/2)/step);
+}
+
+au_uav_ros::mav::DeltaEncoder::DeltaEncoder(int _keyframeInterval)	{
+	keyframeInterval = _keyframeInterval;
+	haveKey = false;
+	keySequence = 0;
+	sequence = 0;
+	sinceKey = 0;
+	keyframes = 0;
+	deltas = 0;
+}
+
+int au_uav_ros::mav::DeltaEncoder::encode(const FrameView &frame, uint8_t *out)	{
+	if(frame.msgid() != MAVLINK_MSG_ID_AU_UAV || frame.length() < MAVLINK_MSG_ID_AU_UAV_LEN)
+		return 0;
+	const uint8_t *payload = frame.payload();
+
+	bool sendKey = !haveKey || sinceKey + 1 >= keyframeInterval ||
+			memcmp(payload + TARGET_OFFSET, key + TARGET_OFFSET, 12) != 0 ||
+			payload[TARGET_WP_INDEX_OFFSET] != key[TARGET_WP_INDEX_OFFSET];
+	uint8_t changed = 0;
+	int16_t differences[DELTA_FIELDS];
+	int count = 0;
+	for(int f = 0; f < DELTA_FIELDS && !sendKey; f++)	{
+		int64_t difference = steps((int64_t)readInt32(payload + fieldOffset[f]) - readInt32(key + fieldOffset[f]), fieldStep[f]);
+		if(difference < SHRT_MIN || difference > SHRT_MAX)
+			sendKey = true;
+		else if(difference != 0)	{
+			changed |= 1 << f;
+			differences[count++] = difference;
+		}
+	}
+
+	out[0] = MAVLINK_STX;
+	out[3] = frame.sysid();
+	out[4] = frame.compid();
+	if(sendKey)	{
+		out[1] = MAVLINK_MSG_ID_AU_UAV_LEN;
+		out[5] = MAVLINK_MSG_ID_AU_UAV;
+		memcpy(out + MAVLINK_NUM_HEADER_BYTES, payload, MAVLINK_MSG_ID_AU_UAV_LEN);
+		memcpy(key, payload, MAVLINK_MSG_ID_AU_UAV_LEN);
+		haveKey = true;
+		keySequence = sequence;
+		sinceKey = 0;
+		keyframes++;
+	}
+	else	{
+		out[1] = DELTA_HEADER_LEN + 2*count;
+		out[5] = MAVLINK_MSG_ID_AU_UAV_DELTA;
+		uint8_t *at = out + MAVLINK_NUM_HEADER_BYTES;
+		*at++ = keySequence;
+		*at++ = changed;
+		for(int i = 0; i < count; i++)	{
+			*at++ = (uint16_t)differences[i];
+			*at++ = (uint16_t)differences[i] >> 8;
+		}
+		sinceKey++;
+		deltas++;
+	}
+	restampFrame(out, sequence++);
+	return out[1] + MAVLINK_NUM_NON_PAYLOAD_BYTES;
+}
+
+au_uav_ros::mav::DeltaDecoder::DeltaDecoder()	{
+	for(int i = 0; i < 256; i++)
+		planes[i].seen = false;
+	rebuilt = 0;
+	dropped = 0;
+}
+
+void au_uav_ros::mav::DeltaDecoder::keyframe(const FrameView &frame)	{
+	if(frame.msgid() != MAVLINK_MSG_ID_AU_UAV || frame.length() < MAVLINK_MSG_ID_AU_UAV_LEN)
+		return;
+	plane &from = planes[frame.sysid()];
+	from.seen = true;
+	from.sequence = frame.sequence();
+	memcpy(from.payload, frame.payload(), MAVLINK_MSG_ID_AU_UAV_LEN);
+}
+
+bool au_uav_ros::mav::DeltaDecoder::rebuild(const FrameView &delta, uint8_t *out)	{
+	const plane &from = planes[delta.sysid()];
+	const uint8_t *at = delta.payload();
+	if(delta.msgid() != MAVLINK_MSG_ID_AU_UAV_DELTA || delta.length() < DELTA_HEADER_LEN || !from.seen ||
+			at[0] != from.sequence || at[1] >> DELTA_FIELDS != 0)	{
+		dropped++;
+		return false;
+	}
+	uint8_t changed = at[1];
+	int count = 0;
+	for(int f = 0; f < DELTA_FIELDS; f++)
+		count += (changed >> f) & 1;
+	if(delta.length() < DELTA_HEADER_LEN + 2*count)	{
+		dropped++;
+		return false;
+	}
+
+	out[0] = MAVLINK_STX;
+	out[1] = MAVLINK_MSG_ID_AU_UAV_LEN;
+	out[3] = delta.sysid();
+	out[4] = delta.compid();
+	out[5] = MAVLINK_MSG_ID_AU_UAV;
+	uint8_t *payload = out + MAVLINK_NUM_HEADER_BYTES;
+	memcpy(payload, from.payload, MAVLINK_MSG_ID_AU_UAV_LEN);
+	at += DELTA_HEADER_LEN;
+	for(int f = 0; f < DELTA_FIELDS; f++)	{
+		if(!(changed & 1 << f))
+			continue;
+		int16_t difference = (int16_t)(at[0] | at[1] << 8);
+		at += 2;
+		uint8_t *field = payload + fieldOffset[f];
+		writeInt32(field, (uint32_t)readInt32(field) + (uint32_t)(difference*fieldStep[f]));
+	}
+	restampFrame(out, delta.sequence());
+	rebuilt++;
+	return true;
+}
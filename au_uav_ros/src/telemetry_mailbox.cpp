@@ -0,0 +1,99 @@
+#include <boost/thread/thread_time.hpp>
+#include "au_uav_ros/telemetry_mailbox.h"
+
+au_uav_ros::TelemetryMailbox::TelemetryMailbox()	{
+	stopped = false;
+	maxDepth = 0;
+	posted = 0;
+	overwritten = 0;
+	takes = 0;
+	taken = 0;
+}
+
+void au_uav_ros::TelemetryMailbox::post(const au_uav_ros::Telemetry &telem, double received)	{
+	if(telem.planeID < 0)
+		return;
+
+	boost::mutex::scoped_lock guard(lock);
+	if(telem.planeID >= (int)slots.size())	{
+		slot empty;
+		empty.waiting = false;
+		slots.resize(telem.planeID + 1, empty);
+	}
+
+	slot &s = slots[telem.planeID];
+	if(s.waiting)
+		overwritten++;
+	else	{
+		s.waiting = true;
+		order.push_back(telem.planeID);
+		if((int)order.size() > maxDepth)
+			maxDepth = order.size();
+	}
+	s.entry.telem = telem;
+	s.entry.received = received;
+	posted++;
+	wakeup.notify_all();
+}
+
+int au_uav_ros::TelemetryMailbox::take(std::vector<mailboxEntry> &updates, double maxWait)	{
+	updates.clear();
+
+	boost::unique_lock<boost::mutex> guard(lock);
+	boost::posix_time::ptime giveUp = boost::get_system_time() + boost::posix_time::microseconds((long)(maxWait*1e6));
+	while(order.empty() && !stopped)	{
+		if(!wakeup.timed_wait(guard, giveUp))
+			break;
+	}
+	if(stopped)
+		return 0;
+
+	for(unsigned int i = 0; i < order.size(); i++)	{
+		slot &s = slots[order[i]];
+		updates.push_back(s.entry);
+		s.waiting = false;
+	}
+	order.clear();
+
+	if(!updates.empty())	{
+		takes++;
+		taken += updates.size();
+	}
+	return updates.size();
+}
+
+void au_uav_ros::TelemetryMailbox::stop()	{
+	boost::mutex::scoped_lock guard(lock);
+	stopped = true;
+	wakeup.notify_all();
+}
+
+int au_uav_ros::TelemetryMailbox::getDepth()	{
+	boost::mutex::scoped_lock guard(lock);
+	return order.size();
+}
+
+int au_uav_ros::TelemetryMailbox::getMaxDepth()	{
+	boost::mutex::scoped_lock guard(lock);
+	return maxDepth;
+}
+
+long au_uav_ros::TelemetryMailbox::getPosted()	{
+	boost::mutex::scoped_lock guard(lock);
+	return posted;
+}
+
+long au_uav_ros::TelemetryMailbox::getOverwritten()	{
+	boost::mutex::scoped_lock guard(lock);
+	return overwritten;
+}
+
+long au_uav_ros::TelemetryMailbox::getTakes()	{
+	boost::mutex::scoped_lock guard(lock);
+	return takes;
+}
+
+long au_uav_ros::TelemetryMailbox::getTaken()	{
+	boost::mutex::scoped_lock guard(lock);
+	return taken;
+}
@@ -0,0 +1,239 @@
+//Report on how much of the XBee link a fleet uses with BroadcastRate (broadcast_rate.h) and how
+//fresh what the planes know about each other is.
+//Not a pass/fail test - run by hand (rosrun au_uav_ros broadcast_rate_benchmark) and compare the table.
+//The recorded flights are given on the command line, e.g.
+//	cd `rospack find au_uav_ros`
+//	rosrun au_uav_ros broadcast_rate_benchmark flightData/NoAvoidance/final_32_*.kml
+//
+//Each plane's track in a flightData .kml (a position a second) is flown again with an autopilot
+//update every UPDATE_PERIOD, the positions in between taken on the straight line. Every update goes
+//through the plane's own BroadcastRate, which only knows the neighbors it has heard from, and what
+//is sent is heard by every plane at once. For each way of picking the updates to send this prints:
+//	- how much of a 57600 baud link the fleet used, and the frames a second each plane sent
+//	- for pairs of planes inside RADAR_ZONE of each other: how old the last update one had heard
+//	  from the other was (median, 99th percentile and worst), and how far off it put the other
+//	- the same ages for every pair of planes, near or not
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <map>
+#include <algorithm>
+#include <vector>
+#include "au_uav_ros/broadcast_rate.h"
+#include "au_uav_ros/Fsquared.h"	//RADAR_ZONE
+#include "au_uav_ros/standardDefs.h"
+
+#define LINK_BYTES_PER_SECOND (57600/10)	//8N1
+#define UPDATE_PERIOD 0.1		//seconds, a 10 Hz autopilot
+#define FRAME_BYTES 49			//an AU_UAV frame
+
+struct point	{
+	double lat, lon, alt;
+};
+
+typedef std::map<int, std::vector<point> > byPlane;
+
+enum policy	{EVERY_UPDATE, ONCE_A_SECOND, ADAPTIVE, ADAPTIVE_BUDGET, POLICIES};
+static const char *policyNames[POLICIES] = {"every update", "1 Hz", "adaptive", "adaptive+budget"};
+
+//The "Telemetry #N" LineString of every "UAV #N" folder, "lon, lat, alt" a line
+bool loadTracks(const char *path, byPlane &tracks)	{
+	FILE *file = fopen(path, "r");
+	if(file == NULL)
+		return false;
+	char line[256];
+	int plane = -1;
+	bool inCoordinates = false;
+	while(fgets(line, sizeof(line), file) != NULL)	{
+		const char *name = strstr(line, "<name>Telemetry #");
+		if(name != NULL)
+			plane = atoi(name + strlen("<name>Telemetry #"));
+		else if(strstr(line, "<coordinates>") != NULL && strstr(line, "</coordinates>") == NULL)
+			inCoordinates = plane >= 0;
+		else if(strstr(line, "</coordinates>") != NULL)	{
+			inCoordinates = false;
+			plane = -1;
+		}
+		else if(inCoordinates)	{
+			point p;
+			if(sscanf(line, " %lf , %lf , %lf", &p.lon, &p.lat, &p.alt) == 3)
+				tracks[plane].push_back(p);
+		}
+	}
+	fclose(file);
+	return !tracks.empty();
+}
+
+//Where a plane is at time seconds, false once its track has ended
+bool positionAt(const std::vector<point> &track, double seconds, point &at)	{
+	unsigned int i = (unsigned int)seconds;
+	if(track.empty() || i + 1 >= track.size())
+		return false;
+	double f = seconds - i;
+	at.lat = track[i].lat + (track[i + 1].lat - track[i].lat)*f;
+	at.lon = track[i].lon + (track[i + 1].lon - track[i].lon)*f;
+	at.alt = track[i].alt + (track[i + 1].alt - track[i].alt)*f;
+	return true;
+}
+
+//Flat earth, the courses are a kilometer across
+double horizontal(const point &a, const point &b)	{
+	double north = (b.lat - a.lat)*LATITUDE_TO_METERS;
+	double east = (b.lon - a.lon)*LATITUDE_TO_METERS*cos(a.lat*DEGREES_TO_RADIANS);
+	return sqrt(east*east + north*north);
+}
+
+struct heard	{
+	bool ever;
+	int at;		//step
+	point position;
+};
+
+//How many times the last update heard was each number of updates old
+struct ages	{
+	std::vector<long> counts;
+	long total;
+
+	ages() : total(0) {}
+
+	void add(int updates)	{
+		if(updates >= (int)counts.size())
+			counts.resize(updates + 1, 0);
+		counts[updates]++;
+		total++;
+	}
+
+	//seconds
+	double percentile(double p) const	{
+		long seen = 0;
+		for(unsigned int i = 0; i < counts.size(); i++)	{
+			seen += counts[i];
+			if(seen > p*total)
+				return i*UPDATE_PERIOD;
+		}
+		return 0;
+	}
+
+	double worst() const	{
+		return counts.empty() ? 0 : (counts.size() - 1)*UPDATE_PERIOD;
+	}
+};
+
+struct result	{
+	long bytes, frames;
+	double seconds, planeSeconds, worstMeters;
+	ages near, all;
+	long nearNeverHeard;
+
+	result() : bytes(0), frames(0), seconds(0), planeSeconds(0), worstMeters(0), nearNeverHeard(0) {}
+};
+
+result fly(const byPlane &tracks, policy how)	{
+	result r;
+	std::vector<int> ids;
+	for(byPlane::const_iterator t = tracks.begin(); t != tracks.end(); t++)
+		ids.push_back(t->first);
+	int planes = ids.size();
+	std::vector<au_uav_ros::BroadcastRate *> rates;
+	for(int p = 0; p < planes; p++)
+		rates.push_back(new au_uav_ros::BroadcastRate(how == ADAPTIVE_BUDGET ? DEFAULT_AIRTIME_BUDGET : 0));
+	heard unheard;
+	unheard.ever = false;
+	std::vector<std::vector<heard> > known(planes, std::vector<heard>(planes, unheard));	//[listener][sender]
+	std::vector<int> lastSent(planes, -1);	//step
+
+	std::vector<point> at(planes);
+	std::vector<bool> flying(planes);
+	bool more = true;
+	for(int step = 0; more; step++)	{
+		double now = step*UPDATE_PERIOD;
+		more = false;
+		for(int p = 0; p < planes; p++)	{
+			flying[p] = positionAt(tracks.find(ids[p])->second, now, at[p]);
+			more = more || flying[p];
+		}
+		if(!more)
+			break;
+		r.seconds = now + UPDATE_PERIOD;
+
+		for(int p = 0; p < planes; p++)	{
+			if(!flying[p])
+				continue;
+			r.planeSeconds += UPDATE_PERIOD;
+			bool send;
+			if(how == EVERY_UPDATE)
+				send = true;
+			else if(how == ONCE_A_SECOND)
+				send = lastSent[p] < 0 || (step - lastSent[p])*UPDATE_PERIOD >= 1 - UPDATE_PERIOD/2;
+			else	{
+				rates[p]->mine(at[p].lat, at[p].lon, at[p].alt, now);
+				send = rates[p]->due(now);
+			}
+			if(!send)
+				continue;
+			rates[p]->sent(FRAME_BYTES, now);
+			lastSent[p] = step;
+			r.bytes += FRAME_BYTES;
+			r.frames++;
+			for(int q = 0; q < planes; q++)	{
+				if(q == p || !flying[q])
+					continue;
+				rates[q]->neighbor(ids[p], at[p].lat, at[p].lon, at[p].alt, now);
+				known[q][p].ever = true;
+				known[q][p].at = step;
+				known[q][p].position = at[p];
+			}
+		}
+
+		for(int q = 0; q < planes; q++)	{
+			for(int p = 0; p < planes && flying[q]; p++)	{
+				if(p == q || !flying[p])
+					continue;
+				bool near = horizontal(at[q], at[p]) < RADAR_ZONE;
+				if(!known[q][p].ever)	{
+					if(near)
+						r.nearNeverHeard++;
+					continue;
+				}
+				int age = step - known[q][p].at;
+				if(near)	{
+					r.near.add(age);
+					r.worstMeters = std::max(r.worstMeters, horizontal(known[q][p].position, at[p]));
+				}
+				r.all.add(age);
+			}
+		}
+	}
+	for(int p = 0; p < planes; p++)
+		delete rates[p];
+	return r;
+}
+
+int main(int argc, char **argv)	{
+	if(argc < 2)	{
+		printf("usage: %s <flight .kml>...\n", argv[0]);
+		return 1;
+	}
+	printf("BroadcastRate, %d byte/s link, %.0f Hz updates, %d byte frames, budget %d byte/s a plane\n",
+			LINK_BYTES_PER_SECOND, 1/UPDATE_PERIOD, FRAME_BYTES, DEFAULT_AIRTIME_BUDGET);
+	printf("%24s %6s %16s %8s %8s | %8s %8s %8s %8s %8s | %8s %8s\n", "flight", "planes", "policy", "link",
+			"frames/s", "near p50", "near p99", "near max", "worst m", "unheard", "all p50", "all p99");
+	for(int i = 1; i < argc; i++)	{
+		const char *name = strrchr(argv[i], '/') ? strrchr(argv[i], '/') + 1 : argv[i];
+		byPlane tracks;
+		if(!loadTracks(argv[i], tracks))	{
+			printf("%24.24s could not be read\n", name);
+			continue;
+		}
+		for(int how = 0; how < POLICIES; how++)	{
+			result r = fly(tracks, (policy)how);
+			printf("%24.24s %6d %16s %7.1f%% %8.2f | %7.2fs %7.2fs %7.2fs %8.1f %8ld | %7.2fs %7.2fs\n", name,
+					(int)tracks.size(), policyNames[how], 100.0*r.bytes/r.seconds/LINK_BYTES_PER_SECOND,
+					r.frames/r.planeSeconds, r.near.percentile(0.5), r.near.percentile(0.99), r.near.worst(),
+					r.worstMeters, r.nearNeverHeard, r.all.percentile(0.5), r.all.percentile(0.99));
+		}
+	}
+	return 0;
+}
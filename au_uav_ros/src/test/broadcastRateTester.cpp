@@ -0,0 +1,137 @@
+//Tests BroadcastRate: the period it wants for neighbors far, near, closing and opening, that the
+//updates it lets out keep to that period, and that the airtime budget holds when a neighbor is near.
+
+#include <gtest/gtest.h>
+#include "au_uav_ros/broadcast_rate.h"
+#include "au_uav_ros/Fsquared.h"	//RADAR_ZONE
+
+namespace	{
+
+#define LAT 32.6
+#define LON -85.49
+#define ALT 400.0
+#define FRAME_BYTES 49		//an AU_UAV frame
+#define UPDATE_PERIOD 0.1	//a 10 Hz autopilot
+
+//Degrees for meters north of LAT, close enough for the distances here
+double north(double meters)	{
+	return LAT + meters/LATITUDE_TO_METERS;
+}
+
+//Me sitting still at LAT, LON and plane 1 flying north at speed (meters/second, below 0 for south)
+//from start meters north of me, both heard every second up to seconds
+void fly(au_uav_ros::BroadcastRate &rate, double start, double speed, int seconds)	{
+	for(int t = 0; t <= seconds; t++)	{
+		rate.mine(LAT, LON, ALT, t);
+		rate.neighbor(1, north(start + speed*t), LON, ALT, t);
+	}
+}
+
+//Every update of a 10 Hz autopilot from start for seconds, returns how many went out
+int broadcast(au_uav_ros::BroadcastRate &rate, double start, double seconds)	{
+	int sent = 0, updates = (int)(seconds/UPDATE_PERIOD + 0.5);
+	for(int i = 0; i < updates; i++)	{
+		double now = start + i*UPDATE_PERIOD;
+		rate.mine(LAT, LON, ALT, now);
+		if(rate.due(now))	{
+			rate.sent(FRAME_BYTES, now);
+			sent++;
+		}
+	}
+	return sent;
+}
+
+}
+
+TEST(BroadcastRate, slowestWithNobodyNear)	{
+	au_uav_ros::BroadcastRate rate(0);
+	rate.mine(LAT, LON, ALT, 0);
+	EXPECT_DOUBLE_EQ(BROADCAST_SLOWEST_PERIOD, rate.period(0));
+	EXPECT_LT(rate.getNearest(), 0);
+
+	fly(rate, 5000, 0, 2);
+	EXPECT_DOUBLE_EQ(BROADCAST_SLOWEST_PERIOD, rate.period(2));
+	EXPECT_NEAR(5000, rate.getNearest(), 50);
+}
+
+TEST(BroadcastRate, onceASecondFromTenUpdatesASecond)	{
+	au_uav_ros::BroadcastRate rate(0);
+	EXPECT_EQ(10, broadcast(rate, 0, 10));
+	EXPECT_EQ(10, rate.getSent());
+	EXPECT_EQ(90, rate.getSkipped());
+}
+
+TEST(BroadcastRate, everyUpdateInsideRadarZone)	{
+	au_uav_ros::BroadcastRate rate(0);
+	fly(rate, RADAR_ZONE/2, 0, 2);
+	EXPECT_DOUBLE_EQ(0, rate.period(2));
+	EXPECT_NEAR(RADAR_ZONE/2, rate.getNearest(), 1);
+
+	for(int i = 0; i < 10; i++)
+		rate.neighbor(1, north(RADAR_ZONE/2), LON, ALT, 3 + i*UPDATE_PERIOD);
+	EXPECT_EQ(10, broadcast(rate, 3, 1));
+}
+
+TEST(BroadcastRate, closingIsSoonerThanOpening)	{
+	//head on at twice MPS_SPEED, and going away at MPS_SPEED (taken as closing at BROADCAST_MIN_CLOSURE)
+	au_uav_ros::BroadcastRate closing(0), opening(0);
+	fly(closing, 250 + 4*MPS_SPEED, -2*MPS_SPEED, 2);
+	fly(opening, 250 - 2*MPS_SPEED, MPS_SPEED, 2);
+
+	//both at 250 m, the one closing is in RADAR_ZONE in 150/(2*MPS_SPEED) seconds
+	double expected = (250 - RADAR_ZONE)/(2*MPS_SPEED)/BROADCAST_UPDATES_TO_ZONE;
+	EXPECT_NEAR(expected, closing.period(2), 0.05);
+	EXPECT_NEAR(2*MPS_SPEED, closing.getClosure(), 0.5);
+	EXPECT_DOUBLE_EQ(BROADCAST_SLOWEST_PERIOD, opening.period(2));
+	EXPECT_NEAR(-MPS_SPEED, opening.getClosure(), 0.5);
+}
+
+TEST(BroadcastRate, periodCarriesTheNeighborForward)	{
+	au_uav_ros::BroadcastRate rate(0);
+	fly(rate, 250 + 4*MPS_SPEED, -2*MPS_SPEED, 2);
+	double heard = rate.period(2);
+
+	//not heard from since, but still closing
+	double later = rate.period(3);
+	EXPECT_LT(later, heard);
+	EXPECT_NEAR(250 - 2*MPS_SPEED, rate.getNearest(), 2);
+}
+
+TEST(BroadcastRate, forgetsNeighborsNotHeardFrom)	{
+	au_uav_ros::BroadcastRate rate(0);
+	fly(rate, RADAR_ZONE/2, 0, 2);
+	EXPECT_DOUBLE_EQ(0, rate.period(2));
+
+	rate.mine(LAT, LON, ALT, 2 + NEIGHBOR_TIMEOUT + 1);
+	EXPECT_DOUBLE_EQ(BROADCAST_SLOWEST_PERIOD, rate.period(2 + NEIGHBOR_TIMEOUT + 1));
+	EXPECT_LT(rate.getNearest(), 0);
+}
+
+TEST(BroadcastRate, budgetHoldsWithANeighborNear)	{
+	int budget = 4*FRAME_BYTES;	//bytes/second
+	au_uav_ros::BroadcastRate rate(budget);
+	fly(rate, RADAR_ZONE/2, 0, 2);
+	for(int t = 3; t < 13; t++)
+		rate.neighbor(1, north(RADAR_ZONE/2), LON, ALT, t);
+
+	//a second's worth up front, then what refills
+	int sent = broadcast(rate, 3, 10);
+	EXPECT_LE(sent*FRAME_BYTES, budget*11 + FRAME_BYTES);
+	EXPECT_GE(sent*FRAME_BYTES, budget*10 - FRAME_BYTES);
+	EXPECT_GT(rate.getOverBudget(), 0);
+	EXPECT_EQ(rate.getOverBudget(), rate.getSkipped());
+}
+
+TEST(BroadcastRate, noBudgetNeverSkipsForIt)	{
+	au_uav_ros::BroadcastRate rate(0);
+	fly(rate, RADAR_ZONE/2, 0, 2);
+	for(int t = 3; t < 13; t++)
+		rate.neighbor(1, north(RADAR_ZONE/2), LON, ALT, t);
+	EXPECT_EQ(100, broadcast(rate, 3, 10));
+	EXPECT_EQ(0, rate.getOverBudget());
+}
+
+int main(int argc, char **argv)	{
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
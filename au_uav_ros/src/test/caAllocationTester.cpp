@@ -0,0 +1,248 @@
+//Checks that CollisionAvoidance::avoid() stops touching the heap once it has seen every plane, the
+//latency it records, and that avoid() over a batch of updates gives the same command as avoid()
+//on each of them, and that nothing is avoided before the frame is anchored. operator new is replaced for the whole test binary, it only counts while
+//"counting" is set.
+
+#include <stdlib.h>
+#include <new>
+#include <vector>
+#include <gtest/gtest.h>
+#include <ros/ros.h>
+#include "au_uav_ros/collision_avoidance.h"
+#include "au_uav_ros/standardFuncs.h"
+
+#if __cplusplus >= 201103L
+#define NEW_THROWS
+#else
+#define NEW_THROWS throw(std::bad_alloc)
+#endif
+
+namespace	{
+bool counting = false;
+long allocations = 0;
+}
+
+void * operator new(std::size_t size) NEW_THROWS	{
+	if(counting)
+		allocations++;
+	void *p = malloc(size ? size : 1);
+	if(!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void * operator new[](std::size_t size) NEW_THROWS	{
+	return operator new(size);
+}
+
+void operator delete(void *p) throw()	{
+	free(p);
+}
+
+void operator delete[](void *p) throw()	{
+	free(p);
+}
+
+namespace	{
+
+#define ORIGIN_LAT 32.606573
+#define ORIGIN_LON -85.490356
+#define NUM_PLANES 16
+
+au_uav_ros::Telemetry telemetryAt(int planeID, double x, double y, double bearing)	{
+	au_uav_ros::Telemetry t;
+	t.planeID = planeID;
+	t.currentLatitude = ORIGIN_LAT + y*METERS_TO_DELTA_LAT;
+	t.currentLongitude = ORIGIN_LON + x*METERS_TO_DELTA_LON;
+	t.currentAltitude = 100;
+	t.destLatitude = ORIGIN_LAT;
+	t.destLongitude = ORIGIN_LON;
+	t.destAltitude = 100;
+	t.groundSpeed = MPS_SPEED;
+	t.targetBearing = bearing;
+	return t;
+}
+
+//First in the file, nothing has anchored LocalFrame::mission() yet. Every test after it anchors at the origin.
+TEST(caFrameTest, avoidNeedsAnchor)	{
+	au_uav_ros::CollisionAvoidance ca;
+	ca.init(0);
+	au_uav_ros::Command com = ca.avoid(telemetryAt(1, 0, 20, 0));
+	EXPECT_EQ(INVALID_GPS_COOR, com.latitude);
+	EXPECT_EQ(INVALID_GPS_COOR, com.longitude);
+	EXPECT_EQ(INVALID_GPS_COOR, com.altitude);
+	com = ca.avoid(std::vector<au_uav_ros::Telemetry>(1, telemetryAt(0, 0, 0, 0)));
+	EXPECT_EQ(INVALID_GPS_COOR, com.latitude);
+
+	EXPECT_TRUE(ca.anchorFrame(ORIGIN_LAT, ORIGIN_LON, 100));
+	EXPECT_TRUE(ca.anchorFrame(ORIGIN_LAT, ORIGIN_LON, 100));
+	EXPECT_FALSE(ca.anchorFrame(ORIGIN_LAT + 0.01, ORIGIN_LON, 100));
+	EXPECT_EQ(ORIGIN_LAT, au_uav_ros::LocalFrame::mission().getAnchor().latitude);
+	com = ca.avoid(telemetryAt(0, 0, 0, 0));
+	EXPECT_NE(INVALID_GPS_COOR, com.latitude);
+}
+
+//maxThreats 0 leaves bounded mode off
+long steadyStateAllocations(bool threatPrefilter, int maxThreats = 0)	{
+	//ROS_INFO in avoid() would be measured too, the node runs at the default level but the
+	//logging is not what this test is about
+	ros::console::set_logger_level(ROSCONSOLE_DEFAULT_NAME, ros::console::levels::Warn);
+	ros::console::notifyLoggerLevelsChanged();
+
+	au_uav_ros::CollisionAvoidance ca;
+	ca.init(0, 0, threatPrefilter);
+	EXPECT_TRUE(ca.anchorFrame(ORIGIN_LAT, ORIGIN_LON, 100));
+	ca.setThreatBound(maxThreats, fsquared::THREAT_BY_TIME_TO_GO, 0.001);
+	au_uav_ros::Command goal;
+	goal.latitude = ORIGIN_LAT + 1000*METERS_TO_DELTA_LAT;
+	goal.longitude = ORIGIN_LON;
+	goal.altitude = 100;
+	ca.setGoalWaypoint(goal);
+
+	//"me" at the origin, the others in a ring close enough that "me" is in some of their fields,
+	//wobbling a few meters every round so some of them cross grid cells and field edges
+	std::vector<au_uav_ros::Telemetry> round[2];
+	for(int r = 0; r < 2; r++)	{
+		round[r].push_back(telemetryAt(0, 0, r, 0));
+		for(int i = 1; i <= NUM_PLANES; i++)	{
+			double angle = 2*PI*i/NUM_PLANES;
+			double distance = 20 + 5*(i % 4) + 3*r;
+			round[r].push_back(telemetryAt(i, distance*cos(angle), distance*sin(angle), 30*i));
+		}
+	}
+
+	//first rounds fill the map, the grid and the batch
+	for(int n = 0; n < 4; n++)
+		for(unsigned int i = 0; i < round[n % 2].size(); i++)
+			ca.avoid(round[n % 2][i]);
+
+	allocations = 0;
+	counting = true;
+	for(int n = 0; n < 100; n++)
+		for(unsigned int i = 0; i < round[n % 2].size(); i++)
+			ca.avoid(round[n % 2][i]);
+	counting = false;
+
+	if(maxThreats > 0)	{
+		EXPECT_LE(ca.getThreatSet().getSummed(), maxThreats);
+	}
+	EXPECT_EQ(4*(NUM_PLANES + 1) + 100*(NUM_PLANES + 1), ca.getLatency().getCount());
+	return allocations;
+}
+
+TEST(caAllocationTest, steadyStateAvoidDoesNotAllocate)	{
+	EXPECT_EQ(0, steadyStateAllocations(false));
+}
+
+TEST(caAllocationTest, steadyStateAvoidWithPrefilterDoesNotAllocate)	{
+	EXPECT_EQ(0, steadyStateAllocations(true));
+}
+
+TEST(caAllocationTest, steadyStateBoundedAvoidDoesNotAllocate)	{
+	EXPECT_EQ(0, steadyStateAllocations(false, 4));
+}
+
+TEST(caLatencyTest, percentiles)	{
+	au_uav_ros::LatencyRecorder latency;
+	EXPECT_EQ(0.0, latency.percentile(99));
+
+	//1 to 100 us, one of each, then one very slow call
+	for(int us = 1; us <= 100; us++)
+		latency.record(us*1e-6 - 1e-9);
+	EXPECT_EQ(100, latency.getCount());
+	EXPECT_NEAR(50e-6, latency.percentile(50), 1e-12);
+	EXPECT_NEAR(99e-6, latency.percentile(99), 1e-12);
+	EXPECT_NEAR(100e-6 - 1e-9, latency.percentile(100), 1e-12);	//never above the longest
+	EXPECT_NEAR(50.5e-6 - 1e-9, latency.getMean(), 1e-12);
+
+	latency.record(0.5);	//past the last bin
+	EXPECT_EQ(0.5, latency.getMax());
+	EXPECT_EQ(0.5, latency.percentile(100));
+	EXPECT_NEAR(51e-6, latency.percentile(50), 1e-12);	//101 calls now
+
+	//10 us bins past 1 ms
+	latency.reset();
+	latency.record(2.345e-3);
+	latency.record(3e-3);
+	EXPECT_NEAR(2.35e-3, latency.percentile(50), 1e-12);
+	EXPECT_EQ(3e-3, latency.percentile(100));
+}
+
+//forceRecomputeInterval and maxThreats as for init and setThreatBound, no budget so both see the same planes
+void expectBatchMatchesOneAtATime(int forceRecomputeInterval, bool threatPrefilter, int maxThreats)	{
+	au_uav_ros::CollisionAvoidance single, batched;
+	au_uav_ros::Command goal;
+	goal.latitude = ORIGIN_LAT + 1000*METERS_TO_DELTA_LAT;
+	goal.longitude = ORIGIN_LON;
+	goal.altitude = 100;
+	single.init(0, forceRecomputeInterval, threatPrefilter);
+	batched.init(0, forceRecomputeInterval, threatPrefilter);
+	EXPECT_TRUE(single.anchorFrame(ORIGIN_LAT, ORIGIN_LON, 100));
+	EXPECT_TRUE(batched.anchorFrame(ORIGIN_LAT, ORIGIN_LON, 100));
+	single.setThreatBound(maxThreats, fsquared::THREAT_BY_DISTANCE, 0);
+	batched.setThreatBound(maxThreats, fsquared::THREAT_BY_DISTANCE, 0);
+	single.setGoalWaypoint(goal);
+	batched.setGoalWaypoint(goal);
+
+	//"me" moving north through a ring closing in on it, "me" reports in the middle of every batch
+	for(int r = 0; r < 10; r++)	{
+		std::vector<au_uav_ros::Telemetry> updates;
+		for(int i = 1; i <= NUM_PLANES; i++)	{
+			double angle = 2*PI*i/NUM_PLANES;
+			double distance = 60 - 4*r + 5*(i % 3);
+			updates.push_back(telemetryAt(i, distance*cos(angle), distance*sin(angle), 30*i));
+			if(i == NUM_PLANES/2)
+				updates.push_back(telemetryAt(0, 0, 2*r, 0));
+		}
+
+		au_uav_ros::Command one;
+		for(unsigned int i = 0; i < updates.size(); i++)
+			one = single.avoid(updates[i]);
+		au_uav_ros::Command all = batched.avoid(updates);
+		EXPECT_DOUBLE_EQ(one.latitude, all.latitude) << "round " << r;
+		EXPECT_DOUBLE_EQ(one.longitude, all.longitude) << "round " << r;
+	}
+}
+
+TEST(caBatchTest, batchMatchesOneAtATime)	{
+	expectBatchMatchesOneAtATime(0, false, 0);
+}
+
+TEST(caBatchTest, batchMatchesOneAtATimeIncremental)	{
+	expectBatchMatchesOneAtATime(DEFAULT_FULL_RECOMPUTE_INTERVAL, false, 0);
+}
+
+TEST(caBatchTest, batchMatchesOneAtATimeWithPrefilter)	{
+	expectBatchMatchesOneAtATime(0, true, 0);
+}
+
+TEST(caBatchTest, batchMatchesOneAtATimeBounded)	{
+	expectBatchMatchesOneAtATime(0, false, 4);
+}
+
+TEST(caBatchTest, emptyBatchIsIgnored)	{
+	au_uav_ros::CollisionAvoidance ca;
+	ca.init(0);
+	au_uav_ros::Command com = ca.avoid(std::vector<au_uav_ros::Telemetry>());
+	EXPECT_EQ(INVALID_GPS_COOR, com.latitude);
+	EXPECT_EQ(INVALID_GPS_COOR, com.longitude);
+	EXPECT_EQ(INVALID_GPS_COOR, com.altitude);
+}
+
+//the counter has to actually see allocations for the test above to mean anything
+TEST(caAllocationTest, counterWorks)	{
+	allocations = 0;
+	counting = true;
+	std::vector<int> *v = new std::vector<int>(10);
+	counting = false;
+	delete v;
+	EXPECT_GE(allocations, 1);
+}
+
+}
+
+int main(int argc, char **argv)	{
+	ros::Time::init();
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
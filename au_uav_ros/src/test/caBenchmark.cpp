@@ -0,0 +1,719 @@
+//Benchmarks for the collision avoidance hot path.
+//Not a pass/fail test - run by hand on the target (rosrun au_uav_ros ca_benchmark) and compare the tables.
+//Course files given on the command line are replayed for the threat prefilter table, e.g.
+//	rosrun au_uav_ros ca_benchmark `rospack find au_uav_ros`/courses/final_{16,32}_*.course
+//
+//Simulated aircraft are spread at a constant density (one per DENSITY_SPACING x DENSITY_SPACING square),
+//so a larger fleet means a larger sky, the same as going from the 4 plane to the 32 plane final_* courses.
+//Every round, every plane moves and sends one telemetry update to "me", which sits in the middle.
+//
+//operator new is replaced to keep a count of the live heap bytes, for the neighbor footprint table.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <new>
+#include <map>
+#include <vector>
+#include <algorithm>
+#include <ros/ros.h>
+#include <au_uav_ros/Telemetry.h>
+#include "au_uav_ros/planeObject.h"
+#include "au_uav_ros/Fsquared.h"
+#include "au_uav_ros/SpatialGrid.h"
+#include "au_uav_ros/RepulsiveForceBatch.h"
+#include "au_uav_ros/ForceAccumulator.h"
+#include "au_uav_ros/NeighborTable.h"
+#include "au_uav_ros/ForceField.h"
+#include "au_uav_ros/ThreatFilter.h"
+#include "au_uav_ros/ThreatSet.h"
+#include "au_uav_ros/LatencyRecorder.h"
+#include "au_uav_ros/collision_avoidance.h"
+#include "au_uav_ros/standardFuncs.h"
+#include "au_uav_ros/vmath.h"
+
+#define ORIGIN_LAT 32.606573
+#define ORIGIN_LON -85.490356
+#define DENSITY_SPACING 150	//meters between planes on average
+#define ROUNDS 200
+#define FORCE_TERMS 32		//repulsive forces summed per message in the vector benchmark
+#define SUMS 200000
+#define BATCH_PASSES 20000
+#define TABLE_PASSES 2000
+#define FIELD_POSITIONS 1024
+#define FIELD_PASSES 2000
+#define COURSE_SECONDS 600	//of each course replayed for the prefilter table
+#define COURSE_REPLAYS 3
+#define BOUNDED_THREATS 8
+#define AVOID_BUDGET 20e-6	//seconds
+
+#if defined(__arm__) || defined(__aarch64__)
+#define ARCH_NAME "ARM"
+#elif defined(__i386__) || defined(__x86_64__)
+#define ARCH_NAME "x86"
+#else
+#define ARCH_NAME "unknown"
+#endif
+
+#if __cplusplus >= 201103L
+#define NEW_THROWS
+#else
+#define NEW_THROWS throw(std::bad_alloc)
+#endif
+
+namespace	{
+long liveHeapBytes = 0;
+const std::size_t SIZE_HEADER = 16;	//keeps the block returned to the caller aligned
+}
+
+void * operator new(std::size_t size) NEW_THROWS	{
+	char *p = (char *)malloc(size + SIZE_HEADER);
+	if(!p)
+		throw std::bad_alloc();
+	*(std::size_t *)p = size;
+	liveHeapBytes += size;
+	return p + SIZE_HEADER;
+}
+
+void * operator new[](std::size_t size) NEW_THROWS	{
+	return operator new(size);
+}
+
+void operator delete(void *p) throw()	{
+	if(!p)
+		return;
+	char *block = (char *)p - SIZE_HEADER;
+	liveHeapBytes -= *(std::size_t *)block;
+	free(block);
+}
+
+void operator delete[](void *p) throw()	{
+	operator delete(p);
+}
+
+namespace	{
+
+struct simPlane	{
+	double x, y;		//meters from origin
+	double heading;		//cartesian degrees
+};
+
+class fleet	{
+public:
+	fleet(int numPlanes)	{
+		srand(numPlanes);
+		side = DENSITY_SPACING*sqrt((double)numPlanes);
+		for(int i = 0; i < numPlanes; i++)	{
+			simPlane p;
+			p.x = side*(rand()/(double)RAND_MAX) - side/2;
+			p.y = side*(rand()/(double)RAND_MAX) - side/2;
+			p.heading = 360.0*(rand()/(double)RAND_MAX) - 180;
+			planes.push_back(p);
+		}
+	}
+
+	//one second of flight, wrapping around the edges of the sky
+	void step()	{
+		for(unsigned int i = 0; i < planes.size(); i++)	{
+			planes[i].x += MPS_SPEED*cos(planes[i].heading*DEGREE_TO_RAD);
+			planes[i].y += MPS_SPEED*sin(planes[i].heading*DEGREE_TO_RAD);
+			if(planes[i].x > side/2) planes[i].x -= side;
+			if(planes[i].x < -side/2) planes[i].x += side;
+			if(planes[i].y > side/2) planes[i].y -= side;
+			if(planes[i].y < -side/2) planes[i].y += side;
+		}
+	}
+
+	au_uav_ros::Telemetry telemetry(int i) const	{
+		au_uav_ros::Telemetry t;
+		t.planeID = i + 1;	//"me" is plane 0
+		t.currentLongitude = ORIGIN_LON + planes[i].x*METERS_TO_DELTA_LON;
+		t.currentLatitude = ORIGIN_LAT + planes[i].y*METERS_TO_DELTA_LAT;
+		t.currentAltitude = 100;
+		t.destLatitude = ORIGIN_LAT;
+		t.destLongitude = ORIGIN_LON;
+		t.destAltitude = 100;
+		t.groundSpeed = MPS_SPEED;
+		t.targetBearing = toCardinal(planes[i].heading);
+		return t;
+	}
+
+	std::vector<simPlane> planes;
+	double side;
+};
+
+au_uav_ros::PlaneObject makeMe()	{
+	au_uav_ros::PlaneObject me(12.0, au_uav_ros::Telemetry());
+	me.setID(0);
+	me.setCurrentLoc(ORIGIN_LAT, ORIGIN_LON, 100);
+	me.setCurrentBearing(0);
+	au_uav_ros::waypoint goal;
+	goal.latitude = ORIGIN_LAT + 1000*METERS_TO_DELTA_LAT;
+	goal.longitude = ORIGIN_LON;
+	goal.altitude = 100;
+	me.setDestination(goal);
+	return me;
+}
+
+//per message cost of findTempForceWaypoint, in microseconds
+double timeAvoid(int numPlanes, bool useGrid)	{
+	fleet sky(numPlanes);
+	au_uav_ros::PlaneObject me = makeMe();
+	fsquared::SpatialGrid grid;
+	fsquared::RepulsiveForceBatch batch;
+
+	double elapsed = 0;
+	long messages = 0;
+	for(int round = 0; round < ROUNDS; round++)	{
+		sky.step();
+		for(int i = 0; i < numPlanes; i++)	{
+			au_uav_ros::Telemetry t = sky.telemetry(i);
+			ros::WallTime start = ros::WallTime::now();
+			if(useGrid)	{
+				grid.update(t.planeID, t.currentLatitude, t.currentLongitude);
+				fsquared::findTempForceWaypoint(me, t, grid, batch);
+			}
+			else
+				fsquared::findTempForceWaypoint(me, t);
+			elapsed += (ros::WallTime::now() - start).toSec();
+			messages++;
+		}
+	}
+	return elapsed/messages*1e6;
+}
+
+//per query cost of finding the planes in RADAR_ZONE, in microseconds
+double timeNeighborQuery(int numPlanes, bool useGrid)	{
+	fleet sky(numPlanes);
+	fsquared::SpatialGrid grid;
+	std::vector<au_uav_ros::Telemetry> known(numPlanes);
+	std::vector<int> found;
+	found.reserve(numPlanes);
+
+	double elapsed = 0;
+	long queries = 0;
+	for(int round = 0; round < ROUNDS; round++)	{
+		sky.step();
+		for(int i = 0; i < numPlanes; i++)	{
+			known[i] = sky.telemetry(i);
+			ros::WallTime start = ros::WallTime::now();
+			if(useGrid)	{
+				grid.update(known[i].planeID, known[i].currentLatitude, known[i].currentLongitude);
+				grid.findNeighbors(ORIGIN_LAT, ORIGIN_LON, RADAR_ZONE);
+			}
+			else	{
+				//what a query costs without an index: look at every plane we know about
+				found.clear();
+				for(int j = 0; j < numPlanes; j++)	{
+					if(findDistance(ORIGIN_LAT, ORIGIN_LON, known[j].currentLatitude, known[j].currentLongitude) <= RADAR_ZONE)
+						found.push_back(known[j].planeID);
+				}
+			}
+			elapsed += (ros::WallTime::now() - start).toSec();
+			queries++;
+		}
+	}
+	return elapsed/queries*1e6;
+}
+
+enum repulsiveMethod { PER_PLANE, BATCH_SCALAR, BATCH_SIMD };
+
+//per pass cost of finding the repulsive force from numPlanes planes all within RADAR_ZONE, in microseconds
+double timeRepulsive(int numPlanes, repulsiveMethod method)	{
+	srand(numPlanes);
+	au_uav_ros::PlaneObject me = makeMe();
+	std::vector<au_uav_ros::PlaneObject> enemies;
+	fsquared::RepulsiveForceBatch batch;
+	for(int i = 0; i < numPlanes; i++)	{
+		double x = 140*(rand()/(double)RAND_MAX) - 70;
+		double y = 140*(rand()/(double)RAND_MAX) - 70;
+		au_uav_ros::PlaneObject enemy(12.0, au_uav_ros::Telemetry());
+		enemy.setID(i + 1);
+		enemy.setCurrentLoc(ORIGIN_LAT + y*METERS_TO_DELTA_LAT, ORIGIN_LON + x*METERS_TO_DELTA_LON, 100);
+		enemy.setCurrentBearing(360.0*(rand()/(double)RAND_MAX) - 180);
+		enemies.push_back(enemy);
+		batch.add(i + 1, x, y, enemy.getCurrentBearing());
+	}
+
+	double checksum = 0;
+	ros::WallTime start = ros::WallTime::now();
+	for(int n = 0; n < BATCH_PASSES; n++)	{
+		au_uav_ros::mathVector sum;
+		if(method == PER_PLANE)	{
+			for(int i = 0; i < numPlanes; i++)
+				sum += fsquared::calculateRepulsiveForce(me, enemies[i]);
+		}
+		else if(method == BATCH_SCALAR)
+			sum = batch.computeForcesScalar(0, 0);
+		else
+			sum = batch.computeForces(0, 0);
+		checksum += sum.getX();
+	}
+	double elapsed = (ros::WallTime::now() - start).toSec();
+	if(checksum == 12345.678) printf(" ");	//keep the optimizer from dropping the loop
+	return elapsed/BATCH_PASSES*1e6;
+}
+
+/*
+ * per message cost of findTempForceWaypoint with numPlanes all within RADAR_ZONE of "me", in microseconds.
+ * Every round each plane and "me" send one update, so "me" moves once per numPlanes + 1 messages.
+ */
+double timeIncremental(int numPlanes, bool incremental)	{
+	srand(numPlanes);
+	std::vector<double> x(numPlanes + 1, 0), y(numPlanes + 1, 0);	//plane 0 is "me"
+	for(int i = 1; i <= numPlanes; i++)	{
+		double angle = 2*PI*(rand()/(double)RAND_MAX);
+		double distance = 90*sqrt(rand()/(double)RAND_MAX);
+		x[i] = distance*cos(angle);
+		y[i] = distance*sin(angle);
+	}
+
+	au_uav_ros::PlaneObject me = makeMe();
+	fsquared::SpatialGrid grid;
+	fsquared::RepulsiveForceBatch batch;
+	fsquared::ForceAccumulator forces;
+
+	double elapsed = 0;
+	long messages = 0;
+	for(int round = 0; round < ROUNDS; round++)	{
+		for(int i = 0; i <= numPlanes; i++)	{
+			x[i] += 2*(rand()/(double)RAND_MAX) - 1;
+			y[i] += 2*(rand()/(double)RAND_MAX) - 1;
+			au_uav_ros::Telemetry t;
+			t.planeID = i;
+			t.currentLatitude = ORIGIN_LAT + y[i]*METERS_TO_DELTA_LAT;
+			t.currentLongitude = ORIGIN_LON + x[i]*METERS_TO_DELTA_LON;
+			t.currentAltitude = 100;
+			t.targetBearing = 360.0*(rand()/(double)RAND_MAX);
+
+			ros::WallTime start = ros::WallTime::now();
+			if(incremental)
+				fsquared::findTempForceWaypoint(me, t, forces);
+			else	{
+				if(i != 0)
+					grid.update(t.planeID, t.currentLatitude, t.currentLongitude);
+				fsquared::findTempForceWaypoint(me, t, grid, batch);
+			}
+			elapsed += (ros::WallTime::now() - start).toSec();
+			messages++;
+		}
+	}
+	return elapsed/messages*1e6;
+}
+
+/*
+ * per call cost of the in field test, plus the magnitude when inside, in nanoseconds.
+ * Positions are anywhere within RADAR_ZONE, about a third of them inside the default oval.
+ */
+template <class Field>
+double timeFieldEvaluation(const Field &field)	{
+	srand(FIELD_POSITIONS);
+	std::vector<fsquared::relativeCoordinates> positions(FIELD_POSITIONS);
+	for(int i = 0; i < FIELD_POSITIONS; i++)	{
+		positions[i].x = 2*RADAR_ZONE*(rand()/(double)RAND_MAX) - RADAR_ZONE;
+		positions[i].y = 2*RADAR_ZONE*(rand()/(double)RAND_MAX) - RADAR_ZONE;
+	}
+
+	double checksum = 0;
+	ros::WallTime start = ros::WallTime::now();
+	for(int n = 0; n < FIELD_PASSES; n++)	{
+		for(int i = 0; i < FIELD_POSITIONS; i++)	{
+			if(field.areCoordinatesInMyField(positions[i], 0, 0))
+				checksum += field.findForceMagnitude(positions[i]);
+		}
+	}
+	double elapsed = (ros::WallTime::now() - start).toSec();
+	if(checksum == 12345.678) printf(" ");	//keep the optimizer from dropping the loop
+	return elapsed/((double)FIELD_PASSES*FIELD_POSITIONS)*1e9;
+}
+
+/*
+ * What planesToAvoid was before NeighborTable: a std::map holding a copy of each enemy PlaneObject,
+ * built the way updatePlanesToAvoid built it. Kept here only to compare against.
+ */
+typedef std::map<int, au_uav_ros::PlaneObject> planeObjectMap;
+
+void store(planeObjectMap &planesToAvoid, const au_uav_ros::Telemetry &t)	{
+	au_uav_ros::PlaneObject enemy;
+	enemy.setID(t.planeID);
+	enemy.setCurrentLoc(t.currentLatitude, t.currentLongitude, t.currentAltitude);
+	enemy.setTargetBearing(t.targetBearing);
+	enemy.setSpeed(t.groundSpeed);
+	planesToAvoid[enemy.getID()] = enemy;
+}
+
+void store(fsquared::NeighborTable &planesToAvoid, const au_uav_ros::Telemetry &t)	{
+	fsquared::NeighborState enemy;
+	enemy.id = t.planeID;
+	au_uav_ros::coordinate location;
+	location.latitude = t.currentLatitude;
+	location.longitude = t.currentLongitude;
+	location.altitude = t.currentAltitude;
+	enemy.position = au_uav_ros::LocalFrame::mission().toLocal(location);
+	enemy.currentBearing = 0.0;
+	enemy.targetBearing = t.targetBearing;
+	enemy.speed = t.groundSpeed;
+	enemy.lastUpdateTime = ros::Time::now().toSec();
+	planesToAvoid.update(enemy);
+}
+
+struct neighborCost	{
+	double bytesPerNeighbor;	//heap bytes the container holds, divided by the planes in it
+	double insertTime;			//us to add a plane that is not there yet
+	double updateTime;			//us to overwrite a plane that is there
+};
+
+//Fills a new map with numPlanes planes TABLE_PASSES times, then updates all of them TABLE_PASSES times
+template <class Map>
+neighborCost timeNeighborMap(int numPlanes)	{
+	fleet sky(numPlanes);
+	std::vector<au_uav_ros::Telemetry> updates;
+	for(int i = 0; i < numPlanes; i++)
+		updates.push_back(sky.telemetry(i));
+
+	neighborCost cost;
+	double elapsed = 0;
+	for(int n = 0; n < TABLE_PASSES; n++)	{
+		long heapBefore = liveHeapBytes;
+		ros::WallTime start = ros::WallTime::now();
+		{
+			Map planesToAvoid;
+			for(int i = 0; i < numPlanes; i++)
+				store(planesToAvoid, updates[i]);
+			elapsed += (ros::WallTime::now() - start).toSec();
+			cost.bytesPerNeighbor = (double)(liveHeapBytes - heapBefore)/numPlanes;
+		}
+	}
+	cost.insertTime = elapsed/((double)TABLE_PASSES*numPlanes)*1e6;
+
+	Map planesToAvoid;
+	for(int i = 0; i < numPlanes; i++)
+		store(planesToAvoid, updates[i]);
+	ros::WallTime start = ros::WallTime::now();
+	for(int n = 0; n < TABLE_PASSES; n++)	{
+		for(int i = 0; i < numPlanes; i++)
+			store(planesToAvoid, updates[i]);
+	}
+	cost.updateTime = (ros::WallTime::now() - start).toSec()/((double)TABLE_PASSES*numPlanes)*1e6;
+	return cost;
+}
+
+/* The mathVector from before it stored x/y: magnitude and direction in degrees, converted to
+components and back on every addition. Kept here only to compare against. */
+struct polarVector	{
+	double magnitude, direction;
+	polarVector(double m = 0, double d = 0) : magnitude(m), direction(d) {}
+	polarVector& operator+=(const polarVector& mV)	{
+		double Rx = magnitude*cos(direction*PI/180.0) + mV.magnitude*cos(mV.direction*PI/180.0);
+		double Ry = magnitude*sin(direction*PI/180.0) + mV.magnitude*sin(mV.direction*PI/180.0);
+		magnitude = sqrt(pow(Rx, 2) + pow(Ry, 2));
+		direction = atan2(Ry, Rx)*180.0/PI;
+		return *this;
+	}
+};
+
+double direction(const polarVector &v)	{ return v.direction; }
+double direction(const au_uav_ros::mathVector &v)	{ return v.getDirection(); }
+
+//per message cost of summing FORCE_TERMS repulsive forces plus the attractive force and
+//taking the heading of the result, in microseconds
+template <class Vector>
+double timeForceSum(const std::vector<double> &magnitudes, const std::vector<double> &angles, double &heading)	{
+	ros::WallTime start = ros::WallTime::now();
+	double checksum = 0;
+	for(int n = 0; n < SUMS; n++)	{
+		Vector sum;
+		for(int i = 0; i < FORCE_TERMS; i++)
+			sum += Vector(magnitudes[i], angles[(i + n) % FORCE_TERMS]);
+		sum += Vector(ATTRACTIVE_FORCE, angles[n % FORCE_TERMS]);
+		checksum += heading = direction(sum);
+	}
+	double elapsed = (ros::WallTime::now() - start).toSec();
+	if(checksum == 12345.678) printf(" ");	//keep the optimizer from dropping the loop
+	return elapsed/SUMS*1e6;
+}
+
+/*
+ * avoid() latency with numPlanes all within RADAR_ZONE of "me", through CollisionAvoidance so the
+ * latency it records is what is reported. maxThreats 0 is the grid path, every plane in the map summed.
+ */
+au_uav_ros::LatencyRecorder avoidLatency(int numPlanes, int maxThreats, double budgetSeconds)	{
+	srand(numPlanes);
+	std::vector<double> x(numPlanes + 1, 0), y(numPlanes + 1, 0);	//plane 0 is "me"
+	for(int i = 1; i <= numPlanes; i++)	{
+		double angle = 2*PI*(rand()/(double)RAND_MAX);
+		double distance = 90*sqrt(rand()/(double)RAND_MAX);
+		x[i] = distance*cos(angle);
+		y[i] = distance*sin(angle);
+	}
+
+	au_uav_ros::CollisionAvoidance ca;
+	ca.init(0);
+	ca.anchorFrame(ORIGIN_LAT, ORIGIN_LON, 100);
+	ca.setThreatBound(maxThreats, fsquared::THREAT_BY_DISTANCE, budgetSeconds);
+	au_uav_ros::Command goal;
+	goal.latitude = ORIGIN_LAT + 1000*METERS_TO_DELTA_LAT;
+	goal.longitude = ORIGIN_LON;
+	goal.altitude = 100;
+	ca.setGoalWaypoint(goal);
+
+	for(int round = 0; round < ROUNDS; round++)	{
+		for(int i = 0; i <= numPlanes; i++)	{
+			x[i] += 2*(rand()/(double)RAND_MAX) - 1;
+			y[i] += 2*(rand()/(double)RAND_MAX) - 1;
+			au_uav_ros::Telemetry t;
+			t.planeID = i;
+			t.currentLatitude = ORIGIN_LAT + y[i]*METERS_TO_DELTA_LAT;
+			t.currentLongitude = ORIGIN_LON + x[i]*METERS_TO_DELTA_LON;
+			t.currentAltitude = 100;
+			t.groundSpeed = MPS_SPEED;
+			t.targetBearing = 360.0*(rand()/(double)RAND_MAX);
+			ca.avoid(t);
+		}
+	}
+	return ca.getLatency();
+}
+
+/*
+ * A course file from courses/: each plane's starting position and its waypoints, in meters
+ * from the course's first starting position.
+ */
+struct course	{
+	std::vector<simPlane> start;
+	std::vector<std::vector<simPlane> > waypoints;	//per plane, heading unused
+	double originLat, originLon;
+};
+
+bool loadCourse(const char *path, course &c)	{
+	FILE *file = fopen(path, "r");
+	if(file == NULL)
+		return false;
+
+	char line[256];
+	bool inWaypoints = false;	//the starting positions come first, then each plane's waypoints
+	bool haveOrigin = false;
+	while(fgets(line, sizeof(line), file) != NULL)	{
+		if(strncmp(line, "#Plane ID:", 10) == 0)
+			inWaypoints = true;
+		int id;
+		double lat, lon, alt;
+		if(line[0] == '#' || sscanf(line, "%d %lf %lf %lf", &id, &lat, &lon, &alt) != 4 || id < 0)
+			continue;
+		if(!haveOrigin)	{
+			c.originLat = lat;
+			c.originLon = lon;
+			haveOrigin = true;
+		}
+
+		simPlane p;
+		p.x = (lon - c.originLon)*DELTA_LON_TO_METERS;
+		p.y = (lat - c.originLat)*DELTA_LAT_TO_METERS;
+		p.heading = 0;
+		if(!inWaypoints)	{
+			if(id >= (int)c.start.size())	{
+				c.start.resize(id + 1);
+				c.waypoints.resize(id + 1);
+			}
+			c.start[id] = p;
+		}
+		else if(id < (int)c.waypoints.size())
+			c.waypoints[id].push_back(p);
+	}
+	fclose(file);
+	return !c.start.empty();
+}
+
+struct prefilterResult	{
+	long messages;				//telemetry messages that went through findTempForceWaypoint
+	long checked, diverging, farFuture, wideMiss;
+	long forces;				//repulsive forces summed, over all messages
+	double avoidTime;			//us per message
+};
+
+/*
+ * Every plane flies straight to its next waypoint at MPS_SPEED, no avoidance, like the NoAvoidance
+ * runs in scores/. Every second each plane sends one update, and every plane (including itself)
+ * runs it through findTempForceWaypoint, so each plane is "me" once.
+ */
+prefilterResult replayCourse(const course &c, bool prefilter)	{
+	int numPlanes = c.start.size();
+	std::vector<simPlane> planes = c.start;
+	std::vector<unsigned int> next(numPlanes, 0);
+	std::vector<au_uav_ros::PlaneObject> mes;
+	std::vector<fsquared::SpatialGrid> grids(numPlanes);
+	std::vector<fsquared::RepulsiveForceBatch> batches(numPlanes);
+	std::vector<fsquared::ThreatFilter> filters(numPlanes);
+	for(int i = 0; i < numPlanes; i++)	{
+		au_uav_ros::PlaneObject me(12.0, au_uav_ros::Telemetry());
+		me.setID(i);
+		mes.push_back(me);
+	}
+
+	prefilterResult result = prefilterResult();
+	double elapsed = 0;
+	for(int second = 0; second < COURSE_SECONDS; second++)	{
+		for(int i = 0; i < numPlanes; i++)	{
+			if(next[i] >= c.waypoints[i].size())
+				continue;	//done, it holds its last position
+			const simPlane &wp = c.waypoints[i][next[i]];
+			double dx = wp.x - planes[i].x, dy = wp.y - planes[i].y;
+			double distance = sqrt(dx*dx + dy*dy);
+			planes[i].heading = atan2(dy, dx)*180.0/PI;
+			if(distance <= MPS_SPEED)	{
+				planes[i].x = wp.x;
+				planes[i].y = wp.y;
+			}
+			else	{
+				planes[i].x += MPS_SPEED*dx/distance;
+				planes[i].y += MPS_SPEED*dy/distance;
+			}
+			if(distance <= COLLISION_THRESHOLD)
+				next[i]++;
+
+			//"me's" attractive force pulls toward the waypoint it is flying to
+			const simPlane &goalWp = c.waypoints[i][std::min(next[i], (unsigned int)c.waypoints[i].size() - 1)];
+			au_uav_ros::waypoint goal;
+			goal.latitude = c.originLat + goalWp.y*METERS_TO_DELTA_LAT;
+			goal.longitude = c.originLon + goalWp.x*METERS_TO_DELTA_LON;
+			goal.altitude = 400;
+			mes[i].setDestination(goal);
+		}
+
+		for(int j = 0; j < numPlanes; j++)	{
+			au_uav_ros::Telemetry t;
+			t.planeID = j;
+			t.currentLatitude = c.originLat + planes[j].y*METERS_TO_DELTA_LAT;
+			t.currentLongitude = c.originLon + planes[j].x*METERS_TO_DELTA_LON;
+			t.currentAltitude = 400;
+			t.groundSpeed = MPS_SPEED;
+			t.targetBearing = toCardinal(planes[j].heading);
+
+			ros::WallTime start = ros::WallTime::now();
+			for(int i = 0; i < numPlanes; i++)	{
+				if(j != i)
+					grids[i].update(j, t.currentLatitude, t.currentLongitude);
+				fsquared::findTempForceWaypoint(mes[i], t, grids[i], batches[i], prefilter ? &filters[i] : NULL);
+			}
+			elapsed += (ros::WallTime::now() - start).toSec();
+			result.messages += numPlanes;
+			for(int i = 0; i < numPlanes; i++)
+				result.forces += mes[i].getMap().size();
+		}
+	}
+
+	for(int i = 0; i < numPlanes; i++)	{
+		result.checked += filters[i].getChecked();
+		result.diverging += filters[i].getDiverging();
+		result.farFuture += filters[i].getFarFuture();
+		result.wideMiss += filters[i].getWideMiss();
+	}
+	result.avoidTime = elapsed/result.messages*1e6;
+	return result;
+}
+
+}
+
+int main(int argc, char **argv)	{
+	ros::Time::init();
+	ros::console::set_logger_level(ROSCONSOLE_DEFAULT_NAME, ros::console::levels::Warn);	//avoid() logs every call
+	ros::console::notifyLoggerLevelsChanged();
+
+	printf("Spatial grid (us per telemetry message, %d rounds, one plane per %dm square)\n", ROUNDS, DENSITY_SPACING);
+	printf("%8s %14s %14s %14s %14s\n", "planes", "scan query", "grid query", "avoid (map)", "avoid (grid)");
+	for(int n = 4; n <= 512; n *= 2)	{
+		printf("%8d %14.3f %14.3f %14.3f %14.3f\n", n,
+				timeNeighborQuery(n, false), timeNeighborQuery(n, true),
+				timeAvoid(n, false), timeAvoid(n, true));
+	}
+
+	printf("\nRepulsive forces on %s (us per pass, every plane within RADAR_ZONE)\n", ARCH_NAME);
+	printf("%8s %14s %14s %14s\n", "planes", "per plane", "batch scalar", "batch SIMD");
+	for(int n = 8; n <= 256; n *= 2)	{
+		printf("%8d %14.3f %14.3f %14.3f (%s)\n", n,
+				timeRepulsive(n, PER_PLANE), timeRepulsive(n, BATCH_SCALAR), timeRepulsive(n, BATCH_SIMD),
+				fsquared::RepulsiveForceBatch::simdName());
+	}
+
+	printf("\nIncremental forces (us per telemetry message, every plane within RADAR_ZONE, full recompute every %d updates)\n",
+			DEFAULT_FULL_RECOMPUTE_INTERVAL);
+	printf("%8s %14s %14s %14s\n", "planes", "full", "incremental", "speedup");
+	for(int n = 32; n <= 256; n *= 8)	{
+		double full = timeIncremental(n, false), incremental = timeIncremental(n, true);
+		printf("%8d %14.3f %14.3f %13.1fx\n", n, full, incremental, full/incremental);
+	}
+
+	printf("\nNeighbor storage (planesToAvoid, sizeof PlaneObject %u, sizeof NeighborState %u)\n",
+			(unsigned int)sizeof(au_uav_ros::PlaneObject), (unsigned int)sizeof(fsquared::NeighborState));
+	printf("%8s %14s %14s %14s %14s %14s %14s\n", "planes", "map B/plane", "table B/plane",
+			"map insert us", "table insert", "map update us", "table update");
+	for(int n = 32; n <= 256; n *= 8)	{
+		neighborCost before = timeNeighborMap<planeObjectMap>(n);
+		neighborCost after = timeNeighborMap<fsquared::NeighborTable>(n);
+		printf("%8d %14.1f %14.1f %14.3f %14.3f %14.3f %14.3f\n", n,
+				before.bytesPerNeighbor, after.bytesPerNeighbor,
+				before.insertTime, after.insertTime, before.updateTime, after.updateTime);
+	}
+
+	printf("\nField evaluation on %s (ns per position, in field test + magnitude, %gm table step)\n",
+			ARCH_NAME, DEFAULT_FIELD_TABLE_STEP);
+	printf("%14s %14s %14s %14s\n", "", "analytic", "tabulated", "speedup");
+	double analytic = timeFieldEvaluation(ForceField<>());
+	double tabulated = timeFieldEvaluation(ForceField<TabulatedOvalField, TabulatedBivariateNormal>());
+	printf("%14s %14.2f %14.2f %13.1fx\n", "ForceField", analytic, tabulated, analytic/tabulated);
+	analytic = timeFieldEvaluation(AnyForceField());
+	tabulated = timeFieldEvaluation(AnyForceField(TABULATED_OVAL_FIELD_SHAPE, TABULATED_BIVARIATE_NORMAL_FUNCTION));
+	printf("%14s %14.2f %14.2f %13.1fx\n", "AnyForceField", analytic, tabulated, analytic/tabulated);
+
+	std::vector<double> magnitudes, angles;
+	srand(FORCE_TERMS);
+	for(int i = 0; i < FORCE_TERMS; i++)	{
+		magnitudes.push_back(4000.0*(rand()/(double)RAND_MAX));
+		angles.push_back(360.0*(rand()/(double)RAND_MAX) - 180);
+	}
+	double polarHeading, cartesianHeading;
+	double polarTime = timeForceSum<polarVector>(magnitudes, angles, polarHeading);
+	double cartesianTime = timeForceSum<au_uav_ros::mathVector>(magnitudes, angles, cartesianHeading);
+	printf("\nForce summation on %s (us per message, %d repulsive forces)\n", ARCH_NAME, FORCE_TERMS);
+	printf("%14s %14s %14s %14s\n", "polar", "cartesian", "speedup", "heading diff");
+	printf("%14.3f %14.3f %13.1fx %14.2e\n", polarTime, cartesianTime, polarTime/cartesianTime,
+			fabs(polarHeading - cartesianHeading));
+
+	printf("\navoid() latency on %s (us per call, every plane within RADAR_ZONE, %d threats at most, %.0f us budget)\n",
+			ARCH_NAME, BOUNDED_THREATS, AVOID_BUDGET*1e6);
+	printf("%8s %14s %10s %10s %10s %10s\n", "planes", "mode", "p50", "p99", "p99.9", "max");
+	for(int n = 32; n <= 512; n *= 4)	{
+		const char *modes[] = { "all", "top-K", "top-K+budget" };
+		au_uav_ros::LatencyRecorder latency[] = { avoidLatency(n, 0, 0), avoidLatency(n, BOUNDED_THREATS, 0),
+												avoidLatency(n, BOUNDED_THREATS, AVOID_BUDGET) };
+		for(int m = 0; m < 3; m++)
+			printf("%8d %14s %10.2f %10.2f %10.2f %10.2f\n", n, modes[m], latency[m].percentile(50)*1e6,
+					latency[m].percentile(99)*1e6, latency[m].percentile(99.9)*1e6, latency[m].getMax()*1e6);
+	}
+
+	printf("\nThreat prefilter (first %d s of each course, no avoidance, forces summed and us per telemetry message per plane)\n",
+			COURSE_SECONDS);
+	printf("%24s %7s %10s %9s %9s %9s %9s %10s %10s %10s %10s\n", "course", "planes", "in radar", "dropped",
+			"diverging", "far", "wide", "off forces", "on forces", "off us", "on us");
+	if(argc < 2)
+		printf("%24s\n", "(no course files given)");
+	for(int i = 1; i < argc; i++)	{
+		course c;
+		if(!loadCourse(argv[i], c))	{
+			printf("%24s could not be read\n", argv[i]);
+			continue;
+		}
+		const char *name = strrchr(argv[i], '/') ? strrchr(argv[i], '/') + 1 : argv[i];
+		//best of a few replays, the difference is small next to the noise of one
+		prefilterResult off = replayCourse(c, false), on = replayCourse(c, true);
+		for(int n = 1; n < COURSE_REPLAYS; n++)	{
+			off.avoidTime = std::min(off.avoidTime, replayCourse(c, false).avoidTime);
+			on.avoidTime = std::min(on.avoidTime, replayCourse(c, true).avoidTime);
+		}
+		printf("%24.24s %7d %10ld %8.1f%% %9ld %9ld %9ld %10.4f %10.4f %10.3f %10.3f\n", name, (int)c.start.size(), on.checked,
+				100.0*(on.diverging + on.farFuture + on.wideMiss)/(on.checked ? on.checked : 1),
+				on.diverging, on.farFuture, on.wideMiss, (double)off.forces/off.messages, (double)on.forces/on.messages,
+				off.avoidTime, on.avoidTime);
+	}
+	return 0;
+}
@@ -0,0 +1,161 @@
+//Benchmark for where the mover runs avoid(): in all_telem_callback, or on the CA worker with the
+//callback only posting to a TelemetryMailbox.
+//Not a pass/fail test - run by hand on the target (rosrun au_uav_ros ca_worker_benchmark) and compare the table.
+//
+//NUM_PLANES planes send telemetry at TELEMETRY_RATE, spread evenly, from the benchmark's thread. avoid()
+//is played by spinning for a fixed time per force sum, from well under the time between updates to
+//more than it, since how long avoid() takes grows with the traffic. For each:
+//	- callback: the subscriber's queue of SUBSCRIBER_QUEUE updates, the oldest dropped when it is
+//	  full (roscpp does the same), and avoid() on every update in it, one at a time
+//	- worker: the mailbox, and avoid() over everything in it at once, forces summed once
+//This prints how many avoid() passes ran, the updates dropped (queue overflow) or overwritten (mailbox),
+//and the age of the oldest update each pass used, from when it was posted to when the command was out.
+
+#include <time.h>
+#include <stdio.h>
+#include <deque>
+#include <vector>
+#include <algorithm>
+#include <boost/thread.hpp>
+#include "au_uav_ros/telemetry_mailbox.h"
+
+#define NUM_PLANES 32
+#define TELEMETRY_RATE 4.0		//updates/second from each plane
+#define SUBSCRIBER_QUEUE 10		//all_telemetry's queue size in Mover::init
+#define RUN_SECONDS 3.0
+#define MAX_WAIT 0.5			//seconds, what the worker waits before checking it should stop
+
+double wallSeconds()	{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+void spinFor(double seconds)	{
+	double until = wallSeconds() + seconds;
+	while(wallSeconds() < until)
+		;
+}
+
+void sleepUntil(double when)	{
+	double rest = when - wallSeconds();
+	if(rest > 0)
+		boost::this_thread::sleep(boost::posix_time::microseconds((long)(rest*1e6)));
+}
+
+struct results	{
+	long passes, dropped;
+	std::vector<double> age;
+	results() : passes(0), dropped(0) {}
+};
+
+//The callback way: roscpp's queue, and the spinner thread running avoid() on each update in turn
+struct subscriberQueue	{
+	boost::mutex lock;
+	boost::condition_variable ready;
+	std::deque<double> posted;		//when each update in the queue was posted
+	bool stopped;
+	subscriberQueue() : stopped(false) {}
+};
+
+void spinner(subscriberQueue *q, double avoidCost, results *r)	{
+	while(true)	{
+		double posted;
+		{
+			boost::unique_lock<boost::mutex> guard(q->lock);
+			while(q->posted.empty() && !q->stopped)
+				q->ready.wait(guard);
+			if(q->stopped)
+				return;
+			posted = q->posted.front();
+			q->posted.pop_front();
+		}
+		spinFor(avoidCost);
+		r->age.push_back(wallSeconds() - posted);
+		r->passes++;
+	}
+}
+
+void worker(au_uav_ros::TelemetryMailbox *mailbox, double avoidCost, results *r)	{
+	std::vector<au_uav_ros::mailboxEntry> taken;
+	while(mailbox->take(taken, MAX_WAIT) > 0)	{
+		double oldest = taken[0].received;
+		for(unsigned int i = 1; i < taken.size(); i++)
+			oldest = std::min(oldest, taken[i].received);
+		spinFor(avoidCost);
+		r->age.push_back(wallSeconds() - oldest);
+		r->passes++;
+	}
+}
+
+void report(const char *name, double avoidCost, long updates, results &r)	{
+	std::vector<double> &age = r.age;
+	std::sort(age.begin(), age.end());
+	if(age.empty())
+		age.push_back(0);
+	int n = age.size();
+	printf("%-10s %8.1f %10ld %9.1f%% %10.1f %10.1f %10.1f\n", name, avoidCost*1e3, r.passes, 100.0*r.dropped/updates,
+			age[(n - 1)/2]*1e3, age[(int)(0.99*(n - 1))]*1e3, age[n - 1]*1e3);
+}
+
+void measure(double avoidCost)	{
+	double gap = 1.0/(NUM_PLANES*TELEMETRY_RATE);
+	long updates = (long)(RUN_SECONDS/gap);
+
+	//callback
+	{
+		subscriberQueue q;
+		results r;
+		boost::thread thread(spinner, &q, avoidCost, &r);
+		double start = wallSeconds();
+		for(long i = 0; i < updates; i++)	{
+			sleepUntil(start + i*gap);
+			boost::mutex::scoped_lock guard(q.lock);
+			if(q.posted.size() == SUBSCRIBER_QUEUE)	{
+				q.posted.pop_front();
+				r.dropped++;
+			}
+			q.posted.push_back(wallSeconds());
+			q.ready.notify_all();
+		}
+		//let it drain what is queued, like the node would
+		sleepUntil(wallSeconds() + SUBSCRIBER_QUEUE*avoidCost);
+		{
+			boost::mutex::scoped_lock guard(q.lock);
+			r.dropped += q.posted.size();
+			q.stopped = true;
+			q.ready.notify_all();
+		}
+		thread.join();
+		report("callback", avoidCost, updates, r);
+	}
+
+	//worker
+	{
+		au_uav_ros::TelemetryMailbox mailbox;
+		results r;
+		boost::thread thread(worker, &mailbox, avoidCost, &r);
+		double start = wallSeconds();
+		au_uav_ros::Telemetry telem;
+		for(long i = 0; i < updates; i++)	{
+			sleepUntil(start + i*gap);
+			telem.planeID = i % NUM_PLANES;
+			mailbox.post(telem, wallSeconds());
+		}
+		sleepUntil(wallSeconds() + 2*avoidCost);
+		mailbox.stop();
+		thread.join();
+		r.dropped = mailbox.getOverwritten();
+		report("worker", avoidCost, updates, r);
+	}
+}
+
+int main(int argc, char **argv)	{
+	printf("avoid() in the callback or on the CA worker (%d planes at %.0f Hz, %.0f s each)\n", NUM_PLANES, TELEMETRY_RATE,
+			RUN_SECONDS);
+	printf("%-10s %8s %10s %10s %10s %10s %10s\n", "avoid()", "cost ms", "passes", "dropped", "age p50", "age p99", "age max");
+	double costs[] = {0.001, 0.005, 0.010, 0.040};
+	for(unsigned int i = 0; i < sizeof(costs)/sizeof(costs[0]); i++)
+		measure(costs[i]);
+	return 0;
+}
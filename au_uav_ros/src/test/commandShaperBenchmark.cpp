@@ -0,0 +1,295 @@
+//Report on how many ca_commands, and so MISSION_ITEM writes to the autopilot, CommandShaper saves.
+//Not a pass/fail test - run by hand (rosrun au_uav_ros command_shaper_benchmark) and compare the table.
+//Course files are given on the command line, e.g.
+//	cd `rospack find au_uav_ros`
+//	rosrun au_uav_ros command_shaper_benchmark courses/Collision.course courses/final_32_*.course
+//
+//Every plane flies straight to its next waypoint at MPS_SPEED, no avoidance, like the NoAvoidance
+//runs in scores/ (and replayCourse in caBenchmark.cpp). Every second each plane sends one update,
+//spread evenly over the second, and every plane runs it through findTempForceWaypoint, the way
+//avoid() does, for the command it wants. Every plane is in ST_GREEN_CA_ON from the start.
+//	- 4 Hz resend: the newest command is written every 0.25 s, the mover before CommandShaper
+//	- shaped: CommandShaper picks the commands, each one is written as soon as the minimum command
+//	  interval allows, and the last one again after a publish period (keepalive) with nothing new
+//For each this prints the writes a second for each plane, how long after avoid() first came up
+//with an avoiding command the autopilot got one (a maneuver start), and how far off the heading the
+//autopilot had was from the newest command (99th percentile and worst).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include <algorithm>
+#include <ros/ros.h>
+#include <au_uav_ros/Telemetry.h>
+#include "au_uav_ros/planeObject.h"
+#include "au_uav_ros/Fsquared.h"
+#include "au_uav_ros/SpatialGrid.h"
+#include "au_uav_ros/RepulsiveForceBatch.h"
+#include "au_uav_ros/command_shaper.h"
+#include "au_uav_ros/mover_schedule.h"
+#include "au_uav_ros/LocalFrame.h"
+#include "au_uav_ros/standardFuncs.h"
+
+#define COURSE_SECONDS 600
+#define RESEND_PERIOD 0.25		//what move() slept before each publish
+#define KEEPALIVE 2.0			//seconds, the publish period with CommandShaper
+
+enum policy { RESEND, SHAPED, POLICIES };
+static const char *policyNames[POLICIES] = {"4 Hz resend", "shaped"};
+
+struct simPlane	{
+	double x, y;		//meters east and north of the course's first starting position
+};
+
+struct course	{
+	std::vector<simPlane> start;
+	std::vector<std::vector<simPlane> > waypoints;
+	double originLat, originLon;
+};
+
+//Same format as caBenchmark's loadCourse
+bool loadCourse(const char *path, course &c)	{
+	FILE *file = fopen(path, "r");
+	if(file == NULL)
+		return false;
+
+	char line[256];
+	bool inWaypoints = false;
+	bool haveOrigin = false;
+	while(fgets(line, sizeof(line), file) != NULL)	{
+		if(strncmp(line, "#Plane ID:", 10) == 0)
+			inWaypoints = true;
+		int id;
+		double lat, lon, alt;
+		if(line[0] == '#' || sscanf(line, "%d %lf %lf %lf", &id, &lat, &lon, &alt) != 4 || id < 0)
+			continue;
+		if(!haveOrigin)	{
+			c.originLat = lat;
+			c.originLon = lon;
+			haveOrigin = true;
+		}
+
+		simPlane p;
+		p.x = (lon - c.originLon)*DELTA_LON_TO_METERS;
+		p.y = (lat - c.originLat)*DELTA_LAT_TO_METERS;
+		if(!inWaypoints)	{
+			if(id >= (int)c.start.size())	{
+				c.start.resize(id + 1);
+				c.waypoints.resize(id + 1);
+			}
+			c.start[id] = p;
+		}
+		else if(id < (int)c.waypoints.size())
+			c.waypoints[id].push_back(p);
+	}
+	fclose(file);
+	return !c.start.empty();
+}
+
+//What one plane's autopilot has been written, and the maneuver it is waiting to hear about
+struct autopilot	{
+	long writes;
+	double lastWrite;			//seconds, below 0 before the first
+	au_uav_ros::coordinate written;
+	bool haveWritten, writtenAvoiding;
+	bool pending;				//a command not written yet
+	double pendingSince;
+	au_uav_ros::coordinate next;
+	bool nextAvoiding;
+	double maneuverStart;		//below 0 unless avoid() is avoiding and no avoiding command was written yet
+
+	autopilot() : writes(0), lastWrite(-1), haveWritten(false), writtenAvoiding(false), pending(false), pendingSince(0),
+			nextAvoiding(false), maneuverStart(-1) {}
+};
+
+struct result	{
+	long writes, maneuvers, missed;
+	double planeSeconds;
+	std::vector<double> latency, headingError;
+
+	result() : writes(0), maneuvers(0), missed(0), planeSeconds(0) {}
+};
+
+void write(autopilot &a, const au_uav_ros::coordinate &command, bool avoiding, double now, result &r)	{
+	a.writes++;
+	r.writes++;
+	a.lastWrite = now;
+	a.written = command;
+	a.haveWritten = true;
+	a.writtenAvoiding = avoiding;
+	if(avoiding && a.maneuverStart >= 0)	{
+		r.latency.push_back(now - a.maneuverStart);
+		a.maneuverStart = -1;
+	}
+}
+
+//Writes what is due by now
+void catchUp(autopilot &a, policy how, double now, result &r)	{
+	if(how == RESEND)	{
+		if(!a.pending)
+			return;
+		double tick = a.lastWrite < 0 ? ceil(a.pendingSince/RESEND_PERIOD)*RESEND_PERIOD : a.lastWrite + RESEND_PERIOD;
+		while(tick <= now)	{
+			write(a, a.next, a.nextAvoiding, tick, r);
+			tick += RESEND_PERIOD;
+		}
+		return;
+	}
+	if(a.pending && (a.lastWrite < 0 || a.lastWrite + MOVER_MIN_COMMAND_INTERVAL <= now))	{
+		write(a, a.next, a.nextAvoiding, a.lastWrite < 0 ? a.pendingSince :
+				std::max(a.lastWrite + MOVER_MIN_COMMAND_INTERVAL, a.pendingSince), r);
+		a.pending = false;
+	}
+	while(!a.pending && a.haveWritten && a.lastWrite + KEEPALIVE <= now)
+		write(a, a.written, a.writtenAvoiding, a.lastWrite + KEEPALIVE, r);
+}
+
+result replay(const course &c, policy how)	{
+	int numPlanes = c.start.size();
+	std::vector<simPlane> planes = c.start;
+	std::vector<unsigned int> next(numPlanes, 0);
+	std::vector<au_uav_ros::PlaneObject> mes;
+	std::vector<fsquared::SpatialGrid> grids(numPlanes);
+	std::vector<fsquared::RepulsiveForceBatch> batches(numPlanes);
+	std::vector<au_uav_ros::CommandShaper> shapers(numPlanes);
+	std::vector<autopilot> autopilots(numPlanes);
+	std::vector<bool> avoiding(numPlanes, false);
+	for(int i = 0; i < numPlanes; i++)	{
+		au_uav_ros::PlaneObject me(12.0, au_uav_ros::Telemetry());
+		me.setID(i);
+		mes.push_back(me);
+	}
+	const au_uav_ros::LocalFrame &frame = au_uav_ros::LocalFrame::mission();
+
+	result r;
+	for(int second = 0; second < COURSE_SECONDS; second++)	{
+		int flying = 0;
+		for(int i = 0; i < numPlanes; i++)	{
+			if(next[i] >= c.waypoints[i].size())
+				continue;	//done, it holds its last position
+			flying++;
+			const simPlane &wp = c.waypoints[i][next[i]];
+			double dx = wp.x - planes[i].x, dy = wp.y - planes[i].y;
+			double distance = sqrt(dx*dx + dy*dy);
+			if(distance <= MPS_SPEED)	{
+				planes[i].x = wp.x;
+				planes[i].y = wp.y;
+			}
+			else	{
+				planes[i].x += MPS_SPEED*dx/distance;
+				planes[i].y += MPS_SPEED*dy/distance;
+			}
+			if(distance <= COLLISION_THRESHOLD)
+				next[i]++;
+
+			const simPlane &goalWp = c.waypoints[i][std::min(next[i], (unsigned int)c.waypoints[i].size() - 1)];
+			au_uav_ros::waypoint goal;
+			goal.latitude = c.originLat + goalWp.y*METERS_TO_DELTA_LAT;
+			goal.longitude = c.originLon + goalWp.x*METERS_TO_DELTA_LON;
+			goal.altitude = 400;
+			mes[i].setDestination(goal);
+		}
+		if(flying == 0)
+			break;
+		r.planeSeconds += flying;
+
+		for(int j = 0; j < numPlanes; j++)	{
+			double now = second + (double)j/numPlanes;
+			au_uav_ros::Telemetry t;
+			t.planeID = j;
+			t.currentLatitude = c.originLat + planes[j].y*METERS_TO_DELTA_LAT;
+			t.currentLongitude = c.originLon + planes[j].x*METERS_TO_DELTA_LON;
+			t.currentAltitude = 400;
+			t.groundSpeed = MPS_SPEED;
+
+			for(int i = 0; i < numPlanes; i++)	{
+				if(j != i)
+					grids[i].update(j, t.currentLatitude, t.currentLongitude);
+				if(next[i] >= c.waypoints[i].size())
+					continue;	//landed, its mover is back in ST_RED
+				autopilot &a = autopilots[i];
+				catchUp(a, how, now, r);
+
+				au_uav_ros::waypoint wp = fsquared::findTempForceWaypoint(mes[i], t, grids[i], batches[i], NULL);
+				au_uav_ros::coordinate me = mes[i].getCurrentLoc(), command, goal;
+				command.latitude = wp.latitude;
+				command.longitude = wp.longitude;
+				command.altitude = mes[i].getDestination().altitude;
+				goal.latitude = mes[i].getDestination().latitude;
+				goal.longitude = mes[i].getDestination().longitude;
+				goal.altitude = mes[i].getDestination().altitude;
+
+				//avoiding the way CommandShaper tells, on every command avoid() comes up with
+				double heading = frame.angle(me.latitude, me.longitude, command.latitude, command.longitude);
+				bool nowAvoiding = frame.distance(me.latitude, me.longitude, goal.latitude, goal.longitude) > COLLISION_THRESHOLD &&
+						fabs(manipulateAngle(heading - frame.angle(me.latitude, me.longitude, goal.latitude, goal.longitude))) > SHAPER_AVOIDING_HEADING;
+				if(nowAvoiding && !avoiding[i])	{
+					r.maneuvers++;
+					if(a.maneuverStart >= 0)
+						r.missed++;		//the last one ended before the autopilot heard of it
+					a.maneuverStart = now;
+				}
+				avoiding[i] = nowAvoiding;
+
+				if(how == RESEND || shapers[i].shape(me, goal, command))	{
+					if(!a.pending)
+						a.pendingSince = now;
+					a.pending = true;
+					a.next = command;
+					a.nextAvoiding = nowAvoiding;
+					catchUp(a, how, now, r);
+				}
+				if(a.haveWritten)
+					r.headingError.push_back(fabs(manipulateAngle(heading -
+							frame.angle(me.latitude, me.longitude, a.written.latitude, a.written.longitude))));
+			}
+		}
+	}
+	for(int i = 0; i < numPlanes; i++)
+		if(autopilots[i].maneuverStart >= 0)
+			r.missed++;
+	return r;
+}
+
+double percentile(std::vector<double> &values, double p)	{
+	if(values.empty())
+		return 0;
+	unsigned int i = std::min((unsigned int)(p*values.size()), (unsigned int)values.size() - 1);
+	std::nth_element(values.begin(), values.begin() + i, values.end());
+	return values[i];
+}
+
+int main(int argc, char **argv)	{
+	if(argc < 2)	{
+		printf("usage: %s <course>...\n", argv[0]);
+		return 1;
+	}
+	ros::Time::init();
+
+	printf("ca_commands written to the autopilot, heading threshold %.1f deg, position threshold %.0f m, keepalive %.1f s\n",
+			SHAPER_HEADING_THRESHOLD, SHAPER_POSITION_THRESHOLD, KEEPALIVE);
+	printf("%24s %6s %12s %9s %8s %9s %8s %8s %8s %8s %8s\n", "course", "planes", "policy", "writes/s", "saved",
+			"maneuvers", "p50 ms", "p99 ms", "missed", "hdg p99", "hdg max");
+	for(int i = 1; i < argc; i++)	{
+		const char *name = strrchr(argv[i], '/') ? strrchr(argv[i], '/') + 1 : argv[i];
+		course c;
+		if(!loadCourse(argv[i], c))	{
+			printf("%24.24s could not be read\n", name);
+			continue;
+		}
+		double resendRate = 0;
+		for(int how = 0; how < POLICIES; how++)	{
+			result r = replay(c, (policy)how);
+			double rate = r.writes/r.planeSeconds;
+			if(how == RESEND)
+				resendRate = rate;
+			double worst = r.headingError.empty() ? 0 : *std::max_element(r.headingError.begin(), r.headingError.end());
+			printf("%24.24s %6d %12s %9.2f %7.1f%% %9ld %8.0f %8.0f %8ld %8.2f %8.2f\n", name, (int)c.start.size(),
+					policyNames[how], rate, 100*(1 - rate/resendRate), r.maneuvers, percentile(r.latency, 0.5)*1e3,
+					percentile(r.latency, 0.99)*1e3, r.missed, percentile(r.headingError, 0.99), worst);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,128 @@
+//Tests CommandShaper: which of F^2's commands go out for a plane flying north to its goal.
+//How many writes it saves on the courses is measured by src/test/commandShaperBenchmark.cpp.
+
+#include <math.h>
+#include <gtest/gtest.h>
+#include "au_uav_ros/command_shaper.h"
+#include "au_uav_ros/LocalFrame.h"
+#include "au_uav_ros/Fsquared.h"	//WP_GEN_SCALAR
+
+namespace	{
+
+#define WAYPOINT_DISTANCE (WP_GEN_SCALAR*10000)	//meters, how far out F^2 puts its waypoints
+
+au_uav_ros::coordinate position(double latitude, double longitude, double altitude)	{
+	au_uav_ros::coordinate c;
+	c.latitude = latitude;
+	c.longitude = longitude;
+	c.altitude = altitude;
+	return c;
+}
+
+//meters from "from" at angle degrees, cartesian (0 east, 90 north)
+au_uav_ros::coordinate toward(const au_uav_ros::coordinate &from, double angle, double meters)	{
+	const au_uav_ros::LocalFrame &frame = au_uav_ros::LocalFrame::mission();
+	return position(frame.toLatitude(frame.toY(from.latitude) + meters*sin(angle*PI/180.0)),
+			frame.toLongitude(frame.toX(from.longitude) + meters*cos(angle*PI/180.0)), from.altitude);
+}
+
+class CommandShaperTest : public ::testing::Test	{
+protected:
+	au_uav_ros::coordinate me, goal;
+	au_uav_ros::CommandShaper shaper;
+
+	void SetUp()	{
+		me = position(32.606573, -85.490356, 400);
+		goal = toward(me, 90, 1000);
+	}
+
+	bool send(double angle)	{
+		return shaper.shape(me, goal, toward(me, angle, WAYPOINT_DISTANCE));
+	}
+};
+
+}
+
+TEST_F(CommandShaperTest, firstCommandGoesOut)	{
+	EXPECT_TRUE(send(90));
+	EXPECT_FALSE(shaper.isAvoiding());
+	EXPECT_EQ(1, shaper.getSent());
+}
+
+TEST_F(CommandShaperTest, sameHeadingIsSuppressed)	{
+	EXPECT_TRUE(send(90));
+	for(int i = 0; i < 10; i++)	{
+		me = toward(me, 90, MPS_SPEED);	//flying along, the waypoint moves with it
+		EXPECT_FALSE(send(90));
+	}
+	EXPECT_EQ(1, shaper.getSent());
+	EXPECT_EQ(10, shaper.getSuppressed());
+}
+
+TEST_F(CommandShaperTest, sameGoalIsSuppressed)	{
+	EXPECT_TRUE(shaper.shape(me, goal, goal));
+	for(int i = 0; i < 10; i++)	{
+		me = toward(me, 90, SHAPER_POSITION_THRESHOLD);		//closing on it, the waypoint stays put
+		EXPECT_FALSE(shaper.shape(me, goal, goal));
+	}
+	EXPECT_EQ(1, shaper.getSent());
+}
+
+TEST_F(CommandShaperTest, headingChangeGoesOut)	{
+	EXPECT_TRUE(send(120));
+	EXPECT_FALSE(send(120 + SHAPER_HEADING_THRESHOLD - 0.5));
+	EXPECT_TRUE(send(120 + SHAPER_HEADING_THRESHOLD + 0.5));
+	EXPECT_FALSE(send(120 + SHAPER_HEADING_THRESHOLD));		//from the last one sent, not the first
+	EXPECT_EQ(0, shaper.getManeuvers());
+}
+
+TEST_F(CommandShaperTest, positionChangeGoesOut)	{
+	au_uav_ros::coordinate command = toward(me, 90, 1000);
+	EXPECT_TRUE(shaper.shape(me, goal, command));
+	command.altitude += SHAPER_POSITION_THRESHOLD/2;
+	EXPECT_FALSE(shaper.shape(me, goal, command));
+	command.altitude += SHAPER_POSITION_THRESHOLD;
+	EXPECT_TRUE(shaper.shape(me, goal, command));
+}
+
+TEST_F(CommandShaperTest, maneuverStartAndEndGoOut)	{
+	//turns smaller than the heading threshold, but off the goal bearing and back
+	double small = (SHAPER_AVOIDING_HEADING + SHAPER_HEADING_THRESHOLD)/2;
+	ASSERT_GT(small, SHAPER_AVOIDING_HEADING);
+	ASSERT_LT(small, SHAPER_HEADING_THRESHOLD);
+
+	EXPECT_TRUE(send(90));
+	EXPECT_TRUE(send(90 + small));
+	EXPECT_TRUE(shaper.isAvoiding());
+	EXPECT_FALSE(send(90 + small + 0.5));
+	EXPECT_TRUE(send(90));
+	EXPECT_FALSE(shaper.isAvoiding());
+	EXPECT_EQ(2, shaper.getManeuvers());
+}
+
+TEST_F(CommandShaperTest, nothingIsAvoidingAtTheGoal)	{
+	goal = me;
+	EXPECT_TRUE(send(0));
+	EXPECT_FALSE(shaper.isAvoiding());
+	EXPECT_FALSE(send(0.5));
+}
+
+TEST_F(CommandShaperTest, resetSendsTheNextOne)	{
+	EXPECT_TRUE(send(90));
+	EXPECT_FALSE(send(90));
+	shaper.reset();
+	EXPECT_TRUE(send(90));
+}
+
+TEST_F(CommandShaperTest, thresholdsCanBeChanged)	{
+	shaper.setHeadingThreshold(20);
+	shaper.setPositionThreshold(1e6);
+	EXPECT_TRUE(send(120));
+	EXPECT_FALSE(send(135));
+	EXPECT_TRUE(send(145));
+}
+
+int main(int argc, char **argv)	{
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
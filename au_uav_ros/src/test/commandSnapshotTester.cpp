@@ -0,0 +1,161 @@
+//Tests CommandSnapshot: what load() and take() give back, and a stress test with a writer storing as
+//fast as it can while readers check they never see a command torn between two stores. Latency
+//against the mutexes it replaced is measured by src/test/snapshotBenchmark.cpp, not here.
+
+#include <vector>
+#include <gtest/gtest.h>
+#include <boost/thread.hpp>
+#include "au_uav_ros/command_snapshot.h"
+
+namespace	{
+
+#define STRESS_STORES 2000000
+#define STRESS_READERS 3
+
+//every field follows from n, so a mix of two stores shows
+au_uav_ros::Command numbered(long n)	{
+	au_uav_ros::Command com;
+	com.planeID = n % 1000;
+	com.commandID = n % 7;
+	com.param = n % 11;
+	com.latitude = n;
+	com.longitude = -n;
+	com.altitude = 2.0*n;
+	com.replace = n % 2;
+	return com;
+}
+
+bool consistent(const au_uav_ros::Command &com)	{
+	long n = (long)com.latitude;
+	return com.latitude == n && com.longitude == -n && com.altitude == 2.0*n && com.planeID == n % 1000 &&
+			com.commandID == n % 7 && com.param == n % 11 && (bool)com.replace == (n % 2 == 1);
+}
+
+struct stress	{
+	au_uav_ros::CommandSnapshot snapshot;
+	volatile bool done;
+	long torn[STRESS_READERS], backwards[STRESS_READERS], reads[STRESS_READERS];
+	long takes, takenTwice;
+};
+
+void write(stress *s)	{
+	for(long n = 1; n <= STRESS_STORES; n++)
+		s->snapshot.store(numbered(n), n);
+	s->done = true;
+}
+
+void loadAll(stress *s, int reader)	{
+	long last = 0;
+	au_uav_ros::Command com;
+	while(!s->done)	{
+		if(!s->snapshot.load(com))
+			continue;
+		s->reads[reader]++;
+		if(!consistent(com))
+			s->torn[reader]++;
+		if((long)com.latitude < last)
+			s->backwards[reader]++;
+		last = com.latitude;
+	}
+}
+
+void takeAll(stress *s)	{
+	long last = 0;
+	au_uav_ros::Command com;
+	double received;
+	while(!s->done)	{
+		if(!s->snapshot.take(com, received))
+			continue;
+		s->takes++;
+		if((long)com.latitude <= last || received != com.latitude)
+			s->takenTwice++;
+		last = com.latitude;
+	}
+}
+
+}
+
+TEST(CommandSnapshot, nothingStoredYet)	{
+	au_uav_ros::CommandSnapshot snapshot;
+	au_uav_ros::Command com = numbered(5);
+	double received = 1;
+	EXPECT_FALSE(snapshot.load(com));
+	EXPECT_FALSE(snapshot.take(com, received));
+	EXPECT_EQ(5, com.latitude);
+	EXPECT_EQ(1, received);
+}
+
+TEST(CommandSnapshot, loadGivesTheLatest)	{
+	au_uav_ros::CommandSnapshot snapshot;
+	au_uav_ros::Command in = numbered(41), out;
+	in.commandHeader.stamp.sec = 12;
+	in.commandHeader.stamp.nsec = 34;
+	snapshot.store(numbered(40));
+	snapshot.store(in);
+	ASSERT_TRUE(snapshot.load(out));
+	EXPECT_TRUE(consistent(out));
+	EXPECT_EQ(41, out.latitude);
+	EXPECT_EQ(12u, out.commandHeader.stamp.sec);
+	EXPECT_EQ(34u, out.commandHeader.stamp.nsec);
+	ASSERT_TRUE(snapshot.load(out));	//as often as asked
+	EXPECT_EQ(41, out.latitude);
+	EXPECT_EQ(2, snapshot.getStores());
+}
+
+TEST(CommandSnapshot, takeGivesEachStoreOnce)	{
+	au_uav_ros::CommandSnapshot snapshot;
+	au_uav_ros::Command com;
+	double received;
+	snapshot.store(numbered(1), 10.0);
+	snapshot.store(numbered(2), 20.0);
+	ASSERT_TRUE(snapshot.take(com, received));
+	EXPECT_EQ(2, com.latitude);		//only the newest, like ca_wp.clear() then push_back()
+	EXPECT_EQ(20.0, received);
+	EXPECT_FALSE(snapshot.take(com, received));
+
+	//the same command stored again is new again
+	snapshot.store(numbered(2), 30.0);
+	ASSERT_TRUE(snapshot.take(com, received));
+	EXPECT_EQ(30.0, received);
+
+	//load() does not count as taking
+	snapshot.store(numbered(3), 40.0);
+	ASSERT_TRUE(snapshot.load(com));
+	EXPECT_TRUE(snapshot.take(com, received));
+}
+
+TEST(CommandSnapshot, readersNeverSeeATornCommand)	{
+	stress s;
+	s.done = false;
+	s.takes = 0;
+	s.takenTwice = 0;
+	for(int r = 0; r < STRESS_READERS; r++)
+		s.torn[r] = s.backwards[r] = s.reads[r] = 0;
+
+	boost::thread_group readers;
+	for(int r = 0; r < STRESS_READERS; r++)
+		readers.create_thread(boost::bind(loadAll, &s, r));
+	readers.create_thread(boost::bind(takeAll, &s));
+	write(&s);
+	readers.join_all();
+
+	long reads = 0;
+	for(int r = 0; r < STRESS_READERS; r++)	{
+		EXPECT_EQ(0, s.torn[r]) << "reader " << r;
+		EXPECT_EQ(0, s.backwards[r]) << "reader " << r;
+		reads += s.reads[r];
+	}
+	EXPECT_EQ(0, s.takenTwice);
+	EXPECT_GT(reads, 0);
+	EXPECT_GT(s.takes, 0);
+	EXPECT_EQ(STRESS_STORES, s.snapshot.getStores());
+
+	au_uav_ros::Command last;
+	ASSERT_TRUE(s.snapshot.load(last));
+	EXPECT_EQ(STRESS_STORES, last.latitude);
+}
+
+int main(int argc, char **argv)	{
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
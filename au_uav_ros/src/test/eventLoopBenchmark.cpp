@@ -0,0 +1,175 @@
+//Benchmark for how the talker nodes wait on their serial lines.
+//Not a pass/fail test - run by hand on the target (rosrun au_uav_ros event_loop_benchmark) and compare the tables.
+//
+//A pty stands in for the serial line. Each way of listening is run for IDLE_SECONDS with nothing on
+//the line, for its idle CPU, then LATENCY_MESSAGES frames are written one at a time, MESSAGE_GAP
+//apart so the listener is asleep each time, for the time from write() to the message being handled.
+//	- byte at a time: the talkers' loop before MavlinkReader, a 1 us sleep, lock and read() per byte
+//	- reader thread: a thread per line on MavlinkReader::readMessages, poll() with a timeout
+//	- EventLoop: epoll, the way the talkers listen now
+
+#include <pty.h>
+#include <time.h>
+#include <stdio.h>
+#include <vector>
+#include <ros/ros.h>
+#include <boost/thread.hpp>
+#include "au_uav_ros/serial_talker.h"
+#include "au_uav_ros/mavlink_read.h"
+#include "au_uav_ros/event_loop.h"
+#include "au_uav_ros/LatencyRecorder.h"
+
+#define IDLE_SECONDS 2.0
+#define LATENCY_MESSAGES 200
+#define MESSAGE_GAP 0.005		//seconds between frames
+#define READER_TIMEOUT_MS 100	//same as READ_POLL_TIMEOUT_MS
+
+enum listener { BYTE_AT_A_TIME, READER_THREAD, EVENT_LOOP };
+
+//Both ends of a pty, the slave end set up like a talker sets up its port
+struct line	{
+	int master;
+	SerialTalker serial;
+
+	line()	{
+		int slave;
+		char name[256];
+		master = -1;
+		if(openpty(&master, &slave, name, NULL, NULL) < 0)
+			return;
+		serial.open_port(name);
+		serial.setup_port(115200, 8, 1, true);
+		close(slave);
+	}
+	~line()	{
+		serial.close_port();
+		if(master >= 0)
+			close(master);
+	}
+};
+
+double wallSeconds()	{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+double processSeconds()	{
+	struct timespec t;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t);
+	return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+//Where the listener says it got a message, and the writer waits for it
+struct handoff	{
+	boost::mutex lock;
+	boost::condition_variable arrived;
+	double handledAt;
+	int handled;
+	volatile bool running;
+
+	handoff() : handledAt(0), handled(0), running(true) {}
+	void onMessage(const mavlink_message_t &)	{
+		double now = wallSeconds();
+		boost::lock_guard<boost::mutex> guard(lock);
+		handledAt = now;
+		handled++;
+		arrived.notify_one();
+	}
+};
+
+void byteAtATime(SerialTalker *serial, handoff *got)	{
+	while(got->running)	{
+		uint8_t cp;
+		mavlink_message_t message;
+		mavlink_status_t status;
+		ros::Duration(0.000001).sleep();
+		serial->lock();
+		int num = read(serial->getFD(), &cp, 1);
+		serial->unlock();
+		if(num > 0 && mavlink_parse_char(MAVLINK_COMM_2, cp, &message, &status))
+			got->onMessage(message);
+	}
+}
+
+void readerThread(au_uav_ros::mav::MavlinkReader *reader, handoff *got)	{
+	std::vector<mavlink_message_t> messages;
+	while(got->running)	{
+		messages.clear();
+		reader->readMessages(messages, READER_TIMEOUT_MS);
+		for(unsigned int i = 0; i < messages.size(); i++)
+			got->onMessage(messages[i]);
+	}
+}
+
+void eventLoop(au_uav_ros::EventLoop *loop, handoff *got)	{
+	while(got->running)
+		loop->runOnce(EVENT_LOOP_SHUTDOWN_CHECK_MS);
+}
+
+void measure(listener how, const char *name)	{
+	line pty;
+	if(pty.master < 0)	{
+		printf("%-16s could not open a pty\n", name);
+		return;
+	}
+	au_uav_ros::mav::MavlinkReader reader(pty.serial);
+	au_uav_ros::EventLoop loop;
+	handoff got;
+	boost::thread *thread;
+	if(how == BYTE_AT_A_TIME)
+		thread = new boost::thread(byteAtATime, &pty.serial, &got);
+	else if(how == READER_THREAD)
+		thread = new boost::thread(readerThread, &reader, &got);
+	else	{
+		loop.addSerial(reader, boost::bind(&handoff::onMessage, &got, _1));
+		thread = new boost::thread(eventLoop, &loop, &got);
+	}
+
+	//idle, the benchmark's own thread is asleep so the process's CPU is the listener's
+	double wall = wallSeconds(), cpu = processSeconds();
+	ros::WallDuration(IDLE_SECONDS).sleep();
+	double idle = (processSeconds() - cpu)/(wallSeconds() - wall);
+	long idleWakeups = loop.getWakeups();
+
+	au_uav_ros::LatencyRecorder latency;
+	uint8_t bytes[MAVLINK_MAX_PACKET_LEN];
+	for(int i = 0; i < LATENCY_MESSAGES; i++)	{
+		mavlink_message_t message;
+		mavlink_msg_au_uav_pack(3, 1, &message, i, 0, 100, 0, 0, 0, 13, 13, 90, 0, (uint8_t)i);
+		int length = mavlink_msg_to_send_buffer(bytes, &message);
+
+		boost::unique_lock<boost::mutex> guard(got.lock);
+		double sent = wallSeconds();
+		if(write(pty.master, bytes, length) != length)
+			break;
+		while(got.handled <= i)
+			if(!got.arrived.timed_wait(guard, boost::posix_time::seconds(1)))
+				break;
+		if(got.handled > i)
+			latency.record(got.handledAt - sent);
+		guard.unlock();
+		ros::WallDuration(MESSAGE_GAP).sleep();
+	}
+
+	got.running = false;
+	loop.stop();
+	thread->join();
+	delete thread;
+
+	printf("%-16s %10.2f%% %10ld %10.1f %10.1f %10.1f %10ld\n", name, idle*100, how == EVENT_LOOP ? idleWakeups : -1L,
+			latency.percentile(50)*1e6, latency.percentile(99)*1e6, latency.getMax()*1e6,
+			LATENCY_MESSAGES - latency.getCount());
+}
+
+int main(int argc, char **argv)	{
+	ros::Time::init();
+
+	printf("Listening on a serial line (pty, %.0f s idle, %d frames %.0f ms apart)\n", IDLE_SECONDS, LATENCY_MESSAGES, MESSAGE_GAP*1e3);
+	printf("%-16s %11s %10s %10s %10s %10s %10s\n", "listener", "idle CPU", "wakeups", "p50 us", "p99 us", "max us", "lost");
+	measure(BYTE_AT_A_TIME, "byte at a time");
+	measure(READER_THREAD, "reader thread");
+	measure(EVENT_LOOP, "EventLoop");
+	printf("(wakeups: while idle, -1 where not counted)\n");
+	return 0;
+}
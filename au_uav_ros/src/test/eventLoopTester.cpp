@@ -0,0 +1,259 @@
+//Tests EventLoop with a pty standing in for a serial line, a UDP socket on loopback and timers,
+//and with all three links a node could have in one loop at once.
+//Wake-up latency and idle CPU are measured by src/test/eventLoopBenchmark.cpp, not here.
+
+#include <pty.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <vector>
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <ros/ros.h>
+#include <boost/thread.hpp>
+#include "au_uav_ros/serial_talker.h"
+#include "au_uav_ros/event_loop.h"
+
+namespace	{
+
+struct line	{
+	int master;
+	SerialTalker serial;
+
+	line()	{
+		int slave;
+		char name[256];
+		master = -1;
+		if(openpty(&master, &slave, name, NULL, NULL) < 0)
+			return;
+		serial.open_port(name);
+		serial.setup_port(115200, 8, 1, true);
+		close(slave);
+	}
+	~line()	{
+		serial.close_port();
+		if(master >= 0)
+			close(master);
+	}
+};
+
+int frame(int index, uint8_t *bytes)	{
+	mavlink_message_t message;
+	mavlink_msg_au_uav_pack(3, 1, &message, index, -index, 100, 0, 0, 0, 13, 13, 90, 0, (uint8_t)index);
+	return mavlink_msg_to_send_buffer(bytes, &message);
+}
+
+struct collector	{
+	std::vector<int> indexes;
+	int ticks;
+
+	collector() : ticks(0) {}
+	void onMessage(const mavlink_message_t &message)	{
+		indexes.push_back(mavlink_msg_au_uav_get_au_target_wp_index(&message));
+	}
+	void onTick()	{
+		ticks++;
+	}
+};
+
+TEST(eventLoopTest, serialMessagesInOrder)	{
+	line pty;
+	ASSERT_GE(pty.master, 0);
+	au_uav_ros::mav::MavlinkReader reader(pty.serial);
+	au_uav_ros::EventLoop loop;
+	collector got;
+	ASSERT_GE(loop.addSerial(reader, boost::bind(&collector::onMessage, &got, _1)), 0);
+
+	//nothing on the line, the wait times out with nothing handled
+	EXPECT_EQ(0, loop.runOnce(20));
+	EXPECT_EQ(0, loop.getWakeups());
+
+	uint8_t bytes[3*MAVLINK_MAX_PACKET_LEN];
+	int length = 0;
+	for(int i = 0; i < 3; i++)
+		length += frame(i, bytes + length);
+	ASSERT_EQ(length, write(pty.master, bytes, length));
+
+	for(int tries = 0; got.indexes.size() < 3 && tries < 10; tries++)
+		loop.runOnce(1000);
+	ASSERT_EQ(3u, got.indexes.size());
+	for(int i = 0; i < 3; i++)
+		EXPECT_EQ(i, got.indexes[i]);
+	EXPECT_EQ(3, loop.getMessagesDispatched());
+}
+
+int udpPair(int &receiver, int &sender, struct sockaddr_in &address)	{
+	receiver = socket(AF_INET, SOCK_DGRAM, 0);
+	sender = socket(AF_INET, SOCK_DGRAM, 0);
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = 0;
+	if(receiver < 0 || sender < 0 || bind(receiver, (struct sockaddr *)&address, sizeof(address)) != 0)
+		return -1;
+	socklen_t size = sizeof(address);
+	return getsockname(receiver, (struct sockaddr *)&address, &size);
+}
+
+TEST(eventLoopTest, udpDatagrams)	{
+	int receiver, sender;
+	struct sockaddr_in address;
+	ASSERT_EQ(0, udpPair(receiver, sender, address));
+
+	au_uav_ros::EventLoop loop;
+	collector got;
+	ASSERT_GE(loop.addUDP(receiver, boost::bind(&collector::onMessage, &got, _1)), 0);
+
+	uint8_t bytes[MAVLINK_MAX_PACKET_LEN];
+	for(int i = 0; i < 2; i++)	{
+		int length = frame(7 + i, bytes);
+		sendto(sender, bytes, length, 0, (struct sockaddr *)&address, sizeof(address));
+	}
+	for(int tries = 0; got.indexes.size() < 2 && tries < 10; tries++)
+		loop.runOnce(1000);
+	close(sender);
+
+	ASSERT_EQ(2u, got.indexes.size());
+	EXPECT_EQ(7, got.indexes[0]);
+	EXPECT_EQ(8, got.indexes[1]);
+}
+
+#define LINK_FRAMES 300
+
+//The frames of one link, latitudes link*100000 + i so a frame on the wrong link shows
+struct linkStream	{
+	std::vector<uint8_t> bytes;
+	std::vector<int> starts;		//of each frame in bytes
+	std::vector<int32_t> got;
+
+	explicit linkStream(int number)	{
+		uint8_t frame[MAVLINK_MAX_PACKET_LEN];
+		for(int i = 0; i < LINK_FRAMES; i++)	{
+			mavlink_message_t message;
+			mavlink_msg_au_uav_pack(number + 1, 1, &message, number*100000 + i, -i, 100, 0, 0, 0, 13, 13, 90, 0, i);
+			starts.push_back(bytes.size());
+			int length = mavlink_msg_to_send_buffer(frame, &message);
+			bytes.insert(bytes.end(), frame, frame + length);
+		}
+		starts.push_back(bytes.size());
+	}
+	void onFrame(const au_uav_ros::mav::FrameView &frame)	{
+		got.push_back(au_uav_ros::mav::AuUavView(frame).lat());
+	}
+	void onMessage(const mavlink_message_t &message)	{
+		got.push_back(mavlink_msg_au_uav_get_au_lat(&message));
+	}
+};
+
+struct threeLinks	{
+	line autopilot, xbee;
+	int udp;
+	struct sockaddr_in address;
+	linkStream fromAutopilot, fromXbee, fromGCS;
+
+	threeLinks() : fromAutopilot(0), fromXbee(1), fromGCS(2) {}
+};
+
+//Takes turns between the links: a few bytes down each pty, in pieces that split frames anywhere,
+//and a datagram to the UDP socket every so often
+void interleave(threeLinks *links)	{
+	unsigned int autopilotAt = 0, xbeeAt = 0, datagrams = 0;
+	int piece = 1;
+	while(autopilotAt < links->fromAutopilot.bytes.size() || xbeeAt < links->fromXbee.bytes.size() ||
+			datagrams < LINK_FRAMES)	{
+		int length = std::min(piece, (int)(links->fromAutopilot.bytes.size() - autopilotAt));
+		if(length > 0 && write(links->autopilot.master, &links->fromAutopilot.bytes[autopilotAt], length) > 0)
+			autopilotAt += length;
+		piece = piece*5 % 61 + 1;
+		length = std::min(piece, (int)(links->fromXbee.bytes.size() - xbeeAt));
+		if(length > 0 && write(links->xbee.master, &links->fromXbee.bytes[xbeeAt], length) > 0)
+			xbeeAt += length;
+		piece = piece*5 % 61 + 1;
+		if(datagrams < LINK_FRAMES && piece % 3 == 0)	{
+			std::vector<int> &starts = links->fromGCS.starts;
+			sendto(links->udp, &links->fromGCS.bytes[starts[datagrams]], starts[datagrams + 1] - starts[datagrams], 0,
+					(struct sockaddr *)&links->address, sizeof(links->address));
+			datagrams++;
+		}
+		if(piece % 7 == 0)
+			ros::WallDuration(0.0005).sleep();	//let the loop in between, and the socket buffer drain
+	}
+}
+
+//The autopilot, an XBee and a GCS in one loop, with bytes arriving on all of them in between each
+//other. Each link gets its own frames, all of them and in order.
+TEST(eventLoopTest, threeLinksInterleaved)	{
+	threeLinks links;
+	ASSERT_GE(links.autopilot.master, 0);
+	ASSERT_GE(links.xbee.master, 0);
+	int receiver;
+	ASSERT_EQ(0, udpPair(receiver, links.udp, links.address));
+
+	au_uav_ros::mav::MavlinkReader autopilotIn(links.autopilot.serial), xbeeIn(links.xbee.serial);
+	au_uav_ros::mav::FrameDispatcher autopilotDispatch, xbeeDispatch;
+	autopilotDispatch.on(MAVLINK_MSG_ID_AU_UAV, boost::bind(&linkStream::onFrame, &links.fromAutopilot, _1));
+	xbeeDispatch.on(MAVLINK_MSG_ID_AU_UAV, boost::bind(&linkStream::onFrame, &links.fromXbee, _1));
+	au_uav_ros::EventLoop loop;
+	ASSERT_GE(loop.addSerial(autopilotIn, autopilotDispatch), 0);
+	ASSERT_GE(loop.addSerial(xbeeIn, xbeeDispatch), 0);
+	ASSERT_GE(loop.addUDP(receiver, boost::bind(&linkStream::onMessage, &links.fromGCS, _1)), 0);
+
+	boost::thread writer(interleave, &links);
+	ros::WallTime start = ros::WallTime::now();
+	while(loop.getMessagesDispatched() < 3*LINK_FRAMES && (ros::WallTime::now() - start).toSec() < 10)
+		loop.runOnce(100);
+	writer.join();
+	close(links.udp);
+
+	linkStream *each[] = {&links.fromAutopilot, &links.fromXbee, &links.fromGCS};
+	for(int number = 0; number < 3; number++)	{
+		ASSERT_EQ((unsigned int)LINK_FRAMES, each[number]->got.size()) << "link " << number;
+		for(int i = 0; i < LINK_FRAMES; i++)
+			ASSERT_EQ(number*100000 + i, each[number]->got[i]) << "link " << number;
+	}
+	EXPECT_EQ(0, autopilotIn.getChecksumErrors());
+	EXPECT_EQ(0, xbeeIn.getChecksumErrors());
+}
+
+TEST(eventLoopTest, timersAndRemove)	{
+	au_uav_ros::EventLoop loop;
+	collector fast, removed;
+	ASSERT_GE(loop.addTimer(0.01, boost::bind(&collector::onTick, &fast)), 0);
+	int id = loop.addTimer(0.01, boost::bind(&collector::onTick, &removed));
+	ASSERT_GE(id, 0);
+	loop.remove(id);
+
+	ros::WallTime start = ros::WallTime::now();
+	while(fast.ticks < 5 && (ros::WallTime::now() - start).toSec() < 2)
+		loop.runOnce(100);
+	EXPECT_EQ(5, fast.ticks);
+	EXPECT_EQ(0, removed.ticks);
+}
+
+void stopLater(au_uav_ros::EventLoop *loop)	{
+	ros::WallDuration(0.05).sleep();
+	loop->stop();
+}
+
+//stop() from another thread wakes a loop that is waiting on nothing
+TEST(eventLoopTest, stopWakesRun)	{
+	au_uav_ros::EventLoop loop;
+	loop.stop();
+	ros::WallTime start = ros::WallTime::now();
+	loop.run();
+	EXPECT_LT((ros::WallTime::now() - start).toSec(), EVENT_LOOP_SHUTDOWN_CHECK_MS/1000.0);
+
+	boost::thread stopper(stopLater, &loop);
+	start = ros::WallTime::now();
+	loop.run();
+	stopper.join();
+	EXPECT_LT((ros::WallTime::now() - start).toSec(), EVENT_LOOP_SHUTDOWN_CHECK_MS/1000.0);
+}
+
+}
+
+int main(int argc, char **argv)	{
+	ros::Time::init();
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,829 @@
+//Unit tests for the fsquared math. No nodes needed, run with catkin_make run_tests.
+
+#include <math.h>
+#include <stdlib.h>
+#include <vector>
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <ros/ros.h>
+#include "au_uav_ros/vmath.h"
+#include "au_uav_ros/standardFuncs.h"
+#include "au_uav_ros/Fsquared.h"
+#include "au_uav_ros/planeObject.h"
+#include "au_uav_ros/RepulsiveForceBatch.h"
+#include "au_uav_ros/ForceAccumulator.h"
+#include "au_uav_ros/SpatialGrid.h"
+#include "au_uav_ros/NeighborTable.h"
+#include "au_uav_ros/LocalFrame.h"
+#include "au_uav_ros/ThreatFilter.h"
+#include "au_uav_ros/ThreatSet.h"
+
+namespace	{
+
+//mathVector stores x/y now, but the polar API has to behave like it did when it stored magnitude/direction
+TEST(mathVectorTest, polarRoundTrip)	{
+	au_uav_ros::mathVector v(10, 30);
+	EXPECT_NEAR(10, v.getMagnitude(), 1e-9);
+	EXPECT_NEAR(30, v.getDirection(), 1e-9);
+	EXPECT_NEAR(10*cos(30*PI/180), v.getX(), 1e-9);
+	EXPECT_NEAR(10*sin(30*PI/180), v.getY(), 1e-9);
+
+	//directions come back on [-180, 180], like the old += and -= returned them
+	au_uav_ros::mathVector w(5, 270);
+	EXPECT_NEAR(-90, w.getDirection(), 1e-9);
+}
+
+TEST(mathVectorTest, addSubtract)	{
+	au_uav_ros::mathVector east(3, 0), north(4, 90);
+	au_uav_ros::mathVector sum = east + north;
+	EXPECT_NEAR(5, sum.getMagnitude(), 1e-9);
+	EXPECT_NEAR(atan2(4.0, 3.0)*180/PI, sum.getDirection(), 1e-9);
+
+	au_uav_ros::mathVector diff = east - north;
+	EXPECT_NEAR(5, diff.getMagnitude(), 1e-9);
+	EXPECT_NEAR(atan2(-4.0, 3.0)*180/PI, diff.getDirection(), 1e-9);
+
+	sum -= north;
+	EXPECT_NEAR(3, sum.getMagnitude(), 1e-9);
+	EXPECT_NEAR(0, sum.getDirection(), 1e-9);
+
+	EXPECT_NEAR(0, east.dotProduct(north), 1e-9);
+	EXPECT_NEAR(12, east.dotProduct(au_uav_ros::mathVector(4, 0)), 1e-9);
+}
+
+TEST(mathVectorTest, setters)	{
+	au_uav_ros::mathVector v(10, 45);
+	v.setDirection(-135);
+	EXPECT_NEAR(10, v.getMagnitude(), 1e-9);
+	EXPECT_NEAR(-135, v.getDirection(), 1e-9);
+
+	v.setMagnitude(2);
+	EXPECT_NEAR(2, v.getMagnitude(), 1e-9);
+	EXPECT_NEAR(-135, v.getDirection(), 1e-9);
+
+	v *= 3;
+	EXPECT_NEAR(6, v.getMagnitude(), 1e-9);
+	v /= 2;
+	EXPECT_NEAR(3, v.getMagnitude(), 1e-9);
+	EXPECT_NEAR(-135, v.getDirection(), 1e-9);
+}
+
+//A zero vector keeps a direction for the polar setters, as it did when direction was stored
+TEST(mathVectorTest, zeroKeepsDirection)	{
+	au_uav_ros::mathVector v(0, 90);
+	EXPECT_NEAR(90, v.getDirection(), 1e-9);
+	v.setMagnitude(5);
+	EXPECT_NEAR(5, v.getMagnitude(), 1e-9);
+	EXPECT_NEAR(90, v.getDirection(), 1e-9);
+
+	au_uav_ros::mathVector w;
+	w.setDirection(90);
+	w.setMagnitude(5);
+	EXPECT_NEAR(0, w.getX(), 1e-9);
+	EXPECT_NEAR(5, w.getY(), 1e-9);
+
+	//scaled to nothing and back
+	au_uav_ros::mathVector u = au_uav_ros::mathVector(3, 0) + au_uav_ros::mathVector(3, 90);
+	u.setMagnitude(0);
+	EXPECT_NEAR(45, u.getDirection(), 1e-9);
+	u.setMagnitude(2);
+	EXPECT_NEAR(45, u.getDirection(), 1e-9);
+	u *= 0;
+	u.setMagnitude(1);
+	EXPECT_NEAR(45, u.getDirection(), 1e-9);
+
+	//added up to exactly nothing, atan2's 0
+	u -= u;
+	EXPECT_NEAR(0, u.getDirection(), 1e-9);
+}
+
+TEST(mathVectorTest, findAngleBetween)	{
+	au_uav_ros::mathVector bearing(1, 90);
+	//CW of bearing is positive, CCW is negative
+	EXPECT_NEAR(45, bearing.findAngleBetween(au_uav_ros::mathVector(1, 45)), 1e-9);
+	EXPECT_NEAR(-45, bearing.findAngleBetween(au_uav_ros::mathVector(1, 135)), 1e-9);
+	EXPECT_NEAR(-170, bearing.findAngleBetween(au_uav_ros::mathVector(1, -100)), 1e-9);
+}
+
+
+/*
+ * RepulsiveForceBatch against the per-plane functions it replaces. Tolerances are the ones
+ * promised in RepulsiveForceBatch.h, looser when the batch is float (NEON).
+ */
+const bool batchIsDouble = sizeof(fsquared::batchReal) == sizeof(double);
+const double COORDINATE_TOLERANCE = batchIsDouble ? 1e-9 : 1e-3;	//meters
+const double FORCE_TOLERANCE = batchIsDouble ? 1e-9 : 1e-4;			//relative to the largest force, maxForce
+
+#define ORIGIN_LAT 32.606573
+#define ORIGIN_LON -85.490356
+
+double uniform(double low, double high)	{
+	return low + (high - low)*(rand()/(double)RAND_MAX);
+}
+
+//planes whose truncated coordinates or oval test could go either way within the tolerance
+bool onTruncationEdge(fsquared::relativeCoordinates rel)	{
+	double xEdge = fabs(rel.x - floor(rel.x + 0.5));
+	double yEdge = fabs(rel.y - floor(rel.y + 0.5));
+	if(xEdge < COORDINATE_TOLERANCE || yEdge < COORDINATE_TOLERANCE)
+		return true;
+
+	OvalField::shapeVariables oval = OvalField().getShapeParams();
+	int x = rel.x, y = rel.y;
+	double level = y < 0 ? oval.alphaBot*x*x + oval.betaBot*y*y : oval.alphaTop*x*x + oval.betaTop*y*y;
+	return fabs(level - oval.gamma) < COORDINATE_TOLERANCE*oval.gamma;
+}
+
+TEST(repulsiveForceBatchTest, matchesPerPlaneFunctions)	{
+	srand(3);
+	double maxForce = BivariateNormal().getFunctionParams().maxForce;
+	au_uav_ros::PlaneObject me(12.0, au_uav_ros::Telemetry());
+	fsquared::RepulsiveForceBatch batch;
+	int compared = 0, inside = 0;
+
+	for(int trial = 0; trial < 200; trial++)	{
+		me.setCurrentLoc(ORIGIN_LAT + uniform(-1e-3, 1e-3), ORIGIN_LON + uniform(-1e-3, 1e-3), 100);
+		me.setCurrentBearing(uniform(-180, 180));
+
+		//an odd count so the scalar code handles the planes left over after the last vector
+		std::vector<au_uav_ros::PlaneObject> enemies;
+		batch.clear();
+		for(int i = 0; i < 37; i++)	{
+			au_uav_ros::PlaneObject enemy(12.0, au_uav_ros::Telemetry());
+			enemy.setID(i + 1);
+			enemy.setCurrentLoc(me.getCurrentLoc().latitude + uniform(-120, 120)*METERS_TO_DELTA_LAT,
+					me.getCurrentLoc().longitude + uniform(-120, 120)*METERS_TO_DELTA_LON, 100);
+			enemy.setCurrentBearing(uniform(-180, 180));
+			enemies.push_back(enemy);
+			batch.add(enemy.getID(),
+					(enemy.getCurrentLoc().longitude - me.getCurrentLoc().longitude)*DELTA_LON_TO_METERS,
+					(enemy.getCurrentLoc().latitude - me.getCurrentLoc().latitude)*DELTA_LAT_TO_METERS,
+					enemy.getCurrentBearing());
+		}
+		au_uav_ros::mathVector batchSum = batch.computeForces(0, 0);
+
+		au_uav_ros::mathVector expectedSum;
+		bool sumComparable = true;
+		for(int i = 0; i < 37; i++)	{
+			au_uav_ros::PlaneObject &enemy = enemies[i];
+			double fieldAngle = fsquared::findFieldAngle(me, enemy);
+			double planeAngle = enemy.findAngle(me);
+			fsquared::relativeCoordinates rel = fsquared::findRelativePosition(me, enemy);
+			bool expectedIn = fsquared::inEnemyField(enemy, rel, fieldAngle, planeAngle);
+			au_uav_ros::mathVector expectedForce = fsquared::calculateRepulsiveForce(me, enemy);
+			expectedSum += expectedForce;
+
+			EXPECT_EQ(enemy.getID(), batch.getPlaneID(i));
+			EXPECT_NEAR(rel.x, batch.getRelativeX(i), COORDINATE_TOLERANCE);
+			EXPECT_NEAR(rel.y, batch.getRelativeY(i), COORDINATE_TOLERANCE);
+			if(onTruncationEdge(rel))	{
+				sumComparable = false;
+				continue;
+			}
+
+			compared++;
+			if(expectedIn) inside++;
+			ASSERT_EQ(expectedIn, batch.isInField(i)) << "plane " << i << " at " << rel.x << ", " << rel.y;
+			double expectedMagnitude = expectedIn ? enemy.getField().findForceMagnitude(rel) : 0;
+			EXPECT_NEAR(expectedMagnitude, batch.getMagnitude(i), FORCE_TOLERANCE*maxForce);
+			EXPECT_NEAR(expectedForce.getX(), batch.getForceX(i), FORCE_TOLERANCE*maxForce);
+			EXPECT_NEAR(expectedForce.getY(), batch.getForceY(i), FORCE_TOLERANCE*maxForce);
+		}
+		if(sumComparable)	{
+			EXPECT_NEAR(expectedSum.getX(), batchSum.getX(), 37*FORCE_TOLERANCE*maxForce);
+			EXPECT_NEAR(expectedSum.getY(), batchSum.getY(), 37*FORCE_TOLERANCE*maxForce);
+		}
+	}
+	//make sure the random planes actually exercised both sides of the oval
+	EXPECT_GT(compared, 7000);
+	EXPECT_GT(inside, 500);
+}
+
+TEST(repulsiveForceBatchTest, simdMatchesScalar)	{
+	srand(4);
+	fsquared::RepulsiveForceBatch batch;
+	for(int i = 0; i < 101; i++)
+		batch.add(i, uniform(-80, 80), uniform(-80, 80), uniform(-180, 180));
+
+	au_uav_ros::mathVector scalar = batch.computeForcesScalar(0, 0);
+	std::vector<double> scalarX, scalarY;
+	for(int i = 0; i < batch.size(); i++)	{
+		scalarX.push_back(batch.getForceX(i));
+		scalarY.push_back(batch.getForceY(i));
+	}
+
+	au_uav_ros::mathVector simd = batch.computeForces(0, 0);
+	double maxForce = BivariateNormal().getFunctionParams().maxForce;
+	for(int i = 0; i < batch.size(); i++)	{
+		EXPECT_NEAR(scalarX[i], batch.getForceX(i), FORCE_TOLERANCE*maxForce) << fsquared::RepulsiveForceBatch::simdName();
+		EXPECT_NEAR(scalarY[i], batch.getForceY(i), FORCE_TOLERANCE*maxForce) << fsquared::RepulsiveForceBatch::simdName();
+	}
+	EXPECT_NEAR(scalar.getX(), simd.getX(), batch.size()*FORCE_TOLERANCE*maxForce);
+	EXPECT_NEAR(scalar.getY(), simd.getY(), batch.size()*FORCE_TOLERANCE*maxForce);
+}
+
+//planes on top of each other push "me" east, like atan2(0, 0) does in calculateRepulsiveForce
+TEST(repulsiveForceBatchTest, samePosition)	{
+	fsquared::RepulsiveForceBatch batch;
+	for(int i = 0; i < 4; i++)
+		batch.add(i, 0, 0, 90*i);
+	batch.computeForces(0, 0);
+	double maxForce = BivariateNormal().getFunctionParams().maxForce;
+	for(int i = 0; i < 4; i++)	{
+		EXPECT_TRUE(batch.isInField(i));
+		EXPECT_NEAR(maxForce, batch.getForceX(i), FORCE_TOLERANCE*maxForce);
+		EXPECT_NEAR(0, batch.getForceY(i), FORCE_TOLERANCE*maxForce);
+	}
+}
+
+
+au_uav_ros::PlaneObject makeMe()	{
+	au_uav_ros::PlaneObject me(12.0, au_uav_ros::Telemetry());
+	me.setID(0);
+	me.setCurrentLoc(ORIGIN_LAT, ORIGIN_LON, 100);
+	au_uav_ros::waypoint goal;
+	goal.latitude = ORIGIN_LAT + 1000*METERS_TO_DELTA_LAT;
+	goal.longitude = ORIGIN_LON;
+	goal.altitude = 100;
+	me.setDestination(goal);
+	return me;
+}
+
+/*
+ * Feeds the same random walk of telemetry updates to the incremental path and to the path that sums
+ * the map again on every update, and compares the repulsive force after every update.
+ * Returns the number of updates where they differ by more than tolerance.
+ */
+int compareIncremental(int fullRecomputeInterval, int updates, double tolerance, fsquared::ForceAccumulator &forces)	{
+	const int numPlanes = 40;
+	std::vector<double> x(numPlanes + 1), y(numPlanes + 1);	//meters from the origin, plane 0 is "me"
+	for(int i = 1; i <= numPlanes; i++)	{
+		x[i] = uniform(-120, 120);
+		y[i] = uniform(-120, 120);
+	}
+
+	au_uav_ros::PlaneObject meFull = makeMe(), meIncremental = makeMe();
+	fsquared::SpatialGrid grid;
+	fsquared::RepulsiveForceBatch fullBatch, checkBatch;
+	forces.setFullRecomputeInterval(fullRecomputeInterval);
+
+	int mismatches = 0, pushed = 0;
+	for(int n = 0; n < updates; n++)	{
+		//"me" sends about one update for every 8 the others send
+		int sender = rand() % 8 == 0 ? 0 : 1 + rand() % numPlanes;
+		x[sender] += uniform(-5, 5);
+		y[sender] += uniform(-5, 5);
+
+		au_uav_ros::Telemetry t;
+		t.planeID = sender;
+		t.currentLatitude = ORIGIN_LAT + y[sender]*METERS_TO_DELTA_LAT;
+		t.currentLongitude = ORIGIN_LON + x[sender]*METERS_TO_DELTA_LON;
+		t.currentAltitude = 100;
+		t.targetBearing = uniform(0, 360);
+
+		if(sender != 0)
+			grid.update(sender, t.currentLatitude, t.currentLongitude);
+		fsquared::findTempForceWaypoint(meFull, t, grid, fullBatch);
+		au_uav_ros::coordinate meLoc = meFull.getCurrentLoc();
+		au_uav_ros::mathVector expected = fsquared::sumRepulsiveForces(meFull, meFull.getMap(),
+				grid.findNeighbors(meLoc.latitude, meLoc.longitude, RADAR_ZONE), checkBatch);
+
+		fsquared::findTempForceWaypoint(meIncremental, t, forces);
+		au_uav_ros::mathVector incremental = forces.getForce();
+
+		if(fabs(expected.getX() - incremental.getX()) > tolerance || fabs(expected.getY() - incremental.getY()) > tolerance)
+			mismatches++;
+		if(expected.getMagnitude() > 0)
+			pushed++;
+	}
+	//most updates should find "me" inside somebody's field, or there is nothing to compare
+	EXPECT_GT(pushed, updates/2);
+	return mismatches;
+}
+
+TEST(forceAccumulatorTest, matchesFullRecompute)	{
+	srand(5);
+	double maxForce = BivariateNormal().getFunctionParams().maxForce;
+	//float lanes get a force tolerance per plane, summed over the 40 planes
+	double tolerance = batchIsDouble ? 1e-6*maxForce : 40*FORCE_TOLERANCE*maxForce;
+	fsquared::ForceAccumulator forces;
+	//a long interval so the running total goes a long way on corrections alone
+	int mismatches = compareIncremental(1000, 5000, tolerance, forces);
+
+	//float lanes (NEON) can truncate a relative coordinate to the other whole meter now and then
+	if(batchIsDouble)
+		EXPECT_EQ(0, mismatches);
+	else
+		EXPECT_LE(mismatches, 50);
+	EXPECT_EQ(5, forces.getFullRecomputes());
+	EXPECT_GT(forces.getBatchedRefreshes(), 500);
+}
+
+TEST(forceAccumulatorTest, recomputeEveryUpdate)	{
+	srand(6);
+	double maxForce = BivariateNormal().getFunctionParams().maxForce;
+	double tolerance = batchIsDouble ? 1e-6*maxForce : 40*FORCE_TOLERANCE*maxForce;
+	fsquared::ForceAccumulator forces;
+	int mismatches = compareIncremental(1, 500, tolerance, forces);
+	if(batchIsDouble)	{
+		EXPECT_EQ(0, mismatches);
+	}
+	EXPECT_EQ(500, forces.getFullRecomputes());
+	EXPECT_EQ(0, forces.getBatchedRefreshes());
+}
+
+
+/*
+ * Tabulated fields against the analytic ones, over every whole meter within RADAR_ZONE (the
+ * field classes truncate to whole meters, so those are the only inputs there are).
+ */
+fsquared::relativeCoordinates at(double x, double y)	{
+	fsquared::relativeCoordinates rel;
+	rel.x = x;
+	rel.y = y;
+	return rel;
+}
+
+//The grid holds what "me's" map holds, a plane that drops out of the map drops out of the grid
+TEST(spatialGridTest, followsPlanesToAvoid)	{
+	au_uav_ros::PlaneObject me = makeMe();
+	fsquared::SpatialGrid grid;
+	fsquared::RepulsiveForceBatch batch;
+	au_uav_ros::Telemetry t;
+	t.planeID = 1;
+	t.currentLongitude = ORIGIN_LON;
+	t.currentAltitude = 100;
+
+	//its field points north, it reaches about 30 m behind the plane
+	const double north[] = {20, 50, 20, 300};		//meters north of "me"
+	const bool inMap[] = {true, false, true, false};	//in the field, behind the field, in, out of RADAR_ZONE
+	for(int i = 0; i < 4; i++)	{
+		t.currentLatitude = ORIGIN_LAT + north[i]*METERS_TO_DELTA_LAT;
+		fsquared::findTempForceWaypoint(me, t, grid, batch);
+		EXPECT_EQ(inMap[i], me.getMap().contains(1));
+		EXPECT_EQ(inMap[i] ? 1 : 0, grid.size());
+	}
+
+	//updates from "me" leave it alone
+	t.planeID = 0;
+	t.currentLatitude = ORIGIN_LAT;
+	fsquared::findTempForceWaypoint(me, t, grid, batch);
+	EXPECT_EQ(0, grid.size());
+}
+
+TEST(tabulatedFieldTest, boundaryMatchesOval)	{
+	OvalField::shapeVariables lopsided = OvalField().getShapeParams();
+	lopsided.alphaTop = .2;
+	lopsided.gamma = 900;
+	OvalField shapes[] = { OvalField(), OvalField(lopsided) };
+
+	for(int s = 0; s < 2; s++)	{
+		TabulatedOvalField tabulated(shapes[s]);
+		for(int x = -RADAR_ZONE; x <= RADAR_ZONE; x++)	{
+			for(int y = -RADAR_ZONE; y <= RADAR_ZONE; y++)	{
+				//fractions too, both truncate them the same way
+				fsquared::relativeCoordinates rel = at(x + .3, y - .6);
+				ASSERT_EQ(shapes[s].internal_areCoordinatesInMyField(rel, 0, 0), tabulated.internal_areCoordinatesInMyField(rel, 0, 0))
+						<< "x " << rel.x << " y " << rel.y;
+			}
+		}
+	}
+}
+
+TEST(tabulatedFieldTest, magnitudeWithinDocumentedError)	{
+	OvalField shape;
+	BivariateNormal function;
+	double steps[] = { DEFAULT_FIELD_TABLE_STEP, .5, 2, 2.5, 4 };
+
+	for(int s = 0; s < 5; s++)	{
+		TabulatedBivariateNormal tabulated(function, shape, steps[s]);
+		double allowed = TabulatedBivariateNormal::maxError(function, steps[s]);
+		//steps that divide a meter put every whole meter on a grid point
+		if(steps[s] <= 1)
+			allowed = 1e-12*function.getFunctionParams().maxForce;
+
+		double worst = 0;
+		int inside = 0;
+		for(int x = -RADAR_ZONE; x <= RADAR_ZONE; x++)	{
+			for(int y = -RADAR_ZONE; y <= RADAR_ZONE; y++)	{
+				fsquared::relativeCoordinates rel = at(x, y);
+				if(!shape.internal_areCoordinatesInMyField(rel, 0, 0))
+					continue;
+				inside++;
+				worst = std::max(worst, fabs(function.findFieldFunctionMagnitude(rel) - tabulated.findFieldFunctionMagnitude(rel)));
+			}
+		}
+		EXPECT_GT(inside, 1000);
+		EXPECT_LE(worst, allowed) << "step " << steps[s];
+	}
+}
+
+//Outside the shape it was built for the table is not used, the function is calculated
+TEST(tabulatedFieldTest, outsideCoverageIsCalculated)	{
+	BivariateNormal function;
+	TabulatedBivariateNormal tabulated(function, OvalField(), 4);
+	fsquared::relativeCoordinates rel = at(90, -90);
+	EXPECT_EQ(function.findFieldFunctionMagnitude(rel), tabulated.findFieldFunctionMagnitude(rel));
+}
+
+TEST(tabulatedFieldTest, selectableAtRuntime)	{
+	AnyForceField analytic;
+	AnyForceField tabulated(TABULATED_OVAL_FIELD_SHAPE, TABULATED_BIVARIATE_NORMAL_FUNCTION);
+	EXPECT_EQ(TABULATED_OVAL_FIELD_SHAPE, tabulated.getShapeCode());
+	EXPECT_EQ(TABULATED_BIVARIATE_NORMAL_FUNCTION, tabulated.getFunctionCode());
+
+	AnyForceField fromTemplate = ForceField<TabulatedOvalField, TabulatedBivariateNormal>();
+	EXPECT_EQ(TABULATED_OVAL_FIELD_SHAPE, fromTemplate.getShapeCode());
+
+	for(int x = -60; x <= 60; x += 7)	{
+		for(int y = -40; y <= 80; y += 5)	{
+			fsquared::relativeCoordinates rel = at(x, y);
+			EXPECT_EQ(analytic.areCoordinatesInMyField(rel, 0, 0), tabulated.areCoordinatesInMyField(rel, 0, 0));
+			EXPECT_EQ(analytic.findForceMagnitude(rel), tabulated.findForceMagnitude(rel));
+		}
+	}
+}
+
+//me's neighbor field reaches every force path: the per-plane functions, the batch and the incremental cache
+TEST(tabulatedFieldTest, neighborFieldOnEveryPath)	{
+	OvalField::shapeVariables longer = OvalField().getShapeParams();
+	longer.gamma *= 4;		//reaches about 61 m behind a plane instead of 30
+	OvalField shape(longer);
+	BivariateNormal function;
+
+	au_uav_ros::PlaneObject me = makeMe(), tabulatedMe = makeMe();
+	me.setNeighborField(ForceField<>(shape, function));
+	tabulatedMe.setNeighborField(ForceField<TabulatedOvalField, TabulatedBivariateNormal>(
+			TabulatedOvalField(shape), TabulatedBivariateNormal(function, shape)));
+	EXPECT_EQ(TABULATED_OVAL_FIELD_SHAPE, tabulatedMe.getNeighborField().getShapeCode());
+	EXPECT_TRUE(shape == tabulatedMe.getNeighborField().getOval());
+
+	fsquared::SpatialGrid grid;
+	fsquared::RepulsiveForceBatch batch;
+	fsquared::ForceAccumulator forces;
+	au_uav_ros::Telemetry t;
+	t.planeID = 1;
+	t.currentLatitude = ORIGIN_LAT + 45*METERS_TO_DELTA_LAT;	//behind the default field, inside this one
+	t.currentLongitude = ORIGIN_LON + 3*METERS_TO_DELTA_LON;
+	t.currentAltitude = 100;
+	fsquared::findTempForceWaypoint(me, t, grid, batch);
+	fsquared::findTempForceWaypoint(tabulatedMe, t, forces);
+	ASSERT_TRUE(me.getMap().contains(1));
+	ASSERT_TRUE(tabulatedMe.getMap().contains(1));
+
+	double maxForce = function.getFunctionParams().maxForce;
+	au_uav_ros::mathVector expected = fsquared::calculateRepulsiveForce(me, *me.getMap().find(1));
+	au_uav_ros::coordinate meLoc = me.getCurrentLoc();
+	au_uav_ros::mathVector batched = fsquared::sumRepulsiveForces(me, me.getMap(),
+			grid.findNeighbors(meLoc.latitude, meLoc.longitude, RADAR_ZONE), batch);
+	EXPECT_GT(expected.getMagnitude(), 0);
+	EXPECT_NEAR(expected.getX(), batched.getX(), FORCE_TOLERANCE*maxForce);
+	EXPECT_NEAR(expected.getY(), batched.getY(), FORCE_TOLERANCE*maxForce);
+	EXPECT_NEAR(expected.getX(), forces.getForce().getX(), FORCE_TOLERANCE*maxForce);
+	EXPECT_NEAR(expected.getY(), forces.getForce().getY(), FORCE_TOLERANCE*maxForce);
+
+	//back to the default field, the cache is rebuilt on the next update and the plane pushes no more
+	tabulatedMe.setNeighborField(AnyForceField());
+	long recomputes = forces.getFullRecomputes();
+	fsquared::findTempForceWaypoint(tabulatedMe, t, forces);
+	EXPECT_EQ(recomputes + 1, forces.getFullRecomputes());
+	EXPECT_FALSE(tabulatedMe.getMap().contains(1));
+	EXPECT_NEAR(0, forces.getForce().getMagnitude(), FORCE_TOLERANCE*maxForce);
+}
+
+fsquared::NeighborState neighborAt(int planeID, double x, double y, double bearing)	{
+	fsquared::NeighborState state = fsquared::NeighborState();
+	state.id = planeID;
+	au_uav_ros::coordinate location;
+	location.latitude = ORIGIN_LAT + y*METERS_TO_DELTA_LAT;
+	location.longitude = ORIGIN_LON + x*METERS_TO_DELTA_LON;
+	location.altitude = 100;
+	state.position = au_uav_ros::LocalFrame::mission().toLocal(location);
+	state.currentBearing = bearing;
+	return state;
+}
+
+TEST(neighborTableTest, insertUpdateErase)	{
+	EXPECT_LE(sizeof(fsquared::NeighborState), 64u);
+
+	fsquared::NeighborTable table;
+	EXPECT_TRUE(table.empty());
+	EXPECT_TRUE(table.find(3) == NULL);
+
+	table.update(neighborAt(3, 10, 20, 0));
+	table.update(neighborAt(7, 30, 40, 90));
+	table.update(neighborAt(-1, 0, 0, 0));	//ignored
+	EXPECT_EQ(2, table.size());
+	EXPECT_EQ(8, table.idLimit());
+	EXPECT_TRUE(table.contains(3));
+	EXPECT_FALSE(table.contains(5));
+	EXPECT_FALSE(table.contains(-1));
+
+	//updating a plane already in the table does not add another
+	table.update(neighborAt(3, 11, 21, 45));
+	EXPECT_EQ(2, table.size());
+	ASSERT_TRUE(table.find(3) != NULL);
+	EXPECT_EQ(45, table.find(3)->currentBearing);
+
+	table.erase(3);
+	table.erase(3);
+	table.erase(100);
+	EXPECT_EQ(1, table.size());
+	EXPECT_FALSE(table.contains(3));
+	EXPECT_TRUE(table.contains(7));
+
+	table.clear();
+	EXPECT_TRUE(table.empty());
+	EXPECT_EQ(8, table.idLimit());	//keeps its slots
+}
+
+//The map holds NeighborStates now, the force from one has to be the force from the PlaneObject it came from
+TEST(neighborTableTest, matchesPlaneObjectForce)	{
+	srand(7);
+	au_uav_ros::PlaneObject me(12.0, au_uav_ros::Telemetry());
+	me.setCurrentLoc(ORIGIN_LAT, ORIGIN_LON, 100);
+	int inside = 0;
+
+	for(int trial = 0; trial < 500; trial++)	{
+		me.setCurrentBearing(uniform(-180, 180));
+		au_uav_ros::PlaneObject enemy(12.0, au_uav_ros::Telemetry());
+		enemy.setID(1);
+		enemy.setCurrentLoc(ORIGIN_LAT + uniform(-80, 80)*METERS_TO_DELTA_LAT, ORIGIN_LON + uniform(-80, 80)*METERS_TO_DELTA_LON, 100);
+		enemy.setCurrentBearing(uniform(-180, 180));
+		fsquared::NeighborState neighbor = enemy.toNeighborState();
+
+		EXPECT_EQ(fsquared::findFieldAngle(me, enemy), fsquared::findFieldAngle(me, neighbor));
+		EXPECT_EQ(fsquared::inEnemyField(me, enemy), fsquared::inEnemyField(me, neighbor));
+		au_uav_ros::mathVector expected = fsquared::calculateRepulsiveForce(me, enemy);
+		au_uav_ros::mathVector actual = fsquared::calculateRepulsiveForce(me, neighbor);
+		EXPECT_EQ(expected.getX(), actual.getX());
+		EXPECT_EQ(expected.getY(), actual.getY());
+		if(expected.getMagnitude() > 0)
+			inside++;
+	}
+	EXPECT_GT(inside, 50);
+}
+
+fsquared::NeighborState flyingAt(int planeID, double x, double y, double bearing, double speed)	{
+	fsquared::NeighborState state = neighborAt(planeID, x, y, 0.0);
+	state.targetBearing = bearing;
+	state.speed = speed;
+	return state;
+}
+
+TEST(threatFilterTest, timeToGoAndMiss)	{
+	au_uav_ros::PlaneObject me(12.0, au_uav_ros::Telemetry());
+	me.setCurrentLoc(ORIGIN_LAT, ORIGIN_LON, 100);
+	me.setCurrentBearing(0);	//north
+	me.setSpeed(10);
+
+	//head on, 80 meters apart and closing at 20 m/s
+	au_uav_ros::threatContainer threat = fsquared::ThreatFilter::assess(me, flyingAt(1, 0, 80, 180, 10));
+	EXPECT_EQ(1, threat.planeID);
+	EXPECT_NEAR(4.0, threat.timeToGo, 1e-6);
+	EXPECT_NEAR(0.0, threat.ZEM, 1e-6);
+
+	//crossing from the east, both reach (0, 50) after 5 seconds
+	threat = fsquared::ThreatFilter::assess(me, flyingAt(2, 50, 50, 270, 10));
+	EXPECT_NEAR(5.0, threat.timeToGo, 1e-6);
+	EXPECT_NEAR(0.0, threat.ZEM, 1e-6);
+
+	//flying alongside, never any closer
+	threat = fsquared::ThreatFilter::assess(me, flyingAt(3, 30, 0, 0, 10));
+	EXPECT_EQ(0.0, threat.timeToGo);
+	EXPECT_NEAR(30.0, threat.ZEM, 1e-6);
+
+	//ahead and pulling away
+	threat = fsquared::ThreatFilter::assess(me, flyingAt(4, 0, 60, 0, 15));
+	EXPECT_LT(threat.timeToGo, 0);
+}
+
+TEST(threatFilterTest, dropsAndRanks)	{
+	au_uav_ros::PlaneObject me(12.0, au_uav_ros::Telemetry());
+	me.setCurrentLoc(ORIGIN_LAT, ORIGIN_LON, 100);
+	me.setCurrentBearing(0);
+	me.setSpeed(10);
+	fsquared::ThreatFilter filter(8.0, 40.0, 20.0);
+
+	EXPECT_TRUE(filter.admit(me, flyingAt(1, 0, 80, 180, 10)));		//head on, 4 s
+	EXPECT_TRUE(filter.admit(me, flyingAt(2, 50, 50, 270, 10)));	//crossing, 5 s
+	EXPECT_TRUE(filter.admit(me, flyingAt(3, -30, 30, 90, 10)));	//crossing from the west, 3 s
+	EXPECT_FALSE(filter.admit(me, flyingAt(4, 0, 60, 0, 15)));		//pulling away
+	EXPECT_FALSE(filter.admit(me, flyingAt(5, 0, 90, 0, 9)));		//being overtaken, 90 s
+	EXPECT_FALSE(filter.admit(me, flyingAt(6, 60, 0, 0, 10)));		//alongside, 60 m
+	EXPECT_TRUE(filter.admit(me, flyingAt(7, 0, -15, 180, 10)));	//moving away, but close
+
+	EXPECT_EQ(7, filter.getChecked());
+	EXPECT_EQ(4, filter.getAdmitted());
+	EXPECT_EQ(1, filter.getDiverging());
+	EXPECT_EQ(1, filter.getFarFuture());
+	EXPECT_EQ(1, filter.getWideMiss());
+	EXPECT_EQ(3, filter.getDropped());
+
+	const std::vector<au_uav_ros::threatContainer> &ranked = filter.rankThreats();
+	ASSERT_EQ(4u, ranked.size());
+	EXPECT_EQ(7, ranked[0].planeID);
+	EXPECT_EQ(3, ranked[1].planeID);
+	EXPECT_EQ(1, ranked[2].planeID);
+	EXPECT_EQ(2, ranked[3].planeID);
+
+	//a threat that stops being one is forgotten
+	EXPECT_FALSE(filter.admit(me, flyingAt(1, 0, 80, 0, 20)));
+	filter.remove(2);
+	EXPECT_TRUE(filter.find(1) == NULL);
+	EXPECT_EQ(2u, filter.rankThreats().size());
+
+	filter.resetCounters();
+	EXPECT_EQ(0, filter.getChecked());
+	EXPECT_EQ(0, filter.getDropped());
+}
+
+//"me" at the origin flying north, numPlanes planes scattered around it, all in the map
+void fillMap(au_uav_ros::PlaneObject &me, int numPlanes)	{
+	me.setCurrentLoc(ORIGIN_LAT, ORIGIN_LON, 100);
+	me.setCurrentBearing(0);
+	me.setSpeed(MPS_SPEED);
+	for(int i = 1; i <= numPlanes; i++)
+		me.planeIn_updateMap(flyingAt(i, uniform(-60, 60), uniform(-60, 60), uniform(0, 360), MPS_SPEED));
+}
+
+TEST(threatSetTest, unboundedMatchesFullSum)	{
+	srand(10);
+	au_uav_ros::PlaneObject me(12.0, au_uav_ros::Telemetry());
+	fillMap(me, 20);
+	au_uav_ros::mathVector expected = fsquared::sumRepulsiveForces(me, me.getMap());
+
+	const fsquared::threatPriority priorities[] = { fsquared::THREAT_BY_DISTANCE, fsquared::THREAT_BY_TIME_TO_GO, fsquared::THREAT_BY_FORCE };
+	for(int p = 0; p < 3; p++)	{
+		fsquared::ThreatSet threats(20, priorities[p]);
+		au_uav_ros::mathVector actual = threats.sumRepulsiveForces(me, me.getMap());
+		EXPECT_NEAR(expected.getX(), actual.getX(), 1e-9);
+		EXPECT_NEAR(expected.getY(), actual.getY(), 1e-9);
+		EXPECT_EQ(20, threats.getConsidered());
+		EXPECT_EQ(20, threats.getSummed());
+		EXPECT_FALSE(threats.wasCut());
+		EXPECT_EQ(0, threats.getThreatsDropped());
+	}
+}
+
+TEST(threatSetTest, keepsMostUrgent)	{
+	srand(11);
+	au_uav_ros::PlaneObject me(12.0, au_uav_ros::Telemetry());
+	fillMap(me, 30);
+	au_uav_ros::localPosition meLocal = me.getLocalPosition();
+
+	//the 5 closest, by hand
+	std::vector<std::pair<double, int> > byDistance;
+	for(int id = 1; id <= 30; id++)	{
+		const fsquared::NeighborState *enemy = me.getMap().find(id);
+		double dx = enemy->position.x - meLocal.x, dy = enemy->position.y - meLocal.y;
+		byDistance.push_back(std::make_pair(dx*dx + dy*dy, id));
+	}
+	std::sort(byDistance.begin(), byDistance.end());
+	au_uav_ros::mathVector expected;
+	for(int i = 0; i < 5; i++)
+		expected += fsquared::calculateRepulsiveForce(me, *me.getMap().find(byDistance[i].second));
+
+	fsquared::ThreatSet threats(5, fsquared::THREAT_BY_DISTANCE);
+	au_uav_ros::mathVector actual = threats.sumRepulsiveForces(me, me.getMap());
+	EXPECT_NEAR(expected.getX(), actual.getX(), 1e-9);
+	EXPECT_NEAR(expected.getY(), actual.getY(), 1e-9);
+	EXPECT_EQ(30, threats.getConsidered());
+	EXPECT_EQ(5, threats.getSummed());
+	EXPECT_EQ(25, threats.getThreatsDropped());
+
+	//the 3 strongest
+	std::vector<std::pair<double, int> > byForce;
+	for(int id = 1; id <= 30; id++)
+		byForce.push_back(std::make_pair(-fsquared::calculateRepulsiveForce(me, *me.getMap().find(id)).getMagnitude(), id));
+	std::sort(byForce.begin(), byForce.end());
+	expected = au_uav_ros::mathVector();
+	for(int i = 0; i < 3; i++)
+		expected += fsquared::calculateRepulsiveForce(me, *me.getMap().find(byForce[i].second));
+
+	threats.setPriority(fsquared::THREAT_BY_FORCE);
+	threats.setMaxThreats(3);
+	actual = threats.sumRepulsiveForces(me, me.getMap());
+	EXPECT_EQ(3, threats.getSummed());
+	EXPECT_NEAR(expected.getX(), actual.getX(), 1e-9);
+	EXPECT_NEAR(expected.getY(), actual.getY(), 1e-9);
+}
+
+//A deadline that has already passed still sums the most urgent plane, and only that one. 10 planes
+//by distance are all ranked before the first look at the clock.
+TEST(threatSetTest, deadlineKeepsMostUrgent)	{
+	srand(12);
+	au_uav_ros::PlaneObject me(12.0, au_uav_ros::Telemetry());
+	fillMap(me, 10);
+	fsquared::ThreatSet one(1, fsquared::THREAT_BY_DISTANCE), late(10, fsquared::THREAT_BY_DISTANCE);
+	au_uav_ros::mathVector expected = one.sumRepulsiveForces(me, me.getMap());
+
+	au_uav_ros::mathVector actual = late.sumRepulsiveForces(me, me.getMap(), 1e-9);
+	EXPECT_TRUE(late.wasCut());
+	EXPECT_EQ(1, late.getSummed());
+	EXPECT_EQ(1, late.getDeadlinesMissed());
+	EXPECT_EQ(expected.getX(), actual.getX());
+	EXPECT_EQ(expected.getY(), actual.getY());
+
+	fsquared::threatPriority priority;
+	EXPECT_TRUE(fsquared::ThreatSet::parsePriority("time_to_go", priority));
+	EXPECT_EQ(fsquared::THREAT_BY_TIME_TO_GO, priority);
+	EXPECT_FALSE(fsquared::ThreatSet::parsePriority("closest", priority));
+	EXPECT_EQ(fsquared::THREAT_BY_TIME_TO_GO, priority);
+}
+
+//A deadline that has already passed stops the ranking too: after the first plane by time to go,
+//after the first 16 by distance. Planes are ranked in ID order.
+TEST(threatSetTest, deadlineCutsRanking)	{
+	srand(13);
+	au_uav_ros::PlaneObject me(12.0, au_uav_ros::Telemetry());
+	fillMap(me, 40);
+	au_uav_ros::localPosition meLocal = me.getLocalPosition();
+
+	fsquared::ThreatSet byTime(10, fsquared::THREAT_BY_TIME_TO_GO);
+	au_uav_ros::mathVector expected = fsquared::calculateRepulsiveForce(me, *me.getMap().find(1));
+	au_uav_ros::mathVector actual = byTime.sumRepulsiveForces(me, me.getMap(), 1e-9);
+	EXPECT_TRUE(byTime.wasCut());
+	EXPECT_EQ(40, byTime.getConsidered());
+	EXPECT_EQ(1, byTime.getSummed());
+	EXPECT_EQ(39, byTime.getThreatsDropped());
+	EXPECT_EQ(expected.getX(), actual.getX());
+	EXPECT_EQ(expected.getY(), actual.getY());
+
+	int closest = 1;
+	double closestSquared = 1e18;
+	for(int id = 1; id <= 16; id++)	{
+		const fsquared::NeighborState *enemy = me.getMap().find(id);
+		double dx = enemy->position.x - meLocal.x, dy = enemy->position.y - meLocal.y;
+		if(dx*dx + dy*dy < closestSquared)	{
+			closestSquared = dx*dx + dy*dy;
+			closest = id;
+		}
+	}
+	fsquared::ThreatSet byDistance(10, fsquared::THREAT_BY_DISTANCE);
+	expected = fsquared::calculateRepulsiveForce(me, *me.getMap().find(closest));
+	actual = byDistance.sumRepulsiveForces(me, me.getMap(), 1e-9);
+	EXPECT_TRUE(byDistance.wasCut());
+	EXPECT_EQ(1, byDistance.getSummed());
+	EXPECT_EQ(expected.getX(), actual.getX());
+	EXPECT_EQ(expected.getY(), actual.getY());
+}
+
+//Until it is anchored a frame has to measure exactly what the DELTA constants did
+TEST(localFrameTest, unanchoredUsesLegacyConstants)	{
+	au_uav_ros::LocalFrame frame;
+	EXPECT_FALSE(frame.isAnchored());
+	EXPECT_EQ(DELTA_LAT_TO_METERS, frame.metersPerDegreeLatitude());
+	EXPECT_EQ(DELTA_LON_TO_METERS, frame.metersPerDegreeLongitude());
+	EXPECT_NEAR(100.0, frame.distance(ORIGIN_LAT, ORIGIN_LON, ORIGIN_LAT + 100*METERS_TO_DELTA_LAT, ORIGIN_LON), 1e-6);
+	EXPECT_NEAR(100.0, frame.distance(ORIGIN_LAT, ORIGIN_LON, ORIGIN_LAT, ORIGIN_LON + 100*METERS_TO_DELTA_LON), 1e-6);
+	EXPECT_NEAR(90.0, frame.angle(ORIGIN_LAT, ORIGIN_LON, ORIGIN_LAT + 100*METERS_TO_DELTA_LAT, ORIGIN_LON), 1e-9);
+}
+
+//Meters per degree on the WGS84 ellipsoid, from the published tables
+TEST(localFrameTest, anchoredScaleAtAnyLatitude)	{
+	const double latitudes[] = { 0, 45, 60, 75 };
+	const double perLatitude[] = { 110574, 111132, 111412, 111618 };
+	const double perLongitude[] = { 111320, 78847, 55800, 28902 };
+	for(int i = 0; i < 4; i++)	{
+		au_uav_ros::LocalFrame frame(latitudes[i], 10, 0);
+		EXPECT_TRUE(frame.isAnchored());
+		EXPECT_NEAR(perLatitude[i], frame.metersPerDegreeLatitude(), 1.0) << "latitude " << latitudes[i];
+		EXPECT_NEAR(perLongitude[i], frame.metersPerDegreeLongitude(), 1.0) << "latitude " << latitudes[i];
+
+		//a kilometer north and a kilometer east of the anchor are a kilometer away
+		double north = 1000/frame.metersPerDegreeLatitude(), east = 1000/frame.metersPerDegreeLongitude();
+		EXPECT_NEAR(1000.0, frame.distance(latitudes[i], 10, latitudes[i] + north, 10), 1e-6);
+		EXPECT_NEAR(1000.0, frame.distance(latitudes[i], 10, latitudes[i], 10 + east), 1e-6);
+		EXPECT_NEAR(45.0, frame.angle(latitudes[i], 10, latitudes[i] + north, 10 + east), 1e-9);
+	}
+}
+
+TEST(localFrameTest, roundTrip)	{
+	au_uav_ros::LocalFrame frame(ORIGIN_LAT, ORIGIN_LON, 50);
+	au_uav_ros::coordinate anchor = frame.getAnchor();
+	au_uav_ros::localPosition origin = frame.toLocal(anchor);
+	EXPECT_EQ(0.0, origin.x);
+	EXPECT_EQ(0.0, origin.y);
+	EXPECT_EQ(0.0, origin.z);
+
+	srand(8);
+	for(int trial = 0; trial < 100; trial++)	{
+		au_uav_ros::localPosition local;
+		local.x = uniform(-5000, 5000);
+		local.y = uniform(-5000, 5000);
+		local.z = uniform(0, 200);
+		au_uav_ros::localPosition back = frame.toLocal(frame.toCoordinate(local));
+		EXPECT_NEAR(local.x, back.x, 1e-6);
+		EXPECT_NEAR(local.y, back.y, 1e-6);
+		EXPECT_NEAR(local.z, back.z, 1e-9);
+	}
+}
+
+}
+
+int main(int argc, char **argv)	{
+	ros::Time::init();
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
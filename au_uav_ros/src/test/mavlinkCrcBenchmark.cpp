@@ -0,0 +1,60 @@
+//Benchmark for the mavlink checksum.
+//Not a pass/fail test - run by hand on the target (rosrun au_uav_ros mavlink_crc_benchmark) and compare the table.
+//
+//Each crc is run over the same bytes in pieces of a few sizes:
+//	- 46 bytes, the header and payload of an AU_UAV frame, what checkFrame() does per frame
+//	- 256 bytes, about the largest frame
+//	- READ_BUFFER_SIZE bytes, a whole read buffer
+//and the MB/s of each is printed. crcAccumulate() is whichever of them CRC_SLICES picked.
+
+#include <time.h>
+#include <stdio.h>
+#include <vector>
+#include "mavlink/v1.0/common/mavlink.h"
+#include "au_uav_ros/mavlink_crc.h"
+#include "au_uav_ros/mavlink_frame.h"
+
+#define TOTAL_BYTES (64*1024*1024)	//per crc and piece size
+
+typedef uint16_t (*crcFunction)(const uint8_t *, int, uint16_t);
+
+double threadSeconds()	{
+	struct timespec t;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+	return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+double megabytesPerSecond(crcFunction crc, const std::vector<uint8_t> &bytes, int piece, uint16_t &sum)	{
+	int pieces = bytes.size()/piece;
+	double cpu = threadSeconds();
+	for(long done = 0; done < TOTAL_BYTES; done += pieces*piece)
+		for(int i = 0; i < pieces; i++)
+			sum ^= crc(&bytes[i*piece], piece, X25_INIT_CRC);
+	return TOTAL_BYTES/(threadSeconds() - cpu)/1e6;
+}
+
+int main(int argc, char **argv)	{
+	std::vector<uint8_t> bytes(64*1024);
+	uint32_t seed = 1;
+	for(unsigned int i = 0; i < bytes.size(); i++)	{
+		seed = seed*1103515245 + 12345;
+		bytes[i] = seed >> 16;
+	}
+
+	const char *names[] = {"crc_accumulate", "table", "slice-by-4", "slice-by-8", "crcAccumulate"};
+	crcFunction crcs[] = {au_uav_ros::mav::crcBytewise, au_uav_ros::mav::crcTable, au_uav_ros::mav::crcSlice4,
+			au_uav_ros::mav::crcSlice8, au_uav_ros::mav::crcAccumulate};
+	int pieces[] = {MAVLINK_NUM_HEADER_BYTES - 1 + MAVLINK_MSG_ID_AU_UAV_LEN, 256, READ_BUFFER_SIZE};
+
+	uint16_t sum = 0;
+	printf("X.25 crc, MB/s (CRC_SLICES %d)\n", CRC_SLICES);
+	printf("%-16s %12s %12s %12s\n", "crc", "46 B", "256 B", "4096 B");
+	for(int c = 0; c < 5; c++)	{
+		printf("%-16s", names[c]);
+		for(int p = 0; p < 3; p++)
+			printf(" %12.0f", megabytesPerSecond(crcs[c], bytes, pieces[p], sum));
+		printf("\n");
+	}
+	printf("(%04x)\n", sum);	//so none of it is optimized away
+	return 0;
+}
@@ -0,0 +1,112 @@
+//Tests the table and sliced crcs against checksum.h's crc_accumulate. Every starting crc is tried
+//with every byte value, in every place of a slice, and buffers of every length a frame can have.
+
+#include <stdint.h>
+#include <vector>
+#include <gtest/gtest.h>
+#include "mavlink/v1.0/common/mavlink.h"
+#include "au_uav_ros/mavlink_crc.h"
+#include "au_uav_ros/mavlink_frame.h"
+
+namespace	{
+
+typedef uint16_t (*crcFunction)(const uint8_t *, int, uint16_t);
+
+uint16_t reference(const uint8_t *bytes, int length, uint16_t crc)	{
+	for(int i = 0; i < length; i++)
+		crc_accumulate(bytes[i], &crc);
+	return crc;
+}
+
+//Filler that is not all zeros, so a table mixed up with another shows
+std::vector<uint8_t> noise(int length, uint32_t seed)	{
+	std::vector<uint8_t> bytes(length);
+	for(int i = 0; i < length; i++)	{
+		seed = seed*1103515245 + 12345;
+		bytes[i] = seed >> 16;
+	}
+	return bytes;
+}
+
+//All 2^16 starting crcs with all 256 values of byte (value % 8) of an 8 byte slice, so every entry
+//of every table is used from every crc
+void everyCrcEveryByte(crcFunction crc)	{
+	std::vector<uint8_t> block = noise(8, 7);
+	int wrong = 0;
+	for(int start = 0; start <= 0xFFFF; start++)	{
+		for(int value = 0; value < 256; value++)	{
+			uint8_t bytes[8];
+			for(int i = 0; i < 8; i++)
+				bytes[i] = block[i] ^ start;
+			bytes[value % 8] = value;
+			if(crc(bytes, 8, start) != reference(bytes, 8, start) || crc(bytes, 1, start) != reference(bytes, 1, start))
+				wrong++;
+		}
+	}
+	EXPECT_EQ(0, wrong);
+}
+
+//Every length up to a whole frame, starting at every alignment
+void everyLength(crcFunction crc)	{
+	std::vector<uint8_t> bytes = noise(MAVLINK_MAX_PACKET_LEN + 8, 11);
+	for(int offset = 0; offset < 8; offset++)
+		for(int length = 0; length <= MAVLINK_MAX_PACKET_LEN; length++)
+			ASSERT_EQ(reference(&bytes[offset], length, X25_INIT_CRC), crc(&bytes[offset], length, X25_INIT_CRC))
+				<< "offset " << offset << " length " << length;
+}
+
+TEST(mavlinkCrcTest, tableMatchesReference)	{
+	everyCrcEveryByte(au_uav_ros::mav::crcTable);
+	everyLength(au_uav_ros::mav::crcTable);
+}
+
+TEST(mavlinkCrcTest, slice4MatchesReference)	{
+	everyCrcEveryByte(au_uav_ros::mav::crcSlice4);
+	everyLength(au_uav_ros::mav::crcSlice4);
+}
+
+TEST(mavlinkCrcTest, slice8MatchesReference)	{
+	everyCrcEveryByte(au_uav_ros::mav::crcSlice8);
+	everyLength(au_uav_ros::mav::crcSlice8);
+}
+
+TEST(mavlinkCrcTest, selectedMatchesReference)	{
+	everyLength(au_uav_ros::mav::crcAccumulate);
+}
+
+//A buffer can be done in pieces, the way a frame is added to after its header
+TEST(mavlinkCrcTest, piecesMatchWhole)	{
+	std::vector<uint8_t> bytes = noise(200, 3);
+	uint16_t whole = au_uav_ros::mav::crcAccumulate(&bytes[0], bytes.size(), X25_INIT_CRC);
+	for(int split = 0; split <= 200; split++)	{
+		uint16_t crc = au_uav_ros::mav::crcAccumulate(&bytes[0], split, X25_INIT_CRC);
+		ASSERT_EQ(whole, au_uav_ros::mav::crcAccumulate(&bytes[split], 200 - split, crc));
+	}
+}
+
+//Frames packed by the generated code check out, and one flipped bit anywhere does not
+TEST(mavlinkCrcTest, checksPackedFrames)	{
+	mavlink_message_t message;
+	uint8_t frame[MAVLINK_MAX_PACKET_LEN];
+	mavlink_msg_au_uav_pack(5, 1, &message, 326065730, -854903560, 123456, 326070000, -854910000, 100000,
+			1300, 1400, 27000, 987, 42);
+	int length = mavlink_msg_to_send_buffer(frame, &message);
+	ASSERT_TRUE(au_uav_ros::mav::checkFrame(frame));
+	for(int i = 2; i < length; i++)	{		//the length byte would move the checksum
+		frame[i] ^= 0x10;
+		EXPECT_FALSE(au_uav_ros::mav::checkFrame(frame)) << "byte " << i;
+		frame[i] ^= 0x10;
+	}
+
+	mavlink_msg_mission_item_pack(1, 110, &message, 1, 0, 3, MAV_FRAME_GLOBAL, MAV_CMD_NAV_WAYPOINT,
+			2, 0, 20.0, 100.0, 1.0, 0.0, 32.6, -85.4, 100);
+	mavlink_msg_to_send_buffer(frame, &message);
+	EXPECT_TRUE(au_uav_ros::mav::checkFrame(frame));
+}
+
+}
+
+int main(int argc, char **argv)	{
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,265 @@
+//Tests FrameParser, FrameView and AuUavView against the messages that were packed and what the
+//generated _decode() functions make of them, and that reading frames through a MavlinkReader does
+//not touch the heap. operator new is replaced for the whole test binary, it only counts while
+//"counting" is set.
+
+#include <pty.h>
+#include <stdlib.h>
+#include <new>
+#include <vector>
+#include <gtest/gtest.h>
+#include <ros/ros.h>
+#include <boost/bind.hpp>
+#include "au_uav_ros/serial_talker.h"
+#include "au_uav_ros/mavlink_read.h"
+#include "au_uav_ros/mavlink_frame.h"
+
+#if __cplusplus >= 201103L
+#define NEW_THROWS
+#else
+#define NEW_THROWS throw(std::bad_alloc)
+#endif
+
+namespace	{
+bool counting = false;
+long allocations = 0;
+}
+
+void * operator new(std::size_t size) NEW_THROWS	{
+	if(counting)
+		allocations++;
+	void *p = malloc(size ? size : 1);
+	if(!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void * operator new[](std::size_t size) NEW_THROWS	{
+	return operator new(size);
+}
+
+void operator delete(void *p) throw()	{
+	free(p);
+}
+
+void operator delete[](void *p) throw()	{
+	free(p);
+}
+
+namespace	{
+
+struct line	{
+	int master;
+	SerialTalker serial;
+
+	line()	{
+		int slave;
+		char name[256];
+		master = -1;
+		if(openpty(&master, &slave, name, NULL, NULL) < 0)
+			return;
+		serial.open_port(name);
+		serial.setup_port(115200, 8, 1, true);
+		close(slave);
+	}
+	~line()	{
+		serial.close_port();
+		if(master >= 0)
+			close(master);
+	}
+};
+
+//A mix of the messages the talkers see, with line noise between some of them. sent gets the
+//messages as they were packed. Sequence numbers start from 0 each time, so the stream is the same
+//whichever tests ran before: once in a while the bytes after a false STX do check out, as they
+//would for mavlink_parse_char, and the frame they overlap is lost.
+std::vector<uint8_t> stream(int count, std::vector<mavlink_message_t> *sent = NULL)	{
+	mavlink_get_channel_status(MAVLINK_COMM_0)->current_tx_seq = 0;
+	std::vector<uint8_t> bytes;
+	uint8_t frame[MAVLINK_MAX_PACKET_LEN];
+	for(int i = 0; i < count; i++)	{
+		mavlink_message_t message;
+		if(i % 5 == 3)
+			mavlink_msg_mission_item_pack(i % 7, 1, &message, 1, 0, i, MAV_FRAME_GLOBAL, MAV_CMD_NAV_WAYPOINT,
+					2, 0, 20.0, 100.0, 1.0, 0.0, 32.6 + i*1e-5, -85.4, 100);
+		else if(i % 5 == 4)
+			mavlink_msg_heartbeat_pack(i % 7, 1, &message, MAV_TYPE_FIXED_WING, MAV_AUTOPILOT_ARDUPILOTMEGA, 0, i, 0);
+		else
+			mavlink_msg_au_uav_pack(i % 7, 1, &message, 326000000 + i, -854000000 - i, 100*i, 1, 2, 3,
+					13*i, 14, 90000 - i, i, (uint8_t)i);
+		if(sent != NULL)
+			sent->push_back(message);
+		int length = mavlink_msg_to_send_buffer(frame, &message);
+		bytes.insert(bytes.end(), frame, frame + length);
+		if(i % 9 == 0)	{
+			//noise, with an STX in it that does not start a frame
+			const uint8_t noise[] = {'n', MAVLINK_STX, 3, 'i', 's', 'e', '\r', '\n'};
+			bytes.insert(bytes.end(), noise, noise + sizeof(noise));
+		}
+	}
+	return bytes;
+}
+
+//Fed in uneven pieces, every frame comes out as it was packed, including the ones that wrap
+//around the end of the buffer. mavlink_parse_char loses the frame after each bit of noise here,
+//the false STX swallows its first bytes.
+TEST(mavlinkFrameTest, findsEveryFrame)	{
+	std::vector<mavlink_message_t> sent;
+	std::vector<uint8_t> bytes = stream(2000, &sent);
+
+	au_uav_ros::mav::FrameParser parser;
+	au_uav_ros::mav::FrameView frame;
+	unsigned int fed = 0, found = 0;
+	int piece = 1;
+	while(true)	{
+		if(parser.next(frame))	{
+			ASSERT_LT(found, sent.size());
+			const mavlink_message_t &want = sent[found];
+			EXPECT_EQ(want.msgid, frame.msgid());
+			EXPECT_EQ(want.sysid, frame.sysid());
+			EXPECT_EQ(want.seq, frame.sequence());
+			EXPECT_EQ(want.len, frame.length());
+			const uint8_t *ck = (const uint8_t *)_MAV_PAYLOAD(&want) + want.len;	//pack leaves it after the payload
+			EXPECT_EQ(ck[0] | ck[1] << 8, frame.checksum());
+			mavlink_message_t copied;
+			frame.toMessage(copied);
+			EXPECT_EQ(0, memcmp(_MAV_PAYLOAD(&want), _MAV_PAYLOAD(&copied), want.len + MAVLINK_NUM_CHECKSUM_BYTES));
+			found++;
+			continue;
+		}
+		if(fed == bytes.size())
+			break;
+		int length = std::min(piece, (int)(bytes.size() - fed));
+		fed += parser.append(&bytes[fed], length);
+		piece = piece*7 % 997 + 1;
+	}
+	EXPECT_EQ(sent.size(), found);
+	EXPECT_GT(parser.getFramesCopied(), 0);		//some did wrap
+	EXPECT_LT(parser.getFramesCopied(), (long)found/10);
+}
+
+//A frame with a bad checksum is skipped, and the frame after it is still found
+TEST(mavlinkFrameTest, badChecksumSkipped)	{
+	std::vector<uint8_t> bytes = stream(2);
+	bytes[10] ^= 0x40;	//in the first frame's payload
+	au_uav_ros::mav::FrameParser parser;
+	parser.append(&bytes[0], bytes.size());
+	au_uav_ros::mav::FrameView frame;
+	ASSERT_TRUE(parser.next(frame));
+	EXPECT_EQ(1, frame.sysid());
+	EXPECT_FALSE(parser.next(frame));
+	EXPECT_GE(parser.getChecksumErrors(), 1);
+}
+
+TEST(mavlinkFrameTest, auUavFieldsMatchDecode)	{
+	mavlink_message_t message;
+	mavlink_msg_au_uav_pack(5, 1, &message, 326065730, -854903560, 123456, 326070000, -854910000, 100000,
+			1300, 1400, 27000, 987, 42);
+	uint8_t bytes[MAVLINK_MAX_PACKET_LEN];
+	mavlink_msg_to_send_buffer(bytes, &message);
+	mavlink_au_uav_t decoded;
+	mavlink_msg_au_uav_decode(&message, &decoded);
+
+	au_uav_ros::mav::FrameView frame(bytes);
+	ASSERT_TRUE(au_uav_ros::mav::checkFrame(bytes));
+	au_uav_ros::mav::AuUavView view(frame);
+	ASSERT_TRUE(view.valid());
+	EXPECT_EQ(decoded.au_lat, view.lat());
+	EXPECT_EQ(decoded.au_lng, view.lng());
+	EXPECT_EQ(decoded.au_alt, view.alt());
+	EXPECT_EQ(decoded.au_target_lat, view.targetLat());
+	EXPECT_EQ(decoded.au_target_lng, view.targetLng());
+	EXPECT_EQ(decoded.au_target_alt, view.targetAlt());
+	EXPECT_EQ(decoded.au_ground_speed, view.groundSpeed());
+	EXPECT_EQ(decoded.au_airspeed, view.airspeed());
+	EXPECT_EQ(decoded.au_target_bearing, view.targetBearing());
+	EXPECT_EQ(decoded.au_distance, view.distance());
+	EXPECT_EQ(decoded.au_target_wp_index, view.targetWPIndex());
+
+	au_uav_ros::Telemetry fromStruct, fromView;
+	au_uav_ros::mav::convertMavlinkTelemetryToROS(decoded, fromStruct);
+	au_uav_ros::mav::convertMavlinkTelemetryToROS(view, fromView);
+	EXPECT_EQ(fromStruct.currentLatitude, fromView.currentLatitude);
+	EXPECT_EQ(fromStruct.currentLongitude, fromView.currentLongitude);
+	EXPECT_EQ(fromStruct.destAltitude, fromView.destAltitude);
+	EXPECT_EQ(fromStruct.targetBearing, fromView.targetBearing);
+}
+
+//A frame passed on with a new sequence number still checks out and carries the same payload
+TEST(mavlinkFrameTest, restampKeepsPayload)	{
+	mavlink_message_t message;
+	mavlink_msg_au_uav_pack(5, 1, &message, 326065730, -854903560, 123456, 326070000, -854910000, 100000,
+			1300, 1400, 27000, 987, 42);
+	uint8_t bytes[MAVLINK_MAX_PACKET_LEN], restamped[MAVLINK_MAX_PACKET_LEN];
+	int length = mavlink_msg_to_send_buffer(bytes, &message);
+	memcpy(restamped, bytes, length);
+	au_uav_ros::mav::restampFrame(restamped, message.seq + 17);
+
+	ASSERT_TRUE(au_uav_ros::mav::checkFrame(restamped));
+	au_uav_ros::mav::FrameView before(bytes), after(restamped);
+	EXPECT_EQ((uint8_t)(message.seq + 17), after.sequence());
+	EXPECT_EQ(before.sysid(), after.sysid());
+	EXPECT_EQ(before.msgid(), after.msgid());
+	EXPECT_EQ(0, memcmp(before.payload(), after.payload(), before.length()));
+	EXPECT_NE(before.checksum(), after.checksum());
+}
+
+struct tally	{
+	long telemetry, other;
+	int32_t latitudes;
+
+	tally() : telemetry(0), other(0), latitudes(0) {}
+	void onTelemetry(const au_uav_ros::mav::FrameView &frame)	{
+		au_uav_ros::mav::AuUavView view(frame);
+		telemetry++;
+		latitudes += view.lat();
+	}
+	void onOther(const au_uav_ros::mav::FrameView &)	{
+		other++;
+	}
+};
+
+//Once running, reading and dispatching frames off a line allocates nothing
+TEST(mavlinkFrameTest, readingFramesDoesNotAllocate)	{
+	line pty;
+	ASSERT_GE(pty.master, 0);
+	au_uav_ros::mav::MavlinkReader reader(pty.serial);
+	tally got;
+	au_uav_ros::mav::FrameDispatcher dispatcher;
+	dispatcher.on(MAVLINK_MSG_ID_AU_UAV, boost::bind(&tally::onTelemetry, &got, _1));
+	dispatcher.on(MAVLINK_MSG_ID_MISSION_ITEM, boost::bind(&tally::onOther, &got, _1));
+	dispatcher.on(MAVLINK_MSG_ID_HEARTBEAT, boost::bind(&tally::onOther, &got, _1));
+
+	std::vector<uint8_t> bytes = stream(3000);
+	unsigned int written = 0;
+	long found = 0;
+	int quietReads = 0;		//in a row, once everything is written
+	counting = true;
+	while(found < 3000 && quietReads < 10)	{
+		if(written < bytes.size())	{
+			int num = write(pty.master, &bytes[written], std::min(1024, (int)(bytes.size() - written)));
+			if(num > 0)
+				written += num;
+		}
+		int num = reader.readFrames(dispatcher, 100);
+		if(num < 0)
+			break;
+		quietReads = (num == 0 && written == bytes.size()) ? quietReads + 1 : 0;
+		found += num;
+	}
+	counting = false;
+
+	EXPECT_EQ(3000, found);
+	EXPECT_EQ(1800, got.telemetry);
+	EXPECT_EQ(1200, got.other);
+	EXPECT_EQ(0, allocations);
+	EXPECT_LE(reader.getFramesCopied(), found);		//a frame is copied at most once
+}
+
+}
+
+int main(int argc, char **argv)	{
+	ros::Time::init();
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
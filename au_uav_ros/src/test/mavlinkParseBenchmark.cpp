@@ -0,0 +1,103 @@
+//Benchmark for turning bytes read off a line into telemetry.
+//Not a pass/fail test - run by hand on the target (rosrun au_uav_ros mavlink_parse_benchmark) and compare the table.
+//
+//FRAMES AU_UAV frames are parsed from memory PASSES times, handed over READ_SIZE bytes at a time the
+//way reads come off a busy line, so the numbers are the parsing alone, without the line.
+//	- parse_char: mavlink_parse_char per byte, then mavlink_msg_au_uav_decode, as the talkers did
+//	- frame + copy: FrameParser, FrameView::toMessage and then the decode, as readMessages() does
+//	- frame view: FrameParser and AuUavView, fields read off the frame, as the talkers do now
+//Each one ends in convertMavlinkTelemetryToROS, and the telemetry is summed so nothing is skipped.
+
+#include <time.h>
+#include <stdio.h>
+#include <vector>
+#include <ros/ros.h>
+#include "au_uav_ros/mavlink_read.h"
+#include "au_uav_ros/mavlink_frame.h"
+
+#define FRAMES 20000
+#define PASSES 20
+#define READ_SIZE 1024		//bytes handed over at a time
+
+enum parser { PARSE_CHAR, FRAME_COPY, FRAME_VIEW };
+
+double threadSeconds()	{
+	struct timespec t;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+	return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+std::vector<uint8_t> telemetryStream()	{
+	std::vector<uint8_t> bytes;
+	uint8_t frame[MAVLINK_MAX_PACKET_LEN];
+	for(int i = 0; i < FRAMES; i++)	{
+		mavlink_message_t message;
+		mavlink_msg_au_uav_pack(i % 16, 1, &message, 326065730 + i, -854903560 - i, 100000, 326070000, -854910000,
+				100000, 1300, 1400, 27000, 987, (uint8_t)i);
+		int length = mavlink_msg_to_send_buffer(frame, &message);
+		bytes.insert(bytes.end(), frame, frame + length);
+	}
+	return bytes;
+}
+
+//Returns the sum of the latitudes, so the work is not optimized away
+double parseAll(parser how, const std::vector<uint8_t> &bytes, long &parsed)	{
+	double sum = 0;
+	au_uav_ros::Telemetry tUpdate;
+	mavlink_message_t message;
+	mavlink_au_uav_t decoded;
+	mavlink_status_t status;
+	au_uav_ros::mav::FrameParser frames;
+	au_uav_ros::mav::FrameView frame;
+	for(unsigned int at = 0; at < bytes.size(); at += READ_SIZE)	{
+		int length = bytes.size() - at < READ_SIZE ? bytes.size() - at : READ_SIZE;
+		if(how == PARSE_CHAR)	{
+			for(int i = 0; i < length; i++)	{
+				if(mavlink_parse_char(MAVLINK_COMM_2, bytes[at + i], &message, &status))	{
+					mavlink_msg_au_uav_decode(&message, &decoded);
+					au_uav_ros::mav::convertMavlinkTelemetryToROS(decoded, tUpdate);
+					sum += tUpdate.currentLatitude;
+					parsed++;
+				}
+			}
+			continue;
+		}
+		frames.append(&bytes[at], length);
+		while(frames.next(frame))	{
+			if(how == FRAME_COPY)	{
+				frame.toMessage(message);
+				mavlink_msg_au_uav_decode(&message, &decoded);
+				au_uav_ros::mav::convertMavlinkTelemetryToROS(decoded, tUpdate);
+			}
+			else
+				au_uav_ros::mav::convertMavlinkTelemetryToROS(au_uav_ros::mav::AuUavView(frame), tUpdate);
+			sum += tUpdate.currentLatitude;
+			parsed++;
+		}
+	}
+	return sum;
+}
+
+void measure(parser how, const char *name, const std::vector<uint8_t> &bytes)	{
+	long parsed = 0;
+	double sum = 0;
+	double cpu = threadSeconds();
+	for(int pass = 0; pass < PASSES; pass++)
+		sum += parseAll(how, bytes, parsed);
+	double seconds = threadSeconds() - cpu;
+	printf("%-16s %14.0f %10.1f %14.1f %10ld %s\n", name, parsed/seconds, bytes.size()*PASSES/seconds/1e6,
+			seconds/parsed*1e9, (long)FRAMES*PASSES - parsed, sum == 0 ? "(?)" : "");
+}
+
+int main(int argc, char **argv)	{
+	ros::Time::init();
+	std::vector<uint8_t> bytes = telemetryStream();
+
+	printf("Parsing AU_UAV telemetry (%d frames, %lu bytes, %d passes, %d bytes at a time)\n", FRAMES,
+			(unsigned long)bytes.size(), PASSES, READ_SIZE);
+	printf("%-16s %14s %10s %14s %10s\n", "parser", "frames/s", "MB/s", "ns/frame", "missed");
+	measure(PARSE_CHAR, "parse_char", bytes);
+	measure(FRAME_COPY, "frame + copy", bytes);
+	measure(FRAME_VIEW, "frame view", bytes);
+	return 0;
+}
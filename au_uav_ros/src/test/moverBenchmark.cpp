@@ -0,0 +1,167 @@
+//Benchmark for how the mover waits for something to publish.
+//Not a pass/fail test - run by hand on the target (rosrun au_uav_ros mover_benchmark) and compare the table.
+//
+//The mover's thread is run on its own, with the callbacks played by the benchmark's thread and
+//publishing to ca_commands reduced to taking the newest CA command. Each way of moving is run for
+//IDLE_SECONDS in ST_RED and IDLE_SECONDS in ST_GREEN_CA_ON with no telemetry, for its idle CPU, then
+//for TELEMETRY_SECONDS with a CA command from all_telem_callback every TELEMETRY_GAP, for the time
+//from each callback to the next publish (of that command, or of a newer one that replaced it). The
+//commands replaced before they went out are counted as dropped.
+//	- busy loop: move() before MoverSchedule, spinning in ST_RED and sleeping 0.25 s before each publish
+//	- schedule: MoverSchedule, the way move() waits now
+//	- no interval: MoverSchedule with min_command_interval 0, every command goes out
+
+#include <time.h>
+#include <stdio.h>
+#include <vector>
+#include <algorithm>
+#include <ros/ros.h>
+#include <boost/thread.hpp>
+#include "au_uav_ros/mover_schedule.h"
+
+#define IDLE_SECONDS 2.0
+#define TELEMETRY_SECONDS 5.0
+#define TELEMETRY_GAP 0.031		//seconds, 32 planes at 1 Hz
+#define BUSY_LOOP_SLEEP 0.25	//what move() slept before each publish
+
+enum mover { BUSY_LOOP, SCHEDULE, SCHEDULE_NO_INTERVAL };
+
+double wallSeconds()	{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+double processSeconds()	{
+	struct timespec t;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t);
+	return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+//What Mover keeps between its callbacks and move()
+struct fakeMover	{
+	boost::mutex lock;
+	volatile bool running;
+	au_uav_ros::moverState state;		//the busy loop's, MoverSchedule keeps its own
+	bool haveCommand;
+	std::vector<double> waiting;		//when the commands not published yet came in
+	long published, dropped;
+	std::vector<double> latency;
+	au_uav_ros::MoverSchedule schedule;
+
+	fakeMover() : running(true), state(au_uav_ros::ST_RED), haveCommand(false), published(0), dropped(0) {}
+
+	void setState(au_uav_ros::moverState s)	{
+		boost::mutex::scoped_lock guard(lock);
+		state = s;
+		schedule.setState(s);
+	}
+
+	//all_telem_callback
+	void command(mover how)	{
+		{
+			boost::mutex::scoped_lock guard(lock);
+			if(haveCommand)
+				dropped++;
+			haveCommand = true;
+			waiting.push_back(wallSeconds());
+		}
+		if(how != BUSY_LOOP)
+			schedule.commandReady();
+	}
+
+	//caCommandPublish
+	void publish()	{
+		boost::mutex::scoped_lock guard(lock);
+		double now = wallSeconds();
+		for(unsigned int i = 0; i < waiting.size(); i++)
+			latency.push_back(now - waiting[i]);
+		waiting.clear();
+		haveCommand = false;
+		published++;
+	}
+};
+
+void busyLoop(fakeMover *m)	{
+	while(m->running)	{
+		au_uav_ros::moverState s;
+		{
+			boost::mutex::scoped_lock guard(m->lock);
+			s = m->state;
+		}
+		if(s != au_uav_ros::ST_RED)	{
+			ros::WallDuration(BUSY_LOOP_SLEEP).sleep();
+			m->publish();
+		}
+	}
+}
+
+void scheduled(fakeMover *m)	{
+	while(m->running)	{
+		au_uav_ros::moverState s;
+		au_uav_ros::MoverSchedule::wakeReason why = m->schedule.wait(s, MOVER_SHUTDOWN_CHECK);
+		if(why == au_uav_ros::MoverSchedule::WAKE_COMMAND || why == au_uav_ros::MoverSchedule::WAKE_DEADLINE)
+			m->publish();
+	}
+}
+
+//the benchmark's own thread is asleep, so the process's CPU is the mover's
+double idleCPU(double seconds)	{
+	double wall = wallSeconds(), cpu = processSeconds();
+	ros::WallDuration(seconds).sleep();
+	return (processSeconds() - cpu)/(wallSeconds() - wall);
+}
+
+void measure(mover how, const char *name)	{
+	fakeMover m;
+	if(how == SCHEDULE_NO_INTERVAL)
+		m.schedule.setMinCommandInterval(0);
+	boost::thread thread(how == BUSY_LOOP ? busyLoop : scheduled, &m);
+
+	double red = idleCPU(IDLE_SECONDS);
+	m.setState(au_uav_ros::ST_GREEN_CA_ON);
+	double green = idleCPU(IDLE_SECONDS);
+
+	{
+		boost::mutex::scoped_lock guard(m.lock);
+		m.published = 0;
+		m.dropped = 0;
+		m.latency.clear();
+	}
+	double start = wallSeconds();
+	long commands = 0;
+	while(wallSeconds() - start < TELEMETRY_SECONDS)	{
+		m.command(how);
+		commands++;
+		ros::WallDuration(TELEMETRY_GAP).sleep();
+	}
+	double seconds = wallSeconds() - start;
+
+	m.running = false;
+	m.setState(au_uav_ros::ST_RED);		//the busy loop stops sleeping
+	thread.join();
+
+	//sorted by hand, LatencyRecorder only has bins up to 100 ms
+	boost::mutex::scoped_lock guard(m.lock);
+	std::vector<double> &latency = m.latency;
+	std::sort(latency.begin(), latency.end());
+	if(latency.empty())
+		latency.push_back(0);
+	int n = latency.size();
+	printf("%-12s %10.2f%% %10.2f%% %10.2f %10.2f %10.2f %12.1f %8.1f%%\n", name, red*100, green*100,
+			latency[(n - 1)/2]*1e3, latency[(int)(0.99*(n - 1))]*1e3, latency[n - 1]*1e3, m.published/seconds,
+			100.0*m.dropped/commands);
+}
+
+int main(int argc, char **argv)	{
+	ros::Time::init();
+
+	printf("Mover waiting to publish (%.0f s idle in each state, then a CA command every %.0f ms for %.0f s)\n",
+			IDLE_SECONDS, TELEMETRY_GAP*1e3, TELEMETRY_SECONDS);
+	printf("%-12s %11s %11s %10s %10s %10s %12s %9s\n", "mover", "red CPU", "green CPU", "p50 ms", "p99 ms", "max ms",
+			"published/s", "dropped");
+	measure(BUSY_LOOP, "busy loop");
+	measure(SCHEDULE, "schedule");
+	measure(SCHEDULE_NO_INTERVAL, "no interval");
+	return 0;
+}
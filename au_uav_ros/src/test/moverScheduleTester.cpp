@@ -0,0 +1,134 @@
+//Tests MoverSchedule: what wakes the mover in each state and when, with the callbacks played by a
+//second thread. Idle CPU and command latency against the old move() loop are measured by
+//src/test/moverBenchmark.cpp, not here.
+
+#include <time.h>
+#include <gtest/gtest.h>
+#include <boost/thread.hpp>
+#include "au_uav_ros/mover_schedule.h"
+
+namespace	{
+
+#define SLACK 0.05		//seconds a wakeup may be late on a loaded machine
+
+double wallSeconds()	{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+void sleepSeconds(double seconds)	{
+	boost::this_thread::sleep(boost::posix_time::microseconds((long)(seconds*1e6)));
+}
+
+void setStateLater(au_uav_ros::MoverSchedule *schedule, au_uav_ros::moverState s, double seconds)	{
+	sleepSeconds(seconds);
+	schedule->setState(s);
+}
+
+void commandLater(au_uav_ros::MoverSchedule *schedule, double seconds)	{
+	sleepSeconds(seconds);
+	schedule->commandReady();
+}
+
+}
+
+TEST(MoverSchedule, redSleepsThroughCommands)	{
+	au_uav_ros::MoverSchedule schedule(0.1, 0);
+	au_uav_ros::moverState s;
+	schedule.commandReady();
+	double start = wallSeconds();
+	EXPECT_EQ(au_uav_ros::MoverSchedule::WAKE_TIMEOUT, schedule.wait(s, 0.2));
+	EXPECT_GE(wallSeconds() - start, 0.2 - 0.001);
+	EXPECT_EQ(au_uav_ros::ST_RED, s);
+	EXPECT_EQ(1, schedule.getWakeups());
+}
+
+TEST(MoverSchedule, stateChangeWakesRed)	{
+	au_uav_ros::MoverSchedule schedule;
+	au_uav_ros::moverState s;
+	boost::thread gcs(setStateLater, &schedule, au_uav_ros::ST_GREEN_CA_ON, 0.05);
+	double start = wallSeconds();
+	EXPECT_EQ(au_uav_ros::MoverSchedule::WAKE_STATE, schedule.wait(s, 5));
+	EXPECT_LT(wallSeconds() - start, 0.05 + SLACK);
+	EXPECT_EQ(au_uav_ros::ST_GREEN_CA_ON, s);
+	gcs.join();
+
+	//nothing published yet, so the first command is due right away
+	EXPECT_EQ(au_uav_ros::MoverSchedule::WAKE_DEADLINE, schedule.wait(s, 5));
+	EXPECT_LT(wallSeconds() - start, 0.05 + SLACK);
+}
+
+TEST(MoverSchedule, greenPublishesEveryPeriodWithNothingNew)	{
+	au_uav_ros::MoverSchedule schedule(0.1, 0);
+	au_uav_ros::moverState s;
+	schedule.setState(au_uav_ros::ST_GREEN_CA_OFF);
+	EXPECT_EQ(au_uav_ros::MoverSchedule::WAKE_STATE, schedule.wait(s, 1));
+	EXPECT_EQ(au_uav_ros::MoverSchedule::WAKE_DEADLINE, schedule.wait(s, 1));
+	double start = wallSeconds();
+	for(int i = 0; i < 3; i++)	{
+		EXPECT_EQ(au_uav_ros::MoverSchedule::WAKE_DEADLINE, schedule.wait(s, 1));
+		EXPECT_EQ(au_uav_ros::ST_GREEN_CA_OFF, s);
+	}
+	EXPECT_NEAR(0.3, wallSeconds() - start, SLACK);
+}
+
+TEST(MoverSchedule, commandWakesGreenRightAway)	{
+	au_uav_ros::MoverSchedule schedule(1, 0);
+	au_uav_ros::moverState s;
+	schedule.setState(au_uav_ros::ST_GREEN_CA_ON);
+	schedule.wait(s, 1);
+	EXPECT_EQ(au_uav_ros::MoverSchedule::WAKE_DEADLINE, schedule.wait(s, 1));
+
+	boost::thread telemetry(commandLater, &schedule, 0.05);
+	double start = wallSeconds();
+	EXPECT_EQ(au_uav_ros::MoverSchedule::WAKE_COMMAND, schedule.wait(s, 1));
+	EXPECT_NEAR(0.05, wallSeconds() - start, SLACK);
+	telemetry.join();
+}
+
+TEST(MoverSchedule, commandsKeepTheMinimumInterval)	{
+	au_uav_ros::MoverSchedule schedule(1, 0.1);
+	au_uav_ros::moverState s;
+	schedule.setState(au_uav_ros::ST_GREEN_CA_ON);
+	schedule.wait(s, 1);
+	EXPECT_EQ(au_uav_ros::MoverSchedule::WAKE_DEADLINE, schedule.wait(s, 1));
+
+	//ready right after one went out, held back until the interval is up
+	double start = wallSeconds();
+	schedule.commandReady();
+	schedule.commandReady();
+	EXPECT_EQ(au_uav_ros::MoverSchedule::WAKE_COMMAND, schedule.wait(s, 1));
+	EXPECT_GE(wallSeconds() - start, 0.1 - 0.001);
+	EXPECT_LT(wallSeconds() - start, 0.1 + SLACK);
+
+	//both were one wakeup, the next is the deadline
+	EXPECT_EQ(au_uav_ros::MoverSchedule::WAKE_DEADLINE, schedule.wait(s, 2));
+}
+
+TEST(MoverSchedule, stopDropsWhatWasReady)	{
+	au_uav_ros::MoverSchedule schedule(1, 1);
+	au_uav_ros::moverState s;
+	schedule.setState(au_uav_ros::ST_GREEN_CA_ON);
+	schedule.wait(s, 1);
+	schedule.wait(s, 1);
+	schedule.commandReady();
+	schedule.setState(au_uav_ros::ST_RED);
+	EXPECT_EQ(au_uav_ros::MoverSchedule::WAKE_STATE, schedule.wait(s, 1));
+	EXPECT_EQ(au_uav_ros::ST_RED, s);
+	EXPECT_EQ(au_uav_ros::MoverSchedule::WAKE_TIMEOUT, schedule.wait(s, 0.1));
+}
+
+TEST(MoverSchedule, getStateFollowsSetState)	{
+	au_uav_ros::MoverSchedule schedule;
+	EXPECT_EQ(au_uav_ros::ST_RED, schedule.getState());
+	schedule.setState(au_uav_ros::ST_GREEN_CA_OFF);
+	EXPECT_EQ(au_uav_ros::ST_GREEN_CA_OFF, schedule.getState());
+	schedule.setState(au_uav_ros::ST_GREEN_CA_ON);
+	EXPECT_EQ(au_uav_ros::ST_GREEN_CA_ON, schedule.getState());
+}
+
+int main(int argc, char **argv)	{
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
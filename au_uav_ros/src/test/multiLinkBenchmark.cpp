@@ -0,0 +1,151 @@
+//Benchmark for reading three links in one process against one process per link.
+//Not a pass/fail test - run by hand on the target (rosrun au_uav_ros multi_link_benchmark) and compare the table.
+//
+//Three ptys stand in for the autopilot, the XBee and a GCS port. The parent pushes FRAMES AU_UAV
+//frames down each one as fast as the ptys take them, and forked readers parse and dispatch them:
+//	- three processes: a reader process per link, each with its own EventLoop, as ardu, xbee and gcs run
+//	- one process: a single reader process with all three links in one EventLoop
+//The wall time until every frame has been dispatched, the CPU time and the context switches of the
+//readers are printed. Readers that have not got everything after TIMEOUT_SECONDS give up.
+
+#include <pty.h>
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <vector>
+#include <ros/ros.h>
+#include <boost/thread.hpp>
+#include "au_uav_ros/serial_talker.h"
+#include "au_uav_ros/event_loop.h"
+
+#define LINKS 3
+#define FRAMES 100000		//per link
+#define WRITE_SIZE 4096
+#define TIMEOUT_SECONDS 60
+
+struct line	{
+	int master;
+	SerialTalker serial;
+
+	line()	{
+		int slave;
+		char name[256];
+		master = -1;
+		if(openpty(&master, &slave, name, NULL, NULL) < 0)
+			return;
+		serial.open_port(name);
+		serial.setup_port(115200, 8, 1, true);
+		close(slave);
+	}
+	~line()	{
+		serial.close_port();
+		if(master >= 0)
+			close(master);
+	}
+};
+
+double wallSeconds()	{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+struct counter	{
+	long frames;
+
+	counter() : frames(0) {}
+	void onTelemetry(const au_uav_ros::mav::FrameView &frame)	{
+		if(au_uav_ros::mav::AuUavView(frame).valid())
+			frames++;
+	}
+};
+
+//Runs in the forked reader, with the lines from first to last in one loop
+void readLines(line *lines, int first, int last)	{
+	int count = last - first;
+	std::vector<au_uav_ros::mav::MavlinkReader *> readers;
+	std::vector<au_uav_ros::mav::FrameDispatcher> dispatchers(count);
+	std::vector<counter> got(count);
+	au_uav_ros::EventLoop loop;
+	for(int i = 0; i < count; i++)	{
+		readers.push_back(new au_uav_ros::mav::MavlinkReader(lines[first + i].serial));
+		dispatchers[i].on(MAVLINK_MSG_ID_AU_UAV, boost::bind(&counter::onTelemetry, &got[i], _1));
+		loop.addSerial(*readers[i], dispatchers[i]);
+	}
+	double giveUp = wallSeconds() + TIMEOUT_SECONDS;
+	while(loop.getMessagesDispatched() < (long)count*FRAMES && wallSeconds() < giveUp)
+		loop.runOnce(100);
+	_exit(loop.getMessagesDispatched() == (long)count*FRAMES ? 0 : 1);
+}
+
+void writeLine(line *to, const std::vector<uint8_t> *bytes)	{
+	for(unsigned int at = 0; at < bytes->size(); )	{
+		int num = write(to->master, &(*bytes)[at], std::min(WRITE_SIZE, (int)(bytes->size() - at)));
+		if(num > 0)
+			at += num;
+	}
+}
+
+void measure(bool oneProcess, const char *name, const std::vector<uint8_t> &bytes)	{
+	line lines[LINKS];
+	for(int i = 0; i < LINKS; i++)
+		if(lines[i].master < 0)	{
+			printf("%-16s could not open a pty\n", name);
+			return;
+		}
+
+	struct rusage before, after;
+	getrusage(RUSAGE_CHILDREN, &before);
+	double start = wallSeconds();
+	std::vector<pid_t> readers;
+	for(int i = 0; i < (oneProcess ? 1 : LINKS); i++)	{
+		pid_t pid = fork();
+		if(pid == 0)	{
+			if(oneProcess)
+				readLines(lines, 0, LINKS);
+			else
+				readLines(lines, i, i + 1);
+		}
+		readers.push_back(pid);
+	}
+
+	boost::thread_group writers;
+	for(int i = 0; i < LINKS; i++)
+		writers.create_thread(boost::bind(writeLine, &lines[i], &bytes));
+	writers.join_all();
+	bool complete = true;
+	for(unsigned int i = 0; i < readers.size(); i++)	{
+		int status;
+		waitpid(readers[i], &status, 0);
+		complete = complete && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+	}
+	double seconds = wallSeconds() - start;
+	getrusage(RUSAGE_CHILDREN, &after);
+
+	double cpu = (after.ru_utime.tv_sec - before.ru_utime.tv_sec) + (after.ru_utime.tv_usec - before.ru_utime.tv_usec)*1e-6 +
+			(after.ru_stime.tv_sec - before.ru_stime.tv_sec) + (after.ru_stime.tv_usec - before.ru_stime.tv_usec)*1e-6;
+	long switches = (after.ru_nvcsw - before.ru_nvcsw) + (after.ru_nivcsw - before.ru_nivcsw);
+	printf("%-16s %10d %12.0f %10.3f %12.2f %12ld %s\n", name, (int)readers.size(), LINKS*FRAMES/seconds, cpu,
+			cpu/(LINKS*FRAMES)*1e6, switches, complete ? "" : "(frames missing)");
+}
+
+int main(int argc, char **argv)	{
+	ros::Time::init();
+	std::vector<uint8_t> bytes;
+	uint8_t frame[MAVLINK_MAX_PACKET_LEN];
+	for(int i = 0; i < FRAMES; i++)	{
+		mavlink_message_t message;
+		mavlink_msg_au_uav_pack(1 + i % 3, 1, &message, 326065730 + i, -854903560, 100000, 326070000, -854910000,
+				100000, 1300, 1400, 27000, 987, (uint8_t)i);
+		int length = mavlink_msg_to_send_buffer(frame, &message);
+		bytes.insert(bytes.end(), frame, frame + length);
+	}
+
+	printf("Reading %d links (%d AU_UAV frames, %lu bytes each, over ptys)\n", LINKS, FRAMES, (unsigned long)bytes.size());
+	printf("%-16s %10s %12s %10s %12s %12s\n", "readers", "processes", "frames/s", "cpu s", "cpu us/frame", "ctx switches");
+	measure(false, "three processes", bytes);
+	measure(true, "one process", bytes);
+	return 0;
+}
@@ -0,0 +1,244 @@
+//Benchmark for launch/PiDeCAF.launch (ardu, xbee and mover as three nodes) against launch/PiDeCAF_nodelets.launch
+//(the same three in one nodelet manager): how long the autopilot's telemetry takes to come back to it as a
+//command, and the CPU the launched processes take meanwhile.
+//Not a pass/fail test - needs a roscore and the package built, run by hand on the target
+//(rosrun au_uav_ros nodelet_benchmark) and compare the table.
+//
+//Ptys stand in for the autopilot and the XBee, each launch file is started on them with roslaunch
+//(ardu_port:= and xbee_port:=). The benchmark is the autopilot: it writes AU_UAV telemetry frames as plane
+//PLANE, puts the mover in collision avoidance mode over gcs_commands, and times each telemetry frame to the
+//MISSION_ITEM ardu writes back for it, the whole path through ardu, all_telemetry, the mover's avoid(),
+//ca_commands and ardu again. One frame is out at a time, sent at each of RATES for RUN_SECONDS; a frame with
+//no command after ANSWER_TIMEOUT counts as lost. The XBee stays quiet, no other planes.
+//So that every telemetry frame is answered, the mover's shape_commands is set false, min_command_interval 0
+//and publish_period to a keepalive that never comes, on the parameter server before each launch.
+//"cpu %" is user+system time of every process roslaunch started, from /proc/<pid>/stat, per wall second.
+
+#include <pty.h>
+#include <poll.h>
+#include <time.h>
+#include <stdio.h>
+#include <string.h>
+#include <dirent.h>
+#include <signal.h>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/wait.h>
+#include <ros/ros.h>
+#include <au_uav_ros/Command.h>
+#include "au_uav_ros/pi_standard_defs.h"
+#include "au_uav_ros/LatencyRecorder.h"
+#include "mavlink/v1.0/common/mavlink.h"
+
+#define RUN_SECONDS 10.0
+#define ANSWER_TIMEOUT 0.5		//seconds for a command to come back before the frame counts as lost
+#define START_TIMEOUT 30.0		//seconds for the launch to answer its first telemetry frame
+#define START_RETRY 0.2			//seconds between telemetry frames and gcs commands while starting
+#define KEEPALIVE_PERIOD 3600.0	//the mover's publish_period, no commands but the answers
+#define PLANE 7
+
+const double RATES[] = {10, 50};		//telemetry frames/second
+const char *LAUNCHES[] = {"PiDeCAF.launch", "PiDeCAF_nodelets.launch"};
+
+double wallSeconds()	{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+void sleepUntil(double when)	{
+	double rest = when - wallSeconds();
+	if(rest > 0)
+		ros::WallDuration(rest).sleep();
+}
+
+//utime and stime of every process whose parent is pid, fields 4, 14 and 15 of /proc/<pid>/stat
+double childrenCpuSeconds(pid_t pid)	{
+	double total = 0;
+	DIR *proc = opendir("/proc");
+	if(proc == NULL)
+		return 0;
+	struct dirent *entry;
+	while((entry = readdir(proc)) != NULL)	{
+		if(entry->d_name[0] < '0' || entry->d_name[0] > '9')
+			continue;
+		char path[64];
+		snprintf(path, sizeof(path), "/proc/%s/stat", entry->d_name);
+		FILE *stat = fopen(path, "r");
+		if(stat == NULL)
+			continue;
+		int parent = 0;
+		unsigned long user = 0, system = 0;
+		int matched = fscanf(stat, "%*d (%*[^)]) %*c %d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu", &parent, &user, &system);
+		fclose(stat);
+		if(matched == 3 && parent == pid)
+			total += (double)(user + system)/sysconf(_SC_CLK_TCK);
+	}
+	closedir(proc);
+	return total;
+}
+
+//A pty, the slave end raw and kept open so the master never sees it hang up between launches
+struct line	{
+	int master, slave;
+	char name[256];
+
+	line() : master(-1), slave(-1)	{
+		if(openpty(&master, &slave, name, NULL, NULL) < 0)
+			return;
+		struct termios raw;
+		tcgetattr(slave, &raw);
+		cfmakeraw(&raw);
+		tcsetattr(slave, TCSANOW, &raw);
+	}
+	~line()	{
+		if(slave >= 0)
+			close(slave);
+		if(master >= 0)
+			close(master);
+	}
+	//everything written so far, thrown away
+	void drain()	{
+		uint8_t bytes[256];
+		struct pollfd waitFor;
+		waitFor.fd = master;
+		waitFor.events = POLLIN;
+		while(poll(&waitFor, 1, 0) > 0 && read(master, bytes, sizeof(bytes)) > 0)
+			;
+	}
+};
+
+//The autopilot's end of ardu's line
+struct autopilot	{
+	line pty;
+	mavlink_status_t status;
+
+	autopilot()	{
+		memset(&status, 0, sizeof(status));
+	}
+	bool sendTelemetry(int index)	{
+		uint8_t frame[MAVLINK_MAX_PACKET_LEN];
+		mavlink_message_t message;
+		mavlink_msg_au_uav_pack(PLANE, 1, &message, 326000000 + index, -854000000, 100, 327000000, -855000000, 100,
+				13, 13, 90, 0, 1);
+		int length = mavlink_msg_to_send_buffer(frame, &message);
+		return write(pty.master, frame, length) == length;
+	}
+	//true once a MISSION_ITEM has come off the line, false at until
+	bool waitForCommand(double until)	{
+		uint8_t bytes[256];
+		mavlink_message_t message;
+		for(;;)	{
+			int rest = (int)((until - wallSeconds())*1000);
+			if(rest < 0)
+				return false;
+			struct pollfd waitFor;
+			waitFor.fd = pty.master;
+			waitFor.events = POLLIN;
+			if(poll(&waitFor, 1, rest) <= 0)
+				continue;
+			int num = read(pty.master, bytes, sizeof(bytes));
+			for(int i = 0; i < num; i++)	{
+				if(mavlink_parse_char(MAVLINK_COMM_3, bytes[i], &message, &status) && message.msgid == MAVLINK_MSG_ID_MISSION_ITEM)
+					return true;
+			}
+		}
+	}
+};
+
+pid_t launch(const char *file, const char *arduPort, const char *xbeePort)	{
+	char ardu[300], xbee[300];
+	snprintf(ardu, sizeof(ardu), "ardu_port:=%s", arduPort);
+	snprintf(xbee, sizeof(xbee), "xbee_port:=%s", xbeePort);
+	pid_t child = fork();
+	if(child == 0)	{
+		execlp("roslaunch", "roslaunch", "au_uav_ros", file, ardu, xbee, (char *)NULL);
+		perror("roslaunch");
+		_exit(1);
+	}
+	return child;
+}
+
+//Telemetry and the CA on command until the first command comes back: ardu has the plane ID, the mover
+//got it from getPlaneID and is avoiding
+bool started(autopilot &ap, line &radio, ros::Publisher &gcs)	{
+	au_uav_ros::Command::Ptr caOn(new au_uav_ros::Command);
+	caOn->planeID = PLANE;
+	caOn->latitude = EMERGENCY_PROTOCOL_LAT;
+	caOn->longitude = META_START_CA_ON_LON;
+	double until = wallSeconds() + START_TIMEOUT;
+	while(wallSeconds() < until)	{
+		gcs.publish(caOn);
+		radio.drain();
+		ap.sendTelemetry(0);
+		if(ap.waitForCommand(wallSeconds() + START_RETRY))
+			return true;
+	}
+	return false;
+}
+
+void measure(const char *layout, double rate, autopilot &ap, line &radio, pid_t launched)	{
+	double gap = 1.0/rate;
+	int count = (int)(RUN_SECONDS*rate);
+	long lost = 0;
+	au_uav_ros::LatencyRecorder roundTrip;
+
+	ros::WallDuration(ANSWER_TIMEOUT).sleep();	//the last run's stragglers
+	ap.pty.drain();
+	double cpuStart = childrenCpuSeconds(launched);
+	double begin = wallSeconds();
+	for(int i = 0; i < count; i++)	{
+		sleepUntil(begin + i*gap);
+		radio.drain();		//xbee forwards each frame, nothing reads the radio's far end otherwise
+		double sentAt = wallSeconds();
+		if(ap.sendTelemetry(i + 1) && ap.waitForCommand(sentAt + ANSWER_TIMEOUT))
+			roundTrip.record(wallSeconds() - sentAt);
+		else
+			lost++;
+	}
+	double wall = wallSeconds() - begin;
+	double cpu = childrenCpuSeconds(launched) - cpuStart;
+
+	printf("%-8s %8.0f %8d %8ld %9.1f %9.1f %9.1f %8.1f\n", layout, rate, count, lost,
+			roundTrip.percentile(50)*1e3, roundTrip.percentile(99)*1e3, roundTrip.getMax()*1e3, 100*cpu/wall);
+}
+
+int main(int argc, char **argv)	{
+	ros::init(argc, argv, "nodelet_benchmark");
+	ros::NodeHandle n;
+	ros::Publisher gcs = n.advertise<au_uav_ros::Command>("gcs_commands", 10);
+	autopilot ap;
+	line radio;
+	if(ap.pty.master < 0 || radio.master < 0)	{
+		fprintf(stderr, "nodelet_benchmark: could not open a pty\n");
+		return 1;
+	}
+
+	printf("autopilot telemetry to command round trip, %.0f s at each rate, milliseconds\n", RUN_SECONDS);
+	printf("%-8s %8s %8s %8s %9s %9s %9s %8s\n", "layout", "msg/s", "sent", "lost", "p50", "p99", "max", "cpu %");
+
+	for(unsigned int l = 0; l < sizeof(LAUNCHES)/sizeof(LAUNCHES[0]) && ros::ok(); l++)	{
+		const char *layout = l == 0 ? "nodes" : "nodelet";
+		n.setParam("shape_commands", false);
+		n.setParam("min_command_interval", 0.0);
+		n.setParam("publish_period", KEEPALIVE_PERIOD);
+
+		pid_t launched = launch(LAUNCHES[l], ap.pty.name, radio.name);
+		if(launched == -1)	{
+			perror("fork");
+			return 1;
+		}
+		if(started(ap, radio, gcs))	{
+			for(unsigned int i = 0; i < sizeof(RATES)/sizeof(RATES[0]); i++)
+				measure(layout, RATES[i], ap, radio, launched);
+		}
+		else
+			fprintf(stderr, "nodelet_benchmark: %s never answered, is roscore up?\n", LAUNCHES[l]);
+
+		kill(launched, SIGINT);
+		waitpid(launched, NULL, 0);
+		radio.drain();
+	}
+	ros::shutdown();
+	return 0;
+}
@@ -0,0 +1,218 @@
+//Benchmark for getting my telemetry from the autopilot line onto the radio line.
+//Not a pass/fail test - run by hand on the target (rosrun au_uav_ros pass_through_benchmark) and compare the table.
+//
+//Two ptys stand in for the autopilot and the XBee. An AU_UAV frame is written to the autopilot
+//line every FRAME_GAP, the ardu end of the chain reads it in an EventLoop, and the xbee end sends it
+//with a SerialWriter. The far end of the radio line timestamps each frame as it comes off.
+//	- decode: AuUavView, rawMavlinkTelemetryToRawROSTelemetry, Telemetry over the topic,
+//	  mavlink_msg_au_uav_pack, as ardu and xbee did
+//	- pass-through: the frame's bytes in a MavlinkFrame over the topic, sent as they are
+//	- restamped: the same, with restampFrame() giving it a new sequence number and checksum
+//The topic between the two nodes is stood in for by ros::serialization, serializing the message and
+//deserializing it again, which is what roscpp does on either side of the socket. The socket itself
+//costs the same either way and is left out.
+//"chain us" is the CPU for the chain alone, run CHAIN_RUNS times without the lines.
+
+#include <pty.h>
+#include <poll.h>
+#include <time.h>
+#include <stdio.h>
+#include <ros/ros.h>
+#include <ros/serialization.h>
+#include <boost/thread.hpp>
+#include <au_uav_ros/Telemetry.h>
+#include <au_uav_ros/MavlinkFrame.h>
+#include "au_uav_ros/serial_talker.h"
+#include "au_uav_ros/event_loop.h"
+#include "au_uav_ros/serial_writer.h"
+#include "au_uav_ros/LatencyRecorder.h"
+
+#define FRAMES 1000
+#define FRAME_GAP 0.002		//seconds between frames from the autopilot
+#define CHAIN_RUNS 200000
+
+enum path { DECODE, PASS_THROUGH, RESTAMPED };
+
+struct line	{
+	int master;
+	SerialTalker serial;
+
+	line()	{
+		int slave;
+		char name[256];
+		master = -1;
+		if(openpty(&master, &slave, name, NULL, NULL) < 0)
+			return;
+		serial.open_port(name);
+		serial.setup_port(115200, 8, 1, true);
+		close(slave);
+	}
+	~line()	{
+		serial.close_port();
+		if(master >= 0)
+			close(master);
+	}
+};
+
+double wallSeconds()	{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+double threadSeconds()	{
+	struct timespec t;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+	return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+template<class M> void topicHop(const M &sent, M &received)	{
+	ros::SerializedMessage serialized = ros::serialization::serializeMessage(sent);
+	ros::serialization::deserializeMessage(serialized, received);
+}
+
+//ardu's handleTelemetry and xbee's callback, back to back
+struct chain	{
+	path how;
+	au_uav_ros::SerialWriter *radio;
+	uint8_t sequence;
+
+	chain(path _how, au_uav_ros::SerialWriter *_radio) : how(_how), radio(_radio), sequence(0) {}
+
+	void onTelemetry(const au_uav_ros::mav::FrameView &frame)	{
+		if(how == DECODE)	{
+			au_uav_ros::mav::AuUavView view(frame);
+			au_uav_ros::Telemetry sent, tUpdate;
+			au_uav_ros::mav::rawMavlinkTelemetryToRawROSTelemetry(view, sent);
+			sent.planeID = frame.sysid();
+			topicHop(sent, tUpdate);
+			mavlink_message_t message;
+			mavlink_msg_au_uav_pack(tUpdate.planeID, 110, &message, tUpdate.currentLatitude, tUpdate.currentLongitude,
+					tUpdate.currentAltitude, tUpdate.destLatitude, tUpdate.destLongitude, tUpdate.destAltitude,
+					tUpdate.groundSpeed, tUpdate.airSpeed, tUpdate.targetBearing, tUpdate.distanceToDestination,
+					tUpdate.currentWaypointIndex);
+			radio->send(message, au_uav_ros::TX_TELEMETRY);
+			return;
+		}
+		au_uav_ros::MavlinkFrame sent, raw;
+		sent.frame.assign(frame.data(), frame.data() + frame.size());
+		topicHop(sent, raw);
+		if(how == RESTAMPED)	{
+			uint8_t bytes[MAVLINK_MAX_PACKET_LEN];
+			memcpy(bytes, &raw.frame[0], raw.frame.size());
+			au_uav_ros::mav::restampFrame(bytes, sequence++);
+			radio->send(bytes, raw.frame.size(), au_uav_ros::TX_TELEMETRY);
+		}
+		else
+			radio->send(&raw.frame[0], raw.frame.size(), au_uav_ros::TX_TELEMETRY);
+	}
+};
+
+struct farEnd	{
+	boost::mutex lock;
+	boost::condition_variable arrived;
+	volatile bool running;
+	int lastIndex;		//latitude of the last frame off the radio
+	double arrivedAt;
+
+	farEnd() : running(true), lastIndex(-1), arrivedAt(0) {}
+};
+
+void readRadio(line *radio, farEnd *far)	{
+	au_uav_ros::mav::FrameParser parser;
+	au_uav_ros::mav::FrameView frame;
+	while(far->running)	{
+		struct pollfd waitFor;
+		waitFor.fd = radio->master;
+		waitFor.events = POLLIN;
+		if(poll(&waitFor, 1, 100) <= 0 || parser.readFrom(radio->master) <= 0)
+			continue;
+		double now = wallSeconds();
+		while(parser.next(frame))	{
+			if(frame.msgid() != MAVLINK_MSG_ID_AU_UAV)
+				continue;
+			boost::lock_guard<boost::mutex> guard(far->lock);
+			far->lastIndex = au_uav_ros::mav::AuUavView(frame).lat();
+			far->arrivedAt = now;
+			far->arrived.notify_all();
+		}
+	}
+}
+
+void loopThread(au_uav_ros::EventLoop *loop, farEnd *far)	{
+	while(far->running)
+		loop->runOnce(100);
+}
+
+double chainMicroseconds(path how, const uint8_t *bytes)	{
+	line radio;
+	au_uav_ros::SerialWriter writer(radio.serial);	//not started, telemetry drops the oldest once it is full
+	chain hop(how, &writer);
+	au_uav_ros::mav::FrameView frame(bytes);
+	double cpu = threadSeconds();
+	for(int i = 0; i < CHAIN_RUNS; i++)
+		hop.onTelemetry(frame);
+	return (threadSeconds() - cpu)/CHAIN_RUNS*1e6;
+}
+
+void measure(path how, const char *name, uint8_t frames[][MAVLINK_MAX_PACKET_LEN], const int *lengths)	{
+	line autopilot, radio;
+	if(autopilot.master < 0 || radio.master < 0)	{
+		printf("%-16s could not open a pty\n", name);
+		return;
+	}
+	au_uav_ros::mav::MavlinkReader ardu(autopilot.serial);
+	au_uav_ros::SerialWriter xbee(radio.serial);
+	xbee.start();
+	chain hop(how, &xbee);
+	au_uav_ros::mav::FrameDispatcher dispatch;
+	dispatch.on(MAVLINK_MSG_ID_AU_UAV, boost::bind(&chain::onTelemetry, &hop, _1));
+	au_uav_ros::EventLoop loop;
+	loop.addSerial(ardu, dispatch);
+
+	farEnd far;
+	boost::thread reading(readRadio, &radio, &far), looping(loopThread, &loop, &far);
+	au_uav_ros::LatencyRecorder latency;
+	for(int i = 0; i < FRAMES; i++)	{
+		boost::unique_lock<boost::mutex> guard(far.lock);
+		double sent = wallSeconds();
+		if(write(autopilot.master, frames[i], lengths[i]) != lengths[i])
+			break;
+		while(far.lastIndex < i)
+			if(!far.arrived.timed_wait(guard, boost::posix_time::seconds(1)))
+				break;
+		if(far.lastIndex == i)
+			latency.record(far.arrivedAt - sent);
+		guard.unlock();
+		ros::WallDuration(FRAME_GAP).sleep();
+	}
+	far.running = false;
+	loop.stop();
+	looping.join();
+	reading.join();
+	xbee.stop();
+
+	printf("%-16s %10.1f %10.1f %10.1f %10ld %10.2f\n", name, latency.percentile(50)*1e6, latency.percentile(99)*1e6,
+			latency.getMax()*1e6, FRAMES - latency.getCount(), chainMicroseconds(how, frames[0]));
+}
+
+int main(int argc, char **argv)	{
+	ros::Time::init();
+
+	//packed up front, mavlink_msg_*_pack counts sequence numbers in a static
+	static uint8_t frames[FRAMES][MAVLINK_MAX_PACKET_LEN];
+	int lengths[FRAMES];
+	for(int i = 0; i < FRAMES; i++)	{
+		mavlink_message_t message;
+		mavlink_msg_au_uav_pack(4, 1, &message, i, -854903560, 100000, 326070000, -854910000, 100000,
+				1300, 1400, 27000, 987, (uint8_t)i);
+		lengths[i] = mavlink_msg_to_send_buffer(frames[i], &message);
+	}
+
+	printf("Autopilot line to radio line (ptys, %d AU_UAV frames %.0f ms apart)\n", FRAMES, FRAME_GAP*1e3);
+	printf("%-16s %10s %10s %10s %10s %10s\n", "path", "p50 us", "p99 us", "max us", "lost", "chain us");
+	measure(DECODE, "decode", frames, lengths);
+	measure(PASS_THROUGH, "pass-through", frames, lengths);
+	measure(RESTAMPED, "restamped", frames, lengths);
+	return 0;
+}
@@ -0,0 +1,89 @@
+//Tests the handoff from ardu's getPlaneID to the mover anchoring collision avoidance's frame: the
+//position getPlaneID answers with is the first fix, never 0, 0, and the frame ends up there. In its
+//own binary, LocalFrame::mission() is anchored once per process and caAllocationTester anchors it too.
+
+#include <math.h>
+#include <gtest/gtest.h>
+#include <boost/thread.hpp>
+#include <ros/ros.h>
+#include "au_uav_ros/plane_identity.h"
+#include "au_uav_ros/collision_avoidance.h"
+#include "au_uav_ros/LocalFrame.h"
+
+namespace	{
+
+#define AUBURN_LAT 32.606573
+#define AUBURN_LON -85.490356
+#define WAIT 0.1		//seconds, PLANE_ID_WAIT shortened for the test
+
+au_uav_ros::Telemetry telemetryAt(double latitude, double longitude, double altitude)	{
+	au_uav_ros::Telemetry t;
+	t.currentLatitude = latitude;
+	t.currentLongitude = longitude;
+	t.currentAltitude = altitude;
+	return t;
+}
+
+void setLater(au_uav_ros::PlaneIdentity *identity, int id, au_uav_ros::Telemetry telem)	{
+	boost::this_thread::sleep(boost::posix_time::milliseconds(20));
+	identity->set(id, telem);
+}
+
+TEST(planeIdentityTest, noFixNoAnswer)	{
+	au_uav_ros::PlaneIdentity identity;
+	au_uav_ros::planeIDGetter::Response res;
+	EXPECT_FALSE(identity.wait(res, WAIT));
+
+	//before the ardupilot has a fix its telemetry is at 0, 0
+	EXPECT_FALSE(identity.set(7, telemetryAt(0, 0, 0)));
+	EXPECT_FALSE(identity.isSet());
+	EXPECT_FALSE(identity.wait(res, WAIT));
+}
+
+TEST(planeIdentityTest, firstFixOnly)	{
+	au_uav_ros::PlaneIdentity identity;
+	boost::thread listener(boost::bind(setLater, &identity, 7, telemetryAt(AUBURN_LAT, AUBURN_LON, 200)));
+	au_uav_ros::planeIDGetter::Response res;
+	EXPECT_TRUE(identity.wait(res, 5));
+	listener.join();
+	EXPECT_EQ(7, res.planeID);
+	EXPECT_EQ(AUBURN_LAT, res.initialLatitude);
+	EXPECT_EQ(AUBURN_LON, res.initialLongitude);
+	EXPECT_EQ(200, res.initialAltitude);
+
+	EXPECT_FALSE(identity.set(8, telemetryAt(AUBURN_LAT + 0.01, AUBURN_LON, 200)));
+	EXPECT_TRUE(identity.wait(res, WAIT));
+	EXPECT_EQ(7, res.planeID);
+	EXPECT_EQ(AUBURN_LAT, res.initialLatitude);
+}
+
+//What Mover::init does with getPlaneID's answer. A response nobody filled in is refused, and does
+//not use up the one anchoring the frame gets.
+TEST(planeIdentityTest, anchorsAtFirstFix)	{
+	au_uav_ros::CollisionAvoidance ca;
+	ca.init(7);
+	au_uav_ros::planeIDGetter::Response empty;
+	EXPECT_FALSE(ca.anchorFrame(empty.initialLatitude, empty.initialLongitude, empty.initialAltitude));
+	EXPECT_FALSE(au_uav_ros::LocalFrame::mission().isAnchored());
+
+	au_uav_ros::PlaneIdentity identity;
+	EXPECT_FALSE(identity.set(7, telemetryAt(0, 0, 0)));
+	EXPECT_TRUE(identity.set(7, telemetryAt(AUBURN_LAT, AUBURN_LON, 200)));
+	au_uav_ros::planeIDGetter::Response res;
+	ASSERT_TRUE(identity.wait(res, WAIT));
+	EXPECT_TRUE(ca.anchorFrame(res.initialLatitude, res.initialLongitude, res.initialAltitude));
+
+	const au_uav_ros::LocalFrame &frame = au_uav_ros::LocalFrame::mission();
+	EXPECT_EQ(AUBURN_LAT, frame.getAnchor().latitude);
+	EXPECT_EQ(AUBURN_LON, frame.getAnchor().longitude);
+	//east-west meters at Auburn's latitude, not the equator's
+	EXPECT_NEAR(cos(AUBURN_LAT*M_PI/180), frame.metersPerDegreeLongitude()/frame.metersPerDegreeLatitude(), 0.01);
+}
+
+}
+
+int main(int argc, char **argv)	{
+	ros::Time::init();
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
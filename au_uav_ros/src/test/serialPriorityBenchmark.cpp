@@ -0,0 +1,182 @@
+//Benchmark for avoidance commands on a radio link saturated with telemetry.
+//Not a pass/fail test - run by hand on the target (rosrun au_uav_ros serial_priority_benchmark) and compare the table.
+//
+//A pty stands in for the XBee. The far end only reads LINK_RATE bytes a second, like a 57600 baud
+//radio, while TELEMETRY_RATE telemetry frames a second are sent, more than the link can carry.
+//COMMANDS avoidance commands are sent COMMAND_GAP apart and the far end timestamps each one as it
+//comes off the link.
+//	- one queue: every frame in one class, first in first out, as SerialWriter was
+//	- priority: commands as TX_SAFETY and telemetry as TX_TELEMETRY
+//	- priority paced: the same, with the writer paced to LINK_RATE the way the radio talkers set it
+//A command counts as lost if it was dropped, or had not come off the link DRAIN_SECONDS after the
+//writer stopped.
+
+#include <pty.h>
+#include <poll.h>
+#include <time.h>
+#include <stdio.h>
+#include <vector>
+#include <algorithm>
+#include <ros/ros.h>
+#include <boost/thread.hpp>
+#include "au_uav_ros/serial_talker.h"
+#include "au_uav_ros/serial_writer.h"
+
+#define LINK_RATE 5760			//bytes per second, 57600 baud 8N1
+#define TELEMETRY_RATE 150		//frames per second, about 7.5 KB/s
+#define COMMANDS 60
+#define COMMAND_GAP 0.05		//seconds between commands
+#define DRAIN_SECONDS 3.0
+
+enum sender { ONE_QUEUE, PRIORITY, PRIORITY_PACED };
+
+struct line	{
+	int master;
+	SerialTalker serial;
+
+	line()	{
+		int slave;
+		char name[256];
+		master = -1;
+		if(openpty(&master, &slave, name, NULL, NULL) < 0)
+			return;
+		serial.open_port(name);
+		serial.setup_port(57600, 8, 1, true);
+		close(slave);
+	}
+	~line()	{
+		serial.close_port();
+		if(master >= 0)
+			close(master);
+	}
+};
+
+double wallSeconds()	{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+struct run	{
+	line pty;
+	volatile bool sending;			//telemetry keeps coming
+	volatile double drainUntil;		//the far end stops reading then, 0 until the writer has stopped
+	volatile int arrived;
+	double sentAt[COMMANDS], arrivedAt[COMMANDS];
+
+	run() : sending(true), drainUntil(0), arrived(0)	{
+		for(int i = 0; i < COMMANDS; i++)
+			arrivedAt[i] = 0;
+	}
+};
+
+//The far end of the radio, it takes at most LINK_RATE bytes a second off the line
+void farEnd(run *r)	{
+	uint8_t bytes[256];
+	mavlink_message_t message;
+	mavlink_status_t status;
+	double allowance = 0, last = wallSeconds();
+	while(r->drainUntil == 0 || (wallSeconds() < r->drainUntil && r->arrived < COMMANDS))	{
+		ros::WallDuration(0.001).sleep();
+		double now = wallSeconds();
+		allowance += (now - last)*LINK_RATE;
+		last = now;
+		if(allowance > 32)
+			allowance = 32;
+		if(allowance < 1)
+			continue;
+		struct pollfd waitFor;
+		waitFor.fd = r->pty.master;
+		waitFor.events = POLLIN;
+		if(poll(&waitFor, 1, 0) <= 0)
+			continue;
+		int num = read(r->pty.master, bytes, (int)allowance);
+		if(num <= 0)
+			continue;
+		allowance -= num;
+		now = wallSeconds();
+		for(int i = 0; i < num; i++)	{
+			if(mavlink_parse_char(MAVLINK_COMM_3, bytes[i], &message, &status) && message.msgid == MAVLINK_MSG_ID_MISSION_ITEM)	{
+				int seq = mavlink_msg_mission_item_get_seq(&message);
+				if(seq >= 0 && seq < COMMANDS && r->arrivedAt[seq] == 0)	{
+					r->arrivedAt[seq] = now;
+					r->arrived++;
+				}
+			}
+		}
+	}
+}
+
+void telemetryStream(run *r, au_uav_ros::SerialWriter *writer, au_uav_ros::txPriority priority)	{
+	uint8_t frame[MAVLINK_MAX_PACKET_LEN];
+	mavlink_message_t message;
+	mavlink_msg_au_uav_pack(4, 1, &message, 326000000, -854000000, 100, 327000000, -855000000, 100, 13, 13, 90, 0, 1);
+	int length = mavlink_msg_to_send_buffer(frame, &message);
+	while(r->sending)	{
+		writer->send(frame, length, priority);
+		ros::WallDuration(1.0/TELEMETRY_RATE).sleep();
+	}
+}
+
+void measure(sender how, const char *name)	{
+	run r;
+	if(r.pty.master < 0)	{
+		printf("%-16s could not open a pty\n", name);
+		return;
+	}
+	au_uav_ros::txPriority commandClass = how == ONE_QUEUE ? au_uav_ros::TX_MISSION : au_uav_ros::TX_SAFETY;
+	au_uav_ros::txPriority telemetryClass = how == ONE_QUEUE ? au_uav_ros::TX_MISSION : au_uav_ros::TX_TELEMETRY;
+
+	//packed up front, mavlink_msg_*_pack counts sequence numbers in a static
+	static uint8_t commands[COMMANDS][MAVLINK_MAX_PACKET_LEN];
+	int lengths[COMMANDS];
+	for(int i = 0; i < COMMANDS; i++)	{
+		mavlink_message_t message;
+		mavlink_msg_mission_item_pack(1, 110, &message, 1, 0, i, MAV_FRAME_GLOBAL, MAV_CMD_NAV_WAYPOINT,
+				2, 0, 20.0, 100.0, 1.0, 0.0, 32.6, -85.4, 100);
+		lengths[i] = mavlink_msg_to_send_buffer(commands[i], &message);
+	}
+
+	au_uav_ros::SerialWriter writer(r.pty.serial);
+	if(how == PRIORITY_PACED)
+		writer.setLinkRate(LINK_RATE);
+	writer.start();
+	boost::thread far(farEnd, &r), telemetry(telemetryStream, &r, &writer, telemetryClass);
+	ros::WallDuration(0.5).sleep();	//let the link fill up
+
+	for(int i = 0; i < COMMANDS; i++)	{
+		r.sentAt[i] = wallSeconds();
+		writer.send(commands[i], lengths[i], commandClass);
+		ros::WallDuration(COMMAND_GAP).sleep();
+	}
+
+	r.sending = false;
+	telemetry.join();
+	writer.stop();
+	r.drainUntil = wallSeconds() + DRAIN_SECONDS;
+	far.join();
+
+	//sorted by hand, LatencyRecorder only has bins up to 100 ms
+	std::vector<double> latency;
+	for(int i = 0; i < COMMANDS; i++)
+		if(r.arrivedAt[i] > 0)
+			latency.push_back(r.arrivedAt[i] - r.sentAt[i]);
+	std::sort(latency.begin(), latency.end());
+	if(latency.empty())
+		latency.push_back(0);
+	int n = latency.size();
+	printf("%-16s %10.1f %10.1f %10.1f %8d %14ld\n", name, latency[(n - 1)/2]*1e3, latency[(int)(0.99*(n - 1))]*1e3,
+			latency[n - 1]*1e3, COMMANDS - r.arrived, writer.getFramesDropped());
+}
+
+int main(int argc, char **argv)	{
+	ros::Time::init();
+
+	printf("Avoidance commands on a saturated radio (pty read at %d B/s, %d telemetry frames/s, %d commands %.0f ms apart)\n",
+			LINK_RATE, TELEMETRY_RATE, COMMANDS, COMMAND_GAP*1e3);
+	printf("%-16s %10s %10s %10s %8s %14s\n", "sender", "p50 ms", "p99 ms", "max ms", "lost", "frames dropped");
+	measure(ONE_QUEUE, "one queue");
+	measure(PRIORITY, "priority");
+	measure(PRIORITY_PACED, "priority paced");
+	return 0;
+}
@@ -0,0 +1,214 @@
+//Tests MavlinkReader over a pseudo terminal, so no serial hardware is needed. The test writes mavlink
+//frames into the master side and the reader decodes them from the slave side, the same way the talker
+//nodes read their serial lines.
+//
+//throughput compares the reader against the byte at a time read the talkers used before (one
+//sleep, lock and read() per byte). It prints the table and only checks that the reader is not the
+//slower one, a pty has no baud rate so the numbers are about CPU, not the radio.
+
+#include <pty.h>
+#include <time.h>
+#include <stdio.h>
+#include <vector>
+#include <gtest/gtest.h>
+#include <ros/ros.h>
+#include <boost/thread.hpp>
+#include "au_uav_ros/serial_talker.h"
+#include "au_uav_ros/mavlink_read.h"
+
+namespace	{
+
+//Both ends of a pty, the slave end set up like a talker sets up its port
+struct line	{
+	int master;
+	SerialTalker serial;
+
+	line()	{
+		int slave;
+		char name[256];
+		master = -1;
+		if(openpty(&master, &slave, name, NULL, NULL) < 0)
+			return;
+		serial.open_port(name);
+		serial.setup_port(115200, 8, 1, true);
+		close(slave);	//the talker has its own descriptor
+	}
+	~line()	{
+		serial.close_port();
+		if(master >= 0)
+			close(master);
+	}
+};
+
+void writeAll(int fd, const uint8_t *bytes, int length)	{
+	while(length > 0)	{
+		int num = write(fd, bytes, length);
+		if(num <= 0)
+			return;
+		bytes += num;
+		length -= num;
+	}
+}
+
+//An AU_UAV frame with its index in the waypoint index and latitude, so order can be checked
+int frame(int index, uint8_t *bytes)	{
+	mavlink_message_t message;
+	mavlink_msg_au_uav_pack(3, 1, &message, index, -index, 100, 0, 0, 0, 13, 13, 90, 0, (uint8_t)index);
+	return mavlink_msg_to_send_buffer(bytes, &message);
+}
+
+void writeFrames(int fd, int count)	{
+	std::vector<uint8_t> bytes(count*MAVLINK_MAX_PACKET_LEN);
+	int length = 0;
+	for(int i = 0; i < count; i++)
+		length += frame(i, &bytes[length]);
+	writeAll(fd, &bytes[0], length);
+}
+
+double threadSeconds()	{
+	struct timespec t;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+	return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+double wallSeconds()	{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+//Reads until count messages are in, the line fails, or a second goes by without a whole message.
+//A read can end inside a frame and find nothing, that alone does not mean the writer is done.
+void readUntil(au_uav_ros::mav::MavlinkReader &reader, std::vector<mavlink_message_t> &messages, int count)	{
+	double giveUp = wallSeconds() + 1;
+	while((int)messages.size() < count && wallSeconds() < giveUp)	{
+		int found = reader.readMessages(messages, 1000);
+		if(found < 0)
+			return;
+		if(found > 0)
+			giveUp = wallSeconds() + 1;
+	}
+}
+
+//What the talkers did before MavlinkReader, kept here only to compare against. ros::ok() is left
+//out, the test never calls ros::init. It gets its own channel so its half decoded messages are
+//kept apart from the reader's.
+mavlink_message_t byteAtATime(SerialTalker &serialIn, long &reads)	{
+	while(true)	{
+		uint8_t cp;
+		mavlink_message_t message;
+		mavlink_status_t status;
+		ros::Duration(0.000001).sleep();
+		serialIn.lock();
+		int num = read(serialIn.getFD(), &cp, 1);
+		serialIn.unlock();
+		reads++;
+		if(num > 0 && mavlink_parse_char(MAVLINK_COMM_2, cp, &message, &status))
+			return message;
+	}
+}
+
+TEST(serialReaderTest, decodesInOrder)	{
+	line pty;
+	ASSERT_GE(pty.master, 0);
+	au_uav_ros::mav::MavlinkReader reader(pty.serial);
+
+	//a whole frame, then one split in two, then frames with noise between them
+	uint8_t bytes[MAVLINK_MAX_PACKET_LEN];
+	std::vector<mavlink_message_t> messages;
+	writeAll(pty.master, bytes, frame(0, bytes));
+	EXPECT_EQ(1, reader.readMessages(messages, 1000));
+
+	int length = frame(1, bytes);
+	writeAll(pty.master, bytes, 10);
+	EXPECT_EQ(0, reader.readMessages(messages, 1000));
+	writeAll(pty.master, bytes + 10, length - 10);
+	EXPECT_EQ(1, reader.readMessages(messages, 1000));
+
+	const char noise[] = "noise\r\n";
+	for(int i = 2; i < 5; i++)	{
+		writeAll(pty.master, (const uint8_t *)noise, sizeof(noise));
+		writeAll(pty.master, bytes, frame(i, bytes));
+	}
+	readUntil(reader, messages, 5);
+
+	ASSERT_EQ(5u, messages.size());
+	for(int i = 0; i < 5; i++)	{
+		mavlink_au_uav_t decoded;
+		mavlink_msg_au_uav_decode(&messages[i], &decoded);
+		EXPECT_EQ(MAVLINK_MSG_ID_AU_UAV, messages[i].msgid);
+		EXPECT_EQ(i, decoded.au_target_wp_index);
+		EXPECT_EQ(i, decoded.au_lat);
+		EXPECT_EQ(-i, decoded.au_lng);
+	}
+	EXPECT_EQ(5, reader.getMessagesDecoded());
+
+	//nothing left over, a read with nothing on the line times out empty
+	EXPECT_EQ(0, reader.readMessages(messages, 10));
+}
+
+//More than the ring holds, written in one go, so the ring wraps and fills
+TEST(serialReaderTest, burstLargerThanBuffer)	{
+	line pty;
+	ASSERT_GE(pty.master, 0);
+	au_uav_ros::mav::MavlinkReader reader(pty.serial);
+
+	const int count = 1000;
+	boost::thread writer(writeFrames, pty.master, count);
+	std::vector<mavlink_message_t> messages;
+	readUntil(reader, messages, count);
+	writer.join();
+
+	ASSERT_EQ(count, (int)messages.size());
+	for(int i = 0; i < count; i++)
+		EXPECT_EQ((uint8_t)i, mavlink_msg_au_uav_get_au_target_wp_index(&messages[i]));
+	EXPECT_LT(reader.getReadCalls(), count);
+}
+
+TEST(serialReaderTest, throughput)	{
+	const int oldCount = 200, newCount = 20000;
+	double oldRate, oldCPU, newRate, newCPU;
+	long oldCalls = 0, newCalls;
+
+	{
+		line pty;
+		ASSERT_GE(pty.master, 0);
+		boost::thread writer(writeFrames, pty.master, oldCount);
+		double wall = wallSeconds(), cpu = threadSeconds();
+		for(int i = 0; i < oldCount; i++)
+			byteAtATime(pty.serial, oldCalls);
+		oldRate = oldCount/(wallSeconds() - wall);
+		oldCPU = (threadSeconds() - cpu)/oldCount;
+		writer.join();
+	}
+	{
+		line pty;
+		ASSERT_GE(pty.master, 0);
+		au_uav_ros::mav::MavlinkReader reader(pty.serial);
+		boost::thread writer(writeFrames, pty.master, newCount);
+		std::vector<mavlink_message_t> messages;
+		messages.reserve(newCount);
+		double wall = wallSeconds(), cpu = threadSeconds();
+		readUntil(reader, messages, newCount);
+		newRate = messages.size()/(wallSeconds() - wall);
+		newCPU = (threadSeconds() - cpu)/newCount;
+		newCalls = reader.getReadCalls();	//only counts reads that got data, the waits are in poll()
+		writer.join();
+		ASSERT_EQ(newCount, (int)messages.size());
+	}
+
+	printf("%-16s %12s %16s %14s\n", "reader", "messages/s", "CPU us/message", "read()/message");
+	printf("%-16s %12.0f %16.2f %14.2f\n", "byte at a time", oldRate, oldCPU*1e6, (double)oldCalls/oldCount);
+	printf("%-16s %12.0f %16.2f %14.3f\n", "MavlinkReader", newRate, newCPU*1e6, (double)newCalls/newCount);
+
+	EXPECT_GT(newRate, oldRate);
+	EXPECT_LT(newCPU, oldCPU);
+}
+
+}
+
+int main(int argc, char **argv)	{
+	ros::Time::init();
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,303 @@
+//Benchmark for sending commands on a serial line that is busy with incoming telemetry.
+//Not a pass/fail test - run by hand on the target (rosrun au_uav_ros serial_writer_benchmark) and compare the tables.
+//
+//A pty stands in for the line. One thread floods the node's side with telemetry (INBOUND_BURST frames
+//every millisecond) while the node reads it, and COMMANDS waypoint commands are sent MESSAGE_GAP
+//apart. The far end timestamps each command as it comes off the wire, for the command to wire latency.
+//	- byte lock: the talkers before MavlinkReader, one lock per byte read, commands written under the lock
+//	- bulk lock: MavlinkReader as it was, the lock held for each bulk read, commands written under the lock
+//	- queue: no lock on reads, commands sent through SerialWriter
+//
+//The second table is a radio that stops taking data: the far end stops reading for STALL_SECONDS
+//while commands keep coming, so the line's output buffer fills and write() blocks. It shows how much
+//telemetry the node still reads meanwhile, and the longest a single send held up the sending thread.
+
+#include <pty.h>
+#include <poll.h>
+#include <time.h>
+#include <stdio.h>
+#include <vector>
+#include <ros/ros.h>
+#include <boost/thread.hpp>
+#include "au_uav_ros/serial_talker.h"
+#include "au_uav_ros/mavlink_read.h"
+#include "au_uav_ros/event_loop.h"
+#include "au_uav_ros/serial_writer.h"
+#include "au_uav_ros/LatencyRecorder.h"
+
+#define COMMANDS 500
+#define MESSAGE_GAP 0.002		//seconds between commands
+#define INBOUND_BURST 20		//telemetry frames written into the node every millisecond
+#define STALL_SECONDS 1.0
+#define STALL_GAP 0.0001		//seconds between commands while the far end is stalled
+
+enum sender { BYTE_LOCK, BULK_LOCK, QUEUE };
+
+struct line	{
+	int master;
+	SerialTalker serial;
+
+	line()	{
+		int slave;
+		char name[256];
+		master = -1;
+		if(openpty(&master, &slave, name, NULL, NULL) < 0)
+			return;
+		serial.open_port(name);
+		serial.setup_port(115200, 8, 1, true);
+		close(slave);
+	}
+	~line()	{
+		serial.close_port();
+		if(master >= 0)
+			close(master);
+	}
+};
+
+double wallSeconds()	{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+struct run	{
+	line pty;
+	volatile bool running;
+	volatile bool stalled;			//the far end is not reading
+	volatile bool sending;			//commands may still be on their way, the far end keeps reading
+	volatile long inbound;			//telemetry frames the node decoded
+	double sentAt[COMMANDS], arrivedAt[COMMANDS];
+
+	run() : running(true), stalled(false), sending(false), inbound(0)	{
+		for(int i = 0; i < COMMANDS; i++)
+			arrivedAt[i] = 0;
+	}
+	void onTelemetry(const mavlink_message_t &)	{
+		inbound++;
+	}
+};
+
+void telemetryFlood(run *r)	{
+	std::vector<uint8_t> burst(INBOUND_BURST*MAVLINK_MAX_PACKET_LEN);
+	int length = 0;
+	for(int i = 0; i < INBOUND_BURST; i++)	{
+		mavlink_message_t message;
+		mavlink_msg_au_uav_pack(4 + i, 1, &message, i, 0, 100, 0, 0, 0, 13, 13, 90, 0, 0);
+		length += mavlink_msg_to_send_buffer(&burst[length], &message);
+	}
+	//non blocking, a reader that cannot keep up loses telemetry instead of stalling the flood
+	fcntl(r->pty.master, F_SETFL, fcntl(r->pty.master, F_GETFL) | O_NONBLOCK);
+	while(r->running)	{
+		write(r->pty.master, &burst[0], length);
+		ros::WallDuration(0.001).sleep();
+	}
+}
+
+//The far end of the line, where the commands come off the wire
+void wire(run *r)	{
+	uint8_t bytes[1024];
+	mavlink_message_t message;
+	mavlink_status_t status;
+	while(r->running || r->sending)	{
+		if(r->stalled)	{
+			ros::WallDuration(0.001).sleep();
+			continue;
+		}
+		struct pollfd waitFor;
+		waitFor.fd = r->pty.master;
+		waitFor.events = POLLIN;
+		if(poll(&waitFor, 1, 100) <= 0)
+			continue;
+		int num = read(r->pty.master, bytes, sizeof(bytes));
+		double now = wallSeconds();
+		for(int i = 0; i < num; i++)	{
+			if(mavlink_parse_char(MAVLINK_COMM_3, bytes[i], &message, &status) && message.msgid == MAVLINK_MSG_ID_MISSION_ITEM)	{
+				int seq = mavlink_msg_mission_item_get_seq(&message);
+				if(seq >= 0 && seq < COMMANDS)
+					r->arrivedAt[seq] = now;
+			}
+		}
+	}
+}
+
+void byteLockReader(run *r)	{
+	mavlink_message_t message;
+	mavlink_status_t status;
+	while(r->running)	{
+		uint8_t cp;
+		ros::Duration(0.000001).sleep();
+		r->pty.serial.lock();
+		int num = read(r->pty.serial.getFD(), &cp, 1);
+		r->pty.serial.unlock();
+		if(num > 0 && mavlink_parse_char(MAVLINK_COMM_2, cp, &message, &status))
+			r->onTelemetry(message);
+	}
+}
+
+void bulkLockReader(run *r)	{
+	uint8_t bytes[READ_BUFFER_SIZE];
+	mavlink_message_t message;
+	mavlink_status_t status;
+	while(r->running)	{
+		struct pollfd waitFor;
+		waitFor.fd = r->pty.serial.getFD();
+		waitFor.events = POLLIN;
+		if(poll(&waitFor, 1, 100) <= 0)
+			continue;
+		r->pty.serial.lock();
+		int num = read(r->pty.serial.getFD(), bytes, sizeof(bytes));
+		r->pty.serial.unlock();
+		for(int i = 0; i < num; i++)
+			if(mavlink_parse_char(MAVLINK_COMM_2, bytes[i], &message, &status))
+				r->onTelemetry(message);
+	}
+}
+
+void loopReader(run *r, au_uav_ros::EventLoop *loop)	{
+	while(r->running)
+		loop->runOnce(EVENT_LOOP_SHUTDOWN_CHECK_MS);
+}
+
+void sendCommand(sender how, SerialTalker &serial, au_uav_ros::SerialWriter &writer, const mavlink_message_t &message)	{
+	if(how == QUEUE)	{
+		writer.send(message);
+		return;
+	}
+	uint8_t buffer[MAVLINK_MAX_PACKET_LEN];
+	int length = mavlink_msg_to_send_buffer(buffer, &message);
+	serial.lock();
+	write(serial.getFD(), buffer, length);
+	serial.unlock();
+}
+
+//Sends commands until the run stops, keeping the longest a single send took
+void commandStream(sender how, run *r, au_uav_ros::SerialWriter *writer, double *longest)	{
+	mavlink_message_t message;
+	mavlink_msg_mission_item_pack(1, 110, &message, 1, 0, 0, MAV_FRAME_GLOBAL, MAV_CMD_NAV_WAYPOINT,
+			2, 0, 20.0, 100.0, 1.0, 0.0, 32.6, -85.4, 100);
+	*longest = 0;
+	while(r->running)	{
+		double before = wallSeconds();
+		sendCommand(how, r->pty.serial, *writer, message);
+		double took = wallSeconds() - before;
+		if(took > *longest)
+			*longest = took;
+		ros::WallDuration(STALL_GAP).sleep();
+	}
+}
+
+void measure(sender how, const char *name)	{
+	run r;
+	if(r.pty.master < 0)	{
+		printf("%-12s could not open a pty\n", name);
+		return;
+	}
+	au_uav_ros::mav::MavlinkReader reader(r.pty.serial);
+	au_uav_ros::EventLoop loop;
+	au_uav_ros::SerialWriter writer(r.pty.serial);
+
+	boost::thread *node;
+	if(how == BYTE_LOCK)
+		node = new boost::thread(byteLockReader, &r);
+	else if(how == BULK_LOCK)
+		node = new boost::thread(bulkLockReader, &r);
+	else	{
+		loop.addSerial(reader, boost::bind(&run::onTelemetry, &r, _1));
+		node = new boost::thread(loopReader, &r, &loop);
+		writer.start();
+	}
+	boost::thread flood(telemetryFlood, &r), far(wire, &r);
+	ros::WallDuration(0.1).sleep();	//let the flood get going
+
+	double start = wallSeconds();
+	long inboundBefore = r.inbound;
+	for(int i = 0; i < COMMANDS; i++)	{
+		mavlink_message_t message;
+		mavlink_msg_mission_item_pack(1, 110, &message, 1, 0, i, MAV_FRAME_GLOBAL, MAV_CMD_NAV_WAYPOINT,
+				2, 0, 20.0, 100.0, 1.0, 0.0, 32.6, -85.4, 100);
+		r.sentAt[i] = wallSeconds();
+		sendCommand(how, r.pty.serial, writer, message);
+		ros::WallDuration(MESSAGE_GAP).sleep();
+	}
+	double inboundRate = (r.inbound - inboundBefore)/(wallSeconds() - start);
+	ros::WallDuration(0.2).sleep();	//let the last commands land
+
+	r.running = false;
+	loop.stop();
+	writer.stop();
+	node->join();
+	flood.join();
+	far.join();
+	delete node;
+
+	au_uav_ros::LatencyRecorder latency;
+	for(int i = 0; i < COMMANDS; i++)
+		if(r.arrivedAt[i] > 0)
+			latency.record(r.arrivedAt[i] - r.sentAt[i]);
+	printf("%-12s %10.1f %10.1f %10.1f %10ld %14.0f\n", name, latency.percentile(50)*1e6, latency.percentile(99)*1e6,
+			latency.getMax()*1e6, COMMANDS - latency.getCount(), inboundRate);
+}
+
+void measureStall(sender how, const char *name)	{
+	run r;
+	if(r.pty.master < 0)	{
+		printf("%-12s could not open a pty\n", name);
+		return;
+	}
+	au_uav_ros::mav::MavlinkReader reader(r.pty.serial);
+	au_uav_ros::EventLoop loop;
+	au_uav_ros::SerialWriter writer(r.pty.serial);
+
+	boost::thread *node;
+	if(how == BYTE_LOCK)
+		node = new boost::thread(byteLockReader, &r);
+	else if(how == BULK_LOCK)
+		node = new boost::thread(bulkLockReader, &r);
+	else	{
+		loop.addSerial(reader, boost::bind(&run::onTelemetry, &r, _1));
+		node = new boost::thread(loopReader, &r, &loop);
+		writer.start();
+	}
+	r.stalled = true;
+	r.sending = true;
+	double longest;
+	boost::thread flood(telemetryFlood, &r), far(wire, &r), commands(commandStream, how, &r, &writer, &longest);
+
+	ros::WallDuration(0.1).sleep();
+	double start = wallSeconds();
+	long inboundBefore = r.inbound;
+	ros::WallDuration(STALL_SECONDS).sleep();
+	double inboundRate = (r.inbound - inboundBefore)/(wallSeconds() - start);
+
+	//the far end reads again, which lets a blocked write finish
+	r.stalled = false;
+	r.running = false;
+	commands.join();
+	loop.stop();
+	writer.stop();
+	r.sending = false;
+	node->join();
+	flood.join();
+	far.join();
+	delete node;
+
+	printf("%-12s %14.0f %16.1f %10ld\n", name, inboundRate, longest*1e3, writer.getFramesDropped());
+}
+
+int main(int argc, char **argv)	{
+	ros::Time::init();
+
+	printf("Command to wire latency (pty, %d commands %.0f ms apart, %d telemetry frames/ms inbound)\n",
+			COMMANDS, MESSAGE_GAP*1e3, INBOUND_BURST);
+	printf("%-12s %10s %10s %10s %10s %14s\n", "sender", "p50 us", "p99 us", "max us", "lost", "inbound/s");
+	measure(BYTE_LOCK, "byte lock");
+	measure(BULK_LOCK, "bulk lock");
+	measure(QUEUE, "queue");
+
+	printf("\nFar end stalled for %.0f s, a command every %.1f ms\n", STALL_SECONDS, STALL_GAP*1e3);
+	printf("%-12s %14s %16s %10s\n", "sender", "inbound/s", "longest send ms", "dropped");
+	measureStall(BYTE_LOCK, "byte lock");
+	measureStall(BULK_LOCK, "bulk lock");
+	measureStall(QUEUE, "queue");
+	return 0;
+}
@@ -0,0 +1,229 @@
+//Tests SerialWriter over a pseudo terminal. Frames are sent into the slave side, the way a talker
+//sends on its port, and read back whole from the master side.
+
+#include <pty.h>
+#include <poll.h>
+#include <vector>
+#include <gtest/gtest.h>
+#include <ros/ros.h>
+#include <boost/thread.hpp>
+#include "au_uav_ros/serial_talker.h"
+#include "au_uav_ros/serial_writer.h"
+
+namespace	{
+
+struct line	{
+	int master;
+	SerialTalker serial;
+
+	line()	{
+		int slave;
+		char name[256];
+		master = -1;
+		if(openpty(&master, &slave, name, NULL, NULL) < 0)
+			return;
+		serial.open_port(name);
+		serial.setup_port(115200, 8, 1, true);
+		close(slave);
+	}
+	~line()	{
+		serial.close_port();
+		if(master >= 0)
+			close(master);
+	}
+};
+
+mavlink_message_t commandFrom(int sender, int index)	{
+	mavlink_message_t message;
+	mavlink_msg_mission_item_pack(sender, 1, &message, 3, 0, index, MAV_FRAME_GLOBAL, MAV_CMD_NAV_WAYPOINT,
+			2, 0, 20.0, 100.0, 1.0, 0.0, 32.6, -85.4, 100);
+	return message;
+}
+
+mavlink_message_t telemetryFrom(int sender, int index)	{
+	mavlink_message_t message;
+	mavlink_msg_au_uav_pack(sender, 1, &message, 326000000, -854000000, 100, 327000000, -855000000, 100, 13, 13, 90, 0, index);
+	return message;
+}
+
+//Reads frames off the master side until count have arrived or nothing comes for a second
+std::vector<mavlink_message_t> readFrames(int master, int count)	{
+	std::vector<mavlink_message_t> messages;
+	uint8_t bytes[1024];
+	mavlink_message_t message;
+	mavlink_status_t status;
+	while((int)messages.size() < count)	{
+		struct pollfd waitFor;
+		waitFor.fd = master;
+		waitFor.events = POLLIN;
+		if(poll(&waitFor, 1, 1000) <= 0)
+			break;
+		int num = read(master, bytes, sizeof(bytes));
+		if(num <= 0)
+			break;
+		for(int i = 0; i < num; i++)
+			if(mavlink_parse_char(MAVLINK_COMM_3, bytes[i], &message, &status))
+				messages.push_back(message);
+	}
+	return messages;
+}
+
+//packed before the threads start, mavlink_msg_*_pack counts sequence numbers in a static
+void sendCommands(au_uav_ros::SerialWriter *writer, const std::vector<mavlink_message_t> *commands)	{
+	for(unsigned int i = 0; i < commands->size(); i++)
+		while(!writer->send((*commands)[i]))
+			boost::this_thread::yield();	//full, the test wants every frame
+}
+
+//Every sender's frames arrive, whole and in the order that sender sent them
+TEST(serialWriterTest, manySenders)	{
+	line pty;
+	ASSERT_GE(pty.master, 0);
+	au_uav_ros::SerialWriter writer(pty.serial, 16);
+	ASSERT_TRUE(writer.start());
+
+	const int senders = 4, each = 250;
+	std::vector<mavlink_message_t> commands[senders];
+	for(int s = 0; s < senders; s++)
+		for(int i = 0; i < each; i++)
+			commands[s].push_back(commandFrom(s + 1, i));
+	boost::thread_group threads;
+	for(int s = 0; s < senders; s++)
+		threads.create_thread(boost::bind(sendCommands, &writer, &commands[s]));
+	std::vector<mavlink_message_t> messages = readFrames(pty.master, senders*each);
+	threads.join_all();
+	writer.stop();
+
+	ASSERT_EQ(senders*each, (int)messages.size());
+	int next[senders + 1] = {0};
+	for(unsigned int i = 0; i < messages.size(); i++)	{
+		ASSERT_EQ(MAVLINK_MSG_ID_MISSION_ITEM, messages[i].msgid);
+		int sender = messages[i].sysid;
+		ASSERT_GE(sender, 1);
+		ASSERT_LE(sender, senders);
+		EXPECT_EQ(next[sender], mavlink_msg_mission_item_get_seq(&messages[i]));
+		next[sender]++;
+	}
+	EXPECT_EQ(senders*each, writer.getFramesSent());
+	EXPECT_LE(writer.getWriteCalls(), writer.getFramesSent());
+}
+
+//Frames waiting when the writer gets to them go out in one writev
+TEST(serialWriterTest, coalescesWaitingFrames)	{
+	line pty;
+	ASSERT_GE(pty.master, 0);
+	au_uav_ros::SerialWriter writer(pty.serial);
+	for(int i = 0; i < 10; i++)
+		ASSERT_TRUE(writer.send(commandFrom(1, i)));
+	ASSERT_TRUE(writer.start());
+
+	std::vector<mavlink_message_t> messages = readFrames(pty.master, 10);
+	writer.stop();
+	EXPECT_EQ(10u, messages.size());
+	EXPECT_EQ(1, writer.getWriteCalls());
+}
+
+//A full queue drops the new frame instead of blocking, and what was queued still goes out
+TEST(serialWriterTest, fullQueueDrops)	{
+	line pty;
+	ASSERT_GE(pty.master, 0);
+	au_uav_ros::SerialWriter writer(pty.serial, 8);
+	int accepted = 0;
+	for(int i = 0; i < 10; i++)
+		if(writer.send(commandFrom(1, i)))
+			accepted++;
+	EXPECT_EQ(8, accepted);
+	EXPECT_EQ(2, writer.getFramesDropped());
+
+	ASSERT_TRUE(writer.start());
+	std::vector<mavlink_message_t> messages = readFrames(pty.master, 8);
+	writer.stop();
+	ASSERT_EQ(8u, messages.size());
+	for(int i = 0; i < 8; i++)
+		EXPECT_EQ(i, mavlink_msg_mission_item_get_seq(&messages[i]));
+}
+
+//Queued before the writer starts, the avoidance command goes out first, then the other commands,
+//then telemetry
+TEST(serialWriterTest, mostUrgentFirst)	{
+	line pty;
+	ASSERT_GE(pty.master, 0);
+	au_uav_ros::SerialWriter writer(pty.serial);
+	for(int i = 0; i < 5; i++)
+		ASSERT_TRUE(writer.send(telemetryFrom(1, i), au_uav_ros::TX_TELEMETRY));
+	for(int i = 0; i < 5; i++)
+		ASSERT_TRUE(writer.send(commandFrom(1, i), au_uav_ros::TX_MISSION));
+	ASSERT_TRUE(writer.send(commandFrom(2, 0), au_uav_ros::TX_SAFETY));
+	ASSERT_TRUE(writer.start());
+
+	std::vector<mavlink_message_t> messages = readFrames(pty.master, 11);
+	writer.stop();
+	ASSERT_EQ(11u, messages.size());
+	EXPECT_EQ(2, messages[0].sysid);
+	for(int i = 1; i <= 5; i++)	{
+		EXPECT_EQ(MAVLINK_MSG_ID_MISSION_ITEM, messages[i].msgid);
+		EXPECT_EQ(1, messages[i].sysid);
+	}
+	for(int i = 6; i < 11; i++)
+		EXPECT_EQ(MAVLINK_MSG_ID_AU_UAV, messages[i].msgid);
+	EXPECT_EQ(1, writer.getFramesSent(au_uav_ros::TX_SAFETY));
+	EXPECT_EQ(5, writer.getFramesSent(au_uav_ros::TX_TELEMETRY));
+}
+
+//A full telemetry queue keeps the newest frames
+TEST(serialWriterTest, telemetryDropsOldest)	{
+	line pty;
+	ASSERT_GE(pty.master, 0);
+	au_uav_ros::SerialWriter writer(pty.serial, 8);
+	long bytes = 0;
+	for(int i = 0; i < 10; i++)	{
+		uint8_t frame[MAVLINK_MAX_PACKET_LEN];
+		mavlink_message_t message = telemetryFrom(1, i);
+		int length = mavlink_msg_to_send_buffer(frame, &message);
+		EXPECT_TRUE(writer.send(frame, length, au_uav_ros::TX_TELEMETRY));
+		if(i >= 2)
+			bytes += length;
+	}
+	EXPECT_EQ(2, writer.getFramesDropped(au_uav_ros::TX_TELEMETRY));
+	EXPECT_EQ(0, writer.getFramesDropped(au_uav_ros::TX_MISSION));
+
+	ASSERT_TRUE(writer.start());
+	std::vector<mavlink_message_t> messages = readFrames(pty.master, 8);
+	writer.stop();
+	ASSERT_EQ(8u, messages.size());
+	for(int i = 0; i < 8; i++)
+		EXPECT_EQ(i + 2, mavlink_msg_au_uav_get_au_target_wp_index(&messages[i]));
+	EXPECT_EQ(bytes, writer.getBytesSent(au_uav_ros::TX_TELEMETRY));
+}
+
+//A paced writer does not put frames on the line faster than the link takes them
+TEST(serialWriterTest, pacedToLinkRate)	{
+	line pty;
+	ASSERT_GE(pty.master, 0);
+	au_uav_ros::SerialWriter writer(pty.serial);
+	const int rate = 2000;
+	writer.setLinkRate(rate);
+	long bytes = 0;
+	for(int i = 0; i < 20; i++)	{
+		uint8_t frame[MAVLINK_MAX_PACKET_LEN];
+		mavlink_message_t message = commandFrom(1, i);
+		int length = mavlink_msg_to_send_buffer(frame, &message);
+		ASSERT_TRUE(writer.send(frame, length));
+		bytes += length;
+	}
+	ros::WallTime start = ros::WallTime::now();
+	ASSERT_TRUE(writer.start());
+	std::vector<mavlink_message_t> messages = readFrames(pty.master, 20);
+	double took = (ros::WallTime::now() - start).toSec();
+	writer.stop();
+	EXPECT_EQ(20u, messages.size());
+	EXPECT_GE(took, 0.9*(bytes - TX_BURST_BYTES - MAVLINK_MAX_PACKET_LEN)/rate);
+}
+
+}
+
+int main(int argc, char **argv)	{
+	ros::Time::init();
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,202 @@
+//Benchmark for how long the mover's threads take to get at goal_wp and ca_wp under a telemetry flood,
+//with the mutexes the mover used to have and with CommandSnapshot.
+//Not a pass/fail test - run by hand on the target (rosrun au_uav_ros snapshot_benchmark) and compare the table.
+//
+//Three threads, all touching the waypoints the way the mover's do:
+//	- CA worker (the telemetry path): for every update, NUM_PLANES planes at FLOOD_RATE, reads
+//	  goal_wp twice (avoid() and the shaper) and replaces ca_wp
+//	- move(): takes ca_wp and reads goal_wp over and over, yielding in between
+//	- GCS callback: a new goal_wp every GCS_GAP
+//Before, goal_wp and ca_wp were Commands behind a boost::mutex each (ca_wp a deque, cleared and pushed),
+//and CollisionAvoidance had its own copy of goal_wp behind another. This prints percentiles for each
+//update on the telemetry path and for each of move()'s reads, and a histogram of the telemetry path.
+
+#include <time.h>
+#include <stdio.h>
+#include <deque>
+#include <vector>
+#include <algorithm>
+#include <boost/thread.hpp>
+#include "au_uav_ros/command_snapshot.h"
+
+#define NUM_PLANES 32
+#define FLOOD_RATE 50.0			//updates/second from each plane
+#define GCS_GAP 0.001			//seconds between goal_wp stores
+#define RUN_SECONDS 3.0
+
+double wallSeconds()	{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+void sleepUntil(double when)	{
+	double rest = when - wallSeconds();
+	if(rest > 0)
+		boost::this_thread::sleep(boost::posix_time::microseconds((long)(rest*1e6)));
+}
+
+//What the mover had: a lock for each
+struct locked	{
+	boost::mutex goalLock, caGoalLock, caLock;
+	au_uav_ros::Command goal, caGoal;
+	std::deque<au_uav_ros::Command> ca;
+	double caReceived;
+
+	void storeGoal(const au_uav_ros::Command &com)	{
+		{
+			boost::mutex::scoped_lock guard(goalLock);
+			goal = com;
+		}
+		boost::mutex::scoped_lock guard(caGoalLock);	//ca.setGoalWaypoint()
+		caGoal = com;
+	}
+	void update(const au_uav_ros::Command &com, double received)	{
+		au_uav_ros::Command g;
+		{
+			boost::mutex::scoped_lock guard(caGoalLock);	//avoid()
+			g = caGoal;
+		}
+		{
+			boost::mutex::scoped_lock guard(goalLock);		//the shaper
+			g = goal;
+		}
+		boost::mutex::scoped_lock guard(caLock);
+		ca.clear();
+		ca.push_back(com);
+		caReceived = received;
+	}
+	void read(au_uav_ros::Command &com, double &received)	{
+		{
+			boost::mutex::scoped_lock guard(caLock);
+			if(!ca.empty())	{
+				com = ca.front();
+				ca.pop_front();
+				received = caReceived;
+			}
+		}
+		boost::mutex::scoped_lock guard(goalLock);
+		com = goal;
+	}
+};
+
+//What the mover has now
+struct snapshots	{
+	au_uav_ros::CommandSnapshot goal, caGoal, ca;
+
+	void storeGoal(const au_uav_ros::Command &com)	{
+		goal.store(com);
+		caGoal.store(com);
+	}
+	void update(const au_uav_ros::Command &com, double received)	{
+		au_uav_ros::Command g;
+		caGoal.load(g);
+		goal.load(g);
+		ca.store(com, received);
+	}
+	void read(au_uav_ros::Command &com, double &received)	{
+		ca.take(com, received);
+		goal.load(com);
+	}
+};
+
+template<typename W>
+struct run	{
+	W waypoints;
+	volatile bool done;
+	std::vector<double> updates, reads;
+	run() : done(false) {}
+};
+
+template<typename W>
+void mover(run<W> *r)	{
+	au_uav_ros::Command com;
+	double received;
+	while(!r->done)	{
+		double start = wallSeconds();
+		r->waypoints.read(com, received);
+		r->reads.push_back(wallSeconds() - start);
+		boost::this_thread::yield();
+	}
+}
+
+template<typename W>
+void gcs(run<W> *r)	{
+	au_uav_ros::Command com;
+	com.commandHeader.frame_id = "gcs";
+	double next = wallSeconds();
+	while(!r->done)	{
+		com.latitude += 1;
+		r->waypoints.storeGoal(com);
+		next += GCS_GAP;
+		sleepUntil(next);
+	}
+}
+
+void percentiles(const char *name, const char *path, std::vector<double> &t)	{
+	std::sort(t.begin(), t.end());
+	if(t.empty())
+		t.push_back(0);
+	int n = t.size();
+	printf("%-10s %-15s %10d %9.2f %9.2f %9.2f %9.2f\n", name, path, n, t[(n - 1)/2]*1e6, t[(int)(0.99*(n - 1))]*1e6,
+			t[(int)(0.999*(n - 1))]*1e6, t[n - 1]*1e6);
+}
+
+//updates by time taken, each bin 10 times the last
+void histogram(const char *name, const std::vector<double> &t)	{
+	const double edges[] = {1e-6, 10e-6, 100e-6, 1e-3, 10e-3};
+	const int EDGES = sizeof(edges)/sizeof(edges[0]);
+	long counts[EDGES + 1] = {0};
+	for(unsigned int i = 0; i < t.size(); i++)	{
+		int b = 0;
+		while(b < EDGES && t[i] >= edges[b])
+			b++;
+		counts[b]++;
+	}
+	printf("%-10s", name);
+	for(int b = 0; b <= EDGES; b++)
+		printf(" %10ld", counts[b]);
+	printf("\n");
+}
+
+template<typename W>
+void measure(const char *name, run<W> &r)	{
+	boost::thread reader(mover<W>, &r);
+	boost::thread ground(gcs<W>, &r);
+
+	au_uav_ros::Command com;
+	double gap = 1.0/(NUM_PLANES*FLOOD_RATE);
+	long updates = (long)(RUN_SECONDS/gap);
+	double begin = wallSeconds();
+	for(long i = 0; i < updates; i++)	{
+		sleepUntil(begin + i*gap);
+		com.latitude = i;
+		double start = wallSeconds();
+		r.waypoints.update(com, start);
+		r.updates.push_back(wallSeconds() - start);
+	}
+	r.done = true;
+	reader.join();
+	ground.join();
+
+	percentiles(name, "telemetry path", r.updates);
+	percentiles(name, "move() read", r.reads);
+}
+
+int main(int argc, char **argv)	{
+	printf("goal_wp and ca_wp under %d planes at %.0f Hz, goal_wp every %.0f ms, %.0f s each, microseconds\n",
+			NUM_PLANES, FLOOD_RATE, GCS_GAP*1e3, RUN_SECONDS);
+	printf("%-10s %-15s %10s %9s %9s %9s %9s\n", "waypoints", "path", "count", "p50", "p99", "p99.9", "max");
+	run<locked> *withLocks = new run<locked>;
+	run<snapshots> *withSnapshots = new run<snapshots>;
+	measure("mutex", *withLocks);
+	measure("snapshot", *withSnapshots);
+
+	printf("\ntelemetry path updates taking\n%-10s %10s %10s %10s %10s %10s %10s\n", "waypoints", "<1 us", "<10 us",
+			"<100 us", "<1 ms", "<10 ms", ">=10 ms");
+	histogram("mutex", withLocks->updates);
+	histogram("snapshot", withSnapshots->updates);
+	delete withLocks;
+	delete withSnapshots;
+	return 0;
+}
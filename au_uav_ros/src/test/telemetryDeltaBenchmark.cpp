@@ -0,0 +1,251 @@
+//Report on what compact telemetry (telemetry_delta.h) saves on the XBee link.
+//Not a pass/fail test - run by hand (rosrun au_uav_ros telemetry_delta_benchmark) and compare the table.
+//The recorded flights and the courses they flew are given on the command line, e.g.
+//	cd `rospack find au_uav_ros`
+//	rosrun au_uav_ros telemetry_delta_benchmark courses flightData/NoAvoidance/final_32_*.kml
+//
+//Each plane's track in a flightData .kml (a position a second) is turned back into the AU_UAV
+//updates it sent: the target is its next waypoint from the course file of the same name, and the
+//ground speed, bearing and distance come from the positions. Every second each plane's update goes
+//through its own DeltaEncoder and all of them through one DeltaDecoder, as on the shared link.
+//For a few keyframe intervals this prints:
+//	- the bytes per update on the line, AU_UAV against compact, and how much smaller compact is
+//	- how many of the updates went out as keyframes
+//	- how far off the rebuilt position was at most, and whether any other field was
+//	- how many planes fit on a 57600 baud link at one update a second, each way
+//	- how many updates could be posted with LOSS_PERCENT of the frames lost, each way
+//	  (AU_UAV only loses the lost frames, compact also the AU_UAV_DELTAs after a lost keyframe)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <map>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "mavlink/v1.0/common/mavlink.h"
+#include "au_uav_ros/mavlink_frame.h"
+#include "au_uav_ros/telemetry_delta.h"
+#include "au_uav_ros/standardDefs.h"
+
+#define LINK_BYTES_PER_SECOND (57600/10)	//8N1
+#define WAYPOINT_REACHED 25		//meters, a waypoint this close is passed and the next one is the target
+#define LOSS_PERCENT 5
+
+struct point	{
+	double lat, lon, alt;
+};
+
+typedef std::map<int, std::vector<point> > byPlane;
+
+struct update	{
+	int32_t lat, lng, alt, targetLat, targetLng, targetAlt, groundSpeed, airspeed, bearing, distance;
+	uint8_t wp;
+};
+
+//The "Telemetry #N" LineString of every "UAV #N" folder, "lon, lat, alt" a line
+bool loadTracks(const char *path, byPlane &tracks)	{
+	FILE *file = fopen(path, "r");
+	if(file == NULL)
+		return false;
+	char line[256];
+	int plane = -1;
+	bool inCoordinates = false;
+	while(fgets(line, sizeof(line), file) != NULL)	{
+		const char *name = strstr(line, "<name>Telemetry #");
+		if(name != NULL)
+			plane = atoi(name + strlen("<name>Telemetry #"));
+		else if(strstr(line, "<coordinates>") != NULL && strstr(line, "</coordinates>") == NULL)
+			inCoordinates = plane >= 0;
+		else if(strstr(line, "</coordinates>") != NULL)	{
+			inCoordinates = false;
+			plane = -1;
+		}
+		else if(inCoordinates)	{
+			point p;
+			if(sscanf(line, " %lf , %lf , %lf", &p.lon, &p.lat, &p.alt) == 3)
+				tracks[plane].push_back(p);
+		}
+	}
+	fclose(file);
+	return !tracks.empty();
+}
+
+//The "#Plane ID: N" sections of a course file, "id lat lon alt" a line
+bool loadWaypoints(const char *path, byPlane &waypoints)	{
+	FILE *file = fopen(path, "r");
+	if(file == NULL)
+		return false;
+	char line[256];
+	bool inWaypoints = false;	//the starting positions come first
+	while(fgets(line, sizeof(line), file) != NULL)	{
+		if(strncmp(line, "#Plane ID:", 10) == 0)
+			inWaypoints = true;
+		int id;
+		point p;
+		if(inWaypoints && line[0] != '#' && sscanf(line, "%d %lf %lf %lf", &id, &p.lat, &p.lon, &p.alt) == 4 && id >= 0)
+			waypoints[id].push_back(p);
+	}
+	fclose(file);
+	return !waypoints.empty();
+}
+
+//Flat earth, the courses are a kilometer across
+void offset(const point &from, const point &to, double &east, double &north)	{
+	north = (to.lat - from.lat)*LATITUDE_TO_METERS;
+	east = (to.lon - from.lon)*LATITUDE_TO_METERS*cos(from.lat*DEGREES_TO_RADIANS);
+}
+
+std::vector<update> updatesFor(const std::vector<point> &track, const std::vector<point> &waypoints)	{
+	std::vector<update> updates;
+	unsigned int wp = 0;
+	for(unsigned int i = 0; i < track.size(); i++)	{
+		const point &at = track[i];
+		double east, north;
+		if(!waypoints.empty())	{
+			offset(at, waypoints[wp], east, north);
+			if(sqrt(east*east + north*north) < WAYPOINT_REACHED && wp + 1 < waypoints.size())
+				wp++;
+		}
+		point target = waypoints.empty() ? at : waypoints[wp];
+		offset(at, target, east, north);
+		double moved = 0;
+		if(i > 0)	{
+			double dx, dy;
+			offset(track[i - 1], at, dx, dy);
+			moved = sqrt(dx*dx + dy*dy);
+		}
+		double bearing = atan2(east, north)*RADIANS_TO_DEGREES;
+
+		update u;
+		u.lat = lround(at.lat*1e7);
+		u.lng = lround(at.lon*1e7);
+		u.alt = lround(at.alt*100);
+		u.targetLat = lround(target.lat*1e7);
+		u.targetLng = lround(target.lon*1e7);
+		u.targetAlt = lround(target.alt*100);
+		u.groundSpeed = lround(moved*100);
+		u.airspeed = lround(MPS_SPEED*100);
+		u.bearing = lround((bearing < 0 ? bearing + 360 : bearing)*100);
+		u.distance = lround(sqrt(east*east + north*north));
+		u.wp = wp;
+		updates.push_back(u);
+	}
+	return updates;
+}
+
+struct result	{
+	long updates, keyframes, plainBytes, compactBytes, plainPosted, compactPosted, wrongFields;
+	double worstMeters;
+
+	result() : updates(0), keyframes(0), plainBytes(0), compactBytes(0), plainPosted(0), compactPosted(0),
+			wrongFields(0), worstMeters(0) {}
+};
+
+void compare(const update &sent, const au_uav_ros::mav::FrameView &rebuilt, result &r)	{
+	au_uav_ros::mav::AuUavView got(rebuilt);
+	double north = (got.lat() - sent.lat)*1e-7*LATITUDE_TO_METERS;
+	double east = (got.lng() - sent.lng)*1e-7*LATITUDE_TO_METERS*cos(sent.lat*1e-7*DEGREES_TO_RADIANS);
+	r.worstMeters = std::max(r.worstMeters, sqrt(east*east + north*north));
+	if(got.alt() != sent.alt || got.targetLat() != sent.targetLat || got.targetLng() != sent.targetLng ||
+			got.targetAlt() != sent.targetAlt || got.groundSpeed() != sent.groundSpeed || got.airspeed() != sent.airspeed ||
+			got.targetBearing() != sent.bearing || got.distance() != sent.distance || got.targetWPIndex() != sent.wp)
+		r.wrongFields++;
+}
+
+//Every plane sends an update every second, in plane order, until the longest track ends
+result replay(const std::map<int, std::vector<update> > &planes, int keyframeInterval)	{
+	result r;
+	std::map<int, au_uav_ros::mav::DeltaEncoder> encoders;
+	for(std::map<int, std::vector<update> >::const_iterator p = planes.begin(); p != planes.end(); p++)
+		encoders.insert(std::make_pair(p->first, au_uav_ros::mav::DeltaEncoder(keyframeInterval)));
+	au_uav_ros::mav::DeltaDecoder decoder, lossyDecoder;
+	uint32_t seed = 1;
+	bool more = true;
+	for(unsigned int second = 0; more; second++)	{
+		more = false;
+		for(std::map<int, std::vector<update> >::const_iterator p = planes.begin(); p != planes.end(); p++)	{
+			if(second >= p->second.size())
+				continue;
+			more = true;
+			const update &u = p->second[second];
+			mavlink_message_t message;
+			uint8_t plain[MAVLINK_MAX_PACKET_LEN], compact[MAVLINK_MAX_PACKET_LEN], rebuilt[MAVLINK_MAX_PACKET_LEN];
+			mavlink_msg_au_uav_pack(p->first, 1, &message, u.lat, u.lng, u.alt, u.targetLat, u.targetLng, u.targetAlt,
+					u.groundSpeed, u.airspeed, u.bearing, u.distance, u.wp);
+			int plainLength = mavlink_msg_to_send_buffer(plain, &message);
+			int compactLength = encoders[p->first].encode(au_uav_ros::mav::FrameView(plain), compact);
+			au_uav_ros::mav::FrameView sent(compact);
+
+			r.updates++;
+			r.plainBytes += plainLength;
+			r.compactBytes += compactLength;
+			bool key = sent.msgid() == MAVLINK_MSG_ID_AU_UAV;
+			if(key)	{
+				r.keyframes++;
+				decoder.keyframe(sent);
+				compare(u, sent, r);
+			}
+			else if(decoder.rebuild(sent, rebuilt))
+				compare(u, au_uav_ros::mav::FrameView(rebuilt), r);
+			else
+				r.wrongFields++;	//nothing lost, it has to rebuild
+
+			seed = seed*1103515245 + 12345;
+			if((seed >> 16) % 100 < LOSS_PERCENT)
+				continue;
+			r.plainPosted++;
+			if(key)	{
+				lossyDecoder.keyframe(sent);
+				r.compactPosted++;
+			}
+			else if(lossyDecoder.rebuild(sent, rebuilt))
+				r.compactPosted++;
+		}
+	}
+	return r;
+}
+
+//final_32_500m_1_test.kml flew final_32_500m_1.course
+std::string courseFor(const std::string &courses, const char *kml)	{
+	std::string name = strrchr(kml, '/') ? strrchr(kml, '/') + 1 : kml;
+	std::string::size_type end = name.find("_test.kml");
+	if(end == std::string::npos)
+		end = name.rfind(".kml");
+	return courses + "/" + name.substr(0, end) + ".course";
+}
+
+int main(int argc, char **argv)	{
+	if(argc < 3)	{
+		printf("usage: %s <courses directory> <flight .kml>...\n", argv[0]);
+		return 1;
+	}
+	int intervals[] = {5, DELTA_KEYFRAME_INTERVAL, 20, 60};
+
+	printf("AU_UAV against AU_UAV_DELTA, %d byte/s link, position step %.2f m\n", LINK_BYTES_PER_SECOND,
+			DELTA_POSITION_STEP*1e-7*LATITUDE_TO_METERS);
+	printf("%24s %6s %8s %8s %8s %8s %8s %8s %8s %8s %8s %8s %8s\n", "flight", "planes", "updates", "interval",
+			"AU_UAV B", "delta B", "saved", "keys", "worst m", "wrong", "AU_UAV 1Hz", "delta 1Hz", "posted");
+	for(int i = 2; i < argc; i++)	{
+		const char *name = strrchr(argv[i], '/') ? strrchr(argv[i], '/') + 1 : argv[i];
+		byPlane tracks, waypoints;
+		if(!loadTracks(argv[i], tracks) || !loadWaypoints(courseFor(argv[1], argv[i]).c_str(), waypoints))	{
+			printf("%24.24s could not be read (or its course)\n", name);
+			continue;
+		}
+		std::map<int, std::vector<update> > planes;
+		for(byPlane::iterator t = tracks.begin(); t != tracks.end(); t++)
+			planes[t->first] = updatesFor(t->second, waypoints[t->first]);
+
+		for(unsigned int k = 0; k < sizeof(intervals)/sizeof(intervals[0]); k++)	{
+			result r = replay(planes, intervals[k]);
+			double plain = (double)r.plainBytes/r.updates, compact = (double)r.compactBytes/r.updates;
+			printf("%24.24s %6d %8ld %8d %8.1f %8.1f %7.1f%% %7.1f%% %8.3f %8ld %8.0f %8.0f %4.1f/%4.1f%%\n", name,
+					(int)planes.size(), r.updates, intervals[k], plain, compact, 100*(1 - compact/plain),
+					100.0*r.keyframes/r.updates, r.worstMeters, r.wrongFields, LINK_BYTES_PER_SECOND/plain,
+					LINK_BYTES_PER_SECOND/compact, 100.0*r.plainPosted/r.updates, 100.0*r.compactPosted/r.updates);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,265 @@
+//Tests DeltaEncoder and DeltaDecoder: what goes out for a plane flying along, that what comes back
+//out of the decoder is the AU_UAV that went in (lat and lng to within half a DELTA_POSITION_STEP),
+//and what happens when frames are lost or planes are mixed together.
+
+#include <stdlib.h>
+#include <vector>
+#include <gtest/gtest.h>
+#include "mavlink/v1.0/common/mavlink.h"
+#include "au_uav_ros/mavlink_frame.h"
+#include "au_uav_ros/telemetry_delta.h"
+
+namespace	{
+
+struct telemetry	{
+	int32_t lat, lng, alt, targetLat, targetLng, targetAlt, groundSpeed, airspeed, bearing, distance;
+	uint8_t wp;
+};
+
+//A plane going north east at about 11 m/s, one update a second
+telemetry flying(int second)	{
+	telemetry t;
+	t.lat = 326065730 + second*700;
+	t.lng = -854903560 + second*800;
+	t.alt = 40000 + (second % 7);
+	t.targetLat = 326170000;
+	t.targetLng = -854780000;
+	t.targetAlt = 40000;
+	t.groundSpeed = 1117 + (second % 3);
+	t.airspeed = 1117;
+	t.bearing = 4500;
+	t.distance = 1500 - 11*second;
+	t.wp = 3;
+	return t;
+}
+
+struct frame	{
+	uint8_t bytes[MAVLINK_MAX_PACKET_LEN];
+	int length;
+
+	au_uav_ros::mav::FrameView view() const	{return au_uav_ros::mav::FrameView(bytes);}
+};
+
+frame pack(uint8_t sysid, const telemetry &t)	{
+	mavlink_message_t message;
+	mavlink_msg_au_uav_pack(sysid, 1, &message, t.lat, t.lng, t.alt, t.targetLat, t.targetLng, t.targetAlt,
+			t.groundSpeed, t.airspeed, t.bearing, t.distance, t.wp);
+	frame f;
+	f.length = mavlink_msg_to_send_buffer(f.bytes, &message);
+	return f;
+}
+
+frame encode(au_uav_ros::mav::DeltaEncoder &encoder, const frame &in)	{
+	frame out;
+	out.length = encoder.encode(in.view(), out.bytes);
+	return out;
+}
+
+//What the receiving end makes of a frame, or false if it has nothing to post
+bool receive(au_uav_ros::mav::DeltaDecoder &decoder, const frame &in, frame &rebuilt)	{
+	EXPECT_TRUE(au_uav_ros::mav::checkFrame(in.bytes));
+	if(in.view().msgid() == MAVLINK_MSG_ID_AU_UAV)	{
+		decoder.keyframe(in.view());
+		rebuilt = in;
+		return true;
+	}
+	if(!decoder.rebuild(in.view(), rebuilt.bytes))
+		return false;
+	rebuilt.length = rebuilt.view().size();
+	EXPECT_TRUE(au_uav_ros::mav::checkFrame(rebuilt.bytes));
+	return true;
+}
+
+void expectSame(const telemetry &sent, const au_uav_ros::mav::FrameView &got)	{
+	au_uav_ros::mav::AuUavView view(got);
+	ASSERT_TRUE(view.valid());
+	EXPECT_LE(abs(view.lat() - sent.lat), DELTA_POSITION_STEP/2);
+	EXPECT_LE(abs(view.lng() - sent.lng), DELTA_POSITION_STEP/2);
+	EXPECT_EQ(sent.alt, view.alt());
+	EXPECT_EQ(sent.targetLat, view.targetLat());
+	EXPECT_EQ(sent.targetLng, view.targetLng());
+	EXPECT_EQ(sent.targetAlt, view.targetAlt());
+	EXPECT_EQ(sent.groundSpeed, view.groundSpeed());
+	EXPECT_EQ(sent.airspeed, view.airspeed());
+	EXPECT_EQ(sent.bearing, view.targetBearing());
+	EXPECT_EQ(sent.distance, view.distance());
+	EXPECT_EQ(sent.wp, view.targetWPIndex());
+}
+
+//The first update is a keyframe, then one in every DELTA_KEYFRAME_INTERVAL, and the rest are much
+//smaller than an AU_UAV
+TEST(telemetryDeltaTest, keyframesAndDeltas)	{
+	au_uav_ros::mav::DeltaEncoder encoder;
+	for(int second = 0; second < 3*DELTA_KEYFRAME_INTERVAL; second++)	{
+		frame out = encode(encoder, pack(7, flying(second)));
+		ASSERT_GT(out.length, 0);
+		EXPECT_TRUE(au_uav_ros::mav::checkFrame(out.bytes));
+		EXPECT_EQ(second % 256, out.view().sequence());
+		EXPECT_EQ(7, out.view().sysid());
+		if(second % DELTA_KEYFRAME_INTERVAL == 0)
+			EXPECT_EQ(MAVLINK_MSG_ID_AU_UAV, out.view().msgid()) << "second " << second;
+		else	{
+			EXPECT_EQ(MAVLINK_MSG_ID_AU_UAV_DELTA, out.view().msgid()) << "second " << second;
+			EXPECT_LE(out.length, 2 + 2*au_uav_ros::mav::DELTA_FIELDS + MAVLINK_NUM_NON_PAYLOAD_BYTES);
+		}
+	}
+	EXPECT_EQ(3, encoder.getKeyframes());
+	EXPECT_EQ(3*(DELTA_KEYFRAME_INTERVAL - 1), encoder.getDeltas());
+}
+
+//Only what changed is sent, an update that is the keyframe again is just the two header bytes
+TEST(telemetryDeltaTest, onlyChangedFieldsSent)	{
+	au_uav_ros::mav::DeltaEncoder encoder;
+	telemetry t = flying(0);
+	encode(encoder, pack(1, t));
+	frame same = encode(encoder, pack(1, t));
+	ASSERT_EQ(MAVLINK_MSG_ID_AU_UAV_DELTA, same.view().msgid());
+	EXPECT_EQ(2, same.view().length());
+	EXPECT_EQ(0, same.view().payload()[1]);
+
+	t.distance -= 11;
+	frame closer = encode(encoder, pack(1, t));
+	ASSERT_EQ(MAVLINK_MSG_ID_AU_UAV_DELTA, closer.view().msgid());
+	EXPECT_EQ(4, closer.view().length());
+	EXPECT_EQ(1 << au_uav_ros::mav::DELTA_DISTANCE, closer.view().payload()[1]);
+
+	t.lat += DELTA_POSITION_STEP/2 - 1;		//rounds back to the keyframe
+	frame still = encode(encoder, pack(1, t));
+	EXPECT_EQ(1 << au_uav_ros::mav::DELTA_DISTANCE, still.view().payload()[1]);
+}
+
+TEST(telemetryDeltaTest, roundTrip)	{
+	au_uav_ros::mav::DeltaEncoder encoder;
+	au_uav_ros::mav::DeltaDecoder decoder;
+	for(int second = 0; second < 100; second++)	{
+		frame rebuilt;
+		ASSERT_TRUE(receive(decoder, encode(encoder, pack(4, flying(second))), rebuilt)) << "second " << second;
+		EXPECT_EQ(MAVLINK_MSG_ID_AU_UAV, rebuilt.view().msgid());
+		EXPECT_EQ(4, rebuilt.view().sysid());
+		expectSame(flying(second), rebuilt.view());
+	}
+	EXPECT_EQ(0, decoder.getDropped());
+	EXPECT_EQ(encoder.getDeltas(), decoder.getRebuilt());
+}
+
+//A new target, or a field that moved too far for an int16_t, is a keyframe right away
+TEST(telemetryDeltaTest, keyframeWhenDeltaCannotSayIt)	{
+	au_uav_ros::mav::DeltaEncoder encoder(1000);
+	au_uav_ros::mav::DeltaDecoder decoder;
+	telemetry t = flying(0);
+	frame rebuilt;
+	receive(decoder, encode(encoder, pack(2, t)), rebuilt);
+
+	t.wp = 4;
+	frame out = encode(encoder, pack(2, t));
+	EXPECT_EQ(MAVLINK_MSG_ID_AU_UAV, out.view().msgid());
+	ASSERT_TRUE(receive(decoder, out, rebuilt));
+	expectSame(t, rebuilt.view());
+
+	t.targetAlt += 1;
+	out = encode(encoder, pack(2, t));
+	EXPECT_EQ(MAVLINK_MSG_ID_AU_UAV, out.view().msgid());
+	receive(decoder, out, rebuilt);
+
+	t.distance += 32767;
+	out = encode(encoder, pack(2, t));
+	EXPECT_EQ(MAVLINK_MSG_ID_AU_UAV_DELTA, out.view().msgid());
+	ASSERT_TRUE(receive(decoder, out, rebuilt));
+	expectSame(t, rebuilt.view());
+	t.distance += 1;
+	EXPECT_EQ(MAVLINK_MSG_ID_AU_UAV, encode(encoder, pack(2, t)).view().msgid());
+
+	t.lat -= 32769*DELTA_POSITION_STEP;
+	out = encode(encoder, pack(2, t));
+	EXPECT_EQ(MAVLINK_MSG_ID_AU_UAV, out.view().msgid());
+	EXPECT_EQ(5, encoder.getKeyframes());
+}
+
+//The differences are from the keyframe, so losing one AU_UAV_DELTA does not matter to the next
+TEST(telemetryDeltaTest, lostDeltaCostsOnlyItself)	{
+	au_uav_ros::mav::DeltaEncoder encoder;
+	au_uav_ros::mav::DeltaDecoder decoder;
+	for(int second = 0; second < 50; second++)	{
+		frame out = encode(encoder, pack(3, flying(second))), rebuilt;
+		if(out.view().msgid() == MAVLINK_MSG_ID_AU_UAV_DELTA && second % 3 == 1)
+			continue;
+		ASSERT_TRUE(receive(decoder, out, rebuilt)) << "second " << second;
+		expectSame(flying(second), rebuilt.view());
+	}
+	EXPECT_EQ(0, decoder.getDropped());
+}
+
+//Without its keyframe an AU_UAV_DELTA is dropped, never added to the keyframe before
+TEST(telemetryDeltaTest, lostKeyframeDropsItsDeltas)	{
+	au_uav_ros::mav::DeltaEncoder encoder;
+	au_uav_ros::mav::DeltaDecoder decoder;
+	int second = 0;
+	frame rebuilt;
+	for(; second < DELTA_KEYFRAME_INTERVAL; second++)
+		ASSERT_TRUE(receive(decoder, encode(encoder, pack(5, flying(second))), rebuilt));
+
+	frame lost = encode(encoder, pack(5, flying(second++)));
+	ASSERT_EQ(MAVLINK_MSG_ID_AU_UAV, lost.view().msgid());
+	for(; second < 2*DELTA_KEYFRAME_INTERVAL; second++)
+		EXPECT_FALSE(receive(decoder, encode(encoder, pack(5, flying(second))), rebuilt)) << "second " << second;
+	EXPECT_EQ(DELTA_KEYFRAME_INTERVAL - 1, decoder.getDropped());
+
+	ASSERT_TRUE(receive(decoder, encode(encoder, pack(5, flying(second))), rebuilt));
+	ASSERT_TRUE(receive(decoder, encode(encoder, pack(5, flying(second + 1))), rebuilt));
+	expectSame(flying(second + 1), rebuilt.view());
+
+	//and before any keyframe at all
+	au_uav_ros::mav::DeltaDecoder late;
+	EXPECT_FALSE(receive(late, encode(encoder, pack(5, flying(second + 2))), rebuilt));
+}
+
+//Each plane is rebuilt from its own keyframe, even with their sequence numbers the same
+TEST(telemetryDeltaTest, planesKeptApart)	{
+	std::vector<au_uav_ros::mav::DeltaEncoder> encoders(3);
+	au_uav_ros::mav::DeltaDecoder decoder;
+	for(int second = 0; second < 40; second++)
+		for(int p = 0; p < 3; p++)	{
+			telemetry t = flying(second + 100*p);
+			frame rebuilt;
+			ASSERT_TRUE(receive(decoder, encode(encoders[p], pack(10 + p, t)), rebuilt));
+			EXPECT_EQ(10 + p, rebuilt.view().sysid());
+			expectSame(t, rebuilt.view());
+		}
+}
+
+//An AU_UAV_DELTA shorter than its bitmask says, or with bits for fields there are not, is dropped
+TEST(telemetryDeltaTest, malformedDeltaDropped)	{
+	au_uav_ros::mav::DeltaEncoder encoder;
+	au_uav_ros::mav::DeltaDecoder decoder;
+	frame rebuilt;
+	receive(decoder, encode(encoder, pack(6, flying(0))), rebuilt);
+	frame out = encode(encoder, pack(6, flying(1)));
+	ASSERT_EQ(MAVLINK_MSG_ID_AU_UAV_DELTA, out.view().msgid());
+
+	frame cut = out;
+	cut.bytes[1] -= 2;
+	au_uav_ros::mav::restampFrame(cut.bytes, cut.view().sequence());
+	EXPECT_FALSE(receive(decoder, cut, rebuilt));
+
+	frame extra = out;
+	extra.bytes[MAVLINK_NUM_HEADER_BYTES + 1] |= 0x80;
+	au_uav_ros::mav::restampFrame(extra.bytes, extra.view().sequence());
+	EXPECT_FALSE(receive(decoder, extra, rebuilt));
+
+	EXPECT_TRUE(receive(decoder, out, rebuilt));
+	EXPECT_EQ(2, decoder.getDropped());
+
+	//and the encoder only takes AU_UAV
+	mavlink_message_t message;
+	frame heartbeat;
+	mavlink_msg_heartbeat_pack(6, 1, &message, MAV_TYPE_FIXED_WING, MAV_AUTOPILOT_GENERIC, 0, 0, 0);
+	heartbeat.length = mavlink_msg_to_send_buffer(heartbeat.bytes, &message);
+	EXPECT_EQ(0, encoder.encode(heartbeat.view(), rebuilt.bytes));
+}
+
+}
+
+int main(int argc, char **argv)	{
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
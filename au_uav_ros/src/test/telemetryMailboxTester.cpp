@@ -0,0 +1,133 @@
+//Tests TelemetryMailbox: newest update per plane, in the order the planes were posted, and take()
+//woken by a post from a second thread. How stale CA's data gets against running avoid() in the
+//callback is measured by src/test/caWorkerBenchmark.cpp, not here.
+
+#include <time.h>
+#include <vector>
+#include <gtest/gtest.h>
+#include <boost/thread.hpp>
+#include "au_uav_ros/telemetry_mailbox.h"
+
+namespace	{
+
+#define SLACK 0.05		//seconds a wakeup may be late on a loaded machine
+
+double wallSeconds()	{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+void sleepSeconds(double seconds)	{
+	boost::this_thread::sleep(boost::posix_time::microseconds((long)(seconds*1e6)));
+}
+
+au_uav_ros::Telemetry telemetry(int planeID, double latitude)	{
+	au_uav_ros::Telemetry t;
+	t.planeID = planeID;
+	t.currentLatitude = latitude;
+	return t;
+}
+
+void postLater(au_uav_ros::TelemetryMailbox *mailbox, int planeID, double seconds)	{
+	sleepSeconds(seconds);
+	mailbox->post(telemetry(planeID, 0), wallSeconds());
+}
+
+void stopLater(au_uav_ros::TelemetryMailbox *mailbox, double seconds)	{
+	sleepSeconds(seconds);
+	mailbox->stop();
+}
+
+}
+
+TEST(TelemetryMailbox, takesWhatWasPosted)	{
+	au_uav_ros::TelemetryMailbox mailbox;
+	std::vector<au_uav_ros::mailboxEntry> updates;
+	mailbox.post(telemetry(3, 1.0), 10.0);
+	mailbox.post(telemetry(1, 2.0), 11.0);
+	EXPECT_EQ(2, mailbox.getDepth());
+
+	ASSERT_EQ(2, mailbox.take(updates, 0));
+	EXPECT_EQ(3, updates[0].telem.planeID);
+	EXPECT_EQ(1.0, updates[0].telem.currentLatitude);
+	EXPECT_EQ(10.0, updates[0].received);
+	EXPECT_EQ(1, updates[1].telem.planeID);
+	EXPECT_EQ(11.0, updates[1].received);
+	EXPECT_EQ(0, mailbox.getDepth());
+	EXPECT_EQ(0, mailbox.getOverwritten());
+}
+
+TEST(TelemetryMailbox, newestUpdateReplacesOneNotTaken)	{
+	au_uav_ros::TelemetryMailbox mailbox;
+	std::vector<au_uav_ros::mailboxEntry> updates;
+	mailbox.post(telemetry(5, 1.0), 1.0);
+	mailbox.post(telemetry(2, 1.0), 2.0);
+	mailbox.post(telemetry(5, 3.0), 3.0);
+	mailbox.post(telemetry(5, 4.0), 4.0);
+	EXPECT_EQ(2, mailbox.getDepth());
+
+	//plane 5 keeps its place in line, with its newest update
+	ASSERT_EQ(2, mailbox.take(updates, 0));
+	EXPECT_EQ(5, updates[0].telem.planeID);
+	EXPECT_EQ(4.0, updates[0].telem.currentLatitude);
+	EXPECT_EQ(4.0, updates[0].received);
+	EXPECT_EQ(2, updates[1].telem.planeID);
+
+	EXPECT_EQ(4, mailbox.getPosted());
+	EXPECT_EQ(2, mailbox.getOverwritten());
+	EXPECT_EQ(2, mailbox.getMaxDepth());
+	EXPECT_EQ(1, mailbox.getTakes());
+	EXPECT_EQ(2, mailbox.getTaken());
+
+	//taken, so the next one from plane 5 is not an overwrite
+	mailbox.post(telemetry(5, 5.0), 5.0);
+	EXPECT_EQ(2, mailbox.getOverwritten());
+	EXPECT_EQ(1, mailbox.take(updates, 0));
+}
+
+TEST(TelemetryMailbox, negativePlaneIDsAreIgnored)	{
+	au_uav_ros::TelemetryMailbox mailbox;
+	std::vector<au_uav_ros::mailboxEntry> updates;
+	mailbox.post(telemetry(-1, 0), 0);
+	EXPECT_EQ(0, mailbox.getPosted());
+	EXPECT_EQ(0, mailbox.take(updates, 0));
+}
+
+TEST(TelemetryMailbox, emptyTakeTimesOut)	{
+	au_uav_ros::TelemetryMailbox mailbox;
+	std::vector<au_uav_ros::mailboxEntry> updates;
+	double start = wallSeconds();
+	EXPECT_EQ(0, mailbox.take(updates, 0.1));
+	EXPECT_GE(wallSeconds() - start, 0.1 - 0.001);
+	EXPECT_EQ(0, mailbox.getTakes());
+}
+
+TEST(TelemetryMailbox, postWakesTake)	{
+	au_uav_ros::TelemetryMailbox mailbox;
+	std::vector<au_uav_ros::mailboxEntry> updates;
+	boost::thread callback(postLater, &mailbox, 7, 0.05);
+	double start = wallSeconds();
+	ASSERT_EQ(1, mailbox.take(updates, 5));
+	EXPECT_LT(wallSeconds() - start, 0.05 + SLACK);
+	EXPECT_EQ(7, updates[0].telem.planeID);
+	callback.join();
+}
+
+TEST(TelemetryMailbox, stopWakesTakeForGood)	{
+	au_uav_ros::TelemetryMailbox mailbox;
+	std::vector<au_uav_ros::mailboxEntry> updates;
+	boost::thread shutdown(stopLater, &mailbox, 0.05);
+	double start = wallSeconds();
+	EXPECT_EQ(0, mailbox.take(updates, 5));
+	EXPECT_LT(wallSeconds() - start, 0.05 + SLACK);
+	shutdown.join();
+
+	mailbox.post(telemetry(1, 0), 0);
+	EXPECT_EQ(0, mailbox.take(updates, 5));
+}
+
+int main(int argc, char **argv)	{
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -7,32 +7,68 @@ are related to implementation, not usage.
 #include "au_uav_ros/vmath.h"
 #include "au_uav_ros/standardFuncs.h" /* for PI */
 
-/* Constructor - specify magnitude and direction of the force vector */
+/* Constructor - specify magnitude and direction of the force vector, stored as components */
 au_uav_ros::mathVector::mathVector(double m, double d) :
-	magnitude(m), direction(d) {}
+	x(m * cos(d * PI / 180.0)), y(m * sin(d * PI / 180.0)), direction(d) {}
 
 /* Copy constructor */
 au_uav_ros::mathVector::mathVector(const au_uav_ros::mathVector& mV) {
+	this->x = mV.x;
+	this->y = mV.y;
 	this->direction = mV.direction;
-	this->magnitude = mV.magnitude;
+}
+
+/* Named constructor - specify the components directly */
+au_uav_ros::mathVector au_uav_ros::mathVector::fromCartesian(double x, double y) {
+	mathVector newVector;
+	newVector.x = x;
+	newVector.y = y;
+	newVector.direction = 0;
+	return newVector;
 }
 
 /* Accessor methods: Allow the client to access the magnitude and direction of the math vector */
 double au_uav_ros::mathVector::getDirection(void) const {
-	return direction;
+	/* Theta = arctan2(y, x), on the interval [-180, 180]. A zero vector has none, it keeps its own */
+	if (x == 0 && y == 0)
+		return direction;
+	return atan2(y, x) * 180.0 / PI;
 }
 
 double au_uav_ros::mathVector::getMagnitude(void) const {
-	return magnitude;
+	/* R = (x^2 + y^2)^(1/2) */
+	return sqrt(x*x + y*y);
+}
+
+double au_uav_ros::mathVector::getX(void) const {
+	return x;
+}
+
+double au_uav_ros::mathVector::getY(void) const {
+	return y;
 }
 
-/* Modifier methods: Allow the client to modify the magnitude and direction of the math vector */
+/* Modifier methods: Allow the client to modify the magnitude and direction of the math vector.
+Each one keeps the other polar coordinate as it was. */
 void au_uav_ros::mathVector::setDirection(double d) {
+	double m = getMagnitude();
+	this->x = m * cos(d * PI / 180.0);
+	this->y = m * sin(d * PI / 180.0);
 	this->direction = d;
 }
 
 void au_uav_ros::mathVector::setMagnitude(double m) {
-	this->magnitude = m;
+	double current = getMagnitude();
+	if (current == 0) {
+		/* x and y have no direction to keep, the cached one does */
+		this->x = m * cos(direction * PI / 180.0);
+		this->y = m * sin(direction * PI / 180.0);
+		return;
+	}
+	if (m == 0)
+		this->direction = getDirection();
+	this->x *= m / current;
+	this->y *= m / current;
 }
 
 /*
@@ -41,16 +77,7 @@ Vector-based addition, subtract, and multiplication operator overloading.
 
 /* Dot produt. */ 
 double au_uav_ros::mathVector::dotProduct(const au_uav_ros::mathVector& mV){
-	/* Ax = mag * cos(degree), Ay = mag * sin(degree) */
-	double Ax = this->magnitude * cos(this->direction * PI / 180.0);
-	double Ay = this->magnitude * sin(this->direction * PI / 180.0);
-
-	/* Bx = mag * cos(degree), By = mag * sin(degree) */
-	double Bx = mV.magnitude * cos(mV.direction * PI / 180.0);
-	double By = mV.magnitude * sin(mV.direction * PI / 180.0);
-
-	return Ax*Bx+Ay*By;
-
+	return this->x*mV.x + this->y*mV.y;
 }
 
 const au_uav_ros::mathVector au_uav_ros::mathVector::operator+(const au_uav_ros::mathVector& mV) const {
@@ -60,30 +87,10 @@ const au_uav_ros::mathVector au_uav_ros::mathVector::operator+(const au_uav_ros:
 }
 
 au_uav_ros::mathVector& au_uav_ros::mathVector::operator+=(const au_uav_ros::mathVector& mV) {
-	double Ax = 0.0, Ay = 0.0, Bx = 0.0, By = 0.0;
-	double Rx = 0.0, Ry = 0.0, R = 0.0, Theta = 0.0;
-
-	/* Ax = mag * cos(degree), Ay = mag * sin(degree) */
-	Ax = this->magnitude * cos(this->direction * PI / 180.0);
-	Ay = this->magnitude * sin(this->direction * PI / 180.0);
-
-	/* Bx = mag * cos(degree), By = mag * sin(degree) */
-	Bx = mV.magnitude * cos(mV.direction * PI / 180.0);
-	By = mV.magnitude * sin(mV.direction * PI / 180.0);
-
-	/* Perform addition */
-	Rx = Ax + Bx;
-	Ry = Ay + By;
-
-	/* R = (Rx^2 + Ry^2)^(1/2) */
-	R = sqrt(pow(Rx, 2) + pow(Ry, 2));
-
-	/* Theta = arctan2(Ry, Rx) */
-	Theta = atan2(Ry , Rx) * 180.0 / PI;
-
-	/* Assign new values */
-	this->magnitude = R;
-	this->direction = Theta;
+	this->x += mV.x;
+	this->y += mV.y;
+	if (x == 0 && y == 0)
+		this->direction = 0;
 
 	/* Return resulting vector */
 	return *this;
@@ -96,30 +103,10 @@ const au_uav_ros::mathVector au_uav_ros::mathVector::operator-(const au_uav_ros:
 }
 
 au_uav_ros::mathVector& au_uav_ros::mathVector::operator-=(const au_uav_ros::mathVector& mV) {
-	double Ax = 0.0, Ay = 0.0, Bx = 0.0, By = 0.0;
-	double Rx = 0.0, Ry = 0.0, R = 0.0, Theta = 0.0;
-
-	/* Ax = mag * cos(degree), Ay = mag * sin(degree) */
-	Ax = this->magnitude * cos(this->direction * PI / 180.0);
-	Ay = this->magnitude * sin(this->direction * PI / 180.0);
-
-	/* -Bx = mag * cos(-degree), -By = mag * sin(-degree) */
-	Bx = mV.magnitude * cos((mV.direction + 180.0) * PI / 180.0);
-	By = mV.magnitude * sin((mV.direction + 180.0) * PI / 180.0);
-
-	/* Perform addition with negative vector */
-	Rx = Ax + Bx;
-	Ry = Ay + By;
-
-	/* R = (Rx^2 + Ry^2)^(1/2) */
-	R = sqrt(pow(Rx, 2) + pow(Ry, 2));
-
-	/* Theta = arctan2(Ry, Rx) */
-	Theta = atan2(Ry , Rx) * 180.0 / PI;
-
-	/* Assign new values */
-	this->magnitude = R;
-	this->direction = Theta;
+	this->x -= mV.x;
+	this->y -= mV.y;
+	if (x == 0 && y == 0)
+		this->direction = 0;
 
 	/* Return resulting vector */
 	return *this;
@@ -136,8 +123,11 @@ const au_uav_ros::mathVector au_uav_ros::mathVector::operator*(double val) const
 }
 
 au_uav_ros::mathVector& au_uav_ros::mathVector::operator*=(double val) {
-	/* Scalar multiplication involves multiplying the magnitude by the scale */
-	this->magnitude *= val;
+	/* Scalar multiplication involves multiplying the magnitude, so both components, by the scale */
+	if (val == 0)
+		this->direction = getDirection();
+	this->x *= val;
+	this->y *= val;
 
 	/* Return resulting vector */
 	return *this;
@@ -150,8 +140,9 @@ const au_uav_ros::mathVector au_uav_ros::mathVector::operator/(double val) const
 }
 
 au_uav_ros::mathVector& au_uav_ros::mathVector::operator/=(double val) {
-	/* Scalar division involves dividing the magnitude by the scale */
-	this->magnitude /= val;
+	/* Scalar division involves dividing the magnitude, so both components, by the scale */
+	this->x /= val;
+	this->y /= val;
 
 	/* Return resulting vector */
 	return *this;
@@ -174,7 +165,8 @@ const au_uav_ros::mathVector operator/(double val, const au_uav_ros::mathVector&
 
 /* Overloaded equality operator */
 au_uav_ros::mathVector& au_uav_ros::mathVector::operator=(const au_uav_ros::mathVector& mV){
-	this->magnitude = mV.magnitude;
+	this->x = mV.x;
+	this->y = mV.y;
 	this->direction = mV.direction;
 	return *this;
 }
@@ -193,8 +185,8 @@ double au_uav_ros::mathVector::findAngleBetween(const au_uav_ros::mathVector& mV
 	double rawDifference, finalAngle;
 	
 	//Force angles to be [0,360]
-	double this_direction = forceAngle360(this->direction);
-	double mV_direction = forceAngle360(mV.direction);
+	double this_direction = forceAngle360(this->getDirection());
+	double mV_direction = forceAngle360(mV.getDirection());
 	if(this_direction > mV_direction)	{
 		rawDifference = this_direction- mV_direction;
 		//Other is CCW from this
@@ -1,19 +1,24 @@
 #include "au_uav_ros/xbee_talker.h"
 #include <cstdio> //printf
+#include <cstring>
 #include <string>
 #include <ros/console.h>	//used for debugging
 
-au_uav_ros::XbeeTalker::XbeeTalker()	{
+au_uav_ros::XbeeTalker::XbeeTalker() : m_xbee_in(m_xbee), m_xbee_out(m_xbee)	{
 	m_port = "dev/ttyUSB0";
 	m_baud = 9600;
 }
 
-au_uav_ros::XbeeTalker::XbeeTalker(std::string _port, int _baud)	{
+au_uav_ros::XbeeTalker::XbeeTalker(std::string _port, int _baud) : m_xbee_in(m_xbee), m_xbee_out(m_xbee)	{
 	m_port = _port;
 	m_baud = _baud;
 }
 
 bool au_uav_ros::XbeeTalker::init(ros::NodeHandle _n)	{
+	return init(_n, ros::NodeHandle("~"));
+}
+
+bool au_uav_ros::XbeeTalker::init(ros::NodeHandle _n, ros::NodeHandle params)	{
 	//Open and setup port.
 	if(m_xbee.open_port(m_port) == -1)	{
 		ROS_INFO("Could not open port %s", m_port.c_str());
@@ -22,6 +27,8 @@ bool au_uav_ros::XbeeTalker::init(ros::NodeHandle _n)	{
 	else	{
 		ROS_INFO("opened port %s", m_port.c_str());
 		m_xbee.setup_port(m_baud, 8, 1, true);		
+		m_xbee_out.setLinkRate(m_baud/10);	//a radio, 8N1
+		m_xbee_out.start();
 	}
 
 	//mavlink
@@ -31,19 +38,29 @@ bool au_uav_ros::XbeeTalker::init(ros::NodeHandle _n)	{
 	pc2serial = true;
 	updateIndex = 0;
 	WPSendSeqNum = 0;
+	frameSeqNum = 0;
 
-	//Set up Ros stuff. Todo - update this my_telemetry
+	//Set up Ros stuff. My telemetry comes from ardu as frames, passed through without decoding
 	m_node = _n;
+	params.param<bool>("restamp_frames", restampFrames, false);	//false = keep the autopilot's sequence numbers
+	params.param<bool>("compact_telemetry", compactTelemetry, false);	//true = always our own sequence numbers
+	int airtimeBudget;
+	double slowestPeriod;
+	params.param<bool>("adaptive_rate", adaptiveRate, false);	//false = send every update, as before
+	params.param<int>("airtime_budget", airtimeBudget, DEFAULT_AIRTIME_BUDGET);	//bytes/second, 0 = none
+	params.param<double>("slowest_period", slowestPeriod, BROADCAST_SLOWEST_PERIOD);
+	m_rate.setAirtimeBudget(airtimeBudget);
+	m_rate.setSlowestPeriod(slowestPeriod);
 	m_telem_pub = m_node.advertise<au_uav_ros::Telemetry>("all_telemetry", 5);
 	m_cmd_pub = m_node.advertise<au_uav_ros::Command>("gcs_commands", 5);
-	telem_sub = m_node.subscribe("my_mav_telemetry", 2, &XbeeTalker::myTelemCallback, this); 
+	frame_sub = m_node.subscribe("my_mav_frames", 2, &XbeeTalker::myFrameCallback, this);
 	return true;
 }
 
 void au_uav_ros::XbeeTalker::run()	{
 	ROS_INFO("Entering Run");
 
-	//Spin up thread to execute myTelemCallback()
+	//Spin up thread to execute myFrameCallback()
 	boost::thread broadcastMyTelem(boost::bind(&XbeeTalker::spinThread, this));	
 
 	//Start listening for telemetry and commands, upon receiving proper command
@@ -54,9 +71,14 @@ void au_uav_ros::XbeeTalker::run()	{
 	broadcastMyTelem.join();	
 }
 
+void au_uav_ros::XbeeTalker::stop()	{
+	m_loop.stop();
+}
+
 void au_uav_ros::XbeeTalker::shutdown()	{
 	//ROS_INFO("Shutting down Xbee port %s", m_port.c_str());
 	printf("XbeeTalker::Shutting down Xbee port %s\n", m_port.c_str()); //i ros::shutdown when exiting run
+	m_xbee_out.stop();	//writes out what is still queued
 	m_xbee.close_port();
 }
 
@@ -87,87 +109,106 @@ void au_uav_ros::XbeeTalker::listen()	{
 		memset(buffer, '\0', 256);
 	}
 	*/
-        while(ros::ok())
-        {
-                //get a mavlink message from the serial line
-                mavlink_message_t message = au_uav_ros::mav::readMavlinkFromSerial(m_xbee);
-                //decode the message and post it to the appropriate topic
-
-		 if(message.msgid == MAVLINK_MSG_ID_HEARTBEAT)
-                {
-                        mavlink_heartbeat_t receivedHeartbeat;
-                        mavlink_msg_heartbeat_decode(&message, &receivedHeartbeat);
-                        ROS_INFO("Received heartbeat");
-                }
-                //Received a telemetry update
-		if(message.msgid == MAVLINK_MSG_ID_AU_UAV)
-                {
-                        //ROS_INFO("Received AU_UAV message from serial with ID #%d (sys:%d|comp:%d):\n", message.msgid, mes$
-                        au_uav_ros::Telemetry tUpdate;
-                        mavlink_au_uav_t myMSG;
-                        mavlink_msg_au_uav_decode(&message, &myMSG);            // decode generic mavlink message in$
-                        au_uav_ros::mav::convertMavlinkTelemetryToROS(myMSG, tUpdate);                   // decode AU_UAV ma$
-                        tUpdate.planeID = message.sysid;                                // update planeID
-                        m_telem_pub.publish(tUpdate);
-			ROS_INFO("Received telemetry message from UAV[#%d] (lat:%f|lng:%f|alt:%f)", tUpdate.planeID,
-					 tUpdate.currentLatitude, tUpdate.currentLongitude, tUpdate.currentAltitude);
-                }
-		//Received a command message, forward it to collision avoidance node
-		if(message.msgid == MAVLINK_MSG_ID_MISSION_ITEM)
-		{
-			au_uav_ros::Command cmdToForward;
-			mavlink_mission_item_t receivedCommand;
-			mavlink_msg_mission_item_decode(&message, &receivedCommand);
-			au_uav_ros::mav::convertMavlinkCommandToROS(receivedCommand, cmdToForward);
-			cmdToForward.planeID = message.sysid;
-			m_cmd_pub.publish(cmdToForward);
-			ROS_ERROR("xbee: Received and forwarded command with ID: %d lat: %f|lng %f|alt%f",cmdToForward.planeID,
-					 cmdToForward.latitude, cmdToForward.longitude, cmdToForward.altitude);
-		}
-        }
+	m_dispatch.on(MAVLINK_MSG_ID_HEARTBEAT, boost::bind(&XbeeTalker::handleHeartbeat, this, _1));
+	m_dispatch.on(MAVLINK_MSG_ID_AU_UAV, boost::bind(&XbeeTalker::handleTelemetry, this, _1));
+	m_dispatch.on(MAVLINK_MSG_ID_AU_UAV_DELTA, boost::bind(&XbeeTalker::handleTelemetryDelta, this, _1));
+	m_dispatch.on(MAVLINK_MSG_ID_MISSION_ITEM, boost::bind(&XbeeTalker::handleCommand, this, _1));
+	m_loop.addSerial(m_xbee_in, m_dispatch);
+	m_loop.run();
+}
+
+void au_uav_ros::XbeeTalker::handleHeartbeat(const au_uav_ros::mav::FrameView &frame)	{
+	ROS_INFO("Received heartbeat");
+}
+
+//Received a telemetry update, read straight off the frame. It is the keyframe of that plane's
+//AU_UAV_DELTAs too.
+void au_uav_ros::XbeeTalker::handleTelemetry(const au_uav_ros::mav::FrameView &frame)	{
+	m_decoder.keyframe(frame);
+	publishTelemetry(frame);
+}
+
+//Received a compact telemetry update, rebuilt from the plane's last keyframe
+void au_uav_ros::XbeeTalker::handleTelemetryDelta(const au_uav_ros::mav::FrameView &frame)	{
+	uint8_t rebuilt[MAVLINK_MAX_PACKET_LEN];
+	if(m_decoder.rebuild(frame, rebuilt))
+		publishTelemetry(au_uav_ros::mav::FrameView(rebuilt));
+	else
+		ROS_INFO("Dropped compact telemetry from UAV[#%d], its keyframe was lost", frame.sysid());
+}
+
+void au_uav_ros::XbeeTalker::publishTelemetry(const au_uav_ros::mav::FrameView &frame)	{
+	au_uav_ros::mav::AuUavView myMSG(frame);
+	if(!myMSG.valid())
+		return;
+	//a shared pointer, only read after publish(), so the mover gets it without a copy in a nodelet manager
+	au_uav_ros::Telemetry::Ptr tUpdate(new au_uav_ros::Telemetry);
+	au_uav_ros::mav::convertMavlinkTelemetryToROS(myMSG, *tUpdate);
+	tUpdate->planeID = frame.sysid();
+	m_telem_pub.publish(tUpdate);
+	m_rate.neighbor(tUpdate->planeID, tUpdate->currentLatitude, tUpdate->currentLongitude, tUpdate->currentAltitude,
+			ros::Time::now().toSec());
+	ROS_INFO("Received telemetry message from UAV[#%d] (lat:%f|lng:%f|alt:%f)", tUpdate->planeID,
+			 tUpdate->currentLatitude, tUpdate->currentLongitude, tUpdate->currentAltitude);
+}
+
+//Received a command message, forward it to collision avoidance node
+void au_uav_ros::XbeeTalker::handleCommand(const au_uav_ros::mav::FrameView &frame)	{
+	mavlink_message_t message;
+	frame.toMessage(message);	//commands are rare, the generated decode is fine for them
+	au_uav_ros::Command::Ptr cmdToForward(new au_uav_ros::Command);
+	mavlink_mission_item_t receivedCommand;
+	mavlink_msg_mission_item_decode(&message, &receivedCommand);
+	au_uav_ros::mav::convertMavlinkCommandToROS(receivedCommand, *cmdToForward);
+	cmdToForward->planeID = frame.sysid();
+	m_cmd_pub.publish(cmdToForward);
+	ROS_ERROR("xbee: Received and forwarded command with ID: %d lat: %f|lng %f|alt%f",cmdToForward->planeID,
+			 cmdToForward->latitude, cmdToForward->longitude, cmdToForward->altitude);
 }
 
 //Output - writing to xbee
 //---------------------------------------------------------------------------
-void au_uav_ros::XbeeTalker::myTelemCallback(au_uav_ros::Telemetry tUpdate)	{
-	ROS_INFO("XbeeTalker::telemCallback::ding! \n");
-
-	mavlink_message_t mavlinkMsg;
-        static uint8_t buffer[MAVLINK_MAX_PACKET_LEN];
-	//stuff mavlinkMsg with all the correct paramaters
-	mavlink_msg_au_uav_pack(tUpdate.planeID, compid, &mavlinkMsg, tUpdate.currentLatitude, tUpdate.currentLongitude,
-				tUpdate.currentAltitude, tUpdate.destLatitude, tUpdate.destLongitude, 
-                                tUpdate.destAltitude, tUpdate.groundSpeed, tUpdate.airSpeed, tUpdate.targetBearing,
-				 tUpdate.distanceToDestination, tUpdate.currentWaypointIndex);
-	
+//The frame is sent as ardu read it, checksum and all, unless it is restamped or sent compact
+void au_uav_ros::XbeeTalker::myFrameCallback(const au_uav_ros::MavlinkFrame::ConstPtr &raw)	{
+	int length = raw->frame.size();
+	if(length < MAVLINK_NUM_NON_PAYLOAD_BYTES || length > MAVLINK_MAX_PACKET_LEN ||
+			length != raw->frame[1] + MAVLINK_NUM_NON_PAYLOAD_BYTES)	{
+		ROS_ERROR("XbeeTalker::myFrameCallback: not a whole frame (%d bytes)", length);
+		return;
+	}
 
-        int messageLength = mavlink_msg_to_send_buffer(buffer, &mavlinkMsg);
-	ros::Duration(0.000001).sleep();
-        m_xbee.lock();
-        int written = write(m_xbee.getFD(), (char*)buffer, messageLength);
-        m_xbee.unlock();
-        if (messageLength != written) ROS_ERROR("ERROR: Wrote %d bytes but should have written %d\n",
-                                                written, messageLength);
+	//updates the neighbors do not need yet stay off the air
+	au_uav_ros::mav::FrameView mine(&raw->frame[0]);
+	au_uav_ros::mav::AuUavView myMSG(mine);
+	double now = ros::Time::now().toSec();
+	if(adaptiveRate && mine.msgid() == MAVLINK_MSG_ID_AU_UAV && myMSG.valid())	{
+		m_rate.mine(myMSG.lat()/10000000.0, myMSG.lng()/10000000.0, myMSG.alt()/100.0, now);
+		if(!m_rate.due(now))
+			return;
+	}
 
+	bool queued;
+	uint8_t frame[MAVLINK_MAX_PACKET_LEN];
+	int compactLength = compactTelemetry ? m_encoder.encode(mine, frame) : 0;
+	if(compactLength > 0)	{
+		queued = m_xbee_out.send(frame, compactLength, au_uav_ros::TX_TELEMETRY);
+		length = compactLength;
+	}
+	else if(restampFrames)	{
+		memcpy(frame, &raw->frame[0], length);
+		au_uav_ros::mav::restampFrame(frame, frameSeqNum++);
+		queued = m_xbee_out.send(frame, length, au_uav_ros::TX_TELEMETRY);
+	}
+	else
+		queued = m_xbee_out.send(&raw->frame[0], length, au_uav_ros::TX_TELEMETRY);
+	if(!queued)
+		ROS_ERROR("ERROR: send queue for %s is full, telemetry dropped\n", m_port.c_str());
+	else if(adaptiveRate)
+		m_rate.sent(length, now);
 }
 
 void au_uav_ros::XbeeTalker::spinThread()	{
 	ROS_INFO("XbeeTalker::spinThread::Starting spinner thread");
-	//Handle myTelemCallback()
+	//Handle myFrameCallback()
 	ros::spin();	
 }
-
-int main(int argc, char** argv)	{
-	int baud = 57600;
-	std::cout << "helo world!" <<std::endl;
-	std::string port = "/dev/ttyUSB0";
-	if(argc == 2){
-		baud = atoi(argv[1]);
-	}
-	ros::init(argc, argv, "XbeeTalker");
-	ros::NodeHandle n;
-	au_uav_ros::XbeeTalker talk(port, baud);
-	if(talk.init(n))	//OK. what if the xbee can't be read???
-		talk.run();
-	talk.shutdown();
-}
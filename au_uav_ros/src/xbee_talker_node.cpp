@@ -0,0 +1,19 @@
+#include "au_uav_ros/xbee_talker.h"
+
+//The xbee node on its own. src/nodelets.cpp loads the same XbeeTalker into a nodelet manager.
+
+int main(int argc, char** argv)	{
+	int baud = 57600;
+	std::cout << "helo world!" <<std::endl;
+	std::string port;
+	if(argc == 2){
+		baud = atoi(argv[1]);
+	}
+	ros::init(argc, argv, "XbeeTalker");
+	ros::NodeHandle n;
+	ros::NodeHandle("~").param<std::string>("port", port, "/dev/ttyUSB0");
+	au_uav_ros::XbeeTalker talk(port, baud);
+	if(talk.init(n))	//OK. what if the xbee can't be read???
+		talk.run();
+	talk.shutdown();
+}